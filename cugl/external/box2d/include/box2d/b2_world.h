@@ -66,6 +66,14 @@ public:
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
 
+	/// Register a task executor to solve the islands of a step in parallel.
+	/// Pass nullptr to solve them on the calling thread. The executor is owned
+	/// by you and must remain in scope.
+	void SetTaskExecutor(b2TaskExecutor* executor);
+
+	/// Get the task executor, or nullptr if the islands are solved serially.
+	b2TaskExecutor* GetTaskExecutor() const;
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside with b2World::DebugDraw method. The debug draw object is owned
 	/// by you and must remain in scope.
@@ -225,6 +233,8 @@ private:
 	void operator=(const b2World&) = delete;
 
 	void Solve(const b2TimeStep& step);
+	void SolveIslands(const b2TimeStep& step);
+	void SolveIslandsParallel(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
@@ -245,6 +255,7 @@ private:
 
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
+	b2TaskExecutor* m_taskExecutor;
 
 	// This is used to compute the time step ratio to
 	// support a variable time step.
@@ -264,6 +275,11 @@ private:
 	b2Profile m_profile;
 };
 
+inline b2TaskExecutor* b2World::GetTaskExecutor() const
+{
+	return m_taskExecutor;
+}
+
 inline b2Body* b2World::GetBodyList()
 {
 	return m_bodyList;
@@ -123,6 +123,35 @@ public:
 	}
 };
 
+/// A range of work that can be run on several threads. The work is split
+/// into items numbered from zero, and any two ranges may run at the same time.
+/// See b2TaskExecutor
+class B2_API b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Run the items in the range [begin, end).
+	virtual void Execute(int32 begin, int32 end) = 0;
+};
+
+/// Implement this class to let the world solve independent islands in
+/// parallel, typically with a thread pool. Islands that share a static body
+/// are solved by the same item, so each island is solved exactly as it would
+/// be on one thread. Only the order of the post-solve callbacks changes, and
+/// these are serialized by the world. The executor is owned by you and must
+/// remain in scope.
+/// See b2World::SetTaskExecutor
+class B2_API b2TaskExecutor
+{
+public:
+	virtual ~b2TaskExecutor() {}
+
+	/// Run the items [0, count) of the task, returning when all of them are
+	/// done. The items may be split into ranges of any size.
+	virtual void ParallelFor(b2Task* task, int32 count) = 0;
+};
+
 /// Callback class for AABB queries.
 /// See b2World::Query
 class B2_API b2QueryCallback
@@ -30,14 +30,23 @@
 b2Version b2_version = {2, 4, 1};
 
 // Memory allocators. Modify these to use your own allocator.
+// Allocation tracking replaces operator new, so route through it when enabled.
 void* b2Alloc_Default(int32 size)
 {
+#ifdef B2_TRACK_ALLOCATIONS
+	return ::operator new(size);
+#else
 	return malloc(size);
+#endif
 }
 
 void b2Free_Default(void* mem)
 {
+#ifdef B2_TRACK_ALLOCATIONS
+	::operator delete(mem);
+#else
 	free(mem);
+#endif
 }
 
 // You can modify this to use your logging facility.
@@ -38,12 +38,14 @@
 #include "box2d/b2_timer.h"
 #include "box2d/b2_world.h"
 
+#include <mutex>
 #include <new>
 
 b2World::b2World(const b2Vec2& gravity)
 {
 	m_destructionListener = nullptr;
 	m_debugDraw = nullptr;
+	m_taskExecutor = nullptr;
 
 	m_bodyList = nullptr;
 	m_jointList = nullptr;
@@ -107,6 +109,11 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactManager.m_contactListener = listener;
 }
 
+void b2World::SetTaskExecutor(b2TaskExecutor* executor)
+{
+	m_taskExecutor = executor;
+}
+
 void b2World::SetDebugDraw(b2Draw* debugDraw)
 {
 	m_debugDraw = debugDraw;
@@ -397,6 +404,43 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
+	if (m_taskExecutor)
+	{
+		SolveIslandsParallel(step);
+	}
+	else
+	{
+		SolveIslands(step);
+	}
+
+	{
+		b2Timer timer;
+		// Synchronize fixtures, check for out of range bodies.
+		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		{
+			// If a body was not in an island then it did not move.
+			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			{
+				continue;
+			}
+
+			if (b->GetType() == b2_staticBody)
+			{
+				continue;
+			}
+
+			// Update fixtures (for broad-phase).
+			b->SynchronizeFixtures();
+		}
+
+		// Look for new contacts.
+		m_contactManager.FindNewContacts();
+		m_profile.broadphase = timer.GetMilliseconds();
+	}
+}
+
+void b2World::SolveIslands(const b2TimeStep& step)
+{
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
@@ -554,31 +598,430 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 
 	m_stackAllocator.Free(stack);
+}
 
+// A range of the bodies, contacts, and joints recorded for one island.
+struct b2IslandRange
+{
+	int32 bodyStart;
+	int32 bodyCount;
+	int32 contactStart;
+	int32 contactCount;
+	int32 jointStart;
+	int32 jointCount;
+};
+
+// Serializes the post-solve callbacks of islands solved on several threads.
+class b2LockedContactListener : public b2ContactListener
+{
+public:
+	explicit b2LockedContactListener(b2ContactListener* listener)
 	{
-		b2Timer timer;
-		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		m_listener = listener;
+	}
+
+	void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_listener->PostSolve(contact, impulse);
+	}
+
+	b2ContactListener* m_listener;
+	std::mutex m_mutex;
+};
+
+// The stack allocator of a thread solving islands. The stack allocator of the
+// world belongs to the stepping thread, so every task thread needs its own.
+// It is too large to keep in thread local storage, so it lives on the heap.
+struct b2TaskStack
+{
+	b2TaskStack()
+	{
+		allocator = nullptr;
+	}
+
+	~b2TaskStack()
+	{
+		delete allocator;
+	}
+
+	b2StackAllocator* allocator;
+};
+
+static b2StackAllocator* b2GetTaskStackAllocator()
+{
+	static thread_local b2TaskStack stack;
+	if (stack.allocator == nullptr)
+	{
+		stack.allocator = new b2StackAllocator();
+	}
+	return stack.allocator;
+}
+
+// Find the group of an island, compressing the path as we go.
+static int32 b2FindIslandGroup(int32* parents, int32 index)
+{
+	while (parents[index] != index)
+	{
+		parents[index] = parents[parents[index]];
+		index = parents[index];
+	}
+	return index;
+}
+
+// Merge the groups of two islands. The root of a group is always its first
+// island, so that the groups are numbered deterministically.
+static void b2MergeIslandGroups(int32* parents, int32 indexA, int32 indexB)
+{
+	int32 rootA = b2FindIslandGroup(parents, indexA);
+	int32 rootB = b2FindIslandGroup(parents, indexB);
+	if (rootA < rootB)
+	{
+		parents[rootB] = rootA;
+	}
+	else if (rootB < rootA)
+	{
+		parents[rootA] = rootB;
+	}
+}
+
+// Solves groups of islands. The islands of a group share static bodies, and
+// the solver writes to the bodies of an island, so a group is solved serially.
+class b2IslandTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end) override
+	{
+		b2StackAllocator* allocator = b2GetTaskStackAllocator();
+		for (int32 g = begin; g < end; ++g)
 		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			// Size the island for the largest island of the group.
+			int32 bodyCapacity = 0;
+			int32 contactCapacity = 0;
+			int32 jointCapacity = 0;
+			for (int32 k = m_groupStarts[g]; k < m_groupStarts[g + 1]; ++k)
 			{
-				continue;
+				const b2IslandRange& range = m_islands[m_order[k]];
+				bodyCapacity = b2Max(bodyCapacity, range.bodyCount);
+				contactCapacity = b2Max(contactCapacity, range.contactCount);
+				jointCapacity = b2Max(jointCapacity, range.jointCount);
 			}
 
+			b2Island island(bodyCapacity, contactCapacity, jointCapacity, allocator, m_listener);
+
+			b2Profile& total = m_profiles[g];
+			total.solveInit = 0.0f;
+			total.solveVelocity = 0.0f;
+			total.solvePosition = 0.0f;
+			for (int32 k = m_groupStarts[g]; k < m_groupStarts[g + 1]; ++k)
+			{
+				const b2IslandRange& range = m_islands[m_order[k]];
+				island.Clear();
+				for (int32 i = 0; i < range.bodyCount; ++i)
+				{
+					island.Add(m_bodies[range.bodyStart + i]);
+				}
+				for (int32 i = 0; i < range.contactCount; ++i)
+				{
+					island.Add(m_contacts[range.contactStart + i]);
+				}
+				for (int32 i = 0; i < range.jointCount; ++i)
+				{
+					island.Add(m_joints[range.jointStart + i]);
+				}
+
+				b2Profile profile;
+				island.Solve(&profile, *m_step, m_gravity, m_allowSleep);
+				total.solveInit += profile.solveInit;
+				total.solveVelocity += profile.solveVelocity;
+				total.solvePosition += profile.solvePosition;
+			}
+		}
+	}
+
+	const b2TimeStep* m_step;
+	b2Vec2 m_gravity;
+	bool m_allowSleep;
+	b2ContactListener* m_listener;
+
+	const b2IslandRange* m_islands;
+	const int32* m_order;
+	const int32* m_groupStarts;
+	b2Body** m_bodies;
+	b2Contact** m_contacts;
+	b2Joint** m_joints;
+	b2Profile* m_profiles;
+};
+
+// This finds the islands exactly as SolveIslands does, but records them
+// instead of solving them. The islands are then solved by the task executor.
+// Islands that share a static body are grouped, as the solver writes to the
+// island index and the sweep of every body in the island. Each island is
+// solved with the same bodies, contacts, and joints in the same order as in
+// SolveIslands, so the result of a step does not depend on the executor.
+void b2World::SolveIslandsParallel(const b2TimeStep& step)
+{
+	// Clear all the island flags. The island index of a static body marks
+	// the first island that reached it.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_flags &= ~b2Body::e_islandFlag;
+		b->m_islandIndex = -1;
+	}
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		c->m_flags &= ~b2Contact::e_islandFlag;
+	}
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->m_islandFlag = false;
+	}
+
+	// A static body is recorded once for every island that reaches it, which
+	// needs a contact or a joint. There is at most one island per body.
+	int32 bodyCapacity = m_bodyCount + m_contactManager.m_contactCount + m_jointCount;
+	int32 contactCapacity = m_contactManager.m_contactCount;
+	int32 islandCapacity = m_bodyCount;
+
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(bodyCapacity * sizeof(b2Body*));
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(contactCapacity * sizeof(b2Contact*));
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	b2IslandRange* islands = (b2IslandRange*)m_stackAllocator.Allocate(islandCapacity * sizeof(b2IslandRange));
+	int32* parents = (int32*)m_stackAllocator.Allocate(islandCapacity * sizeof(int32));
+
+	int32 bodyCount = 0;
+	int32 contactCount = 0;
+	int32 jointCount = 0;
+	int32 islandCount = 0;
+
+	// Record all awake islands.
+	int32 stackSize = m_bodyCount;
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	{
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
+
+		if (seed->IsAwake() == false || seed->IsEnabled() == false)
+		{
+			continue;
+		}
+
+		// The seed can be dynamic or kinematic.
+		if (seed->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		b2IslandRange& range = islands[islandCount];
+		range.bodyStart = bodyCount;
+		range.contactStart = contactCount;
+		range.jointStart = jointCount;
+		parents[islandCount] = islandCount;
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		seed->m_flags |= b2Body::e_islandFlag;
+
+		// Perform a depth first search (DFS) on the constraint graph.
+		while (stackCount > 0)
+		{
+			// Grab the next body off the stack and add it to the island.
+			b2Body* b = stack[--stackCount];
+			b2Assert(b->IsEnabled() == true);
+			b2Assert(bodyCount < bodyCapacity);
+			bodies[bodyCount++] = b;
+
+			// To keep islands as small as possible, we don't
+			// propagate islands across static bodies. Islands that
+			// share a static body are solved together instead.
 			if (b->GetType() == b2_staticBody)
 			{
+				if (b->m_islandIndex < 0)
+				{
+					b->m_islandIndex = islandCount;
+				}
+				else
+				{
+					b2MergeIslandGroups(parents, b->m_islandIndex, islandCount);
+				}
 				continue;
 			}
 
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
+			// Make sure the body is awake (without resetting sleep timer).
+			b->m_flags |= b2Body::e_awakeFlag;
+
+			// Search all contacts connected to this body.
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			{
+				b2Contact* contact = ce->contact;
+
+				// Has this contact already been added to an island?
+				if (contact->m_flags & b2Contact::e_islandFlag)
+				{
+					continue;
+				}
+
+				// Is this contact solid and touching?
+				if (contact->IsEnabled() == false ||
+					contact->IsTouching() == false)
+				{
+					continue;
+				}
+
+				// Skip sensors.
+				bool sensorA = contact->m_fixtureA->m_isSensor;
+				bool sensorB = contact->m_fixtureB->m_isSensor;
+				if (sensorA || sensorB)
+				{
+					continue;
+				}
+
+				b2Assert(contactCount < contactCapacity);
+				contacts[contactCount++] = contact;
+				contact->m_flags |= b2Contact::e_islandFlag;
+
+				b2Body* other = ce->other;
+
+				// Was the other body already added to this island?
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+
+			// Search all joints connect to this body.
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				if (je->joint->m_islandFlag == true)
+				{
+					continue;
+				}
+
+				b2Body* other = je->other;
+
+				// Don't simulate joints connected to disabled bodies.
+				if (other->IsEnabled() == false)
+				{
+					continue;
+				}
+
+				b2Assert(jointCount < m_jointCount);
+				joints[jointCount++] = je->joint;
+				je->joint->m_islandFlag = true;
+
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
 		}
 
-		// Look for new contacts.
-		m_contactManager.FindNewContacts();
-		m_profile.broadphase = timer.GetMilliseconds();
+		range.bodyCount = bodyCount - range.bodyStart;
+		range.contactCount = contactCount - range.contactStart;
+		range.jointCount = jointCount - range.jointStart;
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = range.bodyStart; i < bodyCount; ++i)
+		{
+			b2Body* b = bodies[i];
+			if (b->GetType() == b2_staticBody)
+			{
+				b->m_flags &= ~b2Body::e_islandFlag;
+			}
+		}
+
+		++islandCount;
+	}
+
+	m_stackAllocator.Free(stack);
+
+	// Number the groups in the order of their first island. The root of a
+	// group comes before its other islands, so it is numbered first.
+	int32* groupIds = (int32*)m_stackAllocator.Allocate(islandCount * sizeof(int32));
+	int32 groupCount = 0;
+	for (int32 k = 0; k < islandCount; ++k)
+	{
+		int32 root = b2FindIslandGroup(parents, k);
+		groupIds[k] = root == k ? groupCount++ : groupIds[root];
+	}
+
+	// Sort the islands by group, keeping their order within a group.
+	int32* groupStarts = (int32*)m_stackAllocator.Allocate((groupCount + 1) * sizeof(int32));
+	int32* order = (int32*)m_stackAllocator.Allocate(islandCount * sizeof(int32));
+	for (int32 g = 0; g <= groupCount; ++g)
+	{
+		groupStarts[g] = 0;
+	}
+	for (int32 k = 0; k < islandCount; ++k)
+	{
+		++groupStarts[groupIds[k] + 1];
+	}
+	for (int32 g = 0; g < groupCount; ++g)
+	{
+		groupStarts[g + 1] += groupStarts[g];
+	}
+	for (int32 g = 0; g < groupCount; ++g)
+	{
+		// The parents are no longer needed, so they track the next free slot.
+		parents[g] = groupStarts[g];
+	}
+	for (int32 k = 0; k < islandCount; ++k)
+	{
+		order[parents[groupIds[k]]++] = k;
+	}
+
+	b2Profile* profiles = (b2Profile*)m_stackAllocator.Allocate(groupCount * sizeof(b2Profile));
+	b2LockedContactListener listener(m_contactManager.m_contactListener);
+
+	b2IslandTask task;
+	task.m_step = &step;
+	task.m_gravity = m_gravity;
+	task.m_allowSleep = m_allowSleep;
+	task.m_listener = m_contactManager.m_contactListener ? &listener : nullptr;
+	task.m_islands = islands;
+	task.m_order = order;
+	task.m_groupStarts = groupStarts;
+	task.m_bodies = bodies;
+	task.m_contacts = contacts;
+	task.m_joints = joints;
+	task.m_profiles = profiles;
+
+	if (groupCount == 1)
+	{
+		task.Execute(0, 1);
+	}
+	else if (groupCount > 1)
+	{
+		m_taskExecutor->ParallelFor(&task, groupCount);
 	}
+
+	for (int32 g = 0; g < groupCount; ++g)
+	{
+		m_profile.solveInit += profiles[g].solveInit;
+		m_profile.solveVelocity += profiles[g].solveVelocity;
+		m_profile.solvePosition += profiles[g].solvePosition;
+	}
+
+	m_stackAllocator.Free(profiles);
+	m_stackAllocator.Free(order);
+	m_stackAllocator.Free(groupStarts);
+	m_stackAllocator.Free(groupIds);
+	m_stackAllocator.Free(parents);
+	m_stackAllocator.Free(islands);
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(bodies);
 }
 
 // Find TOI contacts and solve them.
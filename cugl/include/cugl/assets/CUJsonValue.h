@@ -47,6 +47,7 @@
 #include <cJSON/cJSON.h>
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 namespace cugl {
 
@@ -108,6 +109,17 @@ public:
     
     /** The children of this node (only non-empty if array or object) */
     std::vector<std::shared_ptr<JsonValue>> _children;
+    
+    /**
+     * The positions of the children of this node, by key (only used if ObjectType)
+     *
+     * The index is built lazily on the first keyed lookup, and only if the
+     * object has more than a handful of children. Any method that reorders,
+     * removes or renames children must call {@link invalidateIndex}.
+     */
+    mutable std::unordered_map<std::string, size_t> _index;
+    /** Whether the key index is in sync with the children of this node */
+    mutable bool _indexed;
 
 #pragma mark -
 #pragma mark cJSON Conversions
@@ -153,6 +165,34 @@ public:
      */
     static cJSON* toCJSON(const JsonValue* value);
     
+#pragma mark -
+#pragma mark Key Index
+    /**
+     * Returns the position of the first child with the given key.
+     *
+     * Small objects are searched linearly. Larger objects build a key index
+     * on the first lookup and reuse it until the children change. If there
+     * is no child with this key, this method returns -1.
+     *
+     * Building the index modifies this node, so concurrent lookups on the same
+     * node from different threads are not safe.
+     *
+     * @param key   The key identifying the child
+     *
+     * @return the position of the first child with the given key.
+     */
+    int find(const std::string& key) const;
+    
+    /**
+     * Marks the key index of this node as stale.
+     *
+     * The index will be rebuilt on the next keyed lookup.
+     */
+    void invalidateIndex() {
+        _indexed = false;
+        _index.clear();
+    }
+    
 #pragma mark -
 #pragma mark Constructors
 public:
@@ -44,6 +44,8 @@
 #include <cugl/util/CUTimestamp.h>
 #include <unordered_map>
 #include <functional>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <deque>
 #include <queue>
@@ -54,6 +56,9 @@
 /** The default number of slots */
 #define DEFAULT_SLOTSIZE    16
 
+/** The number of pending commands between the main thread and the audio thread */
+#define DEFAULT_COMMANDSIZE 1024
+
 namespace cugl {
     /**
      * The audio graph classes.
@@ -69,6 +74,111 @@ namespace cugl {
         class AudioMixer;
         class AudioFader;
         class AudioPanner;
+
+#pragma mark -
+#pragma mark Audio Command Queue
+/**
+ * This class is a command sent from the main thread to the audio thread.
+ *
+ * Commands are addressed to a voice handle, not a key. A handle identifies
+ * both the slot of a sound effect and the instance played in that slot, so
+ * commands for a sound that has since been replaced are ignored.
+ */
+struct AudioCommand {
+    /** The supported commands */
+    enum class Type : Uint8 {
+        /** Binds the fader to the voice, setting its volume */
+        BIND,
+        /** Sets the volume of the voice */
+        VOLUME,
+        /** Sets the stereo pan of the voice */
+        PAN,
+        /** Pauses the voice, fading out for the given number of seconds */
+        PAUSE,
+        /** Resumes the voice */
+        RESUME,
+        /** Stops the voice, fading out for the given (positive) number of seconds */
+        CLEAR
+    };
+    
+    /** The command type */
+    Type type;
+    /** The voice handle */
+    Uint32 voice;
+    /** The command argument (volume, pan or fade) */
+    float value;
+    /** The fader to bind (BIND only) */
+    AudioFader* fader;
+};
+
+/**
+ * This class is a lock free single-producer, single-consumer command ring.
+ *
+ * Unlike {@link AudioNodeQueue}, this queue has a fixed capacity and never
+ * allocates once it is initialized, so the consumer may safely drain it
+ * in the audio callback. The producer is the main thread, while the
+ * consumer is the audio thread.
+ */
+class AudioCommandQueue {
+private:
+    /** The command buffer (a power of two in size) */
+    std::vector<AudioCommand> _buffer;
+    /** The capacity mask */
+    size_t _mask;
+    /** The index of the next command to read (owned by the consumer) */
+    std::atomic<size_t> _head;
+    /** The index of the next command to write (owned by the producer) */
+    std::atomic<size_t> _tail;
+    
+public:
+    /**
+     * Creates an empty command queue with no capacity
+     */
+    AudioCommandQueue() : _mask(0), _head(0), _tail(0) {}
+    
+    /**
+     * Allocates the command buffer, discarding any pending commands
+     *
+     * The capacity is rounded up to the next power of two. This method is
+     * not thread-safe, and should only be called when there is no consumer.
+     *
+     * @param capacity  The maximum number of pending commands
+     */
+    void init(size_t capacity);
+    
+    /**
+     * Returns true if the queue is empty.
+     *
+     * @return true if the queue is empty.
+     */
+    bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+    
+    /**
+     * Adds a command to the end of this queue.
+     *
+     * This method should only be called by the producer. It returns false
+     * (discarding the command) if the queue is full.
+     *
+     * @param command   The command to add
+     *
+     * @return true if the command was added
+     */
+    bool push(const AudioCommand& command);
+    
+    /**
+     * Removes a command from the front of this queue.
+     *
+     * This method should only be called by the consumer. It returns false
+     * if the queue is empty.
+     *
+     * @param command   The command to store the result
+     *
+     * @return true if a command was removed
+     */
+    bool pop(AudioCommand& command);
+};
     }
 
     /** AudioQueue for music support */
@@ -109,6 +219,13 @@ namespace cugl {
  * executed in the host thread.  If you need to access the AudioEngine in a
  * callback function, you should use the {@link Application#schedule} method
  * to delay until the main thread is next available.
+ *
+ * The main thread never touches the audio graph of an active sound effect.
+ * Changes to volume, pan and playback are sent to the audio thread through a
+ * lock free command queue, and applied at the start of the next audio read.
+ * Likewise, the state of each effect is published by the audio thread after
+ * every read. Hence queries like {@link #getState} may lag behind the most
+ * recent commands by one audio buffer.
  */
 class AudioEngine {
 #pragma mark Sound State
@@ -151,6 +268,37 @@ private:
     
     /** Map keys to identifiers */
     std::unordered_map<std::string,std::shared_ptr<audio::AudioFader>> _actives;
+    
+    /** The state of a sound effect as last set by the main thread */
+    struct Voice {
+        /** The voice handle (the generation in the upper bits, the slot in the lower 8) */
+        Uint32 handle;
+        /** The last volume sent to the audio thread */
+        float volume;
+        /** The last pan factor sent to the audio thread */
+        float pan;
+    };
+    
+    /** The fader bound to a slot, as seen by the audio thread */
+    struct Binding {
+        /** The voice handle of the bound fader */
+        Uint32 handle;
+        /** The bound fader (faders are pooled, so this outlives the sound) */
+        audio::AudioFader* fader;
+        /** Whether the scheduler has picked up the fader */
+        bool started;
+    };
+    
+    /** Map keys to voices (main thread only) */
+    std::unordered_map<std::string,Voice> _voices;
+    /** The number of sounds played in each slot (main thread only) */
+    std::vector<Uint32> _generations;
+    /** Commands from the main thread, applied before each audio read */
+    audio::AudioCommandQueue _commands;
+    /** The fader bound to each slot (audio thread only) */
+    std::vector<Binding> _bindings;
+    /** The voice handle and state of each slot, published after each audio read */
+    std::unique_ptr<std::atomic<Uint64>[]> _published;
     /** A queue for slot eviction if necessary */
     std::deque<std::string> _evicts;
 
@@ -287,6 +435,44 @@ private:
      */
     void gcollect(const std::shared_ptr<audio::AudioNode>& sound, bool status);
 
+    /**
+     * Assigns a new voice handle to the given key and binds it to the fader.
+     *
+     * The audio thread does not see the fader until it processes the bind
+     * command. Until then, all commands for the voice are queued behind it.
+     *
+     * @param key       The reference key for the sound effect
+     * @param fader     The fader wrapping the sound effect
+     * @param volume    The initial volume of the sound effect
+     */
+    void bindVoice(const std::string key, const std::shared_ptr<audio::AudioFader>& fader, float volume);
+
+    /**
+     * Sends a command for the voice with the given key to the audio thread.
+     *
+     * If the key does not correspond to an active sound effect, this method
+     * does nothing.
+     *
+     * @param key       The reference key for the sound effect
+     * @param type      The command type
+     * @param value     The command argument
+     */
+    void sendCommand(const std::string key, audio::AudioCommand::Type type, float value);
+
+    /**
+     * Applies all pending commands from the main thread.
+     *
+     * This method is called by the audio thread at the start of every read.
+     */
+    void applyCommands();
+
+    /**
+     * Publishes the state of every slot for the main thread.
+     *
+     * This method is called by the audio thread at the end of every read.
+     */
+    void publishState();
+
 #pragma mark -
 #pragma mark Static Accessors
 public:
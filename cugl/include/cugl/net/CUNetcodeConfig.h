@@ -116,6 +116,47 @@ public:
      */
     uint8_t apiVersion;
     
+    /**
+     * The physics synchronization budget in bytes per peer per update.
+     *
+     * When this value is positive, networked physics uses a prioritized
+     * scheduler that fills each synchronization packet up to this many bytes.
+     * Obstacles that miss the cut accumulate priority until they are sent. A
+     * value of 0 (the default) synchronizes every owned obstacle each update.
+     */
+    size_t syncBudget;
+    
+    /** The priority weight per unit of obstacle speed (default 1) */
+    float syncSpeedWeight;
+    
+    /** The priority weight for proximity to a peer's focus (default 4) */
+    float syncDistanceWeight;
+    
+    /** The priority weight per update since an obstacle was last sent (default 0.25) */
+    float syncStaleWeight;
+    
+    /** The priority multiplier for obstacles this machine does not own (default 0) */
+    float syncUnownedWeight;
+    
+    /**
+     * The number of ticks between world state hashes.
+     *
+     * When positive, peers exchange a hash of the networked world every this
+     * many ticks and report the first tick at which they diverge. A value of
+     * 0 (the default) disables desync detection.
+     */
+    uint32_t hashInterval;
+    
+    /**
+     * The number of ticks between authoritative state snapshots.
+     *
+     * When positive, the host sends a compact snapshot of the networked world
+     * and game state every this many ticks. Clients keep the latest one, so
+     * that a client promoted by host migration can restore it and take over.
+     * A value of 0 (the default) disables host migration.
+     */
+    uint32_t snapshotInterval;
+    
 #pragma mark Constructors
     /**
      * Creates a new configuration.
@@ -154,6 +195,11 @@ public:
      *      "max message":  An int respresenting the maximum transmission size
      *      "max players":  An int respresenting the maximum number of players
      *      "API version":  An int respresenting the API version
+     *      "sync budget":  An int representing the physics bytes per peer per update
+     *      "sync weights": An object with optional float keys "speed", "distance",
+     *                      "stale", and "unowned" for synchronization priority
+     *      "hash interval": An int representing the ticks between state hashes
+     *      "snapshot interval": An int representing the ticks between state snapshots
      *
      * @param prefs     The configuration settings
      */
@@ -235,6 +281,11 @@ public:
      *      "max message":  An int respresenting the maximum transmission size
      *      "max players":  An int respresenting the maximum number of players
      *      "API version":  An int respresenting the API version
+     *      "sync budget":  An int representing the physics bytes per peer per update
+     *      "sync weights": An object with optional float keys "speed", "distance",
+     *                      "stale", and "unowned" for synchronization priority
+     *      "hash interval": An int representing the ticks between state hashes
+     *      "snapshot interval": An int representing the ticks between state snapshots
      *
      * @param pref      The address settings
      *
@@ -110,6 +110,8 @@ protected:
     
     /** (Singular) callback function for state updates */
     std::function<void(Obstacle* obstacle)> _listener;
+    /** Whether the update of this obstacle may run on a worker thread */
+    bool _updateSafe;
     
     /** The physics body for Box2D. */
     b2Body* _body;
@@ -210,6 +212,18 @@ public:
      */
     virtual bool init(const Vec2 vec);
 
+    /**
+     * Restores this physics object to the state of a new object.
+     *
+     * This is the recycling hook used by {@link FreeList}. It clears the body
+     * and fixture definitions, the listener and the sharing state, and detaches
+     * the debug wireframe from its scene (the wireframe itself is kept so that
+     * it can be reused). The object may be initialized again afterwards.
+     *
+     * Physics must be deactivated before an object is reset.
+     */
+    virtual void reset();
+
     
 #pragma mark -
 #pragma mark BodyDef Methods
@@ -1285,6 +1299,38 @@ public:
     void setListener(const std::function<void(Obstacle* obstacle)>& listener) {
         _listener = listener;
     }
+
+    /**
+     * Returns true if the update of this obstacle may run on a worker thread.
+     *
+     * If an {@link ObstacleWorld} has a job system, it updates these obstacles
+     * in parallel after each physics step.  The update (including the listener)
+     * may only modify this obstacle and objects that belong to it alone, such
+     * as its scene graph node.  It may read other obstacles, but it must not
+     * add or remove scene graph nodes.  An obstacle whose shape is dirty is
+     * always updated on the calling thread.
+     *
+     * This value is false by default.
+     *
+     * @return true if the update of this obstacle may run on a worker thread.
+     */
+    bool isUpdateThreadSafe() const { return _updateSafe; }
+
+    /**
+     * Sets whether the update of this obstacle may run on a worker thread.
+     *
+     * If an {@link ObstacleWorld} has a job system, it updates these obstacles
+     * in parallel after each physics step.  The update (including the listener)
+     * may only modify this obstacle and objects that belong to it alone, such
+     * as its scene graph node.  It may read other obstacles, but it must not
+     * add or remove scene graph nodes.  An obstacle whose shape is dirty is
+     * always updated on the calling thread.
+     *
+     * This value is false by default.
+     *
+     * @param value whether the update of this obstacle may run on a worker thread.
+     */
+    void setUpdateThreadSafe(bool value) { _updateSafe = value; }
     
 #pragma mark -
 #pragma mark Render Snap
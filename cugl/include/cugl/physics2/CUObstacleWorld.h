@@ -49,6 +49,7 @@
 #include <box2d/b2_world.h>
 #include <box2d/b2_joint.h>
 #include <cugl/math/cu_math.h>
+#include <cugl/util/CUThreadPool.h>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
@@ -91,8 +92,12 @@ class Joint;
  * In addition, this class provides a modern callback approach supporting 
  * closures assigned to attributes.  This allows you to modify the callback 
  * functions while the program is running.
+ *
+ * If the world has a {@link JobSystem}, it solves independent islands of
+ * the physics step in parallel, and updates thread-safe obstacles in parallel
+ * after the step.  The result of a step is the same as without a job system.
  */
-class ObstacleWorld : public b2ContactListener, b2DestructionListener, b2ContactFilter {
+class ObstacleWorld : public b2ContactListener, b2DestructionListener, b2ContactFilter, b2TaskExecutor {
 protected:
     /** Reference to the Box2D world */
     b2World* _world;
@@ -126,6 +131,11 @@ protected:
     /** Whether or not to activate the destruction listener */
     bool _destroy;
 
+    /** The job system for parallel steps (or nullptr to step serially) */
+    std::shared_ptr<JobSystem> _jobs;
+    /** The obstacles to update in parallel (reused each step) */
+    std::vector<Obstacle*> _parallel;
+
     
 #pragma mark -
 #pragma mark Constructors
@@ -325,6 +335,38 @@ public:
      */
     void setGravity(const Vec2 gravity);
     
+    /**
+     * Returns the job system for parallel physics steps.
+     *
+     * If this value is nullptr, the world is stepped on the calling thread.
+     *
+     * @return the job system for parallel physics steps.
+     */
+    const std::shared_ptr<JobSystem>& getJobSystem() const { return _jobs; }
+
+    /**
+     * Sets the job system for parallel physics steps.
+     *
+     * With a job system, the islands of each step (groups of bodies that
+     * touch or are joined) are solved in parallel.  Islands that touch the
+     * same static body are solved together, so every island is solved just
+     * as on one thread, and the result of a step does not change.  However,
+     * the {@link #afterSolve} callback may run on a worker thread (though
+     * never at the same time as another callback).  The other callbacks
+     * still run on the calling thread.
+     *
+     * After the step, the obstacles that are {@link Obstacle#isUpdateThreadSafe}
+     * are updated in parallel.  All other obstacles are updated on the calling
+     * thread first.
+     *
+     * If this value is nullptr, the world is stepped on the calling thread.
+     * The job system should not be shared with long running jobs, as every
+     * step waits on its workers.
+     *
+     * @param jobs  The job system for parallel physics steps.
+     */
+    void setJobSystem(const std::shared_ptr<JobSystem>& jobs);
+
     /**
      * Executes a single step of the physics engine.
      *
@@ -536,6 +578,7 @@ public:
      * can be arbitrarily large if the sub-step is small. Hence the impulse is 
      * provided explicitly in a separate data structure.
      * Note: this is only called for contacts that are touching, solid, and awake.
+     * Note: if the world has a job system, this may be called on a worker thread.
      *
      * This attribute is a dynamically assignable callback and may be changed at
      * any given time.
@@ -746,6 +789,20 @@ public:
     }
 
 
+#pragma mark -
+#pragma mark Task Functions
+    /**
+     * Runs the items [0, count) of a Box2d task with the job system.
+     *
+     * This method is the static callback required by the Box2d API.  It should
+     * not be altered.  It is only called when the world has a job system.
+     *
+     * @param  task     the Box2d task to run
+     * @param  count    the number of items in the task
+     */
+    virtual void ParallelFor(b2Task* task, int32 count) override;
+
+
 #pragma mark -
 #pragma mark Query Functions
     /**
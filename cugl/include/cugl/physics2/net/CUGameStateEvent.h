@@ -32,6 +32,7 @@
 
 #include <cugl/physics2/net/CUNetEvent.h>
 #include <cugl/util/CUDebug.h>
+#include <vector>
 namespace cugl {
     /**
      * The classes to represent 2-d physics.
@@ -72,7 +73,15 @@ public:
         /** Pausing the game */
         GAME_PAUSE = 104, // Not used
         /** Resuming the game */
-        GAME_RESUME = 105 // Not used
+        GAME_RESUME = 105, // Not used
+        /** Sharing the world state hash of a tick */
+        STATE_HASH = 106,
+        /** Sharing the per-obstacle hashes of a divergent tick */
+        STATE_DIGEST = 107,
+        /** Sharing the authoritative state snapshot (kept for host migration) */
+        STATE_SNAPSHOT = 108,
+        /** Handing off the authoritative state after a host migration */
+        STATE_HANDOFF = 109
     };
     
 protected:
@@ -80,13 +89,23 @@ protected:
     EventType _type;
     /** The shortUID of the associated physics world */
     Uint32 _shortUID;
+    /** The hashing epoch (incremented each time hashing restarts) */
+    Uint32 _epoch;
+    /** The tick of the state hash */
+    Uint64 _tick;
+    /** The world state hash */
+    Uint32 _hash;
+    /** The per-obstacle hashes for a digest event */
+    std::vector<std::pair<Uint64,Uint32>> _digests;
+    /** The packed state for a snapshot or handoff event */
+    std::vector<std::byte> _snapshot;
     
 #pragma mark Constructors
 public:
     /**
      *  Constructs an event with default values.
      */
-    GameStateEvent() : _shortUID(0) {
+    GameStateEvent() : _shortUID(0), _epoch(0), _tick(0), _hash(0) {
         _type = EventType::GAME_START;
     }
     
@@ -95,7 +114,7 @@ public:
      *
      *  @param t The type of the event
      */
-    GameStateEvent(EventType t) : _shortUID(0) {
+    GameStateEvent(EventType t) : _shortUID(0), _epoch(0), _tick(0), _hash(0) {
         _type = t;
     }
 
@@ -164,6 +183,63 @@ public:
         return ptr;
     }
     
+    /**
+     * Returns a newly allocated event for sharing a world state hash
+     *
+     * @param epoch The hashing epoch
+     * @param tick  The tick the hash was computed at
+     * @param hash  The world state hash
+     */
+    static std::shared_ptr<NetEvent> allocStateHash(Uint32 epoch, Uint64 tick, Uint32 hash) {
+        std::shared_ptr<GameStateEvent> ptr = std::make_shared<GameStateEvent>();
+        ptr->setType(EventType::STATE_HASH);
+        ptr->_epoch = epoch;
+        ptr->_tick = tick;
+        ptr->_hash = hash;
+        return ptr;
+    }
+    
+    /**
+     * Returns a newly allocated event for sharing per-obstacle hashes
+     *
+     * This is sent once a divergence is detected, so that peers can report
+     * which obstacles differ.
+     *
+     * @param epoch     The hashing epoch
+     * @param tick      The tick the hashes were computed at
+     * @param digests   The obstacle ids and their hashes
+     */
+    static std::shared_ptr<NetEvent> allocStateDigest(Uint32 epoch, Uint64 tick,
+                                                      const std::vector<std::pair<Uint64,Uint32>>& digests) {
+        std::shared_ptr<GameStateEvent> ptr = std::make_shared<GameStateEvent>();
+        ptr->setType(EventType::STATE_DIGEST);
+        ptr->_epoch = epoch;
+        ptr->_tick = tick;
+        ptr->_digests = digests;
+        return ptr;
+    }
+    
+    /**
+     * Returns a newly allocated event for sharing the authoritative state
+     *
+     * The host sends these periodically so that every client holds a recent
+     * snapshot in case it is promoted. A promoted host sends a handoff event
+     * instead, which tells the remaining clients to restore it immediately.
+     *
+     * @param tick      The tick the snapshot was taken at
+     * @param snapshot  The packed state
+     * @param handoff   Whether this snapshot completes a host migration
+     */
+    static std::shared_ptr<NetEvent> allocStateSnapshot(Uint64 tick,
+                                                        const std::vector<std::byte>& snapshot,
+                                                        bool handoff = false) {
+        std::shared_ptr<GameStateEvent> ptr = std::make_shared<GameStateEvent>();
+        ptr->setType(handoff ? EventType::STATE_HANDOFF : EventType::STATE_SNAPSHOT);
+        ptr->_tick = tick;
+        ptr->_snapshot = snapshot;
+        return ptr;
+    }
+    
 #pragma mark Event Attributes
     /**
      * Returns the event type
@@ -195,6 +271,58 @@ public:
         return _shortUID;
     }
     
+    /**
+     * Returns the hashing epoch of a state hash or digest event
+     *
+     * @return the hashing epoch of a state hash or digest event
+     */
+    Uint32 getEpoch() const {
+        return _epoch;
+    }
+    
+    /**
+     * Returns the tick of a state hash, digest or snapshot event
+     *
+     * @return the tick of a state hash, digest or snapshot event
+     */
+    Uint64 getTick() const {
+        return _tick;
+    }
+    
+    /**
+     * Returns the world state hash
+     *
+     * If the event is not {@link EventType#STATE_HASH}, this method returns 0.
+     *
+     * @return the world state hash
+     */
+    Uint32 getHash() const {
+        return _hash;
+    }
+    
+    /**
+     * Returns the per-obstacle hashes
+     *
+     * If the event is not {@link EventType#STATE_DIGEST}, this is empty.
+     *
+     * @return the per-obstacle hashes
+     */
+    const std::vector<std::pair<Uint64,Uint32>>& getDigests() const {
+        return _digests;
+    }
+    
+    /**
+     * Returns the packed state
+     *
+     * If the event is not {@link EventType#STATE_SNAPSHOT} or
+     * {@link EventType#STATE_HANDOFF}, this is empty.
+     *
+     * @return the packed state
+     */
+    const std::vector<std::byte>& getSnapshot() const {
+        return _snapshot;
+    }
+    
 #pragma mark Serialization/Deserialization 
     /**
      * Returns a byte vector serializing this event
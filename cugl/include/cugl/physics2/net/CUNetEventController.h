@@ -50,13 +50,16 @@
 #include <cugl/physics2/net/CUNetWorld.h>
 #include <cugl/physics2/net/CUNetEvent.h>
 #include <cugl/physics2/net/CUNetPhysicsController.h>
+#include <cugl/physics2/net/CUNetEventRecorder.h>
 #include <cugl/assets/CUAssetManager.h>
 #include <cugl/base/CUApplication.h>
 #include <cugl/net/CUNetcodeConfig.h>
 #include <cugl/net/CUNetcodeConnection.h>
 #include <cugl/physics2/CUObstacle.h>
 #include <cugl/physics2/CUObstacleWorld.h>
+#include <cugl/util/CUTimestamp.h>
 #include <unordered_map>
+#include <map>
 #include <typeindex>
 #include <vector>
 #include <queue>
@@ -155,6 +158,8 @@ protected:
     std::queue<std::shared_ptr<NetEvent>> _reservedInEventQueue;
     /** Queue for all outbound events. Cleared every update */
     std::vector<std::shared_ptr<NetEvent>> _outEventQueue;
+    /** Queue for outbound events to a single peer. Cleared every update */
+    std::vector<std::pair<std::string, std::shared_ptr<NetEvent>>> _targetedOutQueue;
     
     /** Short user id assigned by the host during session */
     Uint32 _shortUID;
@@ -163,6 +168,39 @@ protected:
     /** The physics synchronization controller */
     std::shared_ptr<NetPhysicsController> _physController;
     
+    /** The world hashed for desync detection (nullptr if disabled) */
+    std::shared_ptr<NetWorld> _hashWorld;
+    /** The hashing epoch, incremented every time hashing is enabled */
+    Uint32 _hashEpoch;
+    /** The recent local state hashes by tick */
+    std::map<Uint64, Uint32> _localHashes;
+    /** The recent local per-obstacle hashes by tick */
+    std::map<Uint64, std::vector<std::pair<Uint64,Uint32>>> _localDigests;
+    /** The recent remote state hashes by tick and then by peer */
+    std::map<Uint64, std::unordered_map<std::string, Uint32>> _remoteHashes;
+    /** Whether a divergence was detected in this epoch */
+    bool _desynced;
+    /** The first divergent tick in this epoch */
+    Uint64 _desyncTick;
+    
+    /** The recorder for all wrapped traffic (nullptr if not recording) */
+    std::shared_ptr<NetEventRecorder> _recorder;
+    
+    /** The latest authoritative snapshot (restored on promotion) */
+    std::vector<std::byte> _snapshot;
+    /** The tick of the latest authoritative snapshot */
+    Uint64 _snapshotTick;
+    /** Whether the connection is migrating to a new host */
+    bool _migrating;
+    /** Whether this controller was promoted and still owes the handoff */
+    bool _handoffPending;
+    /** The moment the current host migration started */
+    Timestamp _migrationStart;
+    /** The time (in microseconds) to restore the snapshot on promotion */
+    Uint64 _restoreTime;
+    /** The time (in microseconds) from migration start to resumed authority */
+    Uint64 _handoffLatency;
+    
     /*
      * =================== Note for clarification ===================
      * Outbound events are generated locally and sent to peers.
@@ -230,8 +268,68 @@ protected:
      */
     bool checkConnection();
     
+    /**
+     * Compares the local state hash of a tick with those of the peers.
+     *
+     * On the first mismatch, this logs the tick and broadcasts the local
+     * per-obstacle hashes so that peers can report the divergent obstacles.
+     *
+     * @param tick  The tick to compare
+     */
+    void checkStateHash(Uint64 tick);
+    
+    /**
+     * Compares per-obstacle hashes from a peer with the local ones.
+     *
+     * This logs the ids of all obstacles that differ.
+     *
+     * @param e The received digest event
+     */
+    void processStateDigest(const std::shared_ptr<GameStateEvent>& e);
+    
+    /**
+     * Returns a snapshot of the networked world and the game state.
+     *
+     * The world is written by {@link NetWorld#writeSnapshot}, followed by
+     * anything written by {@link #onSaveState}.
+     *
+     * @return a snapshot of the networked world and the game state.
+     */
+    std::vector<std::byte> packSnapshot();
+    
+    /**
+     * Restores a snapshot created by {@link #packSnapshot}.
+     *
+     * @param snapshot  The snapshot to restore
+     */
+    void restoreSnapshot(const std::vector<std::byte>& snapshot);
+    
+    /**
+     * Responds to a promotion offer during host migration.
+     *
+     * This is the {@link cugl::net::NetcodeConnection#PromotionCallback} of
+     * the connection. This controller is a candidate if it is in game and
+     * holds a snapshot. When confirmed, it restores the snapshot and takes
+     * over as host within the same frame.
+     *
+     * @param confirmed Whether this connection is confirmed as the new host
+     *
+     * @return true if this controller is willing to become host
+     */
+    bool promoteToHost(bool confirmed);
+    
+    /**
+     * Completes a host handoff once the migration is finished.
+     *
+     * The promoted host sends its restored state to the remaining clients,
+     * which restore it immediately.
+     */
+    void completeHandoff();
+    
     /**
      * Broadcasts all queued outbound events.
+     *
+     * Events queued for a single peer are sent directly to that peer.
      */
     void sendQueuedOutData();
     
@@ -432,6 +530,10 @@ public:
      * with a listener, and then adds that scene node to a scene graph. See
      * {@link NetPhysicsController} for more information.
      *
+     * If the network configuration has a positive sync budget, the controller
+     * synchronizes with {@link NetPhysicsController::SyncType#PRIO_SYNC}.
+     * Otherwise it uses {@link NetPhysicsController::SyncType#FULL_SYNC}.
+     *
      * @param world The physics world to be synchronized.
      * @param linkFunc Function that links a scene node to an obstacle.
      */
@@ -442,6 +544,151 @@ public:
      */
     void disablePhysics();
     
+#pragma mark Desync Detection
+    /**
+     * Enables world state hashing for desync detection.
+     *
+     * Once enabled, {@link #hashState} hashes the world every
+     * {@link cugl::net::NetcodeConfig#hashInterval} ticks and shares the
+     * result with all peers. The first tick at which the hashes disagree is
+     * logged together with the ids of the obstacles that differ.
+     *
+     * Calling this method again (e.g. when the world is rebuilt for a new
+     * round) starts a new epoch and forgets all previous hashes. Hence all
+     * peers must call it the same number of times.
+     *
+     * @param world The physics world to hash
+     */
+    void enableStateHashing(const std::shared_ptr<NetWorld>& world);
+    
+    /**
+     * Disables world state hashing.
+     */
+    void disableStateHashing();
+    
+    /**
+     * Hashes the world state at the given tick, if it is a hashing tick.
+     *
+     * This method should be called after every simulation step, with a tick
+     * that all peers agree on. With lockstep simulation, this is the lockstep
+     * tick. With synchronized physics, {@link #getGameTick} may be used, but
+     * then the hash precision of the world must be coarse enough to absorb
+     * the network delay.
+     *
+     * @param tick  The simulation tick
+     */
+    void hashState(Uint64 tick);
+    
+    /**
+     * Returns true if a divergence was detected since hashing was enabled
+     *
+     * @return true if a divergence was detected since hashing was enabled
+     */
+    bool isDesynced() const { return _desynced; }
+    
+    /**
+     * Returns the first divergent tick since hashing was enabled
+     *
+     * This value is only meaningful if {@link #isDesynced} is true.
+     *
+     * @return the first divergent tick since hashing was enabled
+     */
+    Uint64 getDesyncTick() const { return _desyncTick; }
+    
+#pragma mark Host Migration
+    /**
+     * Callback to append game specific state to a snapshot.
+     *
+     * The networked world only knows about obstacles. Use this callback to
+     * add anything else a promoted host needs to take over, such as gameplay
+     * flags or AI targets.
+     */
+    std::function<void(LWSerializer& out)> onSaveState;
+    
+    /**
+     * Callback to restore the game specific state of a snapshot.
+     *
+     * This must read exactly what {@link #onSaveState} wrote.
+     */
+    std::function<void(LWDeserializer& in)> onRestoreState;
+    
+    /**
+     * Callback invoked when this controller becomes host by migration.
+     *
+     * It is called right after the snapshot is restored. The game should
+     * take ownership of the obstacles the old host simulated, and start
+     * any host-only logic.
+     */
+    std::function<void()> onPromotion;
+    
+    /**
+     * Returns true if this controller holds an authoritative snapshot
+     *
+     * Snapshots are only sent if {@link NetcodeConfig#snapshotInterval} is
+     * positive. Without one, this controller declines host promotion.
+     *
+     * @return true if this controller holds an authoritative snapshot
+     */
+    bool hasSnapshot() const { return !_snapshot.empty(); }
+    
+    /**
+     * Returns the tick of the latest authoritative snapshot
+     *
+     * @return the tick of the latest authoritative snapshot
+     */
+    Uint64 getSnapshotTick() const { return _snapshotTick; }
+    
+    /**
+     * Returns true if the connection is migrating to a new host
+     *
+     * No messages are sent during migration; outbound events are held.
+     *
+     * @return true if the connection is migrating to a new host
+     */
+    bool isMigrating() const { return _migrating; }
+    
+    /**
+     * Returns the time (in microseconds) to restore the last promotion snapshot
+     *
+     * @return the time (in microseconds) to restore the last promotion snapshot
+     */
+    Uint64 getRestoreTime() const { return _restoreTime; }
+    
+    /**
+     * Returns the time (in microseconds) of the last host handoff
+     *
+     * This is measured on the promoted host, from the start of the migration
+     * to the moment the restored state is sent to the remaining clients.
+     *
+     * @return the time (in microseconds) of the last host handoff
+     */
+    Uint64 getHandoffLatency() const { return _handoffLatency; }
+    
+#pragma mark Recording
+    /**
+     * Starts recording all network traffic with the given recorder.
+     *
+     * Every wrapped event received or sent by this controller is appended
+     * to the recorder log, together with the game tick.
+     *
+     * @param recorder  The recorder for the traffic
+     */
+    void startRecording(const std::shared_ptr<NetEventRecorder>& recorder) {
+        _recorder = recorder;
+    }
+    
+    /**
+     * Stops recording network traffic, flushing the log.
+     */
+    void stopRecording();
+    
+    /**
+     * Returns the active recorder (or nullptr if not recording)
+     *
+     * @return the active recorder (or nullptr if not recording)
+     */
+    std::shared_ptr<NetEventRecorder> getRecorder() const { return _recorder; }
+    
 #pragma mark Event Management
     /**
      * Attaches a new NetEvent type to the controller.
@@ -0,0 +1,245 @@
+//
+//  CUNetEventRecorder.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a recorder for the network traffic of a session. It
+//  appends every wrapped event sent or received by a NetEventController to a
+//  compact binary log, so that the traffic of real matches can be inspected
+//  and measured offline.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef __CU_NET_EVENT_RECORDER_H__
+#define __CU_NET_EVENT_RECORDER_H__
+
+#include <cugl/io/CUBinaryWriter.h>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <memory>
+
+/** The magic number at the start of every network log */
+#define CU_NETLOG_MAGIC     0x43554e52
+/** The version of the network log format */
+#define CU_NETLOG_VERSION   1
+/** The peer index of a broadcast in a network log */
+#define CU_NETLOG_BROADCAST 0xff
+
+namespace cugl {
+    /**
+     * The classes to represent 2-d physics.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add a 3-d physics engine as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace physics2 {
+
+        /**
+         * The classes to implement networked physics.
+         *
+         * This namespace represents an extension of our 2-d physics engine
+         * to support networking. This package provides automatic synchronization
+         * of physics objects across devices.
+         */
+        namespace net {
+
+/**
+ * This class records the wrapped network events of a session.
+ *
+ * Events are recorded exactly as {@link NetEventController} sends or receives
+ * them: a type byte, the sender timestamp, and the payload. Each record also
+ * stores the local game tick, so the original timing is preserved.
+ *
+ * The log is written through a large {@link BinaryWriter} buffer, so
+ * recording costs a memory copy per event and an occasional write. The
+ * format is compact. Peer UUIDs are written once and then referenced by a
+ * one byte index, and ticks are stored as deltas. A log has the header
+ *
+ *     Uint32 magic, Uint8 version
+ *
+ * followed by records of the following kinds
+ *
+ *     PEER:     Uint8 0, Uint8 index, Uint16 length, chars
+ *     INBOUND:  Uint8 1, Uint32 tick delta, Uint8 peer, Uint32 length, bytes
+ *     OUTBOUND: Uint8 2, Uint32 tick delta, Uint8 peer, Uint32 length, bytes
+ *
+ * The peer of an outbound record is {@link CU_NETLOG_BROADCAST} for a
+ * broadcast. All values are in network byte order.
+ */
+class NetEventRecorder {
+public:
+    /** The kind of a record in the log */
+    enum class Record : Uint8 {
+        /** The definition of a peer index */
+        PEER = 0,
+        /** An event received from a peer */
+        INBOUND = 1,
+        /** An event sent to a peer (or broadcast) */
+        OUTBOUND = 2
+    };
+    
+protected:
+    /** The buffered writer for the log file */
+    std::shared_ptr<BinaryWriter> _writer;
+    /** The indices of the peers seen so far */
+    std::unordered_map<std::string, Uint8> _peers;
+    /** The tick of the last recorded event */
+    Uint64 _lastTick;
+    /** The number of recorded events */
+    size_t _count;
+    /** The number of recorded payload bytes */
+    size_t _bytes;
+    
+    /**
+     * Returns the index of the given peer, writing its definition if needed
+     *
+     * @param peer  The peer UUID (empty for a broadcast)
+     *
+     * @return the index of the given peer
+     */
+    Uint8 getPeerIndex(const std::string& peer);
+    
+    /**
+     * Writes a single event record to the log
+     *
+     * @param kind  The record kind
+     * @param tick  The local game tick
+     * @param peer  The source or destination UUID (empty for a broadcast)
+     * @param data  The wrapped event
+     */
+    void writeEvent(Record kind, Uint64 tick, const std::string& peer,
+                    const std::vector<std::byte>& data);
+    
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate recorder with no log file.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    NetEventRecorder();
+    
+    /**
+     * Deletes this recorder, closing the log file.
+     */
+    ~NetEventRecorder() { dispose(); }
+    
+    /**
+     * Disposes this recorder, closing the log file.
+     *
+     * A disposed recorder can be safely reinitialized.
+     */
+    void dispose();
+    
+    /**
+     * Initializes a recorder that writes to the given file.
+     *
+     * Any existing file with this name is replaced.
+     *
+     * @param file  The path to the log file
+     *
+     * @return true if the log file was successfully opened
+     */
+    bool init(const std::string file);
+    
+    /**
+     * Returns a newly allocated recorder that writes to the given file.
+     *
+     * Any existing file with this name is replaced.
+     *
+     * @param file  The path to the log file
+     *
+     * @return a newly allocated recorder that writes to the given file.
+     */
+    static std::shared_ptr<NetEventRecorder> alloc(const std::string file) {
+        std::shared_ptr<NetEventRecorder> result = std::make_shared<NetEventRecorder>();
+        return (result->init(file) ? result : nullptr);
+    }
+    
+#pragma mark Recording
+    /**
+     * Records an event received from a peer.
+     *
+     * @param tick      The local game tick
+     * @param source    The UUID of the sender
+     * @param data      The wrapped event
+     */
+    void recordInbound(Uint64 tick, const std::string& source, const std::vector<std::byte>& data) {
+        writeEvent(Record::INBOUND, tick, source, data);
+    }
+    
+    /**
+     * Records an event sent to peers.
+     *
+     * @param tick  The local game tick
+     * @param dest  The UUID of the receiver (empty for a broadcast)
+     * @param data  The wrapped event
+     */
+    void recordOutbound(Uint64 tick, const std::string& dest, const std::vector<std::byte>& data) {
+        writeEvent(Record::OUTBOUND, tick, dest, data);
+    }
+    
+    /**
+     * Writes all buffered records to the log file.
+     */
+    void flush();
+    
+    /**
+     * Returns true if the log file is open for recording
+     *
+     * @return true if the log file is open for recording
+     */
+    bool isOpen() const { return _writer != nullptr; }
+    
+    /**
+     * Returns the number of events recorded so far
+     *
+     * @return the number of events recorded so far
+     */
+    size_t getEventCount() const { return _count; }
+    
+    /**
+     * Returns the number of event bytes recorded so far
+     *
+     * This only counts the wrapped events, not the record headers.
+     *
+     * @return the number of event bytes recorded so far
+     */
+    size_t getByteCount() const { return _bytes; }
+};
+
+        }
+    }
+}
+
+#endif /* __CU_NET_EVENT_RECORDER_H__ */
@@ -47,6 +47,8 @@
 #include "CUPhysSyncEvent.h"
 #include "CUGameStateEvent.h"
 #include "CUObstacleFactory.h"
+#include <cugl/net/CUNetcodeConfig.h>
+#include <unordered_set>
 #include <queue>
 
 namespace cugl {
@@ -136,10 +138,87 @@ public:
         OVERRIDE_FULL_SYNC,
         /** Synchronize all shared objects in the world */
         FULL_SYNC,
-        /** Prioritize syncing volatile objects */
+        /** Prioritize syncing volatile objects within a byte budget */
         PRIO_SYNC
     };
     
+    /**
+     * The synchronization statistics for a single peer.
+     *
+     * These statistics are only gathered by {@link SyncType#PRIO_SYNC}. The
+     * staleness of an obstacle is the number of prioritized synchronizations
+     * since it was last sent to the peer.
+     */
+    class PeerStats {
+    public:
+        /** The total number of bytes budgeted to this peer */
+        Uint64 totalBytes;
+        /** The number of bytes budgeted to this peer in the last update */
+        Uint32 lastBytes;
+        /** The number of obstacles sent to this peer in the last update */
+        Uint32 lastCount;
+        /** The largest obstacle staleness after the last update */
+        Uint64 maxStaleness;
+        /** The average obstacle staleness after the last update */
+        float avgStaleness;
+        
+        /** Creates a statistics set with default values */
+        PeerStats();
+    };
+    
+    
+#pragma mark Priority Scheduling
+protected:
+    /**
+     * The prioritized synchronization state of a single peer.
+     *
+     * The empty peer id represents a broadcast to all peers. It is used by
+     * clients, who have no direct route to other clients.
+     */
+    class PeerState {
+    public:
+        /** Whether the peer has a position of interest */
+        bool hasFocus;
+        /** The position of interest for this peer (e.g. its avatar) */
+        Vec2 focus;
+        /** The accumulated priority of each obstacle id */
+        std::unordered_map<Uint64, float> priority;
+        /** The synchronization count when each obstacle id was last sent */
+        std::unordered_map<Uint64, Uint64> lastSent;
+        
+        /** Creates a peer state with default values */
+        PeerState() : hasFocus(false) {}
+    };
+    
+    /** The byte budget per peer per synchronization (0 for unlimited) */
+    size_t _syncBudget;
+    /** The priority weight per unit of obstacle speed */
+    float _speedWeight;
+    /** The priority weight for proximity to the peer focus */
+    float _distanceWeight;
+    /** The priority weight per synchronization since last sent */
+    float _staleWeight;
+    /** The priority multiplier for obstacles not owned by this machine */
+    float _unownedWeight;
+    /** The number of prioritized synchronizations performed */
+    Uint64 _syncCount;
+    /** The scheduling state of each peer */
+    std::unordered_map<std::string, PeerState> _peerState;
+    /** The synchronization statistics of each peer */
+    std::unordered_map<std::string, PeerStats> _peerStats;
+    /** Vector of generated events to be sent to a specific peer */
+    std::vector<std::pair<std::string, std::shared_ptr<NetEvent>>> _targetedEvents;
+    
+    /**
+     * Packs a budgeted synchronization event for each peer.
+     *
+     * Each shared, non-static obstacle accumulates priority for each peer,
+     * weighted by speed, ownership, proximity to the peer focus and the time
+     * since it was last sent. The highest priority obstacles are then packed
+     * until the byte budget is reached, and their priority is reset.
+     */
+    void packPrioSync();
+    
     
 #pragma mark PhysicsController Stats
 protected:
@@ -337,6 +416,30 @@ public:
      */
     void ownAll();
     
+    /**
+     * Returns the physics world synchronized by this controller
+     *
+     * @return the physics world synchronized by this controller
+     */
+    const std::shared_ptr<NetWorld>& getWorld() const { return _world; }
+    
+    /**
+     * Returns true if this controller acts for the host
+     *
+     * @return true if this controller acts for the host
+     */
+    bool isHost() const { return _isHost; }
+    
+    /**
+     * Makes this controller act for the host after a host migration.
+     *
+     * Pending interpolation targets came from the old host, so they are
+     * dropped. Otherwise they would pull obstacles away from the restored
+     * snapshot. Ownership is not changed; the game decides which obstacles
+     * the new host takes over.
+     */
+    void promoteToHost();
+    
     /**
      * Returns true if the given obstacle is being interpolated.
      *
@@ -369,6 +472,71 @@ public:
         return _outEvents;
     }
     
+    /**
+     * Returns the vector of generated events to be sent to a single peer.
+     *
+     * Each entry pairs the UUID of the destination with the event. These
+     * events are generated by {@link SyncType#PRIO_SYNC} on the host.
+     *
+     * @return the vector of generated events to be sent to a single peer.
+     */
+    std::vector<std::pair<std::string, std::shared_ptr<NetEvent>>>& getTargetedOutEvents() {
+        return _targetedEvents;
+    }
+    
+    /**
+     * Configures the prioritized synchronization from the given settings.
+     *
+     * This method reads the byte budget and the priority weights. See
+     * {@link cugl::net::NetcodeConfig#syncBudget} for their meaning.
+     *
+     * @param config    The network configuration
+     */
+    void setSyncConfig(const cugl::net::NetcodeConfig& config);
+    
+    /**
+     * Returns the byte budget per peer per synchronization.
+     *
+     * A value of 0 means the budget is unlimited.
+     *
+     * @return the byte budget per peer per synchronization.
+     */
+    size_t getSyncBudget() const { return _syncBudget; }
+    
+    /**
+     * Sets the peers that receive prioritized synchronization.
+     *
+     * Each peer receives its own budgeted packet. If the set is empty, a
+     * single budgeted packet is broadcast to all peers instead. Peers not
+     * in this set have their scheduling state and statistics removed.
+     *
+     * @param peers The UUIDs of the peers with a direct route
+     */
+    void setPeers(const std::unordered_set<std::string>& peers);
+    
+    /**
+     * Sets the position of interest for the given peer.
+     *
+     * Obstacles near this position accumulate priority faster for that peer.
+     * This is typically the position of the avatar controlled by the peer.
+     * The position is ignored if the peer is not receiving synchronization.
+     *
+     * @param peer  The peer UUID
+     * @param pos   The position of interest in physics coordinates
+     */
+    void setPeerFocus(const std::string& peer, const Vec2 pos);
+    
+    /**
+     * Returns the synchronization statistics for each peer.
+     *
+     * The empty key holds the statistics for broadcast synchronization.
+     *
+     * @return the synchronization statistics for each peer.
+     */
+    const std::unordered_map<std::string, PeerStats>& getPeerStats() const {
+        return _peerStats;
+    }
+    
     /**
      * Updates the physics controller.
      */
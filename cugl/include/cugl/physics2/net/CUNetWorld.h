@@ -46,7 +46,11 @@
 #include <cugl/physics2/CUObstacle.h>
 #include <cugl/physics2/CUJoint.h>
 #include <cugl/physics2/CUObstacleWorld.h>
+#include <cugl/physics2/net/CULWSerializer.h>
+#include <cugl/physics2/net/CULWDeserializer.h>
 #include <unordered_map>
+#include <functional>
+#include <vector>
 
 namespace cugl {
     /**
@@ -107,6 +111,9 @@ protected:
     /** The next available id for shared joints */
     Uint32 _nextSharedJoint;
     
+    /** The size of the grid positions and velocities are snapped to before hashing */
+    float _hashPrecision;
+    
     /**
      * Activates this obstacle in the shared physics world
      *
@@ -568,6 +575,86 @@ public:
         return _ownedJoints;
     }
     
+#pragma mark -
+#pragma mark State Hashing
+    /**
+     * Callback to mix game specific state of an obstacle into the state hash.
+     *
+     * The physics state of an obstacle (position and velocity) is hashed
+     * automatically. Use this callback to add state the physics world does
+     * not know about, such as an animation state or a gameplay flag. The
+     * callback should return 0 if there is nothing to add.
+     */
+    std::function<Uint32(const std::shared_ptr<Obstacle>& obj)> onHashObstacle;
+    
+    /**
+     * Returns the precision of the state hash.
+     *
+     * Positions and velocities are snapped to a grid of this size before
+     * they are hashed, so that peers which agree up to this precision get
+     * the same hash.
+     *
+     * @return the precision of the state hash.
+     */
+    float getHashPrecision() const { return _hashPrecision; }
+    
+    /**
+     * Sets the precision of the state hash.
+     *
+     * Positions and velocities are snapped to a grid of this size before
+     * they are hashed, so that peers which agree up to this precision get
+     * the same hash.
+     *
+     * @param value the precision of the state hash.
+     */
+    void setHashPrecision(float value) { _hashPrecision = value; }
+    
+    /**
+     * Returns a hash of the current state of all shared obstacles.
+     *
+     * Each obstacle is hashed on its own, with the obstacle id mixed in, and
+     * the results are combined with addition. Hence the total does not depend
+     * on iteration order, and no sorting is needed even though the obstacles
+     * are stored in a hash map.
+     *
+     * If digests is not null, it receives the per-obstacle hashes. These can
+     * be compared with those of a peer to find the obstacles that diverged.
+     *
+     * @param digests   Optional vector to store the per-obstacle hashes
+     *
+     * @return a hash of the current state of all shared obstacles.
+     */
+    Uint32 computeStateHash(std::vector<std::pair<Uint64,Uint32>>* digests=nullptr);
+    
+#pragma mark -
+#pragma mark State Snapshots
+    /**
+     * Writes a snapshot of all shared dynamic obstacles to the serializer.
+     *
+     * The snapshot stores the id, position, velocity, angle, angular velocity
+     * and awake state of each obstacle, for 33 bytes per obstacle. Static
+     * obstacles never move, so they are skipped.
+     *
+     * @param out   The serializer to write to
+     *
+     * @return the number of obstacles written
+     */
+    Uint32 writeSnapshot(LWSerializer& out);
+    
+    /**
+     * Restores a snapshot written by {@link #writeSnapshot}.
+     *
+     * Obstacles are matched by id, and unknown ids are skipped. Obstacles
+     * owned by this world are skipped as well, as the local state is already
+     * authoritative for them. The deserializer is left at the end of the
+     * snapshot, so game specific data may follow it.
+     *
+     * @param in    The deserializer to read from
+     *
+     * @return the number of obstacles restored
+     */
+    Uint32 readSnapshot(LWDeserializer& in);
+    
 #pragma mark -
 #pragma mark Destruction Callback Functions
     /**
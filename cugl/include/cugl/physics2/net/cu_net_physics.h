@@ -33,6 +33,7 @@
 #include "CULWSerializer.h"
 #include "CUObstacleFactory.h"
 #include "CUNetPhysicsController.h"
+#include "CUNetEventRecorder.h"
 #include "CUNetEventController.h"
 
 #include "CUNetEvent.h"
@@ -125,6 +125,63 @@ class Path2;
  * {@link VertexBuffer}.
  */
 class SpriteBatch {
+#pragma mark Statistics
+public:
+    /**
+     * A class storing the drawing statistics of a sprite batch.
+     *
+     * Unlike {@link #getCallsMade} and {@link #getVerticesDrawn}, these values
+     * are not reset by {@link #begin}. They accumulate across all drawing passes
+     * until {@link #resetStats} is called, which makes it possible to measure
+     * the cost of a full frame that uses the batch for several passes.
+     *
+     * Every draw call after the first one in a pass is the result of a context
+     * change. The array {@link #reasons} records which attributes changed for
+     * each of these draw calls, so that it is possible to identify which nodes
+     * break batching. A single draw call may have more than one reason.
+     */
+    class Stats {
+    public:
+        /** The number of distinct flush reasons */
+        static const int REASONS = 15;
+        
+        /** The number of OpenGL draw calls */
+        unsigned int draws;
+        /** The number of vertices (indices) drawn */
+        unsigned int vertices;
+        /** The number of times the vertex data was uploaded */
+        unsigned int flushes;
+        /** The number of drawing passes (calls to {@link #begin}) */
+        unsigned int passes;
+        /** The number of texture binds */
+        unsigned int textureBinds;
+        /** The number of uniform uploads (including uniform block changes) */
+        unsigned int uniformUploads;
+        /** The number of times the shader was swapped */
+        unsigned int shaderSwaps;
+        /** The number of draw calls caused by each attribute change */
+        unsigned int reasons[REASONS];
+        
+        /**
+         * Creates a zeroed statistics record.
+         */
+        Stats() { reset(); }
+        
+        /**
+         * Resets all statistics to 0.
+         */
+        void reset();
+        
+        /**
+         * Returns a human readable name for the given flush reason.
+         *
+         * @param reason    The index into {@link #reasons}
+         *
+         * @return a human readable name for the given flush reason.
+         */
+        static const char* getReasonName(int reason);
+    };
+
 #pragma mark Values
 private:
     
@@ -185,6 +242,15 @@ private:
     unsigned int _vertTotal;
     /** The number of OpenGL calls in this pass (so far) */
     unsigned int _callTotal;
+    /** The statistics accumulated since the last call to resetStats() */
+    Stats _stats;
+    
+    /** Whether scene graph nodes should skip drawing outside of the view */
+    bool _culling;
+    /** The perspective matrix the view bounds were computed from */
+    mutable std::shared_ptr<Mat4> _cullPerspective;
+    /** The visible bounds of the current perspective, in world space */
+    mutable Rect _cullBounds;
     
 
 #pragma mark -
@@ -449,6 +515,21 @@ public:
      */
     unsigned int getCallsMade() const { return _callTotal; }
 
+    /**
+     * Returns the drawing statistics accumulated since the last reset.
+     *
+     * These values are not reset by begin(). Call {@link #resetStats} once per
+     * frame to get per-frame values.
+     *
+     * @return the drawing statistics accumulated since the last reset.
+     */
+    const Stats& getStats() const { return _stats; }
+
+    /**
+     * Resets the accumulated drawing statistics to 0.
+     */
+    void resetStats() { _stats.reset(); }
+
     /**
      * Sets the shader for this sprite batch
      *
@@ -509,6 +590,36 @@ public:
      */
     const Mat4& getPerspective() const;
     
+    /**
+     * Sets whether scene graph nodes should skip drawing outside of the view.
+     *
+     * When culling is enabled, a {@link scene2::SceneNode} whose content bounds
+     * do not intersect {@link #getCullBounds} is not drawn. Nodes marked with
+     * {@link scene2::SceneNode#setCullsChildren} skip their entire subtree.
+     * Culling is disabled by default.
+     *
+     * @param flag  Whether scene graph nodes should skip drawing outside of the view
+     */
+    void setCulling(bool flag) { _culling = flag; }
+    
+    /**
+     * Returns true if scene graph nodes should skip drawing outside of the view.
+     *
+     * @return true if scene graph nodes should skip drawing outside of the view.
+     */
+    bool isCulling() const { return _culling; }
+    
+    /**
+     * Returns the visible bounds of the active perspective matrix.
+     *
+     * These are the world space bounds of the clip space square under the
+     * inverse of the perspective matrix. They are only recomputed when the
+     * perspective changes.
+     *
+     * @return the visible bounds of the active perspective matrix.
+     */
+    const Rect& getCullBounds() const;
+    
     /**
      * Sets the active texture of this sprite batch
      *
@@ -79,7 +79,28 @@ class Shader;
  * for the type.
  */
 class VertexBuffer {
+public:
+    /**
+     * The strategy used to stream data with {@link #streamData}.
+     *
+     * The strategy is chosen by {@link #initStreaming} according to what the
+     * OpenGL driver supports, starting with the most efficient one.
+     */
+    enum class StreamMode {
+        /** Streaming is disabled; data is loaded with glBufferData */
+        NONE,
+        /** The buffers are orphaned and refilled with glBufferSubData */
+        ORPHAN,
+        /** A ring of regions is written with unsynchronized glMapBufferRange */
+        MAPPED,
+        /** A ring of regions is written through a persistent mapping */
+        PERSISTENT
+    };
+    
 private:
+    /** The number of regions in the streaming ring */
+    static const int STREAM_REGIONS = 3;
+    
     /**
      * A data type for keeping track of attribute data.
      *
@@ -121,6 +142,44 @@ private:
     /** The settings for each attribute */
     std::unordered_map<std::string, AttribData> _attributes;
     
+    /** The streaming strategy of this buffer */
+    StreamMode _streamMode;
+    /** The vertex capacity of a single streaming region */
+    GLsizei _streamVerts;
+    /** The index capacity of a single streaming region */
+    GLsizei _streamIndxs;
+    /** The current region of the streaming ring */
+    int _streamRegion;
+    /** The number of vertices written to the current region */
+    GLsizei _streamVertHead;
+    /** The number of indices written to the current region */
+    GLsizei _streamIndxHead;
+    /** The persistently mapped vertex memory (PERSISTENT mode only) */
+    GLubyte* _streamVertData;
+    /** The persistently mapped index memory (PERSISTENT mode only) */
+    GLuint*  _streamIndxData;
+    /** The fences guarding each region from being overwritten while in use */
+    GLsync _streamFences[STREAM_REGIONS];
+    
+#pragma mark Streaming Helpers
+    /**
+     * Advances the streaming ring to the next region.
+     *
+     * This method fences the current region (whose draw commands have all been
+     * issued) and then waits for the GPU to release the next region.
+     */
+    void advanceRegion();
+    
+    /**
+     * Copies the indices to the given destination, offset by base.
+     *
+     * @param dst       The destination memory
+     * @param indices   The indices to copy
+     * @param size      The number of indices
+     * @param base      The vertex offset to add to each index
+     */
+    static void copyIndices(GLuint* dst, const GLuint* indices, GLsizei size, GLuint base);
+    
 public:
 #pragma mark Constructors
     /**
@@ -313,6 +372,58 @@ public:
      */
     void loadIndexData(const void * data, GLsizei size, GLenum usage=GL_STREAM_DRAW);
     
+    /**
+     * Enables ring-buffered streaming for this vertex buffer.
+     *
+     * Loading data with glBufferData every flush can force the driver to
+     * synchronize with draws that are still in flight. In streaming mode,
+     * the vertex and index buffers are split into three regions that are
+     * filled in turn. Each region is guarded by a fence, so the CPU only
+     * waits if it laps the GPU.
+     *
+     * Persistent mapping is used if the driver supports buffer storage
+     * (OpenGL 4.4). Otherwise, regions are written with an unsynchronized
+     * glMapBufferRange, which is available on OpenGLES 3. If mapping fails,
+     * the buffers are orphaned instead.
+     *
+     * This method will only succeed if this buffer is actively bound.
+     *
+     * @param vertices  The maximum number of vertices in a single stream
+     * @param indices   The maximum number of indices in a single stream
+     *
+     * @return the streaming strategy chosen
+     */
+    StreamMode initStreaming(GLsizei vertices, GLsizei indices);
+    
+    /**
+     * Returns the streaming strategy of this buffer.
+     *
+     * @return the streaming strategy of this buffer.
+     */
+    StreamMode getStreamMode() const { return _streamMode; }
+    
+    /**
+     * Streams the given vertices and indices to this buffer.
+     *
+     * The data is appended to the current region of the streaming ring. The
+     * indices are rebased so that they refer to the streamed vertices. The
+     * value returned must be added to the offset of any draw command using
+     * this data.
+     *
+     * If streaming is not enabled, this method is the same as calling both
+     * {@link #loadVertexData} and {@link #loadIndexData}, and it returns 0.
+     *
+     * This method will only succeed if this buffer is actively bound.
+     *
+     * @param vertices  The vertices to stream
+     * @param vsize     The number of vertices (at most the streaming capacity)
+     * @param indices   The indices to stream
+     * @param isize     The number of indices (at most the streaming capacity)
+     *
+     * @return the index offset of the streamed data
+     */
+    GLsizei streamData(const void* vertices, GLsizei vsize, const GLuint* indices, GLsizei isize);
+    
     /**
      * Draws to the active framebuffer using this vertex buffer
      *
@@ -227,10 +227,14 @@ protected:
         static bool sortCompare(Context* a, Context* b);
     };
 
-    /** The render queue (always use a deque for this functionality) */
-    std::deque<Context*> _entries;
+    /** The render queue, in the frame arena (a vector keeps its capacity between frames) */
+    std::vector<Context*> _entries;
     /** The global scissor context (necessary as sprite batches manage this normally) */
     std::shared_ptr<Scissor> _viewport;
+    /** The visible bounds for culling (empty if the batch is not culling) */
+    Rect _cullBounds;
+    /** Whether descendants outside of the cull bounds are skipped */
+    bool _culling;
     /** The current render order */
     Order _order;
     
@@ -129,6 +129,8 @@ protected:
     bool  _hasParentColor;
     /** Whether this node is visible */
     bool  _isVisible;
+    /** Whether the content bounds of this node contain its entire subtree */
+    bool  _cullsChildren;
     
     /** An optional scissor value */
     std::shared_ptr<Scissor> _scissor;
@@ -908,6 +910,48 @@ public:
         return getNodeToParentTransform().transform(Rect(Vec2::ZERO, getContentSize()));
     }
     
+    /**
+     * Returns true if the content bounds of this node lie outside of the view.
+     *
+     * The transform should map node space to the space of the view (e.g. the
+     * global transform used by {@link #render}). Nodes with an empty content
+     * size are never considered outside, as they have no extent.
+     *
+     * @param transform The transform from node space to view space
+     * @param view      The visible bounds
+     *
+     * @return true if the content bounds of this node lie outside of the view.
+     */
+    bool isOutside(const Affine2& transform, const Rect& view) const {
+        Size size = getContentSize();
+        if (size.width == 0 || size.height == 0) {
+            return false;
+        }
+        return !view.doesIntersect(transform.transform(Rect(Vec2::ZERO, size)));
+    }
+    
+    /**
+     * Returns true if the content bounds of this node contain its entire subtree.
+     *
+     * If this is true and the sprite batch is culling, then the children of this
+     * node are skipped whenever this node is outside of the view. Otherwise, only
+     * the drawing of this node is skipped. This value is false by default.
+     *
+     * @return true if the content bounds of this node contain its entire subtree.
+     */
+    bool cullsChildren() const { return _cullsChildren; }
+    
+    /**
+     * Sets whether the content bounds of this node contain its entire subtree.
+     *
+     * If this is true and the sprite batch is culling, then the children of this
+     * node are skipped whenever this node is outside of the view. Otherwise, only
+     * the drawing of this node is skipped. This value is false by default.
+     *
+     * @param flag  Whether the content bounds of this node contain its entire subtree
+     */
+    void setCullsChildren(bool flag) { _cullsChildren = flag; }
+    
     /**
      * Returns true if point is in the bounds of this node and its ancestors.
      *
@@ -568,6 +568,13 @@ public:
     void setIsPlayer(bool player) { _isPlayer = player; }
     
     bool getIsPlayer() const { return _isPlayer; }
+    
+    /**
+     * Returns the y origin of this texture (used by the wheat cover shader).
+     *
+     * @return the y origin of this texture
+     */
+    float getOrigin() const { return _origin; }
 
     /**
      * Returns a string representation of this node for debugging purposes.
@@ -737,6 +744,20 @@ public:
      */
     void refresh() { clearRenderData(); generateRenderData(); }
 
+    /**
+     * Returns the render data for this node, generating it if necessary.
+     *
+     * The mesh is in the coordinate space of this node, and does not include
+     * the node tint. This allows a parent node to bake the mesh of a static
+     * subtree once rather than drawing each node every frame.
+     *
+     * @return the render data for this node.
+     */
+    const Mesh<SpriteVertex2>& getMesh() {
+        if (!_rendered) { generateRenderData(); }
+        return _mesh;
+    }
+
     
 protected:
     /**
@@ -0,0 +1,298 @@
+//
+//  CUAllocTracker.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides an allocation tracker for finding heap traffic in the
+//  game loop.  When CUGL is built with CU_TRACK_ALLOCATIONS (the CMake option
+//  CUGL_TRACK_ALLOCATIONS), the global operator new and delete are replaced so
+//  that every allocation is attributed to a subsystem tag, to the frame it was
+//  made in, and to the call stack that made it.  This covers std::make_shared
+//  and the standard containers, as they allocate with operator new.  The audio
+//  toolkit and Box2D are routed to the tracker by the same build option.
+//
+//  The tag of an allocation is the innermost CU_ALLOC_TAG scope of the thread
+//  that made it.  The engine marks the entry points of scene2, render,
+//  physics2, net, and audio.  Anything else is attributed to the general tag.
+//
+//  Without CU_TRACK_ALLOCATIONS this class only reports that it is disabled,
+//  and the tag scopes compile to nothing.  The tracker is meant for profiling
+//  builds, and should never be shipped.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef __CU_ALLOC_TRACKER_H__
+#define __CU_ALLOC_TRACKER_H__
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace cugl {
+
+#pragma mark -
+#pragma mark AllocTracker
+
+/**
+ * A static class attributing heap allocations to subsystems, frames, and
+ * call sites.
+ *
+ * All statistics are kept in lock-free counters, so the tracker may be used
+ * from any thread.  The per-frame statistics are those of every thread since
+ * the last call to {@link #beginFrame}.
+ *
+ * Call sites are the return addresses of the allocation, up to a depth of
+ * {@link #SITE_DEPTH} frames.  They are only recorded on Linux and macOS.
+ * On Linux, the program should be linked with -rdynamic so that the report
+ * can name the functions.  Otherwise the addresses can be resolved with
+ * addr2line.
+ */
+class AllocTracker {
+public:
+    /**
+     * The subsystem that made an allocation.
+     */
+    enum class Tag : uint8_t {
+        /** Any allocation outside of a tagged scope */
+        GENERAL  = 0,
+        /** The scene graph */
+        SCENE2   = 1,
+        /** The sprite batch and other rendering classes */
+        RENDER   = 2,
+        /** The physics world, including Box2D */
+        PHYSICS2 = 3,
+        /** The network connection and the network events */
+        NET      = 4,
+        /** The audio engine and the audio toolkit */
+        AUDIO    = 5
+    };
+
+    /** The number of tags */
+    static const size_t TAGS = 6;
+
+    /** The number of stack frames recorded for each call site */
+    static const size_t SITE_DEPTH = 8;
+
+    /**
+     * The allocation statistics of a single tag.
+     */
+    struct Stats {
+        /** The number of allocations */
+        size_t allocations;
+        /** The number of frees */
+        size_t frees;
+        /** The number of bytes allocated */
+        size_t bytes;
+        /** The number of bytes currently allocated */
+        size_t liveBytes;
+        /** The largest number of bytes allocated at once */
+        size_t peakBytes;
+        /** The number of allocations since the last call to beginFrame */
+        size_t frameAllocations;
+        /** The number of bytes allocated since the last call to beginFrame */
+        size_t frameBytes;
+        /** The number of allocations in the last frame */
+        size_t lastAllocations;
+        /** The number of bytes allocated in the last frame */
+        size_t lastBytes;
+        /** The largest number of allocations in one frame */
+        size_t maxAllocations;
+        /** The largest number of bytes allocated in one frame */
+        size_t maxBytes;
+    };
+
+    /**
+     * A scope attributing the allocations of the current thread to a tag.
+     *
+     * Scopes nest, and the previous tag is restored when the scope ends.
+     * Use the macro {@link CU_ALLOC_TAG} instead of this class, so that the
+     * scope vanishes when the tracker is disabled.
+     */
+    class Scope {
+    private:
+        /** The tag to restore when this scope ends */
+        Tag _previous;
+
+    public:
+        /**
+         * Attributes the allocations of this thread to the given tag.
+         *
+         * @param tag   The tag for allocations in this scope
+         */
+        explicit Scope(Tag tag) : _previous(setTag(tag)) {}
+
+        /**
+         * Restores the previous tag of this thread.
+         */
+        ~Scope() { setTag(_previous); }
+    };
+
+#pragma mark Tags
+    /**
+     * Returns true if CUGL was built with the allocation tracker.
+     *
+     * If this is false, every statistic is zero.
+     *
+     * @return true if CUGL was built with the allocation tracker
+     */
+    static bool isEnabled();
+
+    /**
+     * Returns the tag of the calling thread.
+     *
+     * @return the tag of the calling thread
+     */
+    static Tag getTag();
+
+    /**
+     * Sets the tag of the calling thread, returning the previous one.
+     *
+     * @param tag   The new tag of the calling thread
+     *
+     * @return the previous tag of the calling thread
+     */
+    static Tag setTag(Tag tag);
+
+    /**
+     * Returns the name of the given tag.
+     *
+     * @param tag   The tag to name
+     *
+     * @return the name of the given tag
+     */
+    static const char* getTagName(Tag tag);
+
+#pragma mark Statistics
+    /**
+     * Returns the statistics of the given tag.
+     *
+     * @param tag   The tag to query
+     *
+     * @return the statistics of the given tag
+     */
+    static Stats getStats(Tag tag);
+
+    /**
+     * Returns the statistics of all tags combined.
+     *
+     * The peak and the per-frame maximums are the sums of those of each tag,
+     * so they are an upper bound for the combined values.
+     *
+     * @return the statistics of all tags combined
+     */
+    static Stats getTotals();
+
+    /**
+     * Marks the start of a new frame.
+     *
+     * The allocations since the last call become the statistics of the last
+     * frame.  This should be called once per frame by the main thread.
+     */
+    static void beginFrame();
+
+#pragma mark Reporting
+    /**
+     * Returns a text report of the tags and the top call sites.
+     *
+     * The call sites are sorted by the number of bytes they allocated.
+     *
+     * @param sites The number of call sites to report
+     *
+     * @return a text report of the tags and the top call sites
+     */
+    static std::string getReport(size_t sites);
+
+    /**
+     * Writes the report of {@link #getReport} to the given file.
+     *
+     * @param path  The file to write
+     * @param sites The number of call sites to report
+     *
+     * @return true if the file was written
+     */
+    static bool dump(const std::string& path, size_t sites);
+
+    /**
+     * Asks the application to dump a report at its next opportunity.
+     *
+     * This is safe to call from a signal handler.  In a tracking build on
+     * Linux and macOS, it is installed as the handler of SIGUSR1, so that a
+     * headless run can be sampled with kill -USR1.
+     */
+    static void requestDump();
+
+    /**
+     * Returns true if a dump was requested, clearing the request.
+     *
+     * @return true if a dump was requested
+     */
+    static bool takeDumpRequest();
+
+#pragma mark Allocation
+    /**
+     * Returns a tracked allocation of the given size and alignment.
+     *
+     * The allocation is attributed to the given tag.  It must be freed with
+     * {@link #deallocate}.  This method returns nullptr if the allocation
+     * fails.
+     *
+     * @param bytes The number of bytes to allocate
+     * @param align The alignment, which must be a power of two
+     * @param tag   The tag of the allocation
+     *
+     * @return a tracked allocation of the given size and alignment
+     */
+    static void* allocate(size_t bytes, size_t align, Tag tag);
+
+    /**
+     * Returns a tracked allocation resized to the given size.
+     *
+     * This has the semantics of realloc.  The memory must have been allocated
+     * with the default alignment.
+     *
+     * @param ptr   The allocation to resize (or nullptr)
+     * @param bytes The new size of the allocation
+     * @param tag   The tag of the new allocation
+     *
+     * @return a tracked allocation resized to the given size
+     */
+    static void* reallocate(void* ptr, size_t bytes, Tag tag);
+
+    /**
+     * Frees a tracked allocation.
+     *
+     * @param ptr   The allocation to free (or nullptr)
+     */
+    static void deallocate(void* ptr);
+};
+
+}
+
+#define CU_ALLOC_CONCAT_INNER(a, b) a##b
+#define CU_ALLOC_CONCAT(a, b) CU_ALLOC_CONCAT_INNER(a, b)
+
+#ifdef CU_TRACK_ALLOCATIONS
+/** Attributes the allocations of the rest of the enclosing scope to a tag */
+#define CU_ALLOC_TAG(tag) \
+    cugl::AllocTracker::Scope CU_ALLOC_CONCAT(_alloctag, __LINE__)(cugl::AllocTracker::Tag::tag)
+#else
+/** Attributes the allocations of the rest of the enclosing scope to a tag */
+#define CU_ALLOC_TAG(tag)
+#endif
+
+#endif /* __CU_ALLOC_TRACKER_H__ */
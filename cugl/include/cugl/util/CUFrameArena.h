@@ -0,0 +1,301 @@
+//
+//  CUFrameArena.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides a linear (bump) allocator for short-lived data.  Many
+//  parts of the render loop allocate small objects that are only needed for
+//  part of a frame, such as render queue entries and recorded uniforms.  An
+//  arena hands out this memory by advancing an offset into a block that is
+//  allocated once, and reclaims all of it at once when it is reset.
+//
+//  Each thread has its own arena.  The application should reset the arena of
+//  the main thread at the start of each phase of the game loop.  Memory from
+//  an arena must never be kept past the next reset.
+//
+//  If a frame needs more memory than the arena has, the arena grows by
+//  allocating another block.  On the next reset the blocks are replaced by a
+//  single block large enough for the whole frame, so that a game in a steady
+//  state makes no heap allocations for this data.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef __CU_FRAME_ARENA_H__
+#define __CU_FRAME_ARENA_H__
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace cugl {
+
+#pragma mark -
+#pragma mark FrameArena
+
+/**
+ * A linear allocator for data that only lives for part of a frame.
+ *
+ * Allocation is a pointer bump, and there is no way to free a single
+ * allocation.  Instead, {@link #reset} reclaims everything at once.  Objects
+ * created with {@link #make} are not destroyed by a reset.  If they are not
+ * trivially destructible, their owner must call the destructor itself.
+ *
+ * An arena is not thread-safe.  Use {@link #get} to access the arena of the
+ * calling thread.
+ */
+class FrameArena {
+private:
+    /** A block of heap memory owned by the arena */
+    struct Block {
+        /** The start of the block */
+        std::byte* data;
+        /** The size of the block in bytes */
+        size_t size;
+    };
+
+    /** The blocks of this arena; the last block is the active one */
+    std::vector<Block> _blocks;
+    /** The offset of the next free byte in the active block */
+    size_t _offset;
+    /** The bytes handed out since the last reset (including padding) */
+    size_t _usage;
+    /** The largest usage of any frame */
+    size_t _peak;
+    /** The number of allocations since the last reset */
+    size_t _allocations;
+    /** The number of allocations over the lifetime of this arena */
+    size_t _totalAllocations;
+    /** The number of blocks this arena has allocated from the heap */
+    size_t _heapBlocks;
+
+    /**
+     * Adds a block of at least the given size to this arena.
+     *
+     * @param bytes The minimum size of the new block
+     */
+    void grow(size_t bytes);
+
+    /** This class holds heap memory, so it cannot be copied */
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+public:
+    /** The initial capacity of the arena of each thread */
+    static const size_t INITIAL_CAPACITY;
+
+#pragma mark Constructors
+    /**
+     * Creates an arena with no memory.
+     *
+     * The arena allocates its first block on first use.
+     */
+    FrameArena();
+
+    /**
+     * Deletes this arena, releasing all of its memory.
+     */
+    ~FrameArena() { dispose(); }
+
+    /**
+     * Releases all of the memory of this arena.
+     *
+     * Every allocation from this arena is invalid afterwards.
+     */
+    void dispose();
+
+    /**
+     * Initializes this arena with a block of the given size.
+     *
+     * @param capacity  The initial capacity in bytes
+     *
+     * @return true if the arena was initialized properly
+     */
+    bool init(size_t capacity);
+
+    /**
+     * Returns the arena of the calling thread.
+     *
+     * The arena is created with {@link #INITIAL_CAPACITY} the first time a
+     * thread calls this method.
+     *
+     * @return the arena of the calling thread
+     */
+    static FrameArena* get();
+
+#pragma mark Allocation
+    /**
+     * Returns uninitialized memory of the given size and alignment.
+     *
+     * The memory is valid until the next call to {@link #reset}.
+     *
+     * @param bytes The number of bytes to allocate
+     * @param align The alignment, which must be a power of two
+     *
+     * @return uninitialized memory of the given size and alignment
+     */
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+    /**
+     * Returns an uninitialized array of the given length.
+     *
+     * This should only be used for trivial types, like floats.
+     *
+     * @param length    The number of elements
+     *
+     * @return an uninitialized array of the given length
+     */
+    template <typename T>
+    T* allocArray(size_t length) {
+        return static_cast<T*>(allocate(length*sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Returns a new object constructed in this arena.
+     *
+     * The object is not destroyed by {@link #reset}.  If it is not trivially
+     * destructible, the caller must invoke its destructor before the reset.
+     *
+     * @param args  The constructor arguments
+     *
+     * @return a new object constructed in this arena
+     */
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Reclaims every allocation of this arena.
+     *
+     * If the arena had to grow since the last reset, its blocks are replaced
+     * by a single block large enough for all of them.
+     */
+    void reset();
+
+#pragma mark Statistics
+    /**
+     * Returns the total size of the blocks of this arena in bytes.
+     *
+     * @return the total size of the blocks of this arena in bytes
+     */
+    size_t getCapacity() const;
+
+    /**
+     * Returns the number of bytes handed out since the last reset.
+     *
+     * @return the number of bytes handed out since the last reset
+     */
+    size_t getUsage() const { return _usage; }
+
+    /**
+     * Returns the largest number of bytes handed out between two resets.
+     *
+     * @return the largest number of bytes handed out between two resets
+     */
+    size_t getPeakUsage() const { return _peak; }
+
+    /**
+     * Returns the number of allocations since the last reset.
+     *
+     * @return the number of allocations since the last reset
+     */
+    size_t getAllocations() const { return _allocations; }
+
+    /**
+     * Returns the number of allocations over the lifetime of this arena.
+     *
+     * Unlike {@link #getAllocations}, this is not cleared by a reset, so it
+     * can measure allocations across several phases of a frame.
+     *
+     * @return the number of allocations over the lifetime of this arena
+     */
+    size_t getTotalAllocations() const { return _totalAllocations; }
+
+    /**
+     * Returns the number of blocks this arena has allocated from the heap.
+     *
+     * This number stops changing once the arena is large enough for every
+     * frame.
+     *
+     * @return the number of blocks this arena has allocated from the heap
+     */
+    size_t getHeapBlocks() const { return _heapBlocks; }
+};
+
+#pragma mark -
+#pragma mark ArenaAllocator
+
+/**
+ * A standard allocator that takes its memory from a {@link FrameArena}.
+ *
+ * This allows standard containers and std::allocate_shared to use an arena.
+ * Deallocation does nothing; the memory is reclaimed when the arena is reset.
+ * Anything using this allocator must be destroyed before the reset.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    /** The allocated type */
+    typedef T value_type;
+
+    /** The arena to allocate from */
+    FrameArena* arena;
+
+    /**
+     * Creates an allocator for the given arena.
+     *
+     * @param arena The arena to allocate from
+     */
+    explicit ArenaAllocator(FrameArena* arena) : arena(arena) {}
+
+    /**
+     * Creates an allocator for the arena of another allocator.
+     *
+     * @param other The allocator to copy
+     */
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    /**
+     * Returns uninitialized memory for the given number of objects.
+     *
+     * @param n The number of objects
+     *
+     * @return uninitialized memory for the given number of objects
+     */
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n*sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Does nothing, as arena memory is reclaimed on reset.
+     */
+    void deallocate(T*, size_t) {}
+
+    /** Returns true if the allocators share an arena */
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+
+    /** Returns true if the allocators do not share an arena */
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+}
+#endif /* __CU_FRAME_ARENA_H__ */
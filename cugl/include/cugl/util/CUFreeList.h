@@ -376,12 +376,12 @@ void FreeList<T>::clear() {
     }
     
     // Clear the preallocated
-    for(int ii =0; ii < _capacity; ii++) {
+    for(size_t ii = 0; ii < _capacity; ii++) {
         _prealloc[ii].reset();
     }
     
     // Clear everything else
-    while (!_expansion.empty()) {
+    while (!_freeobjs.empty()) {
         _freeobjs.pop();
     }
     
@@ -10,6 +10,11 @@
 //  the code for asynchronous asset loading. We generalized that class added
 //  some notable safety changes.
 //
+//  The thread pool is now a facade over a work-stealing job system. The job
+//  system gives each worker its own queue, stores small jobs without any heap
+//  allocation, and supports fork-join through job counters. This allows frame
+//  work to be fanned out across all of the cores of a device.
+//
 //  CUGL MIT License:
 //      This software is provided 'as-is', without any express or implied
 //      warranty.  In no event will the authors be held liable for any damages
@@ -36,8 +41,14 @@
 #define __CU_THREAD_POOL_H__
 #include <cugl/base/CUBase.h>
 #include <condition_variable>
+#include <type_traits>
 #include <functional>
+#include <algorithm>
+#include <cstddef>
 #include <stdio.h>
+#include <atomic>
+#include <memory>
+#include <new>
 #include <queue>
 #include <vector>
 #include <thread>
@@ -47,71 +58,493 @@
     #define CU_SDL_THREADS 1
 #endif
 
+/** The number of bytes a job may capture without allocating */
+#define CU_JOB_STORAGE  64
+
 namespace cugl {
 
 #pragma mark -
-#pragma mark Thread Pool
+#pragma mark Job System
 
 /**
- *  Class to providing a collection of worker threads.
+ * Class providing a work-stealing job system.
  *
- *  This is a general purpose class for performing tasks asynchronously.  There 
- *  is no notification process for when a task is complete.  Instead, your task 
- *  should either set a flag, or execute a callback when it is done.
+ * A job is a void function with no parameters, like a task for a
+ * {@link ThreadPool}. However, jobs are intended for fanning out work that
+ * must finish within a frame, such as updating a large number of objects.
+ * To support this, a job may be assigned a {@link Counter} when it is
+ * submitted. The method {@link #wait} blocks until every job assigned to a
+ * counter is complete, running pending jobs on the calling thread while it
+ * waits. Jobs may submit (and wait on) other jobs, which is how fork-join
+ * parallelism is expressed. The method {@link #parallel_for} is a convenience
+ * built on top of this.
  *
- *  There are some important safety considerations for using this class over
- *  direct thread objects. For example, stopping a thread pool does not shut it 
- *  down immediately; it just marks it for shutdown.  Because of mutex locks, 
- *  it is not safe to delete a thread pool until it is completely shutdown.
+ * Each worker thread has its own job queue. Jobs submitted by a worker are
+ * added to its own queue, and are run in last-in first-out order for cache
+ * locality. Jobs submitted by any other thread (such as the main thread) are
+ * added to a shared queue, and are run in first-in first-out order. A worker
+ * with nothing to do steals the oldest job from the other queues.
  *
- *  More importantly, we do not allow for detached threads. This makes no sense
- *  in this application, because the threads share a resource (_taskQueue) with 
- *  the main thread that will be deleted.  It is therefore unsafe for the 
- *  threads to ever detach.
+ * Jobs store their function inline when it fits in {@link CU_JOB_STORAGE}
+ * bytes, which is enough for a lambda capturing several pointers. Unlike
+ * std::function, submitting such a job never allocates.
  *
- *  See the class {@link AssetManager} for an example of how to use a thread 
- *  pool.
+ * As with {@link ThreadPool}, stopping a job system does not run the jobs
+ * still in the queues. Counters for those jobs will never complete.
  */
-class ThreadPool {
+class JobSystem {
+#pragma mark Jobs
+public:
+    /**
+     * A counter tracking a group of jobs.
+     *
+     * A counter is incremented when a job is submitted with it, and
+     * decremented when that job completes. A counter must outlive all of
+     * the jobs submitted with it.
+     */
+    class Counter {
+    private:
+        /** The number of incomplete jobs */
+        std::atomic<Uint32> _pending;
+        
+        friend class JobSystem;
+        
+    public:
+        /**
+         * Creates a counter with no pending jobs
+         */
+        Counter() : _pending(0) {}
+        
+        /**
+         * Returns true if every job assigned to this counter is complete.
+         *
+         * @return true if every job assigned to this counter is complete.
+         */
+        bool done() const { return _pending.load(std::memory_order_acquire) == 0; }
+        
+        /**
+         * Returns the number of incomplete jobs assigned to this counter
+         *
+         * @return the number of incomplete jobs assigned to this counter
+         */
+        Uint32 pending() const { return _pending.load(std::memory_order_acquire); }
+    };
+    
+    /**
+     * A type-erased job function with inline storage.
+     *
+     * A job is move-only. Functions that do not fit in {@link CU_JOB_STORAGE}
+     * bytes (or that are over-aligned) are stored on the heap instead.
+     */
+    class Job {
+    private:
+        /** The inline storage for the function (or a pointer to it) */
+        alignas(std::max_align_t) unsigned char _storage[CU_JOB_STORAGE];
+        /** Calls the stored function */
+        void (*_invoke)(void*);
+        /** Moves the stored function from the second argument to the first */
+        void (*_relocate)(void*, void*);
+        /** Destroys the stored function */
+        void (*_destroy)(void*);
+        /** The counter to decrement on completion (may be null) */
+        Counter* _counter;
+        
+        /** The operations for a function stored inline */
+        template <typename F>
+        struct Inline {
+            static void invoke(void* data) { (*static_cast<F*>(data))(); }
+            static void relocate(void* dst, void* src) {
+                new (dst) F(std::move(*static_cast<F*>(src)));
+                static_cast<F*>(src)->~F();
+            }
+            static void destroy(void* data) { static_cast<F*>(data)->~F(); }
+        };
+        
+        /** The operations for a function stored on the heap */
+        template <typename F>
+        struct Boxed {
+            static void invoke(void* data) { (**static_cast<F**>(data))(); }
+            static void relocate(void* dst, void* src) {
+                *static_cast<F**>(dst) = *static_cast<F**>(src);
+                *static_cast<F**>(src) = nullptr;
+            }
+            static void destroy(void* data) { delete *static_cast<F**>(data); }
+        };
+        
+        /** Stores a function inline */
+        template <typename Func, typename F>
+        void emplace(F&& func, std::true_type) {
+            new (_storage) Func(std::forward<F>(func));
+            _invoke   = &Inline<Func>::invoke;
+            _relocate = &Inline<Func>::relocate;
+            _destroy  = &Inline<Func>::destroy;
+        }
+        
+        /** Stores a function on the heap */
+        template <typename Func, typename F>
+        void emplace(F&& func, std::false_type) {
+            *reinterpret_cast<Func**>(_storage) = new Func(std::forward<F>(func));
+            _invoke   = &Boxed<Func>::invoke;
+            _relocate = &Boxed<Func>::relocate;
+            _destroy  = &Boxed<Func>::destroy;
+        }
+        
+    public:
+        /**
+         * Creates an empty job
+         */
+        Job() : _invoke(nullptr), _relocate(nullptr), _destroy(nullptr), _counter(nullptr) {}
+        
+        /**
+         * Creates a job for the given function
+         *
+         * @param func      The job function
+         * @param counter   The counter to decrement on completion (may be null)
+         */
+        template <typename F>
+        Job(F&& func, Counter* counter) : _counter(counter) {
+            typedef typename std::decay<F>::type Func;
+            typedef std::integral_constant<bool, sizeof(Func) <= CU_JOB_STORAGE &&
+                                                 alignof(Func) <= alignof(std::max_align_t) &&
+                                                 std::is_nothrow_move_constructible<Func>::value> Fits;
+            emplace<Func>(std::forward<F>(func), Fits());
+        }
+        
+        /**
+         * Creates a job by taking the function of another
+         *
+         * @param job   The job to move
+         */
+        Job(Job&& job) : _invoke(job._invoke), _relocate(job._relocate),
+                         _destroy(job._destroy), _counter(job._counter) {
+            if (_relocate) {
+                _relocate(_storage,job._storage);
+            }
+            job._invoke = nullptr;
+            job._relocate = nullptr;
+            job._destroy = nullptr;
+            job._counter = nullptr;
+        }
+        
+        /**
+         * Takes the function of another job, destroying the current one
+         *
+         * @param job   The job to move
+         *
+         * @return a reference to this job for chaining
+         */
+        Job& operator=(Job&& job) {
+            if (this != &job) {
+                clear();
+                _invoke = job._invoke;
+                _relocate = job._relocate;
+                _destroy = job._destroy;
+                _counter = job._counter;
+                if (_relocate) {
+                    _relocate(_storage,job._storage);
+                }
+                job._invoke = nullptr;
+                job._relocate = nullptr;
+                job._destroy = nullptr;
+                job._counter = nullptr;
+            }
+            return *this;
+        }
+        
+        /**
+         * Destroys this job, without running it
+         */
+        ~Job() { clear(); }
+        
+        /**
+         * Destroys the function of this job, without running it
+         */
+        void clear() {
+            if (_destroy) {
+                _destroy(_storage);
+            }
+            _invoke = nullptr;
+            _relocate = nullptr;
+            _destroy = nullptr;
+            _counter = nullptr;
+        }
+        
+        /**
+         * Returns true if this job has a function
+         *
+         * @return true if this job has a function
+         */
+        bool valid() const { return _invoke != nullptr; }
+        
+        /**
+         * Runs this job, and then marks it complete
+         *
+         * The job is empty after it is run.
+         */
+        void run() {
+            Counter* counter = _counter;
+            _invoke(_storage);
+            clear();
+            if (counter) {
+                counter->_pending.fetch_sub(1,std::memory_order_acq_rel);
+            }
+        }
+        
+        /** Jobs may only be moved */
+        Job(const Job&) = delete;
+        /** Jobs may only be moved */
+        Job& operator=(const Job&) = delete;
+    };
+    
 private:
-    /** The individual worker threads for this thread pool */
+    /** A job queue (defined in the implementation) */
+    class Queue;
+    
+    /** The worker threads */
 #ifdef CU_SDL_THREADS
     std::vector<SDL_Thread*> _workers;
 #else
     std::vector<std::thread> _workers;
 #endif
+    /** The job queues; one per worker, plus a shared queue for all other threads */
+    std::vector<std::unique_ptr<Queue>> _queues;
+    /** The number of jobs in all of the queues */
+    std::atomic<Uint32> _queued;
+    /** The number of workers waiting for a job */
+    std::atomic<Uint32> _sleepers;
+    /** A mutex lock for sleeping workers */
+    std::mutex _sleepMutex;
+    /** A condition variable to wake sleeping workers */
+    std::condition_variable _sleepCondition;
+    /** Whether or not the job system has been marked for shutdown */
+    std::atomic<bool> _stop;
+    /** The number of worker threads that are completed */
+    std::atomic<Uint32> _complete;
+    
+    /**
+     * The body function of a worker thread.
+     *
+     * This function runs jobs until the job system is stopped.
+     *
+     * @param index The index of the worker queue
+     */
+    void workerFunc(Uint32 index);
+    
+    /**
+     * The body function of a worker thread.
+     *
+     * This static implementation uses the SDL thread API.  It should be used
+     * on Android and Windows, which have special thread requirements.
+     */
+    static int sdlWorkerFunc(void* ptr);
     
-    /** Tasks waiting to be assigned to a thread */
-    std::queue< std::function<void()> > _taskQueue;
+    /**
+     * Returns the queue index for the calling thread.
+     *
+     * Worker threads have their own queue. All other threads share the last
+     * queue.
+     *
+     * @return the queue index for the calling thread.
+     */
+    Uint32 getQueueIndex() const;
     
-    /** A mutex lock for the task queue */
-    std::mutex _queueMutex;
-    /** A condition variable to manage tasks waiting for a worker */
-    std::condition_variable _taskCondition;
+    /**
+     * Adds a job to the queue of the calling thread, waking a worker if necessary.
+     *
+     * @param job   The job to add
+     */
+    void push(Job&& job);
     
-    /** Whether or not the thread pool has been marked for shutdown */
-    bool _stop;
-    /** The number of child threads that are completed */
-    int _complete;
+    /**
+     * Removes a job for the given queue, stealing from other queues if necessary.
+     *
+     * @param index The queue index of the calling thread
+     * @param job   The job to store the result
+     *
+     * @return true if a job was found
+     */
+    bool acquire(Uint32 index, Job& job);
     
+#pragma mark Constructors
+public:
     /**
-     * The body function of a single thread.
+     * Creates a job system with no active threads.
      *
-     * This function pulls tasks from the task queue.  
+     * You must initialize this job system before use.
      *
-     * This implementation is safe to use with std::thread.
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a job system
+     * on the heap, use one of the static constructors instead.
      */
-    void threadFunc();
-
+    JobSystem();
+    
     /**
-     * The body function of a single thread.
+     * Deletes this job system, stopping all threads.
+     */
+    ~JobSystem();
+    
+    /**
+     * Disposes this job system, stopping all threads and discarding any
+     * remaining jobs.
      *
-     * This function pulls tasks from the task queue.
+     * A disposed job system can be safely reinitialized.
+     */
+    void dispose();
+    
+    /**
+     * Initializes a job system with the given number of threads.
      *
-     * This static implementation uses the SDL thread API.  It should be used
-     * on Android and Windows, which have special thread requirements.
+     * If threads is 0 (or negative), the job system sizes itself to the
+     * device, with one worker for every core but the one running the calling
+     * thread. The calling thread is expected to help out with {@link #wait}.
+     *
+     * @param threads   the number of worker threads
+     *
+     * @return true if the job system is initialized properly, false otherwise.
+     */
+    bool init(int threads = 0);
+    
+    /**
+     * Returns a newly allocated job system with the given number of threads.
+     *
+     * If threads is 0 (or negative), the job system sizes itself to the
+     * device, with one worker for every core but the one running the calling
+     * thread. The calling thread is expected to help out with {@link #wait}.
+     *
+     * @param threads   the number of worker threads
+     *
+     * @return a newly allocated job system with the given number of threads.
      */
-    static int sdlThreadFunc(void* ptr);
+    static std::shared_ptr<JobSystem> alloc(int threads = 0) {
+        std::shared_ptr<JobSystem> result = std::make_shared<JobSystem>();
+        return (result->init(threads) ? result : nullptr);
+    }
+    
+#pragma mark Job Management
+    /**
+     * Returns the number of worker threads
+     *
+     * @return the number of worker threads
+     */
+    size_t getThreadCount() const { return _workers.size(); }
+    
+    /**
+     * Submits a job to this job system.
+     *
+     * The job will not be executed immediately, but must wait for the first
+     * available worker (or a thread waiting on a counter). If a counter is
+     * provided, it is incremented now and decremented once the job completes.
+     *
+     * @param func      The job function
+     * @param counter   The counter for this job (may be null)
+     */
+    template <typename F>
+    void submit(F&& func, Counter* counter = nullptr) {
+        if (counter) {
+            counter->_pending.fetch_add(1,std::memory_order_relaxed);
+        }
+        push(Job(std::forward<F>(func),counter));
+    }
+    
+    /**
+     * Blocks until every job assigned to the given counter is complete.
+     *
+     * Rather than idle, the calling thread runs pending jobs while it waits.
+     * Hence it is safe to call this method from within a job.
+     *
+     * @param counter   The counter to wait on
+     */
+    void wait(const Counter& counter);
+    
+    /**
+     * Calls the given function on every range of the given size in [begin,end).
+     *
+     * The function is called as func(start,stop) for disjoint ranges covering
+     * [begin,end), each at most grain elements long. The ranges are run in
+     * parallel, and this method returns once they are all complete. The calling
+     * thread runs one of the ranges itself.
+     *
+     * @param begin The start of the range
+     * @param end   The end of the range (exclusive)
+     * @param grain The maximum number of elements per job
+     * @param func  The function to call on each range
+     */
+    template <typename F>
+    void parallel_for(size_t begin, size_t end, size_t grain, F&& func) {
+        if (begin >= end) {
+            return;
+        }
+        grain = std::max(grain,(size_t)1);
+        Counter counter;
+        size_t start = begin;
+        while (end-start > grain) {
+            size_t stop = start+grain;
+            submit([&func,start,stop]() { func(start,stop); },&counter);
+            start = stop;
+        }
+        func(start,end);
+        wait(counter);
+    }
+    
+    /**
+     * Stops the job system, marking it for shut down.
+     *
+     * This method blocks until the worker threads have finished their current
+     * jobs. Jobs still in the queues are not run.
+     */
+    void stop();
+    
+    /**
+     * Returns whether the job system has been stopped.
+     *
+     * @return whether the job system has been stopped.
+     */
+    bool isStopped() const { return _stop.load(std::memory_order_relaxed); }
+    
+    /**
+     * Returns whether the job system has been shut down.
+     *
+     * A shut down job system has no active threads and is safe for deletion.
+     *
+     * @return whether the job system has been shut down.
+     */
+    bool isShutdown() const { return _workers.size() == _complete.load(); }
+    
+private:
+    /** Copying is only allowed via shared pointer. */
+    CU_DISALLOW_COPY_AND_ASSIGN(JobSystem);
+};
+
+#pragma mark -
+#pragma mark Thread Pool
+
+/**
+ *  Class to providing a collection of worker threads.
+ *
+ *  This is a general purpose class for performing tasks asynchronously.  There 
+ *  is no notification process for when a task is complete.  Instead, your task 
+ *  should either set a flag, or execute a callback when it is done.
+ *
+ *  There are some important safety considerations for using this class over
+ *  direct thread objects. For example, stopping a thread pool does not shut it 
+ *  down immediately; it just marks it for shutdown.  Because of mutex locks, 
+ *  it is not safe to delete a thread pool until it is completely shutdown.
+ *
+ *  More importantly, we do not allow for detached threads. This makes no sense
+ *  in this application, because the threads share a resource (_taskQueue) with 
+ *  the main thread that will be deleted.  It is therefore unsafe for the 
+ *  threads to ever detach.
+ *
+ *  See the class {@link AssetManager} for an example of how to use a thread 
+ *  pool.
+ *
+ *  This class is a thin facade over a {@link JobSystem} with the given number
+ *  of workers. Tasks are added from outside of the job system, so they are
+ *  still run in the order they were added (when there is a single worker).
+ */
+class ThreadPool {
+private:
+    /** The job system running the tasks */
+    std::shared_ptr<JobSystem> _jobs;
     
 
 #pragma mark Constructors
@@ -124,7 +557,7 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a thread pool 
      * on the heap, use one of the static constructors instead.
      */
-    ThreadPool() :_stop(false), _complete(0) { }
+    ThreadPool() { }
     
     /**
      * Deletes this thread pool, destroying all resources.
@@ -158,6 +591,13 @@ public:
      * @return true if the threed pool is initialized properly, false otherwise.
      */
     virtual bool init(int threads = 4);
+    
+    /**
+     * Returns the job system running the tasks of this thread pool
+     *
+     * @return the job system running the tasks of this thread pool
+     */
+    const std::shared_ptr<JobSystem>& getJobSystem() const { return _jobs; }
 
     
 #pragma mark Static Constructors
@@ -209,7 +649,7 @@ public:
      *
      * @return whether the thread pool has been stopped.
      */
-    bool isStopped() const { return _stop; }
+    bool isStopped() const { return _jobs == nullptr || _jobs->isStopped(); }
     
     /**
      * Returns whether the thread pool has been shut down.
@@ -218,7 +658,7 @@ public:
      *
      * @return whether the thread pool has been shut down.
      */
-    bool isShutdown() const { return _workers.size() == _complete; }
+    bool isShutdown() const { return _jobs == nullptr || _jobs->isShutdown(); }
   
 private:  
     /** Copying is only allowed via shared pointer. */
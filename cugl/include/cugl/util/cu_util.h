@@ -33,6 +33,8 @@
 #include "CUTimestamp.h"
 #include "CUFiletools.h"
 #include "CUFreeList.h"
+#include "CUFrameArena.h"
+#include "CUAllocTracker.h"
 #include "CUGreedyFreeList.h"
 #include "CULogger.h"
 #include "CUThreadPool.h"
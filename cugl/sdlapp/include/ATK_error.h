@@ -65,7 +65,82 @@
  */
 #define ATK_OutOfMemory SDL_OutOfMemory
 
-#ifdef USE_SDL_MALLOC
+#if defined(ATK_TRACK_ALLOCATIONS)
+#include <SDL.h>
+#include <begin_code.h>
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A function to allocate a block of memory
+ */
+typedef void *(SDLCALL *ATK_malloc_func)(size_t size);
+
+/**
+ * A function to reallocate a block of memory
+ */
+typedef void *(SDLCALL *ATK_realloc_func)(void *mem, size_t size);
+
+/**
+ * A function to free a block of memory
+ */
+typedef void (SDLCALL *ATK_free_func)(void *mem);
+
+/**
+ * Replaces the memory functions used by SDL_atk
+ *
+ * This is an instrumentation hook, much like SDL_SetMemoryFunctions. It is
+ * only available when the library is built with ATK_TRACK_ALLOCATIONS, and
+ * it must be called before SDL_atk allocates any memory, as memory from the
+ * old functions cannot be freed by the new ones.
+ *
+ * @param malloc_func   The function to allocate memory
+ * @param realloc_func  The function to reallocate memory
+ * @param free_func     The function to free memory
+ */
+extern DECLSPEC void SDLCALL ATK_SetMemoryFunctions(ATK_malloc_func malloc_func,
+                                                    ATK_realloc_func realloc_func,
+                                                    ATK_free_func free_func);
+
+/**
+ * Allocate a block of memory with the current memory functions
+ */
+extern DECLSPEC void* SDLCALL ATK_TrackedMalloc(size_t size);
+
+/**
+ * Reallocate a block of memory with the current memory functions
+ */
+extern DECLSPEC void* SDLCALL ATK_TrackedRealloc(void *mem, size_t size);
+
+/**
+ * Free a block of memory with the current memory functions
+ */
+extern DECLSPEC void SDLCALL ATK_TrackedFree(void *mem);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+#include "close_code.h"
+
+/**
+ * Allocate a block of memory
+ */
+#define ATK_malloc  ATK_TrackedMalloc
+
+/**
+ * Reallocate a block of memory
+ */
+#define ATK_realloc  ATK_TrackedRealloc
+
+/**
+ * Free a block of memory
+ */
+#define ATK_free    ATK_TrackedFree
+
+#elif defined(USE_SDL_MALLOC)
 /**
  * Allocate a block of memory
  */
@@ -476,7 +476,7 @@ ATK_AudioSource* ATK_LoadFLAC_RW(SDL_RWops* source, int ownsrc) {
         return NULL;
     }
 
-    ATK_AudioSource* result = ( ATK_AudioSource*)malloc(sizeof( ATK_AudioSource));
+    ATK_AudioSource* result = ( ATK_AudioSource*)ATK_malloc(sizeof( ATK_AudioSource));
     if (!result) {
         ATK_OutOfMemory();
         ATK_free(decoder);
@@ -567,7 +567,7 @@ SDL_bool ATK_SourceIsFLAC(SDL_RWops* source) {
         return SDL_FALSE;
     }
 
-    ATK_AudioSource* wrapper = ( ATK_AudioSource*)malloc(sizeof( ATK_AudioSource));
+    ATK_AudioSource* wrapper = ( ATK_AudioSource*)ATK_malloc(sizeof( ATK_AudioSource));
     if (!wrapper) {
         ATK_free(decoder);
         FLAC__stream_decoder_delete(flac);
@@ -626,7 +626,7 @@ Sint32 ATK_FLAC_UnloadSource(ATK_AudioSource* source) {
         decoder->flac = NULL;
     }
     if (decoder->buffer != NULL) {
-        free(decoder->buffer);
+        ATK_free(decoder->buffer);
         decoder->buffer = NULL;
     }
     if (decoder->stream != NULL && decoder->ownstream) {
@@ -110,24 +110,24 @@ ATK_RealFFT* ATK_AllocRealFFT(size_t size, SDL_bool inverse) {
     kiss_fft_scalar* input = ATK_malloc((size+2)*sizeof(kiss_fft_scalar));
     if (input == NULL) {
         ATK_OutOfMemory();
-        free(state);
+        kiss_fft_free(state);
         return NULL;
     }
 
     kiss_fft_scalar* output = ATK_malloc((size+2)*sizeof(kiss_fft_scalar));;
     if (output == NULL) {
         ATK_OutOfMemory();
-        free(state);
-        free(input);
+        kiss_fft_free(state);
+        ATK_free(input);
         return NULL;
     }
 
     ATK_RealFFT* result = ATK_malloc(sizeof(ATK_RealFFT));
     if (result == NULL) {
         ATK_OutOfMemory();
-        free(state);
-        free(input);
-        free(output);
+        kiss_fft_free(state);
+        ATK_free(input);
+        ATK_free(output);
         return NULL;
     }
 
@@ -465,24 +465,24 @@ ATK_ComplexFFT* ATK_AllocComplexFFT(size_t size, SDL_bool inverse) {
     kiss_fft_cpx* input = ATK_malloc(size*sizeof(kiss_fft_cpx));
     if (input == NULL) {
         ATK_OutOfMemory();
-        free(state);
+        kiss_fft_free(state);
         return NULL;
     }
 
     kiss_fft_cpx* output = ATK_malloc(size*sizeof(kiss_fft_cpx));
     if (output == NULL) {
         ATK_OutOfMemory();
-        free(state);
-        free(input);
+        kiss_fft_free(state);
+        ATK_free(input);
         return NULL;
     }
 
     ATK_ComplexFFT* result = ATK_malloc(sizeof(ATK_ComplexFFT));
     if (result == NULL) {
         ATK_OutOfMemory();
-        free(state);
-        free(input);
-        free(output);
+        kiss_fft_free(state);
+        ATK_free(input);
+        ATK_free(output);
         return NULL;
     }
 
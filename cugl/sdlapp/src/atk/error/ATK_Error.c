@@ -0,0 +1,91 @@
+/*
+ * SDL_atk:  An audio toolkit library for use with SDL
+ * Copyright (C) 2022-2023 Walker M. White
+ *
+ * This is a library to load different types of audio files as PCM data,
+ * and process them with basic DSP tools. The goal of this library is to
+ * provide an alternative to SDL_sound that supports efficient streaming
+ * and file output. In addition, it provides a minimal math library akin
+ * to (and inspired by) numpy for audio processing. This enables the
+ * developer to add custom audio effects that are not possible in SDL_mixer.
+ *
+ * SDL License:
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <ATK_error.h>
+
+/**
+ * @file ATK_Error.c
+ *
+ * This component provides the memory hooks of SDL_atk. They only exist when
+ * the library is built with ATK_TRACK_ALLOCATIONS, which routes ATK_malloc,
+ * ATK_realloc, and ATK_free through the functions below. This allows an
+ * application to attribute the memory of the audio toolkit to its own
+ * allocation tracker.
+ */
+#ifdef ATK_TRACK_ALLOCATIONS
+
+/** The current allocation function */
+static ATK_malloc_func  atk_malloc_func  = malloc;
+/** The current reallocation function */
+static ATK_realloc_func atk_realloc_func = realloc;
+/** The current free function */
+static ATK_free_func    atk_free_func    = free;
+
+/**
+ * Replaces the memory functions used by SDL_atk
+ *
+ * This is an instrumentation hook, much like SDL_SetMemoryFunctions. It is
+ * only available when the library is built with ATK_TRACK_ALLOCATIONS, and
+ * it must be called before SDL_atk allocates any memory, as memory from the
+ * old functions cannot be freed by the new ones.
+ *
+ * @param malloc_func   The function to allocate memory
+ * @param realloc_func  The function to reallocate memory
+ * @param free_func     The function to free memory
+ */
+void ATK_SetMemoryFunctions(ATK_malloc_func malloc_func,
+                            ATK_realloc_func realloc_func,
+                            ATK_free_func free_func) {
+    atk_malloc_func  = malloc_func  ? malloc_func  : malloc;
+    atk_realloc_func = realloc_func ? realloc_func : realloc;
+    atk_free_func    = free_func    ? free_func    : free;
+}
+
+/**
+ * Allocate a block of memory with the current memory functions
+ */
+void* ATK_TrackedMalloc(size_t size) {
+    return atk_malloc_func(size);
+}
+
+/**
+ * Reallocate a block of memory with the current memory functions
+ */
+void* ATK_TrackedRealloc(void *mem, size_t size) {
+    return atk_realloc_func(mem,size);
+}
+
+/**
+ * Free a block of memory with the current memory functions
+ */
+void ATK_TrackedFree(void *mem) {
+    atk_free_func(mem);
+}
+
+#endif
@@ -42,6 +42,346 @@
  * or other optimizations. Instead of trying to identify which functions best
  * benefit from the separation, we just went YOLO and separated them all.
  */
+#pragma mark -
+#pragma mark SIMD Support
+/**
+ * The arithmetic kernels used on every audio callback (add, multiply, scale,
+ * scale-add and max) have vectorized versions. SSE and NEON are selected at
+ * compile time by the intrinsics that SDL_cpuinfo.h makes available, while
+ * AVX (on GCC and Clang) is selected at run time by SDL_HasAVX. Define
+ * ATK_DISABLE_SIMD to build with the scalar loops only.
+ *
+ * Each kernel processes the largest prefix that is a multiple of the vector
+ * width and returns its length, leaving the tail to the scalar loop. The
+ * vectorized operations are pointwise (with no fused multiply-add), so the
+ * results are bit-for-bit identical to the scalar versions. This requires that
+ * the compiler does not contract the scalar loops into fused multiply-adds
+ * either, which it may do on targets with FMA (such as AArch64). Clang obeys
+ * the pragma below, while GCC builds need -ffp-contract=off for this file.
+ *
+ * The harness in tools/atkvec checks every kernel against the scalar loops
+ * and times both.
+ */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+#if !defined(ATK_DISABLE_SIMD)
+#if defined(__SSE__)
+#define ATK_SIMD_SSE 1
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ATK_SIMD_AVX 1
+#define ATK_TARGET_AVX __attribute__((target("avx")))
+#endif
+#elif defined(__ARM_NEON)
+#define ATK_SIMD_NEON 1
+#endif
+#endif
+
+#if defined(ATK_SIMD_SSE) || defined(ATK_SIMD_NEON)
+/** Whether to use the vector kernels (cleared by tools/atkvec to time the scalar loops) */
+static int atk_vec_simd = 1;
+#endif
+
+#if defined(ATK_SIMD_AVX)
+/** Whether the CPU supports AVX (-1 if not yet queried) */
+static int atk_has_avx = -1;
+
+/**
+ * Returns true if the CPU supports AVX
+ *
+ * The query is cached after the first call.
+ *
+ * @return true if the CPU supports AVX
+ */
+static SDL_bool atk_vec_avx(void) {
+    if (atk_has_avx < 0) {
+        atk_has_avx = SDL_HasAVX() ? 1 : 0;
+    }
+    return atk_has_avx ? SDL_TRUE : SDL_FALSE;
+}
+
+ATK_TARGET_AVX
+static size_t atk_vec_add_avx(const float* input1, const float* input2,
+                              float* output, size_t len) {
+    size_t amt = len & ~(size_t)7;
+    for(size_t ii = 0; ii < amt; ii += 8) {
+        __m256 a = _mm256_loadu_ps(input1+ii);
+        __m256 b = _mm256_loadu_ps(input2+ii);
+        _mm256_storeu_ps(output+ii, _mm256_add_ps(a, b));
+    }
+    return amt;
+}
+
+ATK_TARGET_AVX
+static size_t atk_vec_mult_avx(const float* input1, const float* input2,
+                               float* output, size_t len) {
+    size_t amt = len & ~(size_t)7;
+    for(size_t ii = 0; ii < amt; ii += 8) {
+        __m256 a = _mm256_loadu_ps(input1+ii);
+        __m256 b = _mm256_loadu_ps(input2+ii);
+        _mm256_storeu_ps(output+ii, _mm256_mul_ps(a, b));
+    }
+    return amt;
+}
+
+ATK_TARGET_AVX
+static size_t atk_vec_scale_avx(const float* input, float scalar,
+                                float* output, size_t len) {
+    size_t amt = len & ~(size_t)7;
+    __m256 s = _mm256_set1_ps(scalar);
+    for(size_t ii = 0; ii < amt; ii += 8) {
+        __m256 a = _mm256_loadu_ps(input+ii);
+        _mm256_storeu_ps(output+ii, _mm256_mul_ps(a, s));
+    }
+    return amt;
+}
+
+ATK_TARGET_AVX
+static size_t atk_vec_scaleadd_avx(const float* input1, const float* input2, float scalar,
+                                   float* output, size_t len) {
+    size_t amt = len & ~(size_t)7;
+    __m256 s = _mm256_set1_ps(scalar);
+    for(size_t ii = 0; ii < amt; ii += 8) {
+        __m256 a = _mm256_loadu_ps(input1+ii);
+        __m256 b = _mm256_loadu_ps(input2+ii);
+        _mm256_storeu_ps(output+ii, _mm256_add_ps(_mm256_mul_ps(a, s), b));
+    }
+    return amt;
+}
+#endif
+
+/**
+ * Adds two buffers together, returning the number of elements processed
+ *
+ * @param input1    The first input buffer
+ * @param input2    The second input buffer
+ * @param output    The output buffer
+ * @param len       The number of elements to add
+ *
+ * @return the number of elements processed
+ */
+static size_t atk_vec_add_simd(const float* input1, const float* input2,
+                               float* output, size_t len) {
+#if defined(ATK_SIMD_SSE) || defined(ATK_SIMD_NEON)
+    if (!atk_vec_simd) {
+        return 0;
+    }
+#endif
+#if defined(ATK_SIMD_AVX)
+    if (atk_vec_avx()) {
+        return atk_vec_add_avx(input1, input2, output, len);
+    }
+#endif
+    size_t amt = 0;
+#if defined(ATK_SIMD_SSE)
+    amt = len & ~(size_t)3;
+    for(size_t ii = 0; ii < amt; ii += 4) {
+        __m128 a = _mm_loadu_ps(input1+ii);
+        __m128 b = _mm_loadu_ps(input2+ii);
+        _mm_storeu_ps(output+ii, _mm_add_ps(a, b));
+    }
+#elif defined(ATK_SIMD_NEON)
+    amt = len & ~(size_t)3;
+    for(size_t ii = 0; ii < amt; ii += 4) {
+        float32x4_t a = vld1q_f32(input1+ii);
+        float32x4_t b = vld1q_f32(input2+ii);
+        vst1q_f32(output+ii, vaddq_f32(a, b));
+    }
+#endif
+    return amt;
+}
+
+/**
+ * Multiplies two buffers together, returning the number of elements processed
+ *
+ * @param input1    The first input buffer
+ * @param input2    The second input buffer
+ * @param output    The output buffer
+ * @param len       The number of elements to multiply
+ *
+ * @return the number of elements processed
+ */
+static size_t atk_vec_mult_simd(const float* input1, const float* input2,
+                                float* output, size_t len) {
+#if defined(ATK_SIMD_SSE) || defined(ATK_SIMD_NEON)
+    if (!atk_vec_simd) {
+        return 0;
+    }
+#endif
+#if defined(ATK_SIMD_AVX)
+    if (atk_vec_avx()) {
+        return atk_vec_mult_avx(input1, input2, output, len);
+    }
+#endif
+    size_t amt = 0;
+#if defined(ATK_SIMD_SSE)
+    amt = len & ~(size_t)3;
+    for(size_t ii = 0; ii < amt; ii += 4) {
+        __m128 a = _mm_loadu_ps(input1+ii);
+        __m128 b = _mm_loadu_ps(input2+ii);
+        _mm_storeu_ps(output+ii, _mm_mul_ps(a, b));
+    }
+#elif defined(ATK_SIMD_NEON)
+    amt = len & ~(size_t)3;
+    for(size_t ii = 0; ii < amt; ii += 4) {
+        float32x4_t a = vld1q_f32(input1+ii);
+        float32x4_t b = vld1q_f32(input2+ii);
+        vst1q_f32(output+ii, vmulq_f32(a, b));
+    }
+#endif
+    return amt;
+}
+
+/**
+ * Scales an input buffer, returning the number of elements processed
+ *
+ * @param input     The input buffer
+ * @param scalar    The scalar to mutliply by
+ * @param output    The output buffer
+ * @param len       The number of elements to multiply
+ *
+ * @return the number of elements processed
+ */
+static size_t atk_vec_scale_simd(const float* input, float scalar,
+                                 float* output, size_t len) {
+#if defined(ATK_SIMD_SSE) || defined(ATK_SIMD_NEON)
+    if (!atk_vec_simd) {
+        return 0;
+    }
+#endif
+#if defined(ATK_SIMD_AVX)
+    if (atk_vec_avx()) {
+        return atk_vec_scale_avx(input, scalar, output, len);
+    }
+#endif
+    size_t amt = 0;
+#if defined(ATK_SIMD_SSE)
+    amt = len & ~(size_t)3;
+    __m128 s = _mm_set1_ps(scalar);
+    for(size_t ii = 0; ii < amt; ii += 4) {
+        __m128 a = _mm_loadu_ps(input+ii);
+        _mm_storeu_ps(output+ii, _mm_mul_ps(a, s));
+    }
+#elif defined(ATK_SIMD_NEON)
+    amt = len & ~(size_t)3;
+    float32x4_t s = vdupq_n_f32(scalar);
+    for(size_t ii = 0; ii < amt; ii += 4) {
+        float32x4_t a = vld1q_f32(input+ii);
+        vst1q_f32(output+ii, vmulq_f32(a, s));
+    }
+#endif
+    return amt;
+}
+
+/**
+ * Scales an input buffer and adds it to another, returning the number of elements processed
+ *
+ * The multiply and add are kept as separate instructions (no fused multiply-add)
+ * so that the result matches the scalar loop.
+ *
+ * @param input1    The first input buffer
+ * @param input2    The second input buffer
+ * @param scalar    The scalar to mutliply input1 by
+ * @param output    The output buffer
+ * @param len       The number of elements to process
+ *
+ * @return the number of elements processed
+ */
+static size_t atk_vec_scaleadd_simd(const float* input1, const float* input2, float scalar,
+                                    float* output, size_t len) {
+#if defined(ATK_SIMD_SSE) || defined(ATK_SIMD_NEON)
+    if (!atk_vec_simd) {
+        return 0;
+    }
+#endif
+#if defined(ATK_SIMD_AVX)
+    if (atk_vec_avx()) {
+        return atk_vec_scaleadd_avx(input1, input2, scalar, output, len);
+    }
+#endif
+    size_t amt = 0;
+#if defined(ATK_SIMD_SSE)
+    amt = len & ~(size_t)3;
+    __m128 s = _mm_set1_ps(scalar);
+    for(size_t ii = 0; ii < amt; ii += 4) {
+        __m128 a = _mm_loadu_ps(input1+ii);
+        __m128 b = _mm_loadu_ps(input2+ii);
+        _mm_storeu_ps(output+ii, _mm_add_ps(_mm_mul_ps(a, s), b));
+    }
+#elif defined(ATK_SIMD_NEON)
+    amt = len & ~(size_t)3;
+    float32x4_t s = vdupq_n_f32(scalar);
+    for(size_t ii = 0; ii < amt; ii += 4) {
+        float32x4_t a = vld1q_f32(input1+ii);
+        float32x4_t b = vld1q_f32(input2+ii);
+        vst1q_f32(output+ii, vaddq_f32(vmulq_f32(a, s), b));
+    }
+#endif
+    return amt;
+}
+
+/**
+ * Computes the maximum of a buffer prefix, returning the number of elements processed
+ *
+ * Each lane keeps a running maximum, which are combined at the end. If no
+ * elements are processed, max is untouched. The result agrees with the scalar
+ * search, except that it may differ in the sign of a zero maximum or in which
+ * NaN entries are skipped.
+ *
+ * @param data      The data buffer
+ * @param len       The number of elements to search
+ * @param max       Pointer to store the maximum value
+ *
+ * @return the number of elements processed
+ */
+static size_t atk_vec_max_simd(const float* data, size_t len, float* max) {
+#if defined(ATK_SIMD_SSE) || defined(ATK_SIMD_NEON)
+    if (!atk_vec_simd) {
+        return 0;
+    }
+#endif
+    size_t amt = 0;
+#if defined(ATK_SIMD_SSE)
+    amt = len & ~(size_t)3;
+    if (amt) {
+        float lanes[4];
+        __m128 m = _mm_loadu_ps(data);
+        for(size_t ii = 4; ii < amt; ii += 4) {
+            m = _mm_max_ps(_mm_loadu_ps(data+ii), m);
+        }
+        _mm_storeu_ps(lanes, m);
+        float result = lanes[0];
+        for(int jj = 1; jj < 4; jj++) {
+            if (lanes[jj] > result) {
+                result = lanes[jj];
+            }
+        }
+        *max = result;
+    }
+#elif defined(ATK_SIMD_NEON)
+    amt = len & ~(size_t)3;
+    if (amt) {
+        float lanes[4];
+        float32x4_t m = vld1q_f32(data);
+        for(size_t ii = 4; ii < amt; ii += 4) {
+            float32x4_t t = vld1q_f32(data+ii);
+            m = vbslq_f32(vcgtq_f32(t, m), t, m);
+        }
+        vst1q_f32(lanes, m);
+        float result = lanes[0];
+        for(int jj = 1; jj < 4; jj++) {
+            if (lanes[jj] > result) {
+                result = lanes[jj];
+            }
+        }
+        *max = result;
+    }
+#endif
+    return amt;
+}
+
 #pragma mark -
 #pragma mark Distance Utils
 /**
@@ -281,10 +621,16 @@ float ATK_VecMax(float* data, size_t len) {
         return NAN;
     }
 
-    float result = *data;
-    float* out = data+1;
+    float result;
+    size_t done = atk_vec_max_simd(data, len, &result);
+    if (!done) {
+        result = *data;
+        done = 1;
+    }
+    float* out = data+done;
+    len -= done;
     float temp;
-    while (--len) {
+    while (len--) {
         temp = *out++;
         if (temp > result) {
             result = temp;
@@ -312,6 +658,9 @@ float ATK_VecMax_stride(float* data, size_t stride, size_t len) {
     if (!stride) {
         stride = 1;
     }
+    if (stride == 1) {
+        return ATK_VecMax(data, len);
+    }
 
     float result = *data;
     float* out = data+stride;
@@ -1560,6 +1909,11 @@ void ATK_VecAdd(const float* input1, const float* input2,
     const float* src1 = input1;
     const float* src2 = input2;
     float* dst = output;
+    size_t done = atk_vec_add_simd(src1, src2, dst, len);
+    src1 += done;
+    src2 += done;
+    dst  += done;
+    len  -= done;
     while(len--) {
         *dst++ = *(src1++)+*(src2++);
     }
@@ -1592,6 +1946,10 @@ void ATK_VecAdd_stride(const float* input1, size_t istride1,
     if (!ostride) {
         ostride = 1;
     }
+    if (istride1 == 1 && istride2 == 1 && ostride == 1) {
+        ATK_VecAdd(input1, input2, output, len);
+        return;
+    }
 
     const float* src1 = input1;
     const float* src2 = input2;
@@ -1678,6 +2036,11 @@ void ATK_VecMult(const float* input1, const float* input2,
     const float* src1 = input1;
     const float* src2 = input2;
     float* dst = output;
+    size_t done = atk_vec_mult_simd(src1, src2, dst, len);
+    src1 += done;
+    src2 += done;
+    dst  += done;
+    len  -= done;
     while(len--) {
         *dst++ = *(src1++) * *(src2++);
     }
@@ -1710,6 +2073,10 @@ void ATK_VecMult_stride(const float* input1, size_t istride1,
     if (!ostride) {
         ostride = 1;
     }
+    if (istride1 == 1 && istride2 == 1 && ostride == 1) {
+        ATK_VecMult(input1, input2, output, len);
+        return;
+    }
 
     const float* src1 = input1;
     const float* src2 = input2;
@@ -1808,6 +2175,10 @@ void ATK_VecDiv_stride(const float* input1, size_t istride1,
 void ATK_VecScale(const float* input, float scalar, float* output, size_t len) {
     const float* src = input;
     float* dst = output;
+    size_t done = atk_vec_scale_simd(src, scalar, dst, len);
+    src += done;
+    dst += done;
+    len -= done;
     while(len--) {
         *dst++ = *(src++) * scalar;
     }
@@ -1835,6 +2206,10 @@ void ATK_VecScale_stride(const float* input, size_t istride, float scalar,
     if (!ostride) {
         ostride = 1;
     }
+    if (istride == 1 && ostride == 1) {
+        ATK_VecScale(input, scalar, output, len);
+        return;
+    }
 
     const float* src = input;
     float* dst = output;
@@ -1861,6 +2236,11 @@ void ATK_VecScaleAdd(const float* input1, const float* input2, float scalar,
     const float* src1 = input1;
     const float* src2 = input2;
     float* dst  = output;
+    size_t done = atk_vec_scaleadd_simd(src1, src2, scalar, dst, len);
+    src1 += done;
+    src2 += done;
+    dst  += done;
+    len  -= done;
     while(len--) {
         *dst++ = *(src1++)*scalar+*(src2++);
     }
@@ -1894,6 +2274,10 @@ void ATK_VecScaleAdd_stride(const float* input1, size_t istride1,
     if (!ostride) {
         ostride = 1;
     }
+    if (istride1 == 1 && istride2 == 1 && ostride == 1) {
+        ATK_VecScaleAdd(input1, input2, scalar, output, len);
+        return;
+    }
 
     const float* src1 = input1;
     const float* src2 = input2;
@@ -47,6 +47,9 @@
 
 using namespace cugl;
 
+/** The number of children an object needs before keyed lookups use an index */
+#define INDEX_THRESHOLD 8
+
 /**
  * Returns the line of JSON with the offending error.
  *
@@ -221,6 +224,7 @@ void JsonValue::toJsonValue(JsonValue* value, const cJSON* node) {
         }
     }
     value->_children.assign(items.begin(),items.end());
+    value->invalidateIndex();
 }
 
 /**
@@ -278,6 +282,45 @@ cJSON* JsonValue::toCJSON(const JsonValue* value) {
     return result;
 }
 
+#pragma mark -
+#pragma mark Key Index
+/**
+ * Returns the position of the first child with the given key.
+ *
+ * Small objects are searched linearly. Larger objects build a key index
+ * on the first lookup and reuse it until the children change. If there
+ * is no child with this key, this method returns -1.
+ *
+ * Building the index modifies this node, so concurrent lookups on the same
+ * node from different threads are not safe.
+ *
+ * @param key   The key identifying the child
+ *
+ * @return the position of the first child with the given key.
+ */
+int JsonValue::find(const std::string& key) const {
+    if (_children.size() < INDEX_THRESHOLD) {
+        for(size_t ii = 0; ii < _children.size(); ii++) {
+            if (_children[ii]->_key == key) {
+                return (int)ii;
+            }
+        }
+        return -1;
+    }
+    
+    if (!_indexed) {
+        _index.clear();
+        _index.reserve(_children.size());
+        for(size_t ii = 0; ii < _children.size(); ii++) {
+            // Keep the first child on duplicate keys
+            _index.emplace(_children[ii]->_key, ii);
+        }
+        _indexed = true;
+    }
+    auto it = _index.find(key);
+    return it == _index.end() ? -1 : (int)it->second;
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -292,7 +335,8 @@ _parent(nullptr),
 _key(""),
 _stringValue(""),
 _longValue(0L),
-_doubleValue(0.0) {
+_doubleValue(0.0),
+_indexed(false) {
 }
 
 /**
@@ -809,6 +853,7 @@ void JsonValue::setKey(const std::string key) {
     if (_parent) {
         CUAssertLog(!_parent->has(key), "The key %s is already in use", key.c_str());
         _key = key;
+        _parent->invalidateIndex();
     }
 }
 
@@ -842,12 +887,7 @@ const int JsonValue::index() const {
  */
 bool JsonValue::has(const std::string key) const {
     CUAssertLog(isObject(), "Node is not an object type");
-    for(auto it = _children.begin(); it != _children.end(); it++) {
-        if ((*it)->_key == key) {
-            return true;
-        }
-    }
-    return false;
+    return find(key) >= 0;
 }
 
 /**
@@ -896,12 +936,8 @@ const std::shared_ptr<JsonValue> JsonValue::get(int index) const {
  */
 std::shared_ptr<JsonValue> JsonValue::get(const std::string key) {
     CUAssertLog(isObject(), "Node is not an object type");
-    for(auto it = _children.begin(); it != _children.end(); it++) {
-        if ((*it)->_key == key) {
-            return *it;
-        }
-    }
-    return nullptr;
+    int pos = find(key);
+    return pos < 0 ? nullptr : _children[pos];
 }
 
 /**
@@ -918,12 +954,8 @@ std::shared_ptr<JsonValue> JsonValue::get(const std::string key) {
  */
 const std::shared_ptr<JsonValue> JsonValue::get(const std::string key) const {
     CUAssertLog(isObject(), "Node is not an object type");
-    for(auto it = _children.begin(); it != _children.end(); it++) {
-        if ((*it)->_key == key) {
-            return *it;
-        }
-    }
-    return nullptr;
+    int pos = find(key);
+    return pos < 0 ? nullptr : _children[pos];
 }
 
 #pragma mark -
@@ -1060,6 +1092,7 @@ std::shared_ptr<JsonValue> JsonValue::removeChild(int index) {
     CUAssertLog(0 <= index && index < _children.size(), "Index %d out of range", index);
     std::shared_ptr<JsonValue> result = _children[index];
     _children.erase(_children.begin() + index);
+    invalidateIndex();
     result->_parent = nullptr;
     return result;
 }
@@ -1077,15 +1110,11 @@ std::shared_ptr<JsonValue> JsonValue::removeChild(int index) {
  * Returns the child with the specified key and removes it from this node.
  */
 std::shared_ptr<JsonValue> JsonValue::removeChild(const std::string key) {
-    auto jt = _children.end();
-    for(auto it = _children.begin(); jt == _children.end() && it != _children.end(); it++) {
-        if ((*it)->_key == key) {
-            jt = it;
-        }
-    }
-    if (jt != _children.end()) {
-        std::shared_ptr<JsonValue> result = *jt;
-        _children.erase(jt);
+    int pos = find(key);
+    if (pos >= 0) {
+        std::shared_ptr<JsonValue> result = _children[pos];
+        _children.erase(_children.begin() + pos);
+        invalidateIndex();
         result->_parent = nullptr;
         return result;
     }
@@ -1107,6 +1136,7 @@ void JsonValue::merge(const std::shared_ptr<JsonValue>& node) {
     node->_key = _key;
     _parent->removeChild(_key);
     node->_parent->_children.push_back(node);
+    node->_parent->invalidateIndex();
 }
 
 
@@ -1131,6 +1161,9 @@ void JsonValue::appendChild(const std::shared_ptr<JsonValue>& child) {
     CUAssertLog(isArray() || !has(child->key()),
                 "The key %s is already in use", child->key().c_str());
     _children.push_back(child);
+    if (_indexed) {
+        _index.emplace(child->_key, _children.size()-1);
+    }
     child->_parent = this;
 }
 
@@ -1156,6 +1189,9 @@ void JsonValue::appendChild(const std::string key, const std::shared_ptr<JsonVal
     CUAssertLog(!has(key), "The key %s is already in use", key.c_str());
     child->_key = key;
     _children.push_back(child);
+    if (_indexed) {
+        _index.emplace(child->_key, _children.size()-1);
+    }
     child->_parent = this;
 }
 
@@ -1180,6 +1216,7 @@ void JsonValue::insertChild(unsigned int index, const std::shared_ptr<JsonValue>
     CUAssertLog(!child->_parent, "This child already has a parent");
     CUAssertLog(isArray() || isObject(), "This node is a value type");
     _children.insert(_children.begin()+index,child);
+    invalidateIndex();
     child->_parent = this;
 }
 
@@ -1209,6 +1246,7 @@ void JsonValue::insertChild(unsigned int index, const std::string key,
     CUAssertLog(!has(key), "The key %s is already in use", key.c_str());
     child->_key = key;
     _children.insert(_children.begin()+index,child);
+    invalidateIndex();
     child->_parent = this;
 }
 
@@ -48,6 +48,148 @@ AudioEngine* AudioEngine::_gEngine = nullptr;
 /** The read size to use for the audio devices */
 Uint32 AudioEngine::_readsize = 0;
 
+/** The number of bits of a voice handle used for the slot */
+#define VOICE_SLOT_BITS 8
+/** The mask extracting the slot from a voice handle */
+#define VOICE_SLOT_MASK 0xFF
+
+#pragma mark -
+#pragma mark Audio Command Queue
+/**
+ * Allocates the command buffer, discarding any pending commands
+ *
+ * The capacity is rounded up to the next power of two. This method is
+ * not thread-safe, and should only be called when there is no consumer.
+ *
+ * @param capacity  The maximum number of pending commands
+ */
+void AudioCommandQueue::init(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    _buffer.resize(size);
+    _mask = size-1;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * Adds a command to the end of this queue.
+ *
+ * This method should only be called by the producer. It returns false
+ * (discarding the command) if the queue is full.
+ *
+ * @param command   The command to add
+ *
+ * @return true if the command was added
+ */
+bool AudioCommandQueue::push(const AudioCommand& command) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (_buffer.empty() || tail-_head.load(std::memory_order_acquire) > _mask) {
+        return false;
+    }
+    _buffer[tail & _mask] = command;
+    _tail.store(tail+1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Removes a command from the front of this queue.
+ *
+ * This method should only be called by the consumer. It returns false
+ * if the queue is empty.
+ *
+ * @param command   The command to store the result
+ *
+ * @return true if a command was removed
+ */
+bool AudioCommandQueue::pop(AudioCommand& command) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    command = _buffer[head & _mask];
+    _head.store(head+1, std::memory_order_release);
+    return true;
+}
+
+#pragma mark -
+#pragma mark Engine Mixer
+/**
+ * The root mixer of the audio engine.
+ *
+ * This mixer gives the engine a hook into the audio thread at every buffer
+ * boundary. The engine applies pending commands before each read, and
+ * publishes the state of its slots after.
+ */
+class EngineMixer : public AudioMixer {
+public:
+    /** The function called before each read (on the audio thread) */
+    std::function<void()> before;
+    /** The function called after each read (on the audio thread) */
+    std::function<void()> after;
+    
+    /**
+     * Reads up to the specified number of frames into the given buffer
+     *
+     * @param buffer    The read buffer to store the results
+     * @param frames    The maximum number of frames to read
+     *
+     * @return the actual number of frames read
+     */
+    virtual Uint32 read(float* buffer, Uint32 frames) override {
+        if (before) {
+            before();
+        }
+        Uint32 amt = AudioMixer::read(buffer,frames);
+        if (after) {
+            after();
+        }
+        return amt;
+    }
+};
+
+/**
+ * Returns the stereo pan factor of the given panner.
+ *
+ * @param panner    The panner of a sound effect
+ *
+ * @return the stereo pan factor of the given panner.
+ */
+static float get_pan_factor(AudioPanner* panner) {
+    if (panner->getField() == 1) {
+        return panner->getPan(0,1)-panner->getPan(0,0);
+    } else {
+        return panner->getPan(1,1)-panner->getPan(0,0);
+    }
+}
+
+/**
+ * Sets the stereo pan factor of the given panner.
+ *
+ * @param panner    The panner of a sound effect
+ * @param pan       The stereo pan factor
+ */
+static void set_pan_factor(AudioPanner* panner, float pan) {
+    if (panner->getField() == 1) {
+        panner->setPan(0,0,0.5-pan/2.0);
+        panner->setPan(0,1,0.5+pan/2.0);
+    } else {
+        if (pan <= 0) {
+            panner->setPan(0,0,1);
+            panner->setPan(0,1,0);
+            panner->setPan(1,0,-pan);
+            panner->setPan(1,1,1+pan);
+        } else {
+            panner->setPan(1,1,1);
+            panner->setPan(1,0,0);
+            panner->setPan(0,0,1-pan);
+            panner->setPan(0,1,pan);
+        }
+    }
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -80,11 +222,27 @@ bool AudioEngine::init(const std::shared_ptr<AudioOutput>& device, Uint32 slots)
         return false;
     }
     
+    CUAssertLog(slots < VOICE_SLOT_MASK, "Too many slots for the voice handles: %d", slots);
+    
     _capacity = slots;
     _output = device;
-    _mixer  = AudioMixer::alloc(_capacity+1,_output->getChannels(),_output->getRate());
+    std::shared_ptr<EngineMixer> mixer = std::make_shared<EngineMixer>();
+    if (!mixer->init(_capacity+1,_output->getChannels(),_output->getRate())) {
+        return false;
+    }
+    _mixer = mixer;
     
-    for(int ii = 0; ii <= _capacity; ii++) {
+    _commands.init(DEFAULT_COMMANDSIZE);
+    _generations.assign(_capacity+1,0);
+    _bindings.assign(_capacity+1,{0,nullptr,false});
+    _published.reset(new std::atomic<Uint64>[_capacity+1]);
+    for(size_t ii = 0; ii <= _capacity; ii++) {
+        _published[ii].store(0,std::memory_order_relaxed);
+    }
+    mixer->before = [this]() { this->applyCommands(); };
+    mixer->after  = [this]() { this->publishState(); };
+    
+    for(size_t ii = 0; ii <= _capacity; ii++) {
         std::shared_ptr<AudioScheduler> channel;
         channel = audio::AudioScheduler::alloc(_mixer->getChannels(),_mixer->getRate());
         channel->setTag(ii);
@@ -112,7 +270,7 @@ bool AudioEngine::init(const std::shared_ptr<AudioOutput>& device, Uint32 slots)
     }
     
     // Pool needs a fader and panner for 2 times the number of slots
-    for(int ii = 0; ii < 2*_capacity; ii++) {
+    for(size_t ii = 0; ii < 2*_capacity; ii++) {
         _fadePool.push_back(AudioFader::alloc(_mixer->getChannels(),_mixer->getRate()));
         _panPool.push_back(AudioPanner::alloc(_mixer->getChannels(),2,_mixer->getRate()));
     }
@@ -129,6 +287,11 @@ bool AudioEngine::init(const std::shared_ptr<AudioOutput>& device, Uint32 slots)
  */
 void AudioEngine::dispose() {
     if (_capacity) {
+        // The audio thread must not apply commands to a disposed engine
+        _output->lock();
+        _output->detach();
+        _output->unlock();
+        
         if (_primary) {
             AudioDevices::get()->closeOutput(_output);
             AudioDevices::get()->deactivate();
@@ -149,6 +312,10 @@ void AudioEngine::dispose() {
         _queues.clear();
 		_actives.clear();
         _evicts.clear();
+        _voices.clear();
+        _generations.clear();
+        _bindings.clear();
+        _published.reset();
 	}
 }
 
@@ -165,6 +332,7 @@ void AudioEngine::dispose() {
  */
 void AudioEngine::removeKey(const std::string key) {
     _actives.erase(key);
+    _voices.erase(key);
     for(auto it = _evicts.begin(); it != _evicts.end(); ) {
         if (*it == key) {
             it = _evicts.erase(it);
@@ -314,6 +482,140 @@ void AudioEngine::gcollect(const std::shared_ptr<audio::AudioNode>& sound, bool
     }
 }
 
+/**
+ * Assigns a new voice handle to the given key and binds it to the fader.
+ *
+ * The audio thread does not see the fader until it processes the bind
+ * command. Until then, all commands for the voice are queued behind it.
+ *
+ * @param key       The reference key for the sound effect
+ * @param fader     The fader wrapping the sound effect
+ * @param volume    The initial volume of the sound effect
+ */
+void AudioEngine::bindVoice(const std::string key, const std::shared_ptr<audio::AudioFader>& fader, float volume) {
+    Uint32 slot = fader->getTag();
+    Uint32 handle = (++_generations[slot] << VOICE_SLOT_BITS) | slot;
+    
+    // The audio thread only reads the panner, so this is safe
+    AudioPanner* panner = dynamic_cast<AudioPanner*>(fader->getInput().get());
+    _voices[key] = {handle, volume, panner ? get_pan_factor(panner) : 0.0f};
+    
+    AudioCommand command = {AudioCommand::Type::BIND, handle, volume, fader.get()};
+    if (!_commands.push(command)) {
+        CULogError("Audio command queue is full");
+    }
+}
+
+/**
+ * Sends a command for the voice with the given key to the audio thread.
+ *
+ * If the key does not correspond to an active sound effect, this method
+ * does nothing.
+ *
+ * @param key       The reference key for the sound effect
+ * @param type      The command type
+ * @param value     The command argument
+ */
+void AudioEngine::sendCommand(const std::string key, audio::AudioCommand::Type type, float value) {
+    auto it = _voices.find(key);
+    if (it != _voices.end()) {
+        AudioCommand command = {type, it->second.handle, value, nullptr};
+        if (!_commands.push(command)) {
+            CULogError("Audio command queue is full");
+        }
+    }
+}
+
+/**
+ * Applies all pending commands from the main thread.
+ *
+ * This method is called by the audio thread at the start of every read.
+ */
+void AudioEngine::applyCommands() {
+    AudioCommand command;
+    while (_commands.pop(command)) {
+        Uint32 slot = command.voice & VOICE_SLOT_MASK;
+        Binding& binding = _bindings[slot];
+        if (command.type == AudioCommand::Type::BIND) {
+            binding.handle  = command.voice;
+            binding.fader   = command.fader;
+            binding.started = false;
+            binding.fader->setGain(command.value);
+            continue;
+        } else if (binding.handle != command.voice || binding.fader == nullptr) {
+            // The sound has been replaced
+            continue;
+        }
+        
+        // Once the sound has finished, its fader may be recycled at any time
+        AudioFader* fader = binding.fader;
+        if (binding.started && _slots[slot]->getCurrent().get() != fader) {
+            continue;
+        }
+        
+        switch (command.type) {
+            case AudioCommand::Type::VOLUME:
+                fader->setGain(command.value);
+                break;
+            case AudioCommand::Type::PAN:
+            {
+                AudioPanner* panner = dynamic_cast<AudioPanner*>(fader->getInput().get());
+                if (panner) {
+                    set_pan_factor(panner,command.value);
+                }
+            }
+                break;
+            case AudioCommand::Type::PAUSE:
+                fader->fadePause(command.value);
+                break;
+            case AudioCommand::Type::RESUME:
+                fader->resume();
+                break;
+            case AudioCommand::Type::CLEAR:
+                // Act only if we are not already fading out
+                if (!fader->isFadeOut()) {
+                    _slots[slot]->setLoops(0);
+                    fader->fadeOut(command.value);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * Publishes the state of every slot for the main thread.
+ *
+ * This method is called by the audio thread at the end of every read.
+ */
+void AudioEngine::publishState() {
+    for(size_t ii = 0; ii < _bindings.size(); ii++) {
+        const Binding& binding = _bindings[ii];
+        if (binding.fader == nullptr) {
+            continue;
+        }
+        
+        State state = State::INACTIVE;
+        std::shared_ptr<AudioNode> current = _slots[ii]->getCurrent();
+        if (current.get() == binding.fader) {
+            _bindings[ii].started = true;
+            if (binding.fader->isPaused() || _slots[ii]->isPaused()) {
+                state = State::PAUSED;
+            } else {
+                state = State::PLAYING;
+            }
+        } else if (!binding.started && _slots[ii]->getTailSize()) {
+            // Bound, but not yet picked up by the scheduler
+            state = State::PLAYING;
+        } else {
+            _bindings[ii].started = true;
+        }
+        Uint64 value = ((Uint64)binding.handle << 32) | (Uint64)state;
+        _published[ii].store(value,std::memory_order_release);
+    }
+}
+
 #pragma mark -
 #pragma mark Static Accessors
 /**
@@ -616,6 +918,7 @@ void AudioEngine::freeQueue(const std::shared_ptr<AudioQueue>& queue) {
  */
 bool AudioEngine::play(const std::string key, const std::shared_ptr<Sound>& sound,
                        bool loop, float volume, bool force) {
+    CU_ALLOC_TAG(AUDIO);
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
 
     if (isActive(key)) {
@@ -668,6 +971,7 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<Sound>& soun
     _slots[audioID]->play(fader, loop ? -1 : 0);
     _actives.emplace(key,fader);
     _evicts.push_back(key);
+    bindVoice(key,fader,volume);
     return true;
 }
 
@@ -703,6 +1007,7 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<Sound>& soun
  */
 bool AudioEngine::play(const std::string key, const std::shared_ptr<audio::AudioNode>& graph,
                        bool loop, float volume, bool force) {
+    CU_ALLOC_TAG(AUDIO);
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
     CUAssertLog(graph->getName() != "__engine_playback__",  "Audio node uses reserved name '__engine_playback__'");
     CUAssertLog(graph->getName() != "__engine_resampler__", "Audio node uses reserved name '__engine_resampler__'");
@@ -754,6 +1059,7 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<audio::Audio
     _slots[audioID]->play(fader, loop ? -1 : 0);
     _actives.emplace(key,fader);
     _evicts.push_back(key);
+    bindVoice(key,fader,volume);
     return true;
 }
 
@@ -770,19 +1076,18 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<audio::Audio
  */
 AudioEngine::State AudioEngine::getState(const std::string key) const {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) == _actives.end()) {
+    auto it = _voices.find(key);
+    if (it == _voices.end()) {
         return State::INACTIVE;
     }
     
-    std::shared_ptr<AudioNode> node = _actives.at(key);
-    std::shared_ptr<audio::AudioScheduler> slot = _slots.at(node->getTag());
-    if (!slot->isPlaying()) {
-        return State::INACTIVE;
-    } else if (node->isPaused() || slot->isPaused()) {
-        return State::PAUSED;
+    Uint32 handle = it->second.handle;
+    Uint64 value = _published[handle & VOICE_SLOT_MASK].load(std::memory_order_acquire);
+    if ((Uint32)(value >> 32) != handle) {
+        // The audio thread has not seen this sound yet
+        return State::PLAYING;
     }
-    
-    return State::PLAYING;
+    return (State)(value & 0xFFFFFFFF);
 }
 
 /**
@@ -867,10 +1172,9 @@ void AudioEngine::setLoop(const std::string key, bool loop) {
  */
 float AudioEngine::getVolume(const std::string key) const {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        Uint32 tag = _actives.at(key)->getTag();
-        std::shared_ptr<AudioNode> node = _slots[tag]->getCurrent();
-        return node->getGain();
+    auto it = _voices.find(key);
+    if (it != _voices.end()) {
+        return it->second.volume;
     }
     return 0;
 }
@@ -892,10 +1196,10 @@ float AudioEngine::getVolume(const std::string key) const {
  */
 void AudioEngine::setVolume(const std::string key, float volume) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        Uint32 tag = _actives.at(key)->getTag();
-        std::shared_ptr<AudioNode> node = _slots[tag]->getCurrent();
-        node->setGain(volume);
+    auto it = _voices.find(key);
+    if (it != _voices.end()) {
+        it->second.volume = volume;
+        sendCommand(key,AudioCommand::Type::VOLUME,volume);
     }
 }
 
@@ -921,14 +1225,9 @@ void AudioEngine::setVolume(const std::string key, float volume) {
  */
 float AudioEngine::getPanFactor(const std::string key) const {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> fader = _actives.at(key);
-        std::shared_ptr<AudioPanner> panner = std::dynamic_pointer_cast<AudioPanner>(fader->getInput());
-        if (panner->getField() == 1) {
-            return panner->getPan(0,1)-panner->getPan(0,0);
-        } else {
-            return panner->getPan(1,1)-panner->getPan(0,0);
-        }
+    auto it = _voices.find(key);
+    if (it != _voices.end()) {
+        return it->second.pan;
     }
     return 0;
 }
@@ -955,25 +1254,10 @@ float AudioEngine::getPanFactor(const std::string key) const {
 void AudioEngine::setPanFactor(const std::string key, float pan) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
     CUAssertLog(pan >= -1 && pan <= 1, "Pan value %f is out of range",pan);
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> fader = _actives.at(key);
-        std::shared_ptr<AudioPanner> panner = std::dynamic_pointer_cast<AudioPanner>(fader->getInput());
-        if (panner->getField() == 1) {
-            panner->setPan(0,0,0.5-pan/2.0);
-            panner->setPan(0,1,0.5+pan/2.0);
-        } else {
-            if (pan <= 0) {
-                panner->setPan(0,0,1);
-                panner->setPan(0,1,0);
-                panner->setPan(1,0,-pan);
-                panner->setPan(1,1,1+pan);
-            } else {
-                panner->setPan(1,1,1);
-                panner->setPan(1,0,0);
-                panner->setPan(0,0,1-pan);
-                panner->setPan(0,1,pan);
-            }
-        }
+    auto it = _voices.find(key);
+    if (it != _voices.end()) {
+        it->second.pan = pan;
+        sendCommand(key,AudioCommand::Type::PAN,pan);
     }
 }
 
@@ -1126,15 +1410,14 @@ void AudioEngine::setTimeRemaining(const std::string key, float time) {
  */
 void AudioEngine::clear(const std::string key,float fade) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> node = _actives.at(key);
-        // Act only if we are not already fading out
-        if (fade == 0) {
-            _slots[node->getTag()]->skip();
-        } else if (!node->isFadeOut()) {
-            _slots[node->getTag()]->setLoops(0);
-            node->fadeOut(fade);
-        }
+    auto it = _actives.find(key);
+    if (it == _actives.end()) {
+        return;
+    } else if (fade == 0) {
+        // Skipping is atomic, and must happen before the slot is reused
+        _slots[it->second->getTag()]->skip();
+    } else {
+        sendCommand(key,AudioCommand::Type::CLEAR,fade);
     }
 
 }
@@ -1157,10 +1440,7 @@ void AudioEngine::clear(const std::string key,float fade) {
  */
 void AudioEngine::pause(const std::string key,float fade) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> node = _actives.at(key);
-        node->fadePause(fade);
-    }
+    sendCommand(key,AudioCommand::Type::PAUSE,fade);
 }
 
 /**
@@ -1172,10 +1452,7 @@ void AudioEngine::pause(const std::string key,float fade) {
  */
 void AudioEngine::resume(std::string key) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> node = _actives.at(key);
-        node->resume();
-    }
+    sendCommand(key,AudioCommand::Type::RESUME,0);
 }
 
 
@@ -1198,16 +1475,15 @@ void AudioEngine::resume(std::string key) {
 void AudioEngine::clearEffects(float fade) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
     for(auto it = _actives.begin(); it != _actives.end(); ++it) {
-        auto node = it->second;
         if (fade == 0) {
-            _slots[node->getTag()]->skip();
-        } else if (!node->isFadeOut()) {
-            _slots[node->getTag()]->setLoops(0);
-            node->fadeOut(fade);
+            _slots[it->second->getTag()]->skip();
+        } else {
+            sendCommand(it->first,AudioCommand::Type::CLEAR,fade);
         }
     }
     _actives.clear();
     _evicts.clear();
+    _voices.clear();
 }
 
 /**
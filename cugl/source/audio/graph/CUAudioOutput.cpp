@@ -49,6 +49,7 @@
 #include <cugl/audio/graph/CUAudioRedistributor.h>
 #include <cugl/audio/CUAudioDevices.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUAllocTracker.h>
 #include <cugl/util/CUTimestamp.h>
 #include <atomic>
 #include <cstring>
@@ -68,6 +69,7 @@ const static std::string DEFAULT_NAME("(DEFAULT DEVICE)");
  * This is the function that SDL uses to populate the audio buffer
  */
 static void audioCallback(void*  userdata, Uint8* stream, int len) {
+    CU_ALLOC_TAG(AUDIO);
     AudioOutput* device = (AudioOutput*)userdata;
     device->poll(stream,len);
 }
@@ -56,6 +56,13 @@ NetcodeConfig::NetcodeConfig() {
 	maxMessage = 0;
 	maxPlayers = 2;
 	apiVersion = 0;
+    syncBudget = 0;
+    syncSpeedWeight = 1.0f;
+    syncDistanceWeight = 4.0f;
+    syncStaleWeight = 0.25f;
+    syncUnownedWeight = 0.0f;
+    hashInterval = 0;
+    snapshotInterval = 0;
 }
 
 /**
@@ -73,6 +80,13 @@ NetcodeConfig::NetcodeConfig(const InetAddress& lobby) {
 	maxMessage = 0;
 	maxPlayers = 2;
 	apiVersion = 0;
+    syncBudget = 0;
+    syncSpeedWeight = 1.0f;
+    syncDistanceWeight = 4.0f;
+    syncStaleWeight = 0.25f;
+    syncUnownedWeight = 0.0f;
+    hashInterval = 0;
+    snapshotInterval = 0;
 }
 
 /**
@@ -91,6 +105,13 @@ NetcodeConfig::NetcodeConfig(const InetAddress& lobby, const ICEAddress& iceServ
 	maxMessage = 0;
 	maxPlayers = 2;
 	apiVersion = 0;
+    syncBudget = 0;
+    syncSpeedWeight = 1.0f;
+    syncDistanceWeight = 4.0f;
+    syncStaleWeight = 0.25f;
+    syncUnownedWeight = 0.0f;
+    hashInterval = 0;
+    snapshotInterval = 0;
 }
 
 /**
@@ -108,6 +129,11 @@ NetcodeConfig::NetcodeConfig(const InetAddress& lobby, const ICEAddress& iceServ
  *      "max message":  An int respresenting the maximum transmission size
  *      "max players":  An int respresenting the maximum number of players
  *      "API version":  An int respresenting the API version
+ *      "sync budget":  An int representing the physics bytes per peer per update
+ *      "sync weights": An object with optional float keys "speed", "distance",
+ *                      "stale", and "unowned" for synchronization priority
+ *      "hash interval": An int representing the ticks between state hashes
+ *      "snapshot interval": An int representing the ticks between state snapshots
  *
  * @param pref      The configuration settings
  */
@@ -135,6 +161,14 @@ NetcodeConfig::NetcodeConfig(const std::shared_ptr<JsonValue>& prefs) {
 	maxMessage = prefs->getInt("max message",0);
 	maxPlayers = prefs->getInt("max players",2);
 	apiVersion = prefs->getInt("API version",0);
+    syncBudget = prefs->getInt("sync budget",0);
+    auto weights = prefs->get("sync weights");
+    syncSpeedWeight = weights ? weights->getFloat("speed",1.0f) : 1.0f;
+    syncDistanceWeight = weights ? weights->getFloat("distance",4.0f) : 4.0f;
+    syncStaleWeight = weights ? weights->getFloat("stale",0.25f) : 0.25f;
+    syncUnownedWeight = weights ? weights->getFloat("unowned",0.0f) : 0.0f;
+    hashInterval = prefs->getInt("hash interval",0);
+    snapshotInterval = prefs->getInt("snapshot interval",0);
 }
 
 /**
@@ -162,6 +196,13 @@ NetcodeConfig& NetcodeConfig::set(const NetcodeConfig& src) {
 	maxMessage = src.maxMessage;
 	maxPlayers = src.maxPlayers;
 	apiVersion = src.apiVersion;
+    syncBudget = src.syncBudget;
+    syncSpeedWeight = src.syncSpeedWeight;
+    syncDistanceWeight = src.syncDistanceWeight;
+    syncStaleWeight = src.syncStaleWeight;
+    syncUnownedWeight = src.syncUnownedWeight;
+    hashInterval = src.hashInterval;
+    snapshotInterval = src.snapshotInterval;
 	return *this;
 }
 
@@ -182,6 +223,13 @@ NetcodeConfig& NetcodeConfig::set(const std::shared_ptr<NetcodeConfig>& src) {
 	maxMessage = src->maxMessage;
 	maxPlayers = src->maxPlayers;
 	apiVersion = src->apiVersion;
+    syncBudget = src->syncBudget;
+    syncSpeedWeight = src->syncSpeedWeight;
+    syncDistanceWeight = src->syncDistanceWeight;
+    syncStaleWeight = src->syncStaleWeight;
+    syncUnownedWeight = src->syncUnownedWeight;
+    hashInterval = src->hashInterval;
+    snapshotInterval = src->snapshotInterval;
 	return *this;
 }
 
@@ -199,6 +247,11 @@ NetcodeConfig& NetcodeConfig::set(const std::shared_ptr<NetcodeConfig>& src) {
  *      "max message":  An int respresenting the maximum transmission size
  *      "max players":  An int respresenting the maximum number of players
  *      "API version":  An int respresenting the API version
+ *      "sync budget":  An int representing the physics bytes per peer per update
+ *      "sync weights": An object with optional float keys "speed", "distance",
+ *                      "stale", and "unowned" for synchronization priority
+ *      "hash interval": An int representing the ticks between state hashes
+ *      "snapshot interval": An int representing the ticks between state snapshots
  *
  * @param pref      The address settings
  *
@@ -229,5 +282,13 @@ NetcodeConfig& NetcodeConfig::set(const std::shared_ptr<JsonValue>& prefs) {
 	maxMessage = prefs->getInt("max message",0);
 	maxPlayers = prefs->getInt("max players",2);
 	apiVersion = prefs->getInt("API version",0);
+    syncBudget = prefs->getInt("sync budget",0);
+    auto weights = prefs->get("sync weights");
+    syncSpeedWeight = weights ? weights->getFloat("speed",1.0f) : 1.0f;
+    syncDistanceWeight = weights ? weights->getFloat("distance",4.0f) : 4.0f;
+    syncStaleWeight = weights ? weights->getFloat("stale",0.25f) : 0.25f;
+    syncUnownedWeight = weights ? weights->getFloat("unowned",0.0f) : 0.0f;
+    hashInterval = prefs->getInt("hash interval",0);
+    snapshotInterval = prefs->getInt("snapshot interval",0);
 	return *this;
 }
@@ -64,6 +64,7 @@
 #include <cugl/assets/CUJsonValue.h>
 #include <cugl/base/CUApplication.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUAllocTracker.h>
 #include <stduuid/uuid.h>
 #include <stdexcept>
 #include <algorithm>
@@ -338,6 +339,7 @@ void NetcodeConnection::onClosed() {
  * @param data  The message received
  */
 void NetcodeConnection::onMessage(message_variant data) {
+	CU_ALLOC_TAG(NET);
 	// data holds either std::string or rtc::binary
 	if (!std::holds_alternative<std::string>(data)) {
 		return;
@@ -1240,6 +1242,7 @@ void NetcodeConnection::close() {
  * @return true if the message was (apparently) sent
  */
 bool NetcodeConnection::sendTo(const std::string dst, const std::vector<std::byte>& data) {
+	CU_ALLOC_TAG(NET);
 	std::shared_ptr<NetcodeChannel> channel;
     bool self = false;
 	
@@ -1306,6 +1309,7 @@ bool NetcodeConnection::sendTo(const std::string dst, const std::vector<std::byt
  * @return true if the message was (apparently) sent
  */
 bool NetcodeConnection::sendToHost(const std::vector<std::byte>& data) {
+	CU_ALLOC_TAG(NET);
     std::shared_ptr<NetcodeChannel> channel;
     bool self = false;
     std::string uuid;
@@ -1374,6 +1378,7 @@ bool NetcodeConnection::sendToHost(const std::vector<std::byte>& data) {
  * @return true if the message was (apparently) sent
  */
 bool NetcodeConnection::broadcast(const std::vector<std::byte>& data) {
+	CU_ALLOC_TAG(NET);
     std::vector<std::shared_ptr<NetcodeChannel>> channels;
     bool success = true;
     std::string uuid;
@@ -1423,6 +1428,7 @@ bool NetcodeConnection::broadcast(const std::vector<std::byte>& data) {
  * @param dispatcher    The function to process received data
  */
 void NetcodeConnection::receive(const Dispatcher& dispatcher) {
+	CU_ALLOC_TAG(NET);
 	if (dispatcher == nullptr || _socket == nullptr) {
 		return;
 	}
@@ -64,6 +64,7 @@ Obstacle::Obstacle() :
 _scene(nullptr),
 _debug(nullptr),
 _listener(nullptr),
+_updateSafe(false),
 _body(nullptr) {
     _posSnap = _angSnap = -1;
 }
@@ -107,6 +108,33 @@ bool Obstacle::init(const Vec2 vec) {
     return true;
 }
 
+/**
+ * Restores this physics object to the state of a new object.
+ *
+ * This is the recycling hook used by {@link FreeList}. It clears the body
+ * and fixture definitions, the listener and the sharing state, and detaches
+ * the debug wireframe from its scene (the wireframe itself is kept so that
+ * it can be reused). The object may be initialized again afterwards.
+ *
+ * Physics must be deactivated before an object is reset.
+ */
+void Obstacle::reset() {
+    CUAssertLog(_body == nullptr, "You must deactivate physics before resetting an object");
+    setDebugScene(nullptr);
+    _bodyinfo = b2BodyDef();
+    _fixture = b2FixtureDef();
+    _massdata = b2MassData();
+    _masseffect = false;
+    _tag.clear();
+    _listener = nullptr;
+    _updateSafe = false;
+    _posSnap = _angSnap = -1;
+    _shared = false;
+    _remove = false;
+    _dirty = false;
+    clearSharingDirtyBits();
+}
+
 /**
  * Copies the state from the given body to the body def.
  *
@@ -403,6 +431,10 @@ void Obstacle::setDebugScene(const std::shared_ptr<scene2::SceneNode>& node) {
     if (node != nullptr) {
         _scene = node;
         resetDebug();
+        // A recycled wireframe is not added by resetDebug
+        if (_debug != nullptr && _debug->getParent() == nullptr) {
+            _scene->addChild(_debug);
+        }
         updateDebug();
     }
 }
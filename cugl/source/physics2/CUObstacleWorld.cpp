@@ -49,10 +49,17 @@
 #include <cugl/physics2/CUObstacleWorld.h>
 #include <cugl/physics2/CUObstacle.h>
 #include <cugl/physics2/CUJoint.h>
+#include <cugl/util/CUAllocTracker.h>
+#include <algorithm>
 
 using namespace cugl;
 using namespace cugl::physics2;
 
+/** The number of obstacles per job when updating obstacles in parallel */
+#define UPDATE_GRAIN    64
+/** The number of island jobs per thread, to balance uneven islands */
+#define ISLAND_SPLIT    4
+
 #pragma mark Constants
 
 /** The default value of gravity (going down) */
@@ -199,6 +206,8 @@ void ObstacleWorld::dispose() {
     shouldCollide  = nullptr;
     destroyFixture = nullptr;
     destroyJoint   = nullptr;
+    _jobs = nullptr;
+    _parallel.clear();
 }
 
 /**
@@ -235,6 +244,7 @@ bool ObstacleWorld::init(const Rect bounds, const Vec2 gravity) {
     _bounds = bounds;
     _world = new b2World(b2Vec2(gravity.x, gravity.y));
     if (_world) {
+        _world->SetTaskExecutor(_jobs ? this : nullptr);
         return true;
     }
     return false;
@@ -423,6 +433,34 @@ void ObstacleWorld::setGravity(const Vec2 gravity) {
     }
 }
 
+/**
+ * Sets the job system for parallel physics steps.
+ *
+ * With a job system, the islands of each step (groups of bodies that
+ * touch or are joined) are solved in parallel.  Islands that touch the
+ * same static body are solved together, so every island is solved just
+ * as on one thread, and the result of a step does not change.  However,
+ * the {@link #afterSolve} callback may run on a worker thread (though
+ * never at the same time as another callback).  The other callbacks
+ * still run on the calling thread.
+ *
+ * After the step, the obstacles that are {@link Obstacle#isUpdateThreadSafe}
+ * are updated in parallel.  All other obstacles are updated on the calling
+ * thread first.
+ *
+ * If this value is nullptr, the world is stepped on the calling thread.
+ * The job system should not be shared with long running jobs, as every
+ * step waits on its workers.
+ *
+ * @param jobs  The job system for parallel physics steps.
+ */
+void ObstacleWorld::setJobSystem(const std::shared_ptr<JobSystem>& jobs) {
+    _jobs = jobs;
+    if (_world != nullptr) {
+        _world->SetTaskExecutor(_jobs ? this : nullptr);
+    }
+}
+
 /**
  * Executes a single step of the physics engine.
  *
@@ -438,13 +476,27 @@ void ObstacleWorld::setGravity(const Vec2 gravity) {
  * @param dt    Number of seconds since last animation frame
  */
 void ObstacleWorld::update(float dt) {
+    CU_ALLOC_TAG(PHYSICS2);
     // Turn the physics engine crank.
     _world->Step((_lockstep ? _stepssize : dt),_itvelocity,_itposition);
     
     // Post process all objects after physics (this updates graphics)
+    _parallel.clear();
     for(auto it = _obstacles.begin() ; it != _obstacles.end(); ++it) {
         Obstacle* obj = it->get();
-        obj->update(dt);
+        if (_jobs && obj->isUpdateThreadSafe() && !obj->isDirty()) {
+            _parallel.push_back(obj);
+        } else {
+            obj->update(dt);
+        }
+    }
+    if (!_parallel.empty()) {
+        _jobs->parallel_for(0, _parallel.size(), UPDATE_GRAIN, [this,dt](size_t start, size_t stop) {
+            CU_ALLOC_TAG(PHYSICS2);
+            for(size_t ii = start; ii < stop; ii++) {
+                _parallel[ii]->update(dt);
+            }
+        });
     }
     
     // Do we really need something for joints?
@@ -549,6 +601,27 @@ void ObstacleWorld::SayGoodbye(b2Joint* joint) {
 }
 
 
+#pragma mark -
+#pragma mark Task Functions
+/**
+ * Runs the items [0, count) of a Box2d task with the job system.
+ *
+ * This method is the static callback required by the Box2d API.  It should
+ * not be altered.  It is only called when the world has a job system.
+ *
+ * @param  task     the Box2d task to run
+ * @param  count    the number of items in the task
+ */
+void ObstacleWorld::ParallelFor(b2Task* task, int32 count) {
+    size_t jobs  = ISLAND_SPLIT*(_jobs->getThreadCount()+1);
+    size_t grain = std::max((size_t)1,(size_t)count/jobs);
+    _jobs->parallel_for(0, (size_t)count, grain, [task](size_t start, size_t stop) {
+        CU_ALLOC_TAG(PHYSICS2);
+        task->Execute((int32)start,(int32)stop);
+    });
+}
+
+
 #pragma mark -
 #pragma mark Query Functions
 /**
@@ -28,6 +28,8 @@
 //  Version: 11/13/23
 //
 #include <cugl/physics2/net/CUGameStateEvent.h>
+#include <cugl/physics2/net/CULWSerializer.h>
+#include <cugl/physics2/net/CULWDeserializer.h>
 
 using namespace cugl;
 using namespace cugl::physics2;
@@ -60,6 +62,41 @@ std::vector<std::byte> GameStateEvent::serialize() {
             data.push_back(std::byte(EventType::UID_ASSIGN));
             data.push_back(std::byte(_shortUID));
             break;
+        case EventType::STATE_HASH:
+        {
+            LWSerializer serializer;
+            serializer.writeByte(std::byte(EventType::STATE_HASH));
+            serializer.writeUint32(_epoch);
+            serializer.writeUint64(_tick);
+            serializer.writeUint32(_hash);
+            data = serializer.serialize();
+            break;
+        }
+        case EventType::STATE_DIGEST:
+        {
+            LWSerializer serializer;
+            serializer.writeByte(std::byte(EventType::STATE_DIGEST));
+            serializer.writeUint32(_epoch);
+            serializer.writeUint64(_tick);
+            serializer.writeUint32((Uint32)_digests.size());
+            for(auto it = _digests.begin(); it != _digests.end(); ++it) {
+                serializer.writeUint64(it->first);
+                serializer.writeUint32(it->second);
+            }
+            data = serializer.serialize();
+            break;
+        }
+        case EventType::STATE_SNAPSHOT:
+        case EventType::STATE_HANDOFF:
+        {
+            // The packed state is appended raw, so no length prefix
+            LWSerializer serializer;
+            serializer.writeByte(std::byte(_type));
+            serializer.writeUint64(_tick);
+            data = serializer.serialize();
+            data.insert(data.end(), _snapshot.begin(), _snapshot.end());
+            break;
+        }
         default:
             CUAssertLog(false, "Serializing invalid game state event type");
     }
@@ -93,6 +130,46 @@ void GameStateEvent::deserialize(const std::vector<std::byte>& data) {
             _type = EventType::UID_ASSIGN;
             _shortUID = (Uint8)data[1];
             break;
+        case EventType::STATE_HASH:
+        {
+            _type = EventType::STATE_HASH;
+            LWDeserializer deserializer;
+            deserializer.receive(data);
+            deserializer.readByte();
+            _epoch = deserializer.readUint32();
+            _tick = deserializer.readUint64();
+            _hash = deserializer.readUint32();
+            break;
+        }
+        case EventType::STATE_DIGEST:
+        {
+            _type = EventType::STATE_DIGEST;
+            LWDeserializer deserializer;
+            deserializer.receive(data);
+            deserializer.readByte();
+            _epoch = deserializer.readUint32();
+            _tick = deserializer.readUint64();
+            Uint32 size = deserializer.readUint32();
+            _digests.clear();
+            _digests.reserve(size);
+            for(Uint32 ii = 0; ii < size; ii++) {
+                Uint64 oid = deserializer.readUint64();
+                Uint32 hash = deserializer.readUint32();
+                _digests.emplace_back(oid, hash);
+            }
+            break;
+        }
+        case EventType::STATE_SNAPSHOT:
+        case EventType::STATE_HANDOFF:
+        {
+            _type = flag;
+            LWDeserializer deserializer;
+            deserializer.receive(data);
+            deserializer.readByte();
+            _tick = deserializer.readUint64();
+            _snapshot.assign(data.begin()+sizeof(Uint8)+sizeof(Uint64), data.end());
+            break;
+        }
         default:
             CUAssertLog(false, "Deserializing game state event type");
     }
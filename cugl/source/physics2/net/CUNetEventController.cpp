@@ -46,6 +46,7 @@
 #include <cugl/physics2/net/CUNetEventController.h>
 #include <cugl/physics2/net/CULWSerializer.h>
 #include <cugl/net/CUNetworkLayer.h>
+#include <cugl/util/CUAllocTracker.h>
 
 /** The minimum message length */
 #define MIN_MSG_LENGTH sizeof(std::byte)+sizeof(Uint64)
@@ -66,13 +67,21 @@ using namespace cugl::physics2::net;
  * the heap, use one of the static constructors instead.
  */
 NetEventController::NetEventController(void):
+_startGameTimeStamp(0),
+_status(Status::IDLE),
+_roomid(""),
 _isHost(false),
-_shortUID(0),
 _numReady(0),
-_roomid(""),
+_shortUID(0),
 _physEnabled(false),
-_status(Status::IDLE),
-_startGameTimeStamp(0) {
+_hashEpoch(0),
+_desynced(false),
+_desyncTick(0),
+_snapshotTick(0),
+_migrating(false),
+_handoffPending(false),
+_restoreTime(0),
+_handoffLatency(0) {
 }
 
 /**
@@ -137,6 +146,9 @@ bool NetEventController::connectAsHost() {
     if (_status == Status::IDLE) {
         _status = Status::CONNECTING;
         _network = cugl::net::NetcodeConnection::alloc(_config);
+        _network->onPromotion([this](bool confirmed) {
+            return promoteToHost(confirmed);
+        });
         _network->open();
     }
     return checkConnection();
@@ -158,6 +170,9 @@ bool NetEventController::connectAsClient(std::string roomID) {
     if (_status == Status::IDLE) {
         _status = Status::CONNECTING;
         _network = cugl::net::NetcodeConnection::alloc(_config, roomID);
+        _network->onPromotion([this](bool confirmed) {
+            return promoteToHost(confirmed);
+        });
         _network->open();
     }
     _roomid = roomID;
@@ -174,13 +189,21 @@ void NetEventController::disconnect() {
     }
     _network = nullptr;
     _physController = nullptr;
+    stopRecording();
     _shortUID = 0;
     _status = Status::IDLE;
     _physEnabled = false;
     _isHost = false;
+    disableStateHashing();
+    _hashEpoch = 0;
+    _snapshot.clear();
+    _snapshotTick = 0;
+    _migrating = false;
+    _handoffPending = false;
     _startGameTimeStamp = 0;
     _numReady = 0;
     _outEventQueue.clear();
+    _targetedOutQueue.clear();
     
     while (!_inEventQueue.empty()) {
         _inEventQueue.pop();
@@ -240,6 +263,10 @@ Uint64 NetEventController::getGameTick() const {
  * with a listener, and then adds that scene node to a scene graph. See
  * {@link NetPhysicsController} for more information.
  *
+ * If the network configuration has a positive sync budget, the controller
+ * synchronizes with {@link NetPhysicsController::SyncType#PRIO_SYNC}.
+ * Otherwise it uses {@link NetPhysicsController::SyncType#FULL_SYNC}.
+ *
  * @param world The physics world to be synchronized.
  * @param linkFunc Function that links a scene node to an obstacle.
  */
@@ -247,6 +274,9 @@ void NetEventController::enablePhysics(std::shared_ptr<NetWorld>& world, Obstacl
     CUAssertLog(_shortUID, "You must receive a UID assigned from host before enabling physics.");
     _physEnabled = true;
     _physController = NetPhysicsController::alloc(world,_shortUID,_isHost,linkFunc);
+    _physController->setSyncConfig(_config);
+    _snapshot.clear();
+    _snapshotTick = 0;
     //CULog("ENABLED PHYSICS");
     attachEventType<PhysSyncEvent>();
     attachEventType<PhysObstEvent>();
@@ -263,6 +293,247 @@ void NetEventController::disablePhysics() {
     _physController = nullptr;
 }
 
+#pragma mark Host Migration
+/**
+ * Returns a snapshot of the networked world and the game state.
+ *
+ * The world is written by {@link NetWorld#writeSnapshot}, followed by
+ * anything written by {@link #onSaveState}.
+ *
+ * @return a snapshot of the networked world and the game state.
+ */
+std::vector<std::byte> NetEventController::packSnapshot() {
+    LWSerializer serializer;
+    _physController->getWorld()->writeSnapshot(serializer);
+    if (onSaveState) {
+        onSaveState(serializer);
+    }
+    return serializer.serialize();
+}
+
+/**
+ * Restores a snapshot created by {@link #packSnapshot}.
+ *
+ * @param snapshot  The snapshot to restore
+ */
+void NetEventController::restoreSnapshot(const std::vector<std::byte>& snapshot) {
+    LWDeserializer deserializer;
+    deserializer.receive(snapshot);
+    _physController->getWorld()->readSnapshot(deserializer);
+    if (onRestoreState) {
+        onRestoreState(deserializer);
+    }
+}
+
+/**
+ * Responds to a promotion offer during host migration.
+ *
+ * This is the {@link cugl::net::NetcodeConnection#PromotionCallback} of
+ * the connection. This controller is a candidate if it is in game and
+ * holds a snapshot. When confirmed, it restores the snapshot and takes
+ * over as host within the same frame.
+ *
+ * @param confirmed Whether this connection is confirmed as the new host
+ *
+ * @return true if this controller is willing to become host
+ */
+bool NetEventController::promoteToHost(bool confirmed) {
+    bool ready = _status == Status::INGAME && _physEnabled && !_snapshot.empty();
+    if (!confirmed || !ready) {
+        return ready;
+    }
+    
+    if (!_migrating) {
+        // The offer can arrive in the same frame the migration started
+        _migrating = true;
+        _migrationStart.mark();
+    }
+    
+    Timestamp start;
+    _isHost = true;
+    _physController->promoteToHost();
+    restoreSnapshot(_snapshot);
+    if (onPromotion) {
+        onPromotion();
+    }
+    _restoreTime = Timestamp::ellapsedMicros(start, Timestamp());
+    _handoffPending = true;
+    CULog("NET PHYSICS: Promoted to host, restored tick %llu in %llu us",
+          (unsigned long long)_snapshotTick, (unsigned long long)_restoreTime);
+    return true;
+}
+
+/**
+ * Completes a host handoff once the migration is finished.
+ *
+ * The promoted host sends its restored state to the remaining clients,
+ * which restore it immediately.
+ */
+void NetEventController::completeHandoff() {
+    _handoffPending = false;
+    _snapshot = packSnapshot();
+    _snapshotTick = getGameTick();
+    pushOutEvent(GameStateEvent::allocStateSnapshot(_snapshotTick, _snapshot, true));
+    _handoffLatency = Timestamp::ellapsedMicros(_migrationStart, Timestamp());
+    CULog("NET PHYSICS: Host handoff complete in %llu us",
+          (unsigned long long)_handoffLatency);
+}
+
+#pragma mark Recording
+/**
+ * Stops recording network traffic, flushing the log.
+ */
+void NetEventController::stopRecording() {
+    if (_recorder) {
+        _recorder->flush();
+        _recorder = nullptr;
+    }
+}
+
+#pragma mark Desync Detection
+/** The number of hashing ticks to remember while waiting for peers */
+#define HASH_HISTORY    16
+/** The maximum number of divergent obstacle ids to log */
+#define HASH_MAX_LOGGED 16
+
+/**
+ * Enables world state hashing for desync detection.
+ *
+ * Once enabled, {@link #hashState} hashes the world every
+ * {@link cugl::net::NetcodeConfig#hashInterval} ticks and shares the
+ * result with all peers. The first tick at which the hashes disagree is
+ * logged together with the ids of the obstacles that differ.
+ *
+ * Calling this method again (e.g. when the world is rebuilt for a new
+ * round) starts a new epoch and forgets all previous hashes. Hence all
+ * peers must call it the same number of times.
+ *
+ * @param world The physics world to hash
+ */
+void NetEventController::enableStateHashing(const std::shared_ptr<NetWorld>& world) {
+    disableStateHashing();
+    _hashWorld = world;
+    _hashEpoch++;
+}
+
+/**
+ * Disables world state hashing.
+ */
+void NetEventController::disableStateHashing() {
+    _hashWorld = nullptr;
+    _localHashes.clear();
+    _localDigests.clear();
+    _remoteHashes.clear();
+    _desynced = false;
+    _desyncTick = 0;
+}
+
+/**
+ * Hashes the world state at the given tick, if it is a hashing tick.
+ *
+ * This method should be called after every simulation step, with a tick
+ * that all peers agree on. With lockstep simulation, this is the lockstep
+ * tick. With synchronized physics, {@link #getGameTick} may be used, but
+ * then the hash precision of the world must be coarse enough to absorb
+ * the network delay.
+ *
+ * @param tick  The simulation tick
+ */
+void NetEventController::hashState(Uint64 tick) {
+    Uint32 interval = _config.hashInterval;
+    if (_hashWorld == nullptr || interval == 0 || tick % interval != 0 ||
+        _status != Status::INGAME || _localHashes.count(tick)) {
+        return;
+    }
+    
+    std::vector<std::pair<Uint64,Uint32>>& digests = _localDigests[tick];
+    Uint32 hash = _hashWorld->computeStateHash(&digests);
+    _localHashes[tick] = hash;
+    pushOutEvent(GameStateEvent::allocStateHash(_hashEpoch, tick, hash));
+    checkStateHash(tick);
+    
+    // Forget hashes that peers should have answered long ago
+    if (tick >= (Uint64)interval*HASH_HISTORY) {
+        Uint64 cutoff = tick-(Uint64)interval*HASH_HISTORY;
+        _localHashes.erase(_localHashes.begin(), _localHashes.lower_bound(cutoff));
+        _localDigests.erase(_localDigests.begin(), _localDigests.lower_bound(cutoff));
+        _remoteHashes.erase(_remoteHashes.begin(), _remoteHashes.lower_bound(cutoff));
+    }
+}
+
+/**
+ * Compares the local state hash of a tick with those of the peers.
+ *
+ * On the first mismatch, this logs the tick and broadcasts the local
+ * per-obstacle hashes so that peers can report the divergent obstacles.
+ *
+ * @param tick  The tick to compare
+ */
+void NetEventController::checkStateHash(Uint64 tick) {
+    auto local = _localHashes.find(tick);
+    auto remote = _remoteHashes.find(tick);
+    if (_desynced || local == _localHashes.end() || remote == _remoteHashes.end()) {
+        return;
+    }
+    
+    for(auto it = remote->second.begin(); it != remote->second.end(); ++it) {
+        if (it->second != local->second) {
+            _desynced = true;
+            _desyncTick = tick;
+            CUWarn("NET PHYSICS: Desync at tick %llu with %s (local %08x, remote %08x)",
+                   (unsigned long long)tick, it->first.c_str(), local->second, it->second);
+            pushOutEvent(GameStateEvent::allocStateDigest(_hashEpoch, tick, _localDigests[tick]));
+            return;
+        }
+    }
+}
+
+/**
+ * Compares per-obstacle hashes from a peer with the local ones.
+ *
+ * This logs the ids of all obstacles that differ.
+ *
+ * @param e The received digest event
+ */
+void NetEventController::processStateDigest(const std::shared_ptr<GameStateEvent>& e) {
+    auto local = _localDigests.find(e->getTick());
+    if (local == _localDigests.end()) {
+        CUWarn("NET PHYSICS: No local hashes for divergent tick %llu",
+               (unsigned long long)e->getTick());
+        return;
+    }
+    if (!_desynced) {
+        _desynced = true;
+        _desyncTick = e->getTick();
+    }
+    
+    std::unordered_map<Uint64, Uint32> mine(local->second.begin(), local->second.end());
+    size_t count = 0;
+    for(auto it = e->getDigests().begin(); it != e->getDigests().end(); ++it) {
+        auto jt = mine.find(it->first);
+        if (jt == mine.end() || jt->second != it->second) {
+            if (count < HASH_MAX_LOGGED) {
+                CUWarn("NET PHYSICS: Obstacle %016llx diverged at tick %llu",
+                       (unsigned long long)it->first, (unsigned long long)e->getTick());
+            }
+            count++;
+        }
+        if (jt != mine.end()) {
+            mine.erase(jt);
+        }
+    }
+    for(auto it = mine.begin(); it != mine.end(); ++it) {
+        if (count < HASH_MAX_LOGGED) {
+            CUWarn("NET PHYSICS: Obstacle %016llx missing on %s at tick %llu",
+                   (unsigned long long)it->first, e->getSourceId().c_str(),
+                   (unsigned long long)e->getTick());
+        }
+        count++;
+    }
+    CUWarn("NET PHYSICS: %zu obstacles diverged from %s at tick %llu",
+           count, e->getSourceId().c_str(), (unsigned long long)e->getTick());
+}
+
 
 #pragma mark Event Management
 /**
@@ -317,21 +588,47 @@ void NetEventController::pushOutEvent(const std::shared_ptr<NetEvent>& e) {
  * events.
  */
 void NetEventController::updateNet() {
+    CU_ALLOC_TAG(NET);
     if(_network){
         checkConnection();
+        
+        if (_migrating) {
+            // Nothing can be sent until a new host is chosen
+            processReceivedData();
+            return;
+        }
 
         if (_status == Status::INGAME && _physEnabled) {
-            _physController->packPhysSync(NetPhysicsController::SyncType::FULL_SYNC);
+            if (_physController->getSyncBudget() > 0) {
+                // Clients can only reach other clients through a broadcast
+                std::unordered_set<std::string> peers;
+                if (_isHost) {
+                    peers = _network->getPlayers();
+                    peers.erase(_network->getUUID());
+                }
+                _physController->setPeers(peers);
+                _physController->packPhysSync(NetPhysicsController::SyncType::PRIO_SYNC);
+            } else {
+                _physController->packPhysSync(NetPhysicsController::SyncType::FULL_SYNC);
+            }
             _physController->packPhysObj();
             _physController->updateSimulation();
             for (auto it = _physController->getOutEvents().begin(); it != _physController->getOutEvents().end(); it++) {
                 pushOutEvent(*it);
-                auto physevent =std::dynamic_pointer_cast<cugl::physics2::net::PhysSyncEvent>((*it));
-                                if (physevent != nullptr) {
-//                                    std::cout << physevent->getSyncList().size() << "\n";
-                                }
             }
             _physController->getOutEvents().clear();
+            auto& targeted = _physController->getTargetedOutEvents();
+            _targetedOutQueue.insert(_targetedOutQueue.end(), targeted.begin(), targeted.end());
+            targeted.clear();
+            
+            Uint64 tick = getGameTick();
+            // The tick advances in fixed steps, which need not happen every frame
+            if (_isHost && _config.snapshotInterval > 0 &&
+                tick-_snapshotTick >= _config.snapshotInterval) {
+                _snapshot = packSnapshot();
+                _snapshotTick = tick;
+                pushOutEvent(GameStateEvent::allocStateSnapshot(tick, _snapshot));
+            }
         }
         
         processReceivedData();
@@ -400,6 +697,9 @@ void NetEventController::processReceivedData(){
         //if (cugl::net::NetworkLayer::get()->isDebug()) {
         //    CULog("DATA %d, CUR STATE %d, SOURCE %s", data[0], _status, source.c_str());
         //}
+        if (_recorder) {
+            _recorder->recordInbound(getGameTick(), source, data);
+        }
         processReceivedEvent(unwrap(data, source));
     });
 }
@@ -454,6 +754,25 @@ void NetEventController::processGameStateEvent(const std::shared_ptr<GameStateEv
         _status = Status::INGAME;
         _startGameTimeStamp = Application::get()->getFixedCount();
     }
+    if (_status == Status::INGAME && _hashWorld != nullptr && e->getEpoch() == _hashEpoch &&
+        e->getSourceId() != _network->getUUID()) {
+        if (e->getType() == GameStateEvent::EventType::STATE_HASH) {
+            _remoteHashes[e->getTick()][e->getSourceId()] = e->getHash();
+            checkStateHash(e->getTick());
+        } else if (e->getType() == GameStateEvent::EventType::STATE_DIGEST) {
+            processStateDigest(e);
+        }
+    }
+    if (_status == Status::INGAME && !_isHost &&
+        (e->getType() == GameStateEvent::EventType::STATE_SNAPSHOT ||
+         e->getType() == GameStateEvent::EventType::STATE_HANDOFF)) {
+        _snapshot = e->getSnapshot();
+        _snapshotTick = e->getTick();
+        if (e->getType() == GameStateEvent::EventType::STATE_HANDOFF && _physEnabled) {
+            restoreSnapshot(_snapshot);
+            CULog("NET PHYSICS: Restored handoff from new host %s", e->getSourceId().c_str());
+        }
+    }
     if (_isHost) {
         if (e->getType() == GameStateEvent::EventType::CLIENT_RDY) {
             _numReady++;
@@ -478,6 +797,21 @@ bool NetEventController::checkConnection() {
     auto state = _network->getState();
     bool debug = cugl::net::NetworkLayer::get()->isDebug();
 
+    if (state == cugl::net::NetcodeConnection::State::MIGRATING) {
+        if (!_migrating) {
+            _migrating = true;
+            _migrationStart.mark();
+            CULog("NET PHYSICS: Host migration started");
+        }
+        return true;
+    } else if (_migrating) {
+        _migrating = false;
+        if (_handoffPending && state == cugl::net::NetcodeConnection::State::INSESSION) {
+            completeHandoff();
+        }
+        _handoffPending = false;
+    }
+
     if (state == cugl::net::NetcodeConnection::State::CONNECTED) {
         if(_status == Status::CONNECTING || _status == Status::IDLE)
             _status = Status::CONNECTED;
@@ -534,8 +868,22 @@ void NetEventController::sendQueuedOutData(){
         msgCount++;
         byteCount += wrapped.size();
         //CULog("flag: %x", (std::byte)getType(*e))
-        _network->broadcast(wrap(e));
+        if (_recorder) {
+            _recorder->recordOutbound(getGameTick(), "", wrapped);
+        }
+        _network->broadcast(wrapped);
     }
     _outEventQueue.clear();
+    
+    for(auto it = _targetedOutQueue.begin(); it != _targetedOutQueue.end(); it++){
+        auto wrapped = wrap(it->second);
+        msgCount++;
+        byteCount += wrapped.size();
+        if (_recorder) {
+            _recorder->recordOutbound(getGameTick(), it->first, wrapped);
+        }
+        _network->sendTo(it->first, wrapped);
+    }
+    _targetedOutQueue.clear();
 }
 
@@ -0,0 +1,161 @@
+//
+//  CUNetEventRecorder.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a recorder for the network traffic of a session. It
+//  appends every wrapped event sent or received by a NetEventController to a
+//  compact binary log, so that the traffic of real matches can be inspected
+//  and measured offline.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+#include <cugl/physics2/net/CUNetEventRecorder.h>
+#include <cugl/util/CUDebug.h>
+
+using namespace cugl;
+using namespace cugl::physics2::net;
+
+/** The size of the write buffer; large so that recording rarely touches the disk */
+#define RECORD_BUFFER   (1 << 16)
+
+#pragma mark Constructors
+/**
+ * Creates a degenerate recorder with no log file.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+NetEventRecorder::NetEventRecorder() :
+_lastTick(0),
+_count(0),
+_bytes(0) {
+}
+
+/**
+ * Disposes this recorder, closing the log file.
+ *
+ * A disposed recorder can be safely reinitialized.
+ */
+void NetEventRecorder::dispose() {
+    if (_writer) {
+        _writer->close();
+        _writer = nullptr;
+    }
+    _peers.clear();
+    _lastTick = 0;
+    _count = 0;
+    _bytes = 0;
+}
+
+/**
+ * Initializes a recorder that writes to the given file.
+ *
+ * Any existing file with this name is replaced.
+ *
+ * @param file  The path to the log file
+ *
+ * @return true if the log file was successfully opened
+ */
+bool NetEventRecorder::init(const std::string file) {
+    if (_writer) {
+        CUAssertLog(false, "Recorder is already initialized");
+        return false;
+    }
+    _writer = BinaryWriter::alloc(file, RECORD_BUFFER);
+    if (_writer == nullptr) {
+        return false;
+    }
+    _writer->writeUint32(CU_NETLOG_MAGIC);
+    _writer->writeUint8(CU_NETLOG_VERSION);
+    return true;
+}
+
+#pragma mark Recording
+/**
+ * Returns the index of the given peer, writing its definition if needed
+ *
+ * @param peer  The peer UUID (empty for a broadcast)
+ *
+ * @return the index of the given peer
+ */
+Uint8 NetEventRecorder::getPeerIndex(const std::string& peer) {
+    if (peer.empty()) {
+        return CU_NETLOG_BROADCAST;
+    }
+    auto it = _peers.find(peer);
+    if (it != _peers.end()) {
+        return it->second;
+    }
+    
+    CUAssertLog(_peers.size() < CU_NETLOG_BROADCAST, "Too many peers to record");
+    Uint8 index = (Uint8)_peers.size();
+    _peers.emplace(peer,index);
+    _writer->writeUint8((Uint8)Record::PEER);
+    _writer->writeUint8(index);
+    _writer->writeUint16((Uint16)peer.size());
+    _writer->write(peer.c_str(), peer.size());
+    return index;
+}
+
+/**
+ * Writes a single event record to the log
+ *
+ * @param kind  The record kind
+ * @param tick  The local game tick
+ * @param peer  The source or destination UUID (empty for a broadcast)
+ * @param data  The wrapped event
+ */
+void NetEventRecorder::writeEvent(Record kind, Uint64 tick, const std::string& peer,
+                                  const std::vector<std::byte>& data) {
+    if (_writer == nullptr) {
+        return;
+    }
+    Uint8 index = getPeerIndex(peer);
+    Uint32 delta = tick > _lastTick ? (Uint32)(tick-_lastTick) : 0;
+    _lastTick = std::max(tick,_lastTick);
+    
+    _writer->writeUint8((Uint8)kind);
+    _writer->writeUint32(delta);
+    _writer->writeUint8(index);
+    _writer->writeUint32((Uint32)data.size());
+    _writer->write(reinterpret_cast<const Uint8*>(data.data()), data.size());
+    _count++;
+    _bytes += data.size();
+}
+
+/**
+ * Writes all buffered records to the log file.
+ */
+void NetEventRecorder::flush() {
+    if (_writer) {
+        _writer->flush();
+    }
+}
@@ -42,7 +42,12 @@
 #include <cugl/physics2/net/CUNetWorld.h>
 #include <cugl/physics2/net/CUNetPhysicsController.h>
 #include <cugl/physics2/net/CULWSerializer.h>
+#include <algorithm>
 
+/** The wrapped size of an empty synchronization event (type byte, tick, count) */
+#define SYNC_HEADER_BYTES   (1+sizeof(Uint64)+sizeof(Uint64))
+/** The serialized size of a single obstacle snapshot (id and 6 floats) */
+#define SYNC_ENTRY_BYTES    (sizeof(Uint64)+6*sizeof(float))
 
 using namespace cugl;
 using namespace cugl::physics2;
@@ -61,6 +66,15 @@ NetPhysicsController::TargetParams::TargetParams() {
     numI = 0;
 }
 
+/** Creates a statistics set with default values */
+NetPhysicsController::PeerStats::PeerStats() {
+    totalBytes = 0;
+    lastBytes = 0;
+    lastCount = 0;
+    maxStaleness = 0;
+    avgStaleness = 0;
+}
+
 /**
  * Creates a degenerate physics controller with default values.
  *
@@ -68,13 +82,19 @@ NetPhysicsController::TargetParams::TargetParams() {
  * the heap, use one of the static constructors instead.
  */
 NetPhysicsController::NetPhysicsController() :
+_syncBudget(0),
+_speedWeight(1.0f),
+_distanceWeight(4.0f),
+_staleWeight(0.25f),
+_unownedWeight(0.0f),
+_syncCount(0),
 _itprMethod(0),
 _itprDebug(false),
 _itprCount(0),
 _ovrdCount(0),
 _stepSum(0),
-_objRotation(0),
-_isHost(false) {
+_isHost(false),
+_objRotation(0) {
 }
 
 
@@ -116,6 +136,8 @@ void NetPhysicsController::dispose() {
     reset();
     _obstacleFacts.clear();
     _sharedObsToNodeMap.clear();
+    _peerState.clear();
+    _peerStats.clear();
     _world = nullptr;
     _isHost = false;
     _linkSceneToObsFunc = nullptr;
@@ -234,6 +256,20 @@ void NetPhysicsController::ownAll() {
     }
 }
 
+/**
+ * Makes this controller act for the host after a host migration.
+ *
+ * Pending interpolation targets came from the old host, so they are
+ * dropped. Otherwise they would pull obstacles away from the restored
+ * snapshot. Ownership is not changed; the game decides which obstacles
+ * the new host takes over.
+ */
+void NetPhysicsController::promoteToHost() {
+    _isHost = true;
+    _cache.clear();
+    _deleteCache.clear();
+}
+
 /**
  * Adds an object to interpolate with the given target parameters.
  *
@@ -578,44 +614,165 @@ void NetPhysicsController::packPhysSync(SyncType type) {
         }
             break;
         case SyncType::PRIO_SYNC:
-        {
-            std::vector<Uint64> velQueue;
-            auto objmap = _world->getObstacleMap();
-            for (auto it = objmap.begin(); it != objmap.end(); it++) {
-                Uint64 id = (*it).first;
-                auto obj = (*it).second;
-                if(obj->isShared()) {
-                    velQueue.push_back(id);
-                }
-            }
-            
-            std::sort(velQueue.begin(), velQueue.end(), [this](Uint64 const& l, Uint64 const& r) {
-                auto omap = _world->getObstacleMap();
-                return omap.at(l)->getLinearVelocity().length() > omap.at(r)->getLinearVelocity().length();
-            });
-            
-            size_t defaultPri = 60;
-            size_t numPrioObj = std::min(defaultPri,velQueue.size());
-            
-            
-            for (size_t ii = 0; ii < numPrioObj; ii++) {
-                auto obj = objmap.at(velQueue[ii]);
-                if(obj->isShared()) {
-                    event->addObstacle(velQueue[ii],obj);
-                }
+            packPrioSync();
+            return;
+    }
+    
+    _outEvents.push_back(event);
+}
+
+#pragma mark Priority Scheduling
+/**
+ * Configures the prioritized synchronization from the given settings.
+ *
+ * This method reads the byte budget and the priority weights. See
+ * {@link cugl::net::NetcodeConfig#syncBudget} for their meaning.
+ *
+ * @param config    The network configuration
+ */
+void NetPhysicsController::setSyncConfig(const cugl::net::NetcodeConfig& config) {
+    _syncBudget = config.syncBudget;
+    _speedWeight = config.syncSpeedWeight;
+    _distanceWeight = config.syncDistanceWeight;
+    _staleWeight = config.syncStaleWeight;
+    _unownedWeight = config.syncUnownedWeight;
+}
+
+/**
+ * Sets the peers that receive prioritized synchronization.
+ *
+ * Each peer receives its own budgeted packet. If the set is empty, a
+ * single budgeted packet is broadcast to all peers instead. Peers not
+ * in this set have their scheduling state and statistics removed.
+ *
+ * @param peers The UUIDs of the peers with a direct route
+ */
+void NetPhysicsController::setPeers(const std::unordered_set<std::string>& peers) {
+    for(auto it = _peerState.begin(); it != _peerState.end(); ) {
+        bool keep = peers.empty() ? it->first.empty() : peers.count(it->first) > 0;
+        if (keep) {
+            ++it;
+        } else {
+            _peerStats.erase(it->first);
+            it = _peerState.erase(it);
+        }
+    }
+    if (peers.empty()) {
+        _peerState[""];
+    }
+    for(auto it = peers.begin(); it != peers.end(); ++it) {
+        _peerState[*it];
+    }
+}
+
+/**
+ * Sets the position of interest for the given peer.
+ *
+ * Obstacles near this position accumulate priority faster for that peer.
+ * This is typically the position of the avatar controlled by the peer.
+ * The position is ignored if the peer is not receiving synchronization.
+ *
+ * @param peer  The peer UUID
+ * @param pos   The position of interest in physics coordinates
+ */
+void NetPhysicsController::setPeerFocus(const std::string& peer, const Vec2 pos) {
+    auto it = _peerState.find(peer);
+    if (it != _peerState.end()) {
+        it->second.hasFocus = true;
+        it->second.focus = pos;
+    }
+}
+
+/**
+ * Packs a budgeted synchronization event for each peer.
+ *
+ * Each shared, non-static obstacle accumulates priority for each peer,
+ * weighted by speed, ownership, proximity to the peer focus and the time
+ * since it was last sent. The highest priority obstacles are then packed
+ * until the byte budget is reached, and their priority is reset.
+ */
+void NetPhysicsController::packPrioSync() {
+    if (_peerState.empty()) {
+        _peerState[""];
+    }
+    _syncCount++;
+    
+    // Gather the candidates once for all peers
+    auto& ownership = _world->getOwnedObstacles();
+    std::vector<std::pair<Uint64, std::shared_ptr<physics2::Obstacle>>> candidates;
+    std::vector<float> weights;
+    for (auto it = _world->getObstacleMap().begin(); it != _world->getObstacleMap().end(); ++it) {
+        auto obj = it->second;
+        if (!obj->isShared() || obj->getBodyType() == b2_staticBody) {
+            continue;
+        }
+        float weight = ownership.count(obj) ? 1.0f : _unownedWeight;
+        if (weight > 0) {
+            candidates.push_back(*it);
+            weights.push_back(weight);
+        }
+    }
+    
+    std::vector<size_t> order(candidates.size());
+    for (auto it = _peerState.begin(); it != _peerState.end(); ++it) {
+        PeerState& state = it->second;
+        PeerStats& stats = _peerStats[it->first];
+        
+        // Accumulate priority
+        for (size_t ii = 0; ii < candidates.size(); ii++) {
+            Uint64 id = candidates[ii].first;
+            auto& obj = candidates[ii].second;
+            auto sent = state.lastSent.find(id);
+            if (sent == state.lastSent.end()) {
+                sent = state.lastSent.emplace(id, _syncCount-1).first;
             }
-            
-            defaultPri = 20;
-            for (size_t ii = 0; ii < std::min(defaultPri,velQueue.size()); ii++) {
-                // Refactored as obstacles are no longer a vector
-                auto obj = _world->getNextObstacle();
-                event->addObstacle(_world->getObstacleId(obj),obj);
+            float rate = 1.0f + _speedWeight*obj->getLinearVelocity().length();
+            rate += _staleWeight*(_syncCount-sent->second);
+            if (state.hasFocus) {
+                rate += _distanceWeight/(1.0f+obj->getPosition().distance(state.focus));
             }
+            state.priority[id] += rate*weights[ii];
+            order[ii] = ii;
+        }
+        
+        // Sort only as much as the budget can hold
+        size_t limit = order.size();
+        if (_syncBudget > 0) {
+            limit = _syncBudget > SYNC_HEADER_BYTES ? (_syncBudget-SYNC_HEADER_BYTES)/SYNC_ENTRY_BYTES : 0;
+            limit = std::min(limit,order.size());
+        }
+        auto compare = [&](size_t l, size_t r) {
+            return state.priority[candidates[l].first] > state.priority[candidates[r].first];
+        };
+        std::partial_sort(order.begin(), order.begin()+limit, order.end(), compare);
+        
+        auto event = PhysSyncEvent::alloc();
+        for (size_t ii = 0; ii < limit; ii++) {
+            Uint64 id = candidates[order[ii]].first;
+            event->addObstacle(id,candidates[order[ii]].second);
+            state.priority[id] = 0;
+            state.lastSent[id] = _syncCount;
+        }
+        
+        // Record the statistics
+        Uint64 total = 0;
+        stats.maxStaleness = 0;
+        for (size_t ii = 0; ii < candidates.size(); ii++) {
+            Uint64 stale = _syncCount-state.lastSent[candidates[ii].first];
+            stats.maxStaleness = std::max(stats.maxStaleness,stale);
+            total += stale;
+        }
+        stats.avgStaleness = candidates.empty() ? 0 : ((float)total)/candidates.size();
+        stats.lastCount = (Uint32)limit;
+        stats.lastBytes = (Uint32)(SYNC_HEADER_BYTES+limit*SYNC_ENTRY_BYTES);
+        stats.totalBytes += stats.lastBytes;
+        
+        if (it->first.empty()) {
+            _outEvents.push_back(event);
+        } else {
+            _targetedEvents.push_back(std::make_pair(it->first,event));
         }
-            break;
     }
-    
-    _outEvents.push_back(event);
 }
 
 /**
@@ -689,5 +846,11 @@ void NetPhysicsController::reset() {
     _objRotation = 0;
     _deleteCache.clear();
     _outEvents.clear();
+    _targetedEvents.clear();
     _sharedObsToNodeMap.clear();
+    _syncCount = 0;
+    for (auto it = _peerState.begin(); it != _peerState.end(); ++it) {
+        it->second.priority.clear();
+        it->second.lastSent.clear();
+    }
 }
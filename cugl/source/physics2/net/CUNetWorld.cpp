@@ -44,6 +44,7 @@
 #include <stduuid/uuid.h>
 #include <algorithm>
 #include <random>
+#include <cmath>
 
 
 using namespace cugl;
@@ -81,7 +82,8 @@ NetWorld::NetWorld() : ObstacleWorld(),
 _nextInitObj(0),
 _nextSharedObj(0),
 _nextInitJoint(0),
-_nextSharedJoint(0) {
+_nextSharedJoint(0),
+_hashPrecision(1.0f/64) {
     _uuid = genuuid();
     std::hash<std::string> hasher;
     _shortUID = (Uint32)hasher(_uuid);
@@ -105,6 +107,7 @@ void NetWorld::dispose() {
     _nextSharedObj = 0;
     _nextInitJoint = 0;
     _nextSharedJoint = 0;
+    onHashObstacle = nullptr;
     ObstacleWorld::dispose();
 }
 
@@ -402,6 +405,181 @@ void NetWorld::removeJoint(const std::shared_ptr<Joint>& joint) {
     }
 }
 
+#pragma mark -
+#pragma mark State Hashing
+/** The FNV-1a offset basis */
+#define FNV_OFFSET  2166136261u
+/** The FNV-1a prime */
+#define FNV_PRIME   16777619u
+
+/**
+ * Returns the hash h with the bytes of value mixed in (FNV-1a)
+ *
+ * @param h     The running hash
+ * @param value The value to mix in
+ *
+ * @return the hash h with the bytes of value mixed in
+ */
+static Uint32 fnvMix(Uint32 h, Uint32 value) {
+    for(int ii = 0; ii < 4; ii++) {
+        h ^= (value >> (8*ii)) & 0xff;
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+/**
+ * Returns the value snapped to the given precision, as an integer
+ *
+ * @param value     The value to snap
+ * @param precision The snapping precision
+ *
+ * @return the value snapped to the given precision, as an integer
+ */
+static Uint32 snap(float value, float precision) {
+    return (Uint32)(Sint32)std::lround(value/precision);
+}
+
+/**
+ * Returns a hash of the current state of all shared obstacles.
+ *
+ * Each obstacle is hashed on its own, with the obstacle id mixed in, and
+ * the results are combined with addition. Hence the total does not depend
+ * on iteration order, and no sorting is needed even though the obstacles
+ * are stored in a hash map.
+ *
+ * If digests is not null, it receives the per-obstacle hashes. These can
+ * be compared with those of a peer to find the obstacles that diverged.
+ *
+ * @param digests   Optional vector to store the per-obstacle hashes
+ *
+ * @return a hash of the current state of all shared obstacles.
+ */
+Uint32 NetWorld::computeStateHash(std::vector<std::pair<Uint64,Uint32>>* digests) {
+    if (digests) {
+        digests->clear();
+        digests->reserve(_idToObs.size());
+    }
+    
+    float precision = _hashPrecision > 0 ? _hashPrecision : 1.0f;
+    Uint32 total = 0;
+    for(auto it = _idToObs.begin(); it != _idToObs.end(); ++it) {
+        const std::shared_ptr<Obstacle>& obj = it->second;
+        if (!obj->isShared()) {
+            continue;
+        }
+        
+        Uint32 h = FNV_OFFSET;
+        h = fnvMix(h, (Uint32)(it->first >> 32));
+        h = fnvMix(h, (Uint32)(it->first & 0xffffffff));
+        if (obj->getBodyType() != b2_staticBody) {
+            Vec2 pos = obj->getPosition();
+            Vec2 vel = obj->getLinearVelocity();
+            h = fnvMix(h, snap(pos.x, precision));
+            h = fnvMix(h, snap(pos.y, precision));
+            h = fnvMix(h, snap(vel.x, precision));
+            h = fnvMix(h, snap(vel.y, precision));
+            h = fnvMix(h, snap(obj->getAngle(), precision));
+        }
+        if (onHashObstacle) {
+            h = fnvMix(h, onHashObstacle(obj));
+        }
+        
+        if (digests) {
+            digests->emplace_back(it->first, h);
+        }
+        total += h;
+    }
+    return total;
+}
+
+#pragma mark -
+#pragma mark State Snapshots
+/**
+ * Writes a snapshot of all shared dynamic obstacles to the serializer.
+ *
+ * The snapshot stores the id, position, velocity, angle, angular velocity
+ * and awake state of each obstacle, for 33 bytes per obstacle. Static
+ * obstacles never move, so they are skipped.
+ *
+ * @param out   The serializer to write to
+ *
+ * @return the number of obstacles written
+ */
+Uint32 NetWorld::writeSnapshot(LWSerializer& out) {
+    Uint32 count = 0;
+    for(auto it = _idToObs.begin(); it != _idToObs.end(); ++it) {
+        if (it->second->isShared() && it->second->getBodyType() != b2_staticBody) {
+            count++;
+        }
+    }
+    
+    out.writeUint32(count);
+    for(auto it = _idToObs.begin(); it != _idToObs.end(); ++it) {
+        const std::shared_ptr<Obstacle>& obj = it->second;
+        if (!obj->isShared() || obj->getBodyType() == b2_staticBody) {
+            continue;
+        }
+        Vec2 pos = obj->getPosition();
+        Vec2 vel = obj->getLinearVelocity();
+        out.writeUint64(it->first);
+        out.writeFloat(pos.x);
+        out.writeFloat(pos.y);
+        out.writeFloat(vel.x);
+        out.writeFloat(vel.y);
+        out.writeFloat(obj->getAngle());
+        out.writeFloat(obj->getAngularVelocity());
+        out.writeBool(obj->isAwake());
+    }
+    return count;
+}
+
+/**
+ * Restores a snapshot written by {@link #writeSnapshot}.
+ *
+ * Obstacles are matched by id, and unknown ids are skipped. Obstacles
+ * owned by this world are skipped as well, as the local state is already
+ * authoritative for them. The deserializer is left at the end of the
+ * snapshot, so game specific data may follow it.
+ *
+ * @param in    The deserializer to read from
+ *
+ * @return the number of obstacles restored
+ */
+Uint32 NetWorld::readSnapshot(LWDeserializer& in) {
+    Uint32 count = in.readUint32();
+    Uint32 restored = 0;
+    for(Uint32 ii = 0; ii < count; ii++) {
+        Uint64 oid = in.readUint64();
+        Vec2 pos, vel;
+        pos.x = in.readFloat();
+        pos.y = in.readFloat();
+        vel.x = in.readFloat();
+        vel.y = in.readFloat();
+        float angle = in.readFloat();
+        float angv  = in.readFloat();
+        bool awake  = in.readBool();
+        
+        auto it = _idToObs.find(oid);
+        if (it == _idToObs.end() || _ownedObs.count(it->second)) {
+            continue;
+        }
+        
+        const std::shared_ptr<Obstacle>& obj = it->second;
+        obj->setShared(false);
+        // ===== BEGIN NON-SHARED BLOCK =====
+        obj->setPosition(pos);
+        obj->setLinearVelocity(vel);
+        obj->setAngle(angle);
+        obj->setAngularVelocity(angv);
+        obj->setAwake(awake);
+        // ====== END NON-SHARED BLOCK ======
+        obj->setShared(true);
+        restored++;
+    }
+    return restored;
+}
+
 #pragma mark Destruction Callback Functions
 /**
  * Called when a joint is about to be destroyed.
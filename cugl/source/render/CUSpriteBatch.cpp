@@ -45,6 +45,8 @@
 //
 #include <cugl/math/cu_math.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUFrameArena.h>
+#include <cugl/util/CUAllocTracker.h>
 #include <cugl/render/CUSpriteBatch.h>
 #include <cugl/render/CUVertexBuffer.h>
 #include <cugl/render/CUTexture.h>
@@ -126,6 +128,13 @@ using namespace cugl;
 /** All values have changed */
 #define DIRTY_ALL_VALS          0x7FFF
 
+/** The names of the dirty bits above, in bit order */
+static const char* DIRTY_NAMES[SpriteBatch::Stats::REASONS] = {
+    "command", "blend equation", "src function", "dst function", "depth",
+    "draw type", "perspective", "stencil effect", "stencil clear", "texture",
+    "blur", "uniform block", "height", "origin", "player"
+};
+
 /**
  * Fills poly with a mesh defining the given rectangle.
  *
@@ -164,6 +173,38 @@ static void makeRect(Poly2& poly, const Rect& rect, bool solid) {
     }
 }
 
+#pragma mark -
+#pragma mark Statistics
+/**
+ * Resets all statistics to 0.
+ */
+void SpriteBatch::Stats::reset() {
+    draws = 0;
+    vertices = 0;
+    flushes = 0;
+    passes = 0;
+    textureBinds = 0;
+    uniformUploads = 0;
+    shaderSwaps = 0;
+    for(int ii = 0; ii < REASONS; ii++) {
+        reasons[ii] = 0;
+    }
+}
+
+/**
+ * Returns a human readable name for the given flush reason.
+ *
+ * @param reason    The index into {@link #reasons}
+ *
+ * @return a human readable name for the given flush reason.
+ */
+const char* SpriteBatch::Stats::getReasonName(int reason) {
+    if (reason < 0 || reason >= REASONS) {
+        return "unknown";
+    }
+    return DIRTY_NAMES[reason];
+}
+
 #pragma mark -
 #pragma mark Context
 /**
@@ -350,7 +391,8 @@ _vertSize(0),
 _indxMax(0),
 _indxSize(0),
 _vertTotal(0),
-_callTotal(0) {
+_callTotal(0),
+_culling(false) {
     _shader = nullptr;
     _vertbuff = nullptr;
     _unifbuff = nullptr;
@@ -491,6 +533,7 @@ bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& sha
     _vertData = new SpriteVertex2[_vertMax];
     _indxMax = capacity*3;
     _indxData = new GLuint[_indxMax];
+    _vertbuff->initStreaming(_vertMax, _indxMax);
     
     // Create uniform buffer (this has its own backing array)
     _unifbuff = UniformBuffer::alloc(40*sizeof(float),capacity/16);
@@ -541,6 +584,9 @@ void SpriteBatch::setColor(const Color4 color) {
 void SpriteBatch::setShader(const std::shared_ptr<Shader>& shader) {
     CUAssertLog(!_active, "Attempt to reassign shader while drawing is active");
     CUAssertLog(shader != nullptr, "Shader cannot be null");
+    if (_shader != shader) {
+        _stats.shaderSwaps++;
+    }
     _vertbuff->detach();
     _shader = shader;
     _vertbuff->attach(_shader);
@@ -578,6 +624,36 @@ const Mat4& SpriteBatch::getPerspective() const {
     return *(_context->perspective.get());
 }
 
+/**
+ * Returns the visible bounds of the active perspective matrix.
+ *
+ * These are the world space bounds of the clip space square under the
+ * inverse of the perspective matrix. They are only recomputed when the
+ * perspective changes.
+ *
+ * @return the visible bounds of the active perspective matrix.
+ */
+const Rect& SpriteBatch::getCullBounds() const {
+    if (_cullPerspective != _context->perspective) {
+        _cullPerspective = _context->perspective;
+        Mat4 inverse;
+        Mat4::invert(*_cullPerspective, &inverse);
+        Vec2 corner = Vec2(-1,-1) * inverse;
+        float minx = corner.x, maxx = corner.x;
+        float miny = corner.y, maxy = corner.y;
+        const Vec2 others[3] = { Vec2(1,-1), Vec2(-1,1), Vec2(1,1) };
+        for(int ii = 0; ii < 3; ii++) {
+            corner = others[ii] * inverse;
+            minx = std::min(minx, corner.x);
+            maxx = std::max(maxx, corner.x);
+            miny = std::min(miny, corner.y);
+            maxy = std::max(maxy, corner.y);
+        }
+        _cullBounds.set(minx, miny, maxx-minx, maxy-miny);
+    }
+    return _cullBounds;
+}
+
 /**
  * Sets the active texture of this sprite batch
  *
@@ -1194,6 +1270,7 @@ void SpriteBatch::begin() {
     _active = true;
     _callTotal = 0;
     _vertTotal = 0;
+    _stats.passes++;
 }
 
 /**
@@ -1229,15 +1306,15 @@ void SpriteBatch::end() {
  * restoring the OpenGL state.
  */
 void SpriteBatch::flush() {
+    CU_ALLOC_TAG(RENDER);
     if (_indxSize == 0 || _vertSize == 0) {
         return;
     } else if (_context->first != _indxSize) {
         record();
     }
     
-    // Load all the vertex data at once
-    _vertbuff->loadVertexData(_vertData, _vertSize);
-    _vertbuff->loadIndexData(_indxData, _indxSize);
+    // Stream all the vertex data at once
+    GLsizei base = _vertbuff->streamData(_vertData, _vertSize, _indxData, _indxSize);
     _unifbuff->activate();
     _unifbuff->flush();
     
@@ -1245,6 +1322,14 @@ void SpriteBatch::flush() {
     std::shared_ptr<Texture> previous = _context->texture;
     for(auto it = _history.begin(); it != _history.end(); ++it) {
         Context* next = *it;
+        // A fully dirty context starts a pass, so it did not break a batch
+        if (next->dirty != DIRTY_ALL_VALS) {
+            for(int ii = 0; ii < Stats::REASONS; ii++) {
+                if (next->dirty & (1 << ii)) {
+                    _stats.reasons[ii]++;
+                }
+            }
+        }
         if (next->dirty & DIRTY_BLENDEQUATION) {
             _shader->setBlendEquation(next->blendEq);
         }
@@ -1258,21 +1343,26 @@ void SpriteBatch::flush() {
         }
         if (next->dirty & DIRTY_DEPTHVALUE) {
             _shader->setUniform1f("uDepth", 0);
+            _stats.uniformUploads++;
         }
         if (next->dirty & DIRTY_DRAWTYPE) {
              _shader->setUniform1i("uType", next->type);
+            _stats.uniformUploads++;
         }
         if (next->dirty & DIRTY_PERSPECTIVE) {
             _shader->setUniformMat4("uPerspective",*(next->perspective.get()));
+            _stats.uniformUploads++;
         }
         if (next->dirty & DIRTY_TEXTURE) {
             previous = next->texture;
             if (previous != nullptr) {
                 previous->bind();
+                _stats.textureBinds++;
             }
         }
         if (next->dirty & DIRTY_UNIBLOCK) {
             _unifbuff->setBlock(next->blockptr);
+            _stats.uniformUploads++;
         }
         if (next->dirty & DIRTY_BLURSTEP) {
             blurTexture(next->texture,next->blur);
@@ -1285,23 +1375,29 @@ void SpriteBatch::flush() {
         }
         if (next->dirty & DIRTY_HEIGHT) {
             _shader->setUniform1f("tex_height", next->height);
+            _stats.uniformUploads++;
         }
         if (next->dirty & DIRTY_ORIGIN) {
             _shader->setUniform1f("tex_y_origin", next->origin);
+            _stats.uniformUploads++;
         }
         if (next->dirty & DIRTY_PLAYER) {
             _shader->setUniform1f("player", next->player ? 1.0 : 0.0);
+            _stats.uniformUploads++;
         }
         
         GLuint amt = next->last-next->first;
-        _vertbuff->draw(next->command, amt, next->first);
+        _vertbuff->draw(next->command, amt, base+next->first);
         _callTotal++;
+        _stats.draws++;
     }
     
     _unifbuff->deactivate();
     
     // Increment the counters
     _vertTotal += _indxSize;
+    _stats.vertices += _indxSize;
+    _stats.flushes++;
     
     _vertSize = _indxSize = 0;
     unwind();
@@ -2678,11 +2774,14 @@ void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text,
  * will use the correct set of uniforms.
  */
 void SpriteBatch::record() {
-    Context* next = new Context(_context);
-    _context->last = _indxSize;
-    next->first = _indxSize;
-    _history.push_back(_context);
-    _context = next;
+    // The history only lives until the next flush, so it is kept in the frame
+    // arena. The active context stays on the heap, as it outlives the frame.
+    Context* past = FrameArena::get()->make<Context>(*_context);
+    past->last = _indxSize;
+    _history.push_back(past);
+    _context->first = _indxSize;
+    _context->cleared = STENCIL_NONE; // DO NOT COPY
+    _context->dirty = 0;
     _inflight = false;
 }
 
@@ -2692,8 +2791,9 @@ void SpriteBatch::record() {
  * This method is called upon flushing or cleanup.
  */
 void SpriteBatch::unwind() {
+    // The arena reclaims the memory
     for(auto it = _history.begin(); it != _history.end(); ++it) {
-        delete *it;
+        (*it)->~Context();
     }
     _history.clear();
 }
@@ -33,6 +33,10 @@
 #include <cugl/render/CUVertexBuffer.h>
 #include <cugl/render/CUShader.h>
 #include <cugl/render/CUTexture.h>
+#include <cstring>
+
+/** The nanoseconds to wait on a streaming fence before flushing again */
+#define STREAM_TIMEOUT  1000000
 
 using namespace cugl;
 
@@ -46,8 +50,19 @@ VertexBuffer::VertexBuffer() :
 _vertArray(0),
 _vertBuffer(0),
 _indxBuffer(0),
-_stride(0) {
+_stride(0),
+_streamMode(StreamMode::NONE),
+_streamVerts(0),
+_streamIndxs(0),
+_streamRegion(0),
+_streamVertHead(0),
+_streamIndxHead(0),
+_streamVertData(nullptr),
+_streamIndxData(nullptr) {
     _shader = nullptr;
+    for(int ii = 0; ii < STREAM_REGIONS; ii++) {
+        _streamFences[ii] = nullptr;
+    }
 }
 
 /**
@@ -116,6 +131,16 @@ void VertexBuffer::dispose() {
     }
     _enabled.clear();
     _attributes.clear();
+    for(int ii = 0; ii < STREAM_REGIONS; ii++) {
+        if (_streamFences[ii]) {
+            glDeleteSync(_streamFences[ii]);
+            _streamFences[ii] = nullptr;
+        }
+    }
+    // Deleting a buffer implicitly unmaps it
+    _streamVertData = nullptr;
+    _streamIndxData = nullptr;
+    _streamMode = StreamMode::NONE;
     glDeleteBuffers(1,&_indxBuffer);
     glDeleteBuffers(1,&_vertBuffer);
     glDeleteVertexArrays(1,&_vertArray);
@@ -302,6 +327,207 @@ void VertexBuffer::loadIndexData(const void * data, GLsizei size, GLenum usage)
     CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
 }
 
+/**
+ * Enables ring-buffered streaming for this vertex buffer.
+ *
+ * Loading data with glBufferData every flush can force the driver to
+ * synchronize with draws that are still in flight. In streaming mode,
+ * the vertex and index buffers are split into three regions that are
+ * filled in turn. Each region is guarded by a fence, so the CPU only
+ * waits if it laps the GPU.
+ *
+ * Persistent mapping is used if the driver supports buffer storage
+ * (OpenGL 4.4). Otherwise, regions are written with an unsynchronized
+ * glMapBufferRange, which is available on OpenGLES 3. If mapping fails,
+ * the buffers are orphaned instead.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ *
+ * @param vertices  The maximum number of vertices in a single stream
+ * @param indices   The maximum number of indices in a single stream
+ *
+ * @return the streaming strategy chosen
+ */
+VertexBuffer::StreamMode VertexBuffer::initStreaming(GLsizei vertices, GLsizei indices) {
+    CUAssertLog(_streamMode == StreamMode::NONE, "Streaming is already enabled");
+    _streamVerts = vertices;
+    _streamIndxs = indices;
+    _streamRegion = 0;
+    _streamVertHead = 0;
+    _streamIndxHead = 0;
+    
+    GLsizeiptr vbytes = (GLsizeiptr)_stride*vertices*STREAM_REGIONS;
+    GLsizeiptr ibytes = (GLsizeiptr)sizeof(GLuint)*indices*STREAM_REGIONS;
+    
+#if CU_GL_PLATFORM == CU_GL_OPENGL && defined(GL_MAP_PERSISTENT_BIT)
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 4)) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, vbytes, nullptr, flags);
+        glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, ibytes, nullptr, flags);
+        _streamVertData = (GLubyte*)glMapBufferRange(GL_ARRAY_BUFFER, 0, vbytes, flags);
+        _streamIndxData = (GLuint*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, ibytes, flags);
+        if (_streamVertData && _streamIndxData) {
+            _streamMode = StreamMode::PERSISTENT;
+            return _streamMode;
+        }
+        
+        // Buffer storage is immutable, so we need fresh buffers
+        CUWarn("Persistent mapping failed; falling back to mapped streaming");
+        _streamVertData = nullptr;
+        _streamIndxData = nullptr;
+        std::shared_ptr<Shader> shader = detach();
+        glDeleteBuffers(1,&_indxBuffer);
+        glDeleteBuffers(1,&_vertBuffer);
+        glGenBuffers(1, &_vertBuffer);
+        glGenBuffers(1, &_indxBuffer);
+        if (shader != nullptr) {
+            attach(shader);
+        } else {
+            bind();
+        }
+    }
+#endif
+    
+    glBufferData(GL_ARRAY_BUFFER, vbytes, nullptr, GL_STREAM_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, ibytes, nullptr, GL_STREAM_DRAW);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    void* probe = glMapBufferRange(GL_ARRAY_BUFFER, 0, _stride, flags);
+    if (probe) {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        _streamMode = StreamMode::MAPPED;
+    } else {
+        _streamMode = StreamMode::ORPHAN;
+    }
+    
+    GLenum error = glGetError();
+    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+    return _streamMode;
+}
+
+/**
+ * Streams the given vertices and indices to this buffer.
+ *
+ * The data is appended to the current region of the streaming ring. The
+ * indices are rebased so that they refer to the streamed vertices. The
+ * value returned must be added to the offset of any draw command using
+ * this data.
+ *
+ * If streaming is not enabled, this method is the same as calling both
+ * {@link #loadVertexData} and {@link #loadIndexData}, and it returns 0.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ *
+ * @param vertices  The vertices to stream
+ * @param vsize     The number of vertices (at most the streaming capacity)
+ * @param indices   The indices to stream
+ * @param isize     The number of indices (at most the streaming capacity)
+ *
+ * @return the index offset of the streamed data
+ */
+GLsizei VertexBuffer::streamData(const void* vertices, GLsizei vsize, const GLuint* indices, GLsizei isize) {
+    switch (_streamMode) {
+        case StreamMode::NONE:
+            loadVertexData(vertices, vsize);
+            loadIndexData(indices, isize);
+            return 0;
+        case StreamMode::ORPHAN:
+            // Orphaning lets the driver hand us fresh memory instead of waiting
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)_stride*_streamVerts, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)_stride*vsize, vertices);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*_streamIndxs, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(GLuint)*isize, indices);
+            return 0;
+        default:
+            break;
+    }
+    
+    CUAssertLog(vsize <= _streamVerts && isize <= _streamIndxs, "Stream exceeds the region capacity");
+    if (vsize == 0 || isize == 0) {
+        return 0;
+    }
+    if (_streamVertHead+vsize > _streamVerts || _streamIndxHead+isize > _streamIndxs) {
+        advanceRegion();
+    }
+    
+    GLsizeiptr vfirst = (GLsizeiptr)_streamRegion*_streamVerts+_streamVertHead;
+    GLsizeiptr ifirst = (GLsizeiptr)_streamRegion*_streamIndxs+_streamIndxHead;
+    if (_streamMode == StreamMode::PERSISTENT) {
+        std::memcpy(_streamVertData+vfirst*_stride, vertices, (size_t)_stride*vsize);
+        copyIndices(_streamIndxData+ifirst, indices, isize, (GLuint)vfirst);
+    } else {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        void* vdst = glMapBufferRange(GL_ARRAY_BUFFER, vfirst*_stride,
+                                      (GLsizeiptr)_stride*vsize, flags);
+        void* idst = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, ifirst*sizeof(GLuint),
+                                      sizeof(GLuint)*isize, flags);
+        if (vdst == nullptr || idst == nullptr) {
+            if (vdst) {
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+            if (idst) {
+                glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+            }
+            CUWarn("Mapped streaming failed; falling back to buffer orphaning");
+            _streamMode = StreamMode::ORPHAN;
+            return streamData(vertices, vsize, indices, isize);
+        }
+        std::memcpy(vdst, vertices, (size_t)_stride*vsize);
+        copyIndices((GLuint*)idst, indices, isize, (GLuint)vfirst);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    }
+    
+    _streamVertHead += vsize;
+    _streamIndxHead += isize;
+    return (GLsizei)ifirst;
+}
+
+/**
+ * Advances the streaming ring to the next region.
+ *
+ * This method fences the current region (whose draw commands have all been
+ * issued) and then waits for the GPU to release the next region.
+ */
+void VertexBuffer::advanceRegion() {
+    _streamFences[_streamRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _streamRegion = (_streamRegion+1) % STREAM_REGIONS;
+    _streamVertHead = 0;
+    _streamIndxHead = 0;
+    
+    GLsync fence = _streamFences[_streamRegion];
+    if (fence) {
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_TIMEOUT);
+        }
+        CUAssertLog(status != GL_WAIT_FAILED, "VertexBuffer: fence wait failed");
+        glDeleteSync(fence);
+        _streamFences[_streamRegion] = nullptr;
+    }
+}
+
+/**
+ * Copies the indices to the given destination, offset by base.
+ *
+ * @param dst       The destination memory
+ * @param indices   The indices to copy
+ * @param size      The number of indices
+ * @param base      The vertex offset to add to each index
+ */
+void VertexBuffer::copyIndices(GLuint* dst, const GLuint* indices, GLsizei size, GLuint base) {
+    if (base == 0) {
+        std::memcpy(dst, indices, sizeof(GLuint)*size);
+        return;
+    }
+    for(GLsizei ii = 0; ii < size; ii++) {
+        dst[ii] = indices[ii]+base;
+    }
+}
+
 /**
  * Draws to the active framebuffer using this vertex buffer
  *
@@ -45,6 +45,7 @@
 //  Version: 3/7/21
 #include <cugl/scene2/graph/CUOrderedNode.h>
 #include <cugl/render/CUScissor.h>
+#include <cugl/util/CUFrameArena.h>
 
 using namespace cugl;
 using namespace cugl::scene2;
@@ -144,6 +145,7 @@ bool OrderedNode::Context::sortCompare(Context* a, Context* b) {
  */
 OrderedNode::OrderedNode() :
 _viewport(nullptr),
+_culling(false),
 _order(Order::PRE_ORDER) {
     _classname = "OrderedNode";
 }
@@ -159,7 +161,7 @@ _order(Order::PRE_ORDER) {
  */
 void OrderedNode::dispose() {
     for(auto it = _entries.begin(); it != _entries.end(); ++it) {
-        delete *it;
+        (*it)->~Context();
         *it = nullptr;
     }
     _entries.clear();
@@ -292,6 +294,12 @@ void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& t
 
     Affine2 matrix;
     Affine2::multiply(node->getTransform(),transform,&matrix);
+    
+    // Ordered nodes cull themselves when rendered
+    bool barrier = node->getClassName() == getClassName();
+    bool outside = _culling && !barrier && node->isOutside(matrix, _cullBounds);
+    if (outside && node->cullsChildren()) { return; }
+    
     Color4 color = node->getColor();
     if (node->hasRelativeColor()) {
         color *= tint;
@@ -301,7 +309,8 @@ void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& t
     std::shared_ptr<Scissor> previous = _viewport;
     std::shared_ptr<Scissor> current = nullptr;
     if (node->getScissor()) {
-        current = Scissor::alloc(node->getScissor());
+        // The render queue only lives for this frame
+        current = std::allocate_shared<Scissor>(ArenaAllocator<Scissor>(FrameArena::get()), *node->getScissor());
         current->setTransform(matrix);
         if (previous) {
             current->intersect(previous);
@@ -311,27 +320,30 @@ void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& t
     
     // Identify pre or post. Block at child ordered nodes
     bool ispost = (_order == Order::POST_ORDER || _order == Order::POST_ASCEND || _order == Order::POST_DESCEND);
-    bool barrier = node->getClassName() == getClassName();
     if (ispost && !barrier) {
-        auto children = node->getChildren();
+        const SceneNode& parent = *node;
+        const auto& children = parent.getChildren();
         for(auto it = children.begin(); it != children.end(); ++it) {
             visit(*it, matrix, color);
         }
     }
     
     // Capture pre or post order traversal
-    Uint32 canonical = (_entries.empty() ? 0 : _entries.back()->canonical+1);
-    
-    Context* context = new Context(this);
-    _entries.push_back(context);
-    context->node = node;
-    context->transform = barrier ? transform : matrix;
-    context->scissor = _viewport;
-    context->tint = barrier ? tint : color;
-    context->canonical = canonical;
+    if (!outside) {
+        Uint32 canonical = (_entries.empty() ? 0 : _entries.back()->canonical+1);
+        
+        Context* context = FrameArena::get()->make<Context>(this);
+        _entries.push_back(context);
+        context->node = node;
+        context->transform = barrier ? transform : matrix;
+        context->scissor = _viewport;
+        context->tint = barrier ? tint : color;
+        context->canonical = canonical;
+    }
     
     if (!ispost && !barrier) {
-        auto children = node->getChildren();
+        const SceneNode& parent = *node;
+        const auto& children = parent.getChildren();
         for(auto it = children.begin(); it != children.end(); ++it) {
             visit(*it, matrix, color);
         }
@@ -372,7 +384,7 @@ void OrderedNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine
         std::shared_ptr<Scissor> active = batch->getScissor();
         _viewport = active;
         if (_scissor) {
-            std::shared_ptr<Scissor> local = Scissor::alloc(_scissor);
+            std::shared_ptr<Scissor> local = std::allocate_shared<Scissor>(ArenaAllocator<Scissor>(FrameArena::get()), *_scissor);
             local->setTransform(matrix);
             if (active) {
                 local->intersect(active);
@@ -380,6 +392,12 @@ void OrderedNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine
             _viewport = local;
         }
 
+        // Capture the culling state for the descendants
+        _culling = batch->isCulling();
+        if (_culling) {
+            _cullBounds = batch->getCullBounds();
+        }
+        
         // Build and sort
         for(auto it = _children.begin(); it != _children.end(); ++it) {
             visit(*it, matrix, color);
@@ -397,9 +415,9 @@ void OrderedNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine
             }
         }
 
-        // Clean up and restore state
+        // Clean up and restore state (the arena reclaims the memory)
         for(auto it = _entries.begin(); it != _entries.end(); ++it) {
-            delete *it;
+            (*it)->~Context();
             *it = nullptr;
         }
         _entries.clear();
@@ -56,19 +56,20 @@ using namespace cugl::scene2;
  * heap, use one of the static constructors instead.
  */
 SceneNode::SceneNode() :
-_tag(0),
-_name(""),
-_hashOfName(0),
+_anchor(Vec2::ANCHOR_BOTTOM_LEFT),
 _tintColor(Color4::WHITE),
 _hasParentColor(true),
 _isVisible(true),
-_anchor(Vec2::ANCHOR_BOTTOM_LEFT),
+_cullsChildren(false),
 _scale(Vec2::ONE),
 _angle(0),
 _useTransform(false),
 _parent(nullptr),
 _graph(nullptr),
 _childOffset(-2),
+_tag(0),
+_name(""),
+_hashOfName(0),
 _priority(0) {
     _classname = "SceneNode";
 }
@@ -800,6 +801,9 @@ void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
     
     Affine2 matrix;
     Affine2::multiply(_combined,transform,&matrix);
+    bool outside = batch->isCulling() && isOutside(matrix, batch->getCullBounds());
+    if (outside && _cullsChildren) { return; }
+    
     Color4 color = _tintColor;
     if (_hasParentColor) {
         color *= tint;
@@ -815,7 +819,9 @@ void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
         batch->setScissor(local);
     }
 
-    draw(batch,matrix,color);
+    if (!outside) {
+        draw(batch,matrix,color);
+    }
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         (*it)->render(batch, matrix, color);
     }
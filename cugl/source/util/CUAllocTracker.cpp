@@ -0,0 +1,798 @@
+//
+//  CUAllocTracker.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides an allocation tracker for finding heap traffic in the
+//  game loop.  When CUGL is built with CU_TRACK_ALLOCATIONS, this module also
+//  replaces the global operator new and delete.  Every tracked allocation has
+//  a small header in front of it recording its size, tag, and call site, so
+//  that a free can be attributed to the same tag and site as the allocation.
+//
+//  The call sites are kept in a fixed-size hash table of stacks, so recording
+//  a site never allocates.  Sites that do not fit in the table are counted,
+//  but not reported individually.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+#include <cugl/util/CUAllocTracker.h>
+#include <cugl/util/CUDebug.h>
+#include <cugl/io/CUTextWriter.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <vector>
+
+#if defined (__LINUX__) || defined (__MACOSX__)
+    #define CU_ALLOC_SITES 1
+    #include <cxxabi.h>
+    #include <execinfo.h>
+    #include <signal.h>
+#else
+    #define CU_ALLOC_SITES 0
+#endif
+
+#ifdef ATK_TRACK_ALLOCATIONS
+    #include <ATK_error.h>
+#endif
+
+using namespace cugl;
+
+/** The number of call sites in the site table */
+#define SITE_CAPACITY   4096
+/** The site index of an allocation without a recorded site */
+#define SITE_NONE       0xffff
+/** The number of slots to probe before giving up on a site */
+#define SITE_PROBES     32
+/** The stack frames inside the tracker (record_site and allocate) */
+#define SITE_SKIP       2
+/** The marker of a tracked allocation header */
+#define HEADER_MAGIC    0xa7
+
+#pragma mark -
+#pragma mark Tracker State
+
+/**
+ * The counters of a single tag.
+ *
+ * The atomics have trivial constructors, so the counters are zero-initialized
+ * before any allocation, even those made by static initializers.
+ */
+struct TagCounters {
+    /** The number of allocations */
+    std::atomic<size_t> allocations;
+    /** The number of frees */
+    std::atomic<size_t> frees;
+    /** The number of bytes allocated */
+    std::atomic<size_t> bytes;
+    /** The number of bytes currently allocated */
+    std::atomic<size_t> live;
+    /** The largest number of bytes allocated at once */
+    std::atomic<size_t> peak;
+    /** The allocations since the last frame began */
+    std::atomic<size_t> frameAllocations;
+    /** The bytes allocated since the last frame began */
+    std::atomic<size_t> frameBytes;
+    /** The allocations of the last frame */
+    std::atomic<size_t> lastAllocations;
+    /** The bytes allocated in the last frame */
+    std::atomic<size_t> lastBytes;
+    /** The most allocations of any frame */
+    std::atomic<size_t> maxAllocations;
+    /** The most bytes allocated in any frame */
+    std::atomic<size_t> maxBytes;
+};
+
+/**
+ * A call site in the site table.
+ *
+ * A slot is claimed by setting its key, and its stack is valid once ready
+ * is set.  Slots are never released.
+ */
+struct AllocSite {
+    /** The hash of the stack and tag, or 0 if the slot is free */
+    std::atomic<uint64_t> key;
+    /** Whether the stack of this site has been written */
+    std::atomic<bool> ready;
+    /** The return addresses of the stack, innermost first */
+    void* frames[AllocTracker::SITE_DEPTH];
+    /** The number of return addresses */
+    uint8_t depth;
+    /** The tag of the allocations */
+    uint8_t tag;
+    /** The number of allocations */
+    std::atomic<size_t> allocations;
+    /** The number of bytes allocated */
+    std::atomic<size_t> bytes;
+    /** The number of bytes currently allocated */
+    std::atomic<size_t> live;
+};
+
+/**
+ * The header in front of every tracked allocation.
+ *
+ * The header is 16 bytes, so an allocation with the default alignment stays
+ * aligned after it.
+ */
+struct AllocHeader {
+    /** The size of the allocation */
+    uint64_t size;
+    /** The distance from the start of the heap block to the allocation */
+    uint32_t offset;
+    /** The index of the call site, or SITE_NONE */
+    uint16_t site;
+    /** The tag of the allocation */
+    uint8_t tag;
+    /** The marker HEADER_MAGIC */
+    uint8_t magic;
+};
+static_assert(sizeof(AllocHeader) == 16, "Allocation header must be 16 bytes");
+
+/** The counters of each tag */
+static TagCounters tag_counters[AllocTracker::TAGS];
+/** The call site table */
+static AllocSite alloc_sites[SITE_CAPACITY];
+/** The allocations whose call site did not fit in the table */
+static std::atomic<size_t> lost_sites;
+/** The number of frames begun */
+static std::atomic<size_t> frame_count;
+/** Whether a dump has been requested */
+static std::atomic<bool> dump_requested;
+/** The tag of the current thread */
+static thread_local AllocTracker::Tag current_tag = AllocTracker::Tag::GENERAL;
+/** Whether the current thread must not record call sites (to avoid recursion) */
+static thread_local bool in_capture = false;
+
+/** The names of the tags */
+static const char* tag_names[AllocTracker::TAGS] = {
+    "general", "scene2", "render", "physics2", "net", "audio"
+};
+
+#pragma mark -
+#pragma mark Bookkeeping
+
+/**
+ * Returns the index of the call site of the current allocation.
+ *
+ * The site counters are updated with the given allocation.  This returns
+ * SITE_NONE if sites are not supported, or if the table is full.
+ *
+ * @param tag   The tag of the allocation
+ * @param bytes The size of the allocation
+ *
+ * @return the index of the call site of the current allocation
+ */
+static uint16_t record_site(AllocTracker::Tag tag, size_t bytes) {
+#if CU_ALLOC_SITES
+    // The first call to backtrace may allocate (with malloc, but be careful)
+    if (in_capture) {
+        return SITE_NONE;
+    }
+    in_capture = true;
+    void* frames[AllocTracker::SITE_DEPTH+SITE_SKIP];
+    int depth = backtrace(frames, AllocTracker::SITE_DEPTH+SITE_SKIP);
+    in_capture = false;
+    int first = std::min(depth, SITE_SKIP);
+    depth -= first;
+
+    // FNV-1a over the stack and tag
+    uint64_t key = 14695981039346656037ULL ^ (uint64_t)tag;
+    for (int ii = 0; ii < depth; ii++) {
+        key = (key ^ (uint64_t)(uintptr_t)frames[first+ii]) * 1099511628211ULL;
+    }
+    key = (key == 0 ? 1 : key);
+
+    for (size_t probe = 0; probe < SITE_PROBES; probe++) {
+        size_t index = (size_t)((key + probe) % SITE_CAPACITY);
+        AllocSite& site = alloc_sites[index];
+        uint64_t current = site.key.load(std::memory_order_acquire);
+        if (current == 0 && site.key.compare_exchange_strong(current, key)) {
+            for (int ii = 0; ii < depth; ii++) {
+                site.frames[ii] = frames[first+ii];
+            }
+            site.depth = (uint8_t)depth;
+            site.tag = (uint8_t)tag;
+            site.ready.store(true, std::memory_order_release);
+            current = key;
+        }
+        if (current == key) {
+            site.allocations.fetch_add(1, std::memory_order_relaxed);
+            site.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            site.live.fetch_add(bytes, std::memory_order_relaxed);
+            return (uint16_t)index;
+        }
+    }
+    lost_sites.fetch_add(1, std::memory_order_relaxed);
+#endif
+    return SITE_NONE;
+}
+
+/**
+ * Records an allocation of the given size.
+ *
+ * @param header    The header of the allocation
+ */
+static void count_alloc(const AllocHeader* header) {
+    TagCounters& counters = tag_counters[header->tag];
+    size_t bytes = (size_t)header->size;
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    counters.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    counters.frameBytes.fetch_add(bytes, std::memory_order_relaxed);
+    size_t live = counters.live.fetch_add(bytes, std::memory_order_relaxed)+bytes;
+    size_t peak = counters.peak.load(std::memory_order_relaxed);
+    while (live > peak && !counters.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+/**
+ * Records the free of an allocation.
+ *
+ * @param header    The header of the allocation
+ */
+static void count_free(const AllocHeader* header) {
+    TagCounters& counters = tag_counters[header->tag];
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.live.fetch_sub((size_t)header->size, std::memory_order_relaxed);
+    if (header->site != SITE_NONE) {
+        alloc_sites[header->site].live.fetch_sub((size_t)header->size, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Returns the header of a tracked allocation.
+ *
+ * @param ptr   The tracked allocation
+ *
+ * @return the header of a tracked allocation
+ */
+static AllocHeader* get_header(void* ptr) {
+    AllocHeader* header = reinterpret_cast<AllocHeader*>(ptr)-1;
+    CUAssertLog(header->magic == HEADER_MAGIC, "Memory at %p was not allocated by the tracker", ptr);
+    return header;
+}
+
+#pragma mark -
+#pragma mark Tags
+/**
+ * Returns true if CUGL was built with the allocation tracker.
+ *
+ * If this is false, every statistic is zero.
+ *
+ * @return true if CUGL was built with the allocation tracker
+ */
+bool AllocTracker::isEnabled() {
+#ifdef CU_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Returns the tag of the calling thread.
+ *
+ * @return the tag of the calling thread
+ */
+AllocTracker::Tag AllocTracker::getTag() {
+    return current_tag;
+}
+
+/**
+ * Sets the tag of the calling thread, returning the previous one.
+ *
+ * @param tag   The new tag of the calling thread
+ *
+ * @return the previous tag of the calling thread
+ */
+AllocTracker::Tag AllocTracker::setTag(Tag tag) {
+    Tag previous = current_tag;
+    current_tag = tag;
+    return previous;
+}
+
+/**
+ * Returns the name of the given tag.
+ *
+ * @param tag   The tag to name
+ *
+ * @return the name of the given tag
+ */
+const char* AllocTracker::getTagName(Tag tag) {
+    size_t index = (size_t)tag;
+    return index < TAGS ? tag_names[index] : "unknown";
+}
+
+#pragma mark -
+#pragma mark Statistics
+/**
+ * Returns the statistics of the given tag.
+ *
+ * @param tag   The tag to query
+ *
+ * @return the statistics of the given tag
+ */
+AllocTracker::Stats AllocTracker::getStats(Tag tag) {
+    const TagCounters& counters = tag_counters[(size_t)tag];
+    Stats result;
+    result.allocations = counters.allocations.load(std::memory_order_relaxed);
+    result.frees = counters.frees.load(std::memory_order_relaxed);
+    result.bytes = counters.bytes.load(std::memory_order_relaxed);
+    result.liveBytes = counters.live.load(std::memory_order_relaxed);
+    result.peakBytes = counters.peak.load(std::memory_order_relaxed);
+    result.frameAllocations = counters.frameAllocations.load(std::memory_order_relaxed);
+    result.frameBytes = counters.frameBytes.load(std::memory_order_relaxed);
+    result.lastAllocations = counters.lastAllocations.load(std::memory_order_relaxed);
+    result.lastBytes = counters.lastBytes.load(std::memory_order_relaxed);
+    result.maxAllocations = counters.maxAllocations.load(std::memory_order_relaxed);
+    result.maxBytes = counters.maxBytes.load(std::memory_order_relaxed);
+    return result;
+}
+
+/**
+ * Returns the statistics of all tags combined.
+ *
+ * The peak and the per-frame maximums are the sums of those of each tag,
+ * so they are an upper bound for the combined values.
+ *
+ * @return the statistics of all tags combined
+ */
+AllocTracker::Stats AllocTracker::getTotals() {
+    Stats result = {};
+    for (size_t ii = 0; ii < TAGS; ii++) {
+        Stats stats = getStats((Tag)ii);
+        result.allocations += stats.allocations;
+        result.frees += stats.frees;
+        result.bytes += stats.bytes;
+        result.liveBytes += stats.liveBytes;
+        result.peakBytes += stats.peakBytes;
+        result.frameAllocations += stats.frameAllocations;
+        result.frameBytes += stats.frameBytes;
+        result.lastAllocations += stats.lastAllocations;
+        result.lastBytes += stats.lastBytes;
+        result.maxAllocations += stats.maxAllocations;
+        result.maxBytes += stats.maxBytes;
+    }
+    return result;
+}
+
+/**
+ * Marks the start of a new frame.
+ *
+ * The allocations since the last call become the statistics of the last
+ * frame.  This should be called once per frame by the main thread.
+ */
+void AllocTracker::beginFrame() {
+    for (size_t ii = 0; ii < TAGS; ii++) {
+        TagCounters& counters = tag_counters[ii];
+        size_t allocs = counters.frameAllocations.exchange(0, std::memory_order_relaxed);
+        size_t bytes  = counters.frameBytes.exchange(0, std::memory_order_relaxed);
+        counters.lastAllocations.store(allocs, std::memory_order_relaxed);
+        counters.lastBytes.store(bytes, std::memory_order_relaxed);
+        if (allocs > counters.maxAllocations.load(std::memory_order_relaxed)) {
+            counters.maxAllocations.store(allocs, std::memory_order_relaxed);
+        }
+        if (bytes > counters.maxBytes.load(std::memory_order_relaxed)) {
+            counters.maxBytes.store(bytes, std::memory_order_relaxed);
+        }
+    }
+    frame_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+#pragma mark -
+#pragma mark Reporting
+
+/**
+ * Returns the symbol of a return address, demangled if possible.
+ *
+ * @param symbol    The symbol from backtrace_symbols
+ *
+ * @return the symbol of a return address, demangled if possible
+ */
+static std::string demangle(const char* symbol) {
+    std::string result(symbol);
+#if CU_ALLOC_SITES
+    // Linux has "file(name+offset) [address]", macOS "index file address name + offset"
+    size_t start = result.find("_Z");
+    if (start == std::string::npos) {
+        return result;
+    }
+    size_t end = result.find_first_of("+) ", start);
+    std::string name = result.substr(start, end == std::string::npos ? std::string::npos : end-start);
+    int status = 0;
+    char* readable = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+    if (status == 0 && readable != nullptr) {
+        result.replace(start, name.size(), readable);
+    }
+    std::free(readable);
+#endif
+    return result;
+}
+
+/**
+ * Returns the given number of bytes as a string in kilobytes.
+ *
+ * @param bytes The number of bytes
+ *
+ * @return the given number of bytes as a string in kilobytes
+ */
+static std::string kilobytes(size_t bytes) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << bytes / 1024.0 << " KB";
+    return ss.str();
+}
+
+/**
+ * Returns a text report of the tags and the top call sites.
+ *
+ * The call sites are sorted by the number of bytes they allocated.
+ *
+ * @param sites The number of call sites to report
+ *
+ * @return a text report of the tags and the top call sites
+ */
+std::string AllocTracker::getReport(size_t sites) {
+    std::stringstream ss;
+    if (!isEnabled()) {
+        ss << "Allocation tracking is disabled (build with CUGL_TRACK_ALLOCATIONS)\n";
+        return ss.str();
+    }
+
+    ss << "Allocations after " << frame_count.load(std::memory_order_relaxed) << " frames\n";
+    ss << std::left << std::setw(10) << "tag"
+       << std::right << std::setw(12) << "last allocs" << std::setw(14) << "last bytes"
+       << std::setw(12) << "max allocs" << std::setw(14) << "max bytes"
+       << std::setw(14) << "total allocs" << std::setw(14) << "total bytes"
+       << std::setw(14) << "live bytes" << std::setw(14) << "peak bytes" << "\n";
+    for (size_t ii = 0; ii <= TAGS; ii++) {
+        Stats stats = (ii < TAGS ? getStats((Tag)ii) : getTotals());
+        ss << std::left << std::setw(10) << (ii < TAGS ? tag_names[ii] : "total")
+           << std::right << std::setw(12) << stats.lastAllocations
+           << std::setw(14) << kilobytes(stats.lastBytes)
+           << std::setw(12) << stats.maxAllocations
+           << std::setw(14) << kilobytes(stats.maxBytes)
+           << std::setw(14) << stats.allocations
+           << std::setw(14) << kilobytes(stats.bytes)
+           << std::setw(14) << kilobytes(stats.liveBytes)
+           << std::setw(14) << kilobytes(stats.peakBytes) << "\n";
+    }
+
+#if CU_ALLOC_SITES
+    // Snapshot the sites first, and keep the report out of the site table
+    bool capture = in_capture;
+    in_capture = true;
+    std::vector<size_t> order;
+    order.reserve(SITE_CAPACITY);
+    for (size_t ii = 0; ii < SITE_CAPACITY; ii++) {
+        if (alloc_sites[ii].ready.load(std::memory_order_acquire)) {
+            order.push_back(ii);
+        }
+    }
+    std::vector<size_t> totals(SITE_CAPACITY, 0);
+    for (size_t index : order) {
+        totals[index] = alloc_sites[index].bytes.load(std::memory_order_relaxed);
+    }
+    size_t count = std::min(sites, order.size());
+    std::partial_sort(order.begin(), order.begin()+count, order.end(), [&](size_t a, size_t b) {
+        return totals[a] > totals[b];
+    });
+
+    ss << "\nTop " << count << " of " << order.size() << " call sites by bytes allocated";
+    size_t lost = lost_sites.load(std::memory_order_relaxed);
+    if (lost > 0) {
+        ss << " (" << lost << " allocations did not fit in the site table)";
+    }
+    ss << "\n";
+    for (size_t ii = 0; ii < count; ii++) {
+        const AllocSite& site = alloc_sites[order[ii]];
+        ss << "#" << ii+1 << " " << tag_names[site.tag] << ": "
+           << site.allocations.load(std::memory_order_relaxed) << " allocs, "
+           << kilobytes(totals[order[ii]]) << " (live "
+           << kilobytes(site.live.load(std::memory_order_relaxed)) << ")\n";
+        char** symbols = backtrace_symbols(site.frames, site.depth);
+        for (int jj = 0; jj < site.depth; jj++) {
+            ss << "    " << (symbols != nullptr ? demangle(symbols[jj]) : "?") << "\n";
+        }
+        std::free(symbols);
+    }
+    in_capture = capture;
+#else
+    ss << "\nCall sites are not recorded on this platform\n";
+#endif
+    return ss.str();
+}
+
+/**
+ * Writes the report of {@link #getReport} to the given file.
+ *
+ * @param path  The file to write
+ * @param sites The number of call sites to report
+ *
+ * @return true if the file was written
+ */
+bool AllocTracker::dump(const std::string& path, size_t sites) {
+    std::string report = getReport(sites);
+    auto writer = TextWriter::alloc(path);
+    if (writer == nullptr) {
+        return false;
+    }
+    writer->write(report);
+    writer->close();
+    return true;
+}
+
+/**
+ * Asks the application to dump a report at its next opportunity.
+ *
+ * This is safe to call from a signal handler.  In a tracking build on
+ * Linux and macOS, it is installed as the handler of SIGUSR1, so that a
+ * headless run can be sampled with kill -USR1.
+ */
+void AllocTracker::requestDump() {
+    dump_requested.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * Returns true if a dump was requested, clearing the request.
+ *
+ * @return true if a dump was requested
+ */
+bool AllocTracker::takeDumpRequest() {
+    return dump_requested.exchange(false, std::memory_order_relaxed);
+}
+
+#pragma mark -
+#pragma mark Allocation
+/**
+ * Returns a tracked allocation of the given size and alignment.
+ *
+ * The allocation is attributed to the given tag.  It must be freed with
+ * {@link #deallocate}.  This method returns nullptr if the allocation
+ * fails.
+ *
+ * @param bytes The number of bytes to allocate
+ * @param align The alignment, which must be a power of two
+ * @param tag   The tag of the allocation
+ *
+ * @return a tracked allocation of the given size and alignment
+ */
+void* AllocTracker::allocate(size_t bytes, size_t align, Tag tag) {
+    std::byte* block = nullptr;
+    std::byte* result = nullptr;
+    if (align <= alignof(std::max_align_t)) {
+        block = static_cast<std::byte*>(std::malloc(bytes+sizeof(AllocHeader)));
+        result = block+sizeof(AllocHeader);
+    } else {
+        block = static_cast<std::byte*>(std::malloc(bytes+sizeof(AllocHeader)+align));
+        uintptr_t start = reinterpret_cast<uintptr_t>(block+sizeof(AllocHeader));
+        result = block+sizeof(AllocHeader)+(((start+align-1) & ~(uintptr_t)(align-1))-start);
+    }
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    AllocHeader* header = reinterpret_cast<AllocHeader*>(result)-1;
+    header->size = bytes;
+    header->offset = (uint32_t)(result-block);
+    header->site = record_site(tag, bytes);
+    header->tag = (uint8_t)tag;
+    header->magic = HEADER_MAGIC;
+    count_alloc(header);
+    return result;
+}
+
+/**
+ * Returns a tracked allocation resized to the given size.
+ *
+ * This has the semantics of realloc.  The memory must have been allocated
+ * with the default alignment.
+ *
+ * @param ptr   The allocation to resize (or nullptr)
+ * @param bytes The new size of the allocation
+ * @param tag   The tag of the new allocation
+ *
+ * @return a tracked allocation resized to the given size
+ */
+void* AllocTracker::reallocate(void* ptr, size_t bytes, Tag tag) {
+    if (ptr == nullptr) {
+        return allocate(bytes, alignof(std::max_align_t), tag);
+    } else if (bytes == 0) {
+        deallocate(ptr);
+        return nullptr;
+    }
+
+    AllocHeader previous = *get_header(ptr);
+    CUAssertLog(previous.offset == sizeof(AllocHeader), "Memory at %p is over-aligned", ptr);
+    std::byte* block = static_cast<std::byte*>(ptr)-sizeof(AllocHeader);
+    block = static_cast<std::byte*>(std::realloc(block, bytes+sizeof(AllocHeader)));
+    if (block == nullptr) {
+        return nullptr; // The original allocation is untouched
+    }
+
+    count_free(&previous);
+    AllocHeader* header = reinterpret_cast<AllocHeader*>(block);
+    header->size = bytes;
+    header->site = record_site(tag, bytes);
+    header->tag = (uint8_t)tag;
+    count_alloc(header);
+    return block+sizeof(AllocHeader);
+}
+
+/**
+ * Frees a tracked allocation.
+ *
+ * @param ptr   The allocation to free (or nullptr)
+ */
+void AllocTracker::deallocate(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    AllocHeader* header = get_header(ptr);
+    count_free(header);
+    header->magic = 0;
+    std::free(static_cast<std::byte*>(ptr)-header->offset);
+}
+
+#ifdef CU_TRACK_ALLOCATIONS
+#pragma mark -
+#pragma mark Hooks
+
+#ifdef ATK_TRACK_ALLOCATIONS
+/** Allocates memory for the audio toolkit */
+static void* SDLCALL atk_malloc(size_t size) {
+    return AllocTracker::allocate(size, alignof(std::max_align_t), AllocTracker::Tag::AUDIO);
+}
+
+/** Reallocates memory for the audio toolkit */
+static void* SDLCALL atk_realloc(void* mem, size_t size) {
+    return AllocTracker::reallocate(mem, size, AllocTracker::Tag::AUDIO);
+}
+
+/** Frees memory of the audio toolkit */
+static void SDLCALL atk_free(void* mem) {
+    AllocTracker::deallocate(mem);
+}
+#endif
+
+#if CU_ALLOC_SITES
+/** Requests a dump when the process receives SIGUSR1 */
+static void dump_signal(int) {
+    AllocTracker::requestDump();
+}
+#endif
+
+/**
+ * Installs the hooks of the tracker when the program starts.
+ *
+ * This object lives in the same file as operator new, so it is always linked
+ * into a tracking build.
+ */
+static struct TrackerHooks {
+    TrackerHooks() {
+#ifdef ATK_TRACK_ALLOCATIONS
+        ATK_SetMemoryFunctions(atk_malloc, atk_realloc, atk_free);
+#endif
+#if CU_ALLOC_SITES
+        signal(SIGUSR1, dump_signal);
+#endif
+    }
+} tracker_hooks;
+
+#pragma mark -
+#pragma mark Global Operators
+
+/**
+ * Returns a tracked allocation, throwing std::bad_alloc on failure.
+ *
+ * @param size  The number of bytes to allocate
+ * @param align The alignment of the allocation
+ *
+ * @return a tracked allocation
+ */
+static void* tracked_new(std::size_t size, std::size_t align) {
+    void* result = AllocTracker::allocate(size, align, current_tag);
+    if (result == nullptr) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+void* operator new(std::size_t size) {
+    return tracked_new(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+    return tracked_new(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return AllocTracker::allocate(size, alignof(std::max_align_t), current_tag);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return AllocTracker::allocate(size, alignof(std::max_align_t), current_tag);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    return tracked_new(size, (std::size_t)align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return tracked_new(size, (std::size_t)align);
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return AllocTracker::allocate(size, (std::size_t)align, current_tag);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return AllocTracker::allocate(size, (std::size_t)align, current_tag);
+}
+
+void operator delete(void* ptr) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    AllocTracker::deallocate(ptr);
+}
+
+#endif
@@ -0,0 +1,181 @@
+//
+//  CUFrameArena.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a linear (bump) allocator for short-lived data.  Many
+//  parts of the render loop allocate small objects that are only needed for
+//  part of a frame, such as render queue entries and recorded uniforms.  An
+//  arena hands out this memory by advancing an offset into a block that is
+//  allocated once, and reclaims all of it at once when it is reset.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+#include <cugl/util/CUFrameArena.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+#include <cstdint>
+
+using namespace cugl;
+
+/** The initial capacity of the arena of each thread */
+const size_t FrameArena::INITIAL_CAPACITY = 64*1024;
+
+#pragma mark Constructors
+/**
+ * Creates an arena with no memory.
+ *
+ * The arena allocates its first block on first use.
+ */
+FrameArena::FrameArena() :
+_offset(0),
+_usage(0),
+_peak(0),
+_allocations(0),
+_totalAllocations(0),
+_heapBlocks(0) {
+}
+
+/**
+ * Releases all of the memory of this arena.
+ *
+ * Every allocation from this arena is invalid afterwards.
+ */
+void FrameArena::dispose() {
+    for(auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+        delete[] it->data;
+    }
+    _blocks.clear();
+    _offset = 0;
+    _usage = 0;
+    _allocations = 0;
+}
+
+/**
+ * Initializes this arena with a block of the given size.
+ *
+ * @param capacity  The initial capacity in bytes
+ *
+ * @return true if the arena was initialized properly
+ */
+bool FrameArena::init(size_t capacity) {
+    CUAssertLog(_blocks.empty(), "Arena is already initialized");
+    if (capacity > 0) {
+        grow(capacity);
+    }
+    return true;
+}
+
+/**
+ * Returns the arena of the calling thread.
+ *
+ * The arena is created with {@link #INITIAL_CAPACITY} the first time a
+ * thread calls this method.
+ *
+ * @return the arena of the calling thread
+ */
+FrameArena* FrameArena::get() {
+    static thread_local FrameArena arena;
+    if (arena._blocks.empty()) {
+        arena.init(INITIAL_CAPACITY);
+    }
+    return &arena;
+}
+
+#pragma mark Allocation
+/**
+ * Adds a block of at least the given size to this arena.
+ *
+ * @param bytes The minimum size of the new block
+ */
+void FrameArena::grow(size_t bytes) {
+    size_t size = _blocks.empty() ? bytes : std::max(bytes, 2*_blocks.back().size);
+    Block block;
+    block.data = new std::byte[size];
+    block.size = size;
+    _blocks.push_back(block);
+    _offset = 0;
+    _heapBlocks++;
+}
+
+/**
+ * Returns uninitialized memory of the given size and alignment.
+ *
+ * The memory is valid until the next call to {@link #reset}.
+ *
+ * @param bytes The number of bytes to allocate
+ * @param align The alignment, which must be a power of two
+ *
+ * @return uninitialized memory of the given size and alignment
+ */
+void* FrameArena::allocate(size_t bytes, size_t align) {
+    CUAssertLog((align & (align-1)) == 0, "Alignment %zu is not a power of two", align);
+    size_t padding = 0;
+    if (!_blocks.empty()) {
+        uintptr_t next = reinterpret_cast<uintptr_t>(_blocks.back().data + _offset);
+        padding = ((next + align - 1) & ~(uintptr_t)(align - 1)) - next;
+    }
+    if (_blocks.empty() || _offset + padding + bytes > _blocks.back().size) {
+        grow(bytes + align);
+        uintptr_t next = reinterpret_cast<uintptr_t>(_blocks.back().data);
+        padding = ((next + align - 1) & ~(uintptr_t)(align - 1)) - next;
+    }
+
+    void* result = _blocks.back().data + _offset + padding;
+    _offset += padding + bytes;
+    _usage  += padding + bytes;
+    _peak = std::max(_peak, _usage);
+    _allocations++;
+    _totalAllocations++;
+    return result;
+}
+
+/**
+ * Reclaims every allocation of this arena.
+ *
+ * If the arena had to grow since the last reset, its blocks are replaced
+ * by a single block large enough for all of them.
+ */
+void FrameArena::reset() {
+    if (_blocks.size() > 1) {
+        size_t capacity = getCapacity();
+        for(auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+            delete[] it->data;
+        }
+        _blocks.clear();
+        grow(capacity);
+    }
+    _offset = 0;
+    _usage = 0;
+    _allocations = 0;
+}
+
+#pragma mark Statistics
+/**
+ * Returns the total size of the blocks of this arena in bytes.
+ *
+ * @return the total size of the blocks of this arena in bytes
+ */
+size_t FrameArena::getCapacity() const {
+    size_t result = 0;
+    for(auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+        result += it->size;
+    }
+    return result;
+}
@@ -10,6 +10,11 @@
 //  the code for asynchronous asset loading. We generalized that class added
 //  some notable safety changes.
 //
+//  The thread pool is now a facade over a work-stealing job system. The job
+//  system gives each worker its own queue, stores small jobs without any heap
+//  allocation, and supports fork-join through job counters. This allows frame
+//  work to be fanned out across all of the cores of a device.
+//
 //  CUGL MIT License:
 //      This software is provided 'as-is', without any express or implied
 //      warranty.  In no event will the authors be held liable for any damages
@@ -33,117 +38,391 @@
 //  Version: 11/29/16
 //
 #include <cugl/util/CUThreadPool.h>
+#include <cugl/util/CUDebug.h>
+
 
 using namespace cugl;
 
+/** The initial capacity of each job queue */
+#define QUEUE_CAPACITY  64
+
+/** The job system owning the current thread (null if not a worker) */
+static thread_local JobSystem* t_system = nullptr;
+/** The queue index of the current thread (if a worker) */
+static thread_local Uint32 t_index = 0;
+
 #pragma mark -
-#pragma mark Constructors
+#pragma mark Job Queue
 /**
- * Disposes this thread pool, releasing all memory.
+ * A double-ended job queue.
  *
- * A disposed thread pool can be safely reinitialized. However, it is a bad
- * idea to destroy the thread pool if the pool is not yet shut down. The
- * task queue is shared by the child threads, so we cannot delete it until
- * all the threads complete.  This destructor will block unti showndown.
+ * The owner of the queue adds and removes jobs from the back, while other
+ * threads steal jobs from the front. The queue is a ring buffer that only
+ * grows (doubling in size) when it is full, so it rarely allocates. Each
+ * queue has its own lock, so workers only contend when stealing.
  */
-void ThreadPool::dispose() {
+class JobSystem::Queue {
+private:
+    /** A mutex lock for this queue */
+    std::mutex _mutex;
+    /** The ring buffer (a power of two in size) */
+    std::vector<Job> _ring;
+    /** The position of the front of the queue */
+    size_t _head;
+    /** The number of jobs in the queue */
+    size_t _size;
+    
+public:
+    /**
+     * Creates an empty job queue
+     */
+    Queue() : _head(0), _size(0) {
+        _ring.resize(QUEUE_CAPACITY);
+    }
+    
+    /**
+     * Adds a job to the back of this queue.
+     *
+     * @param job   The job to add
+     */
+    void pushBack(Job&& job) {
+        std::lock_guard<std::mutex> lk(_mutex);
+        if (_size == _ring.size()) {
+            std::vector<Job> ring(2*_ring.size());
+            for(size_t ii = 0; ii < _size; ii++) {
+                ring[ii] = std::move(_ring[(_head+ii) & (_ring.size()-1)]);
+            }
+            _ring.swap(ring);
+            _head = 0;
+        }
+        _ring[(_head+_size) & (_ring.size()-1)] = std::move(job);
+        _size++;
+    }
+    
+    /**
+     * Removes a job from the back of this queue.
+     *
+     * @param job   The job to store the result
+     *
+     * @return true if a job was removed
+     */
+    bool popBack(Job& job) {
+        std::lock_guard<std::mutex> lk(_mutex);
+        if (_size == 0) {
+            return false;
+        }
+        _size--;
+        job = std::move(_ring[(_head+_size) & (_ring.size()-1)]);
+        return true;
+    }
+    
+    /**
+     * Removes a job from the front of this queue.
+     *
+     * @param job   The job to store the result
+     *
+     * @return true if a job was removed
+     */
+    bool popFront(Job& job) {
+        std::lock_guard<std::mutex> lk(_mutex);
+        if (_size == 0) {
+            return false;
+        }
+        job = std::move(_ring[_head]);
+        _head = (_head+1) & (_ring.size()-1);
+        _size--;
+        return true;
+    }
+    
+    /**
+     * Removes all jobs from this queue, without running them
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lk(_mutex);
+        for(size_t ii = 0; ii < _size; ii++) {
+            _ring[(_head+ii) & (_ring.size()-1)].clear();
+        }
+        _head = 0;
+        _size = 0;
+    }
+};
+
+/**
+ * The start data for an SDL worker thread
+ */
+struct WorkerStart {
+    /** The job system of the worker */
+    JobSystem* system;
+    /** The queue index of the worker */
+    Uint32 index;
+};
+
+#pragma mark -
+#pragma mark Job System
+/**
+ * Creates a job system with no active threads.
+ *
+ * You must initialize this job system before use.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a job system
+ * on the heap, use one of the static constructors instead.
+ */
+JobSystem::JobSystem() :
+_queued(0),
+_sleepers(0),
+_stop(false),
+_complete(0) {
+}
+
+/**
+ * Deletes this job system, stopping all threads.
+ */
+JobSystem::~JobSystem() {
+    dispose();
+}
+
+/**
+ * Disposes this job system, stopping all threads and discarding any
+ * remaining jobs.
+ *
+ * A disposed job system can be safely reinitialized.
+ */
+void JobSystem::dispose() {
     stop();
-    while (!isShutdown());
+    for(auto it = _queues.begin(); it != _queues.end(); ++it) {
+        (*it)->clear();
+    }
+    _queues.clear();
+    _workers.clear();
+    _queued.store(0);
+    _complete.store(0);
 }
 
 /**
- * Initializes a thread pool with the given number of threads.
+ * Initializes a job system with the given number of threads.
  *
- * You can specify the number of simultaneous worker threads. We find that
- * 4 is generally a good number, even if you have a lot of tasks.  Much
- * more than the number of cores on a machine is counter-productive.
+ * If threads is 0 (or negative), the job system sizes itself to the
+ * device, with one worker for every core but the one running the calling
+ * thread. The calling thread is expected to help out with {@link #wait}.
  *
- * @param threads   the number of threads in this pool
+ * @param threads   the number of worker threads
  *
- * @return true if the threed pool is initialized properly, false otherwise.
+ * @return true if the job system is initialized properly, false otherwise.
  */
-bool ThreadPool::init(int threads) {
-    for (int index = 0; index < threads; ++index) {
+bool JobSystem::init(int threads) {
+    if (!_queues.empty()) {
+        return false;
+    }
+    if (threads <= 0) {
+        threads = std::max(SDL_GetCPUCount()-1,1);
+    }
+    
+    _stop.store(false);
+    for(int ii = 0; ii <= threads; ii++) {
+        _queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    for (Uint32 index = 0; index < (Uint32)threads; ++index) {
 #ifdef CU_SDL_THREADS
-        _workers.emplace_back(SDL_CreateThread(ThreadPool::sdlThreadFunc,"Pool Dispatch",(void*)this));
+        WorkerStart* start = new WorkerStart();
+        start->system = this;
+        start->index = index;
+        _workers.emplace_back(SDL_CreateThread(JobSystem::sdlWorkerFunc,"Job Worker",(void*)start));
 #else
-        _workers.emplace_back(std::thread(std::bind(&ThreadPool::threadFunc, this)));
+        _workers.emplace_back(std::thread(&JobSystem::workerFunc, this, index));
 #endif
     }
     return true;
 }
 
-
 #pragma mark -
 #pragma mark Thread Execution
-
 /**
- * The body function of a single thread.
+ * The body function of a worker thread.
  *
- * This function pulls tasks from the task queue.
+ * This function runs jobs until the job system is stopped.
  *
- * This implementation is safe to use with std::thread.
+ * @param index The index of the worker queue
  */
-void ThreadPool::threadFunc() {
-    while (!_stop) {
-        std::function<void()> task = nullptr;
-        {   // Lock for save queue access
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            if (_stop) {
-                break;
-            }
-            // Pull the next task off the queue
-            if (!_taskQueue.empty()) {
-                task = std::move(_taskQueue.front());
-                _taskQueue.pop();
-            } else {
-                _taskCondition.wait(lk);
-                continue;
-            }
+void JobSystem::workerFunc(Uint32 index) {
+    t_system = this;
+    t_index = index;
+    
+    Job job;
+    while (!_stop.load(std::memory_order_acquire)) {
+        if (acquire(index,job)) {
+            job.run();
+            continue;
+        }
+        
+        // Sleep until there is something to do
+        std::unique_lock<std::mutex> lk(_sleepMutex);
+        _sleepers.fetch_add(1);
+        if (!_stop.load() && _queued.load() == 0) {
+            _sleepCondition.wait(lk);
         }
-        // Perform the current task
-        task();
+        _sleepers.fetch_sub(1);
     }
-    _complete++;
+    _complete.fetch_add(1);
 }
 
 /**
- * The body function of a single thread.
- *
- * This function pulls tasks from the task queue.
+ * The body function of a worker thread.
  *
  * This static implementation uses the SDL thread API.  It should be used
  * on Android and Windows, which have special thread requirements.
  */
-int ThreadPool::sdlThreadFunc(void* ptr) {
-    ThreadPool* self = (ThreadPool*)ptr;
-    while (!self->_stop) {
-        std::function<void()> task = nullptr;
-        {   // Lock for save queue access
-            std::unique_lock<std::mutex> lk(self->_queueMutex);
-            if (self->_stop) {
-                break;
-            }
-            // Pull the next task off the queue
-            if (!self->_taskQueue.empty()) {
-                task = std::move(self->_taskQueue.front());
-                self->_taskQueue.pop();
-            } else {
-                self->_taskCondition.wait(lk);
-                continue;
-            }
+int JobSystem::sdlWorkerFunc(void* ptr) {
+    WorkerStart* start = (WorkerStart*)ptr;
+    JobSystem* self = start->system;
+    Uint32 index = start->index;
+    delete start;
+    self->workerFunc(index);
+    return 0;
+}
+
+/**
+ * Returns the queue index for the calling thread.
+ *
+ * Worker threads have their own queue. All other threads share the last
+ * queue.
+ *
+ * @return the queue index for the calling thread.
+ */
+Uint32 JobSystem::getQueueIndex() const {
+    if (t_system == this) {
+        return t_index;
+    }
+    return (Uint32)_queues.size()-1;
+}
+
+/**
+ * Adds a job to the queue of the calling thread, waking a worker if necessary.
+ *
+ * @param job   The job to add
+ */
+void JobSystem::push(Job&& job) {
+    CUAssertLog(!_queues.empty(), "Attempt to use an uninitialized job system");
+    _queues[getQueueIndex()]->pushBack(std::move(job));
+    _queued.fetch_add(1);
+    if (_sleepers.load() > 0) {
+        // Locking guarantees the sleeper is waiting (or has seen the job)
+        { std::lock_guard<std::mutex> lk(_sleepMutex); }
+        _sleepCondition.notify_one();
+    }
+}
+
+/**
+ * Removes a job for the given queue, stealing from other queues if necessary.
+ *
+ * @param index The queue index of the calling thread
+ * @param job   The job to store the result
+ *
+ * @return true if a job was found
+ */
+bool JobSystem::acquire(Uint32 index, Job& job) {
+    Uint32 shared = (Uint32)_queues.size()-1;
+    bool found = false;
+    if (index < shared) {
+        found = _queues[index]->popBack(job);
+    }
+    if (!found) {
+        found = _queues[shared]->popFront(job);
+    }
+    for(Uint32 ii = 1; !found && ii < shared+1; ii++) {
+        Uint32 victim = (index+ii) % (shared+1);
+        if (victim != shared) {
+            found = _queues[victim]->popFront(job);
         }
-        // Perform the current task
-        task();
     }
-    self->_complete++;
-    return 0;
+    if (found) {
+        _queued.fetch_sub(1);
+    }
+    return found;
 }
 
+#pragma mark -
+#pragma mark Job Management
+/**
+ * Blocks until every job assigned to the given counter is complete.
+ *
+ * Rather than idle, the calling thread runs pending jobs while it waits.
+ * Hence it is safe to call this method from within a job.
+ *
+ * @param counter   The counter to wait on
+ */
+void JobSystem::wait(const Counter& counter) {
+    Uint32 index = getQueueIndex();
+    Job job;
+    while (!counter.done()) {
+        if (acquire(index,job)) {
+            job.run();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
 
+/**
+ * Stops the job system, marking it for shut down.
+ *
+ * This method blocks until the worker threads have finished their current
+ * jobs. Jobs still in the queues are not run.
+ */
+void JobSystem::stop() {
+    {
+        std::unique_lock<std::mutex> lk(_sleepMutex);
+        _stop.store(true);
+        _sleepCondition.notify_all();
+    }
+    
+    for (auto&& worker : _workers) {
+#ifdef CU_SDL_THREADS
+        if (worker) {
+            int status;
+            SDL_WaitThread(worker,&status);
+            worker = nullptr;
+        }
+#else
+        if (worker.joinable()) {
+            worker.join();
+        }
+#endif
+    }
+}
 
 #pragma mark -
-#pragma mark Task Management
+#pragma mark Thread Pool
+/**
+ * Disposes this thread pool, releasing all memory.
+ *
+ * A disposed thread pool can be safely reinitialized. However, it is a bad
+ * idea to destroy the thread pool if the pool is not yet shut down. The
+ * task queue is shared by the child threads, so we cannot delete it until
+ * all the threads complete.  This destructor will block unti showndown.
+ */
+void ThreadPool::dispose() {
+    if (_jobs) {
+        _jobs->dispose();
+        _jobs = nullptr;
+    }
+}
+
+/**
+ * Initializes a thread pool with the given number of threads.
+ *
+ * You can specify the number of simultaneous worker threads. We find that
+ * 4 is generally a good number, even if you have a lot of tasks.  Much
+ * more than the number of cores on a machine is counter-productive.
+ *
+ * @param threads   the number of threads in this pool
+ *
+ * @return true if the threed pool is initialized properly, false otherwise.
+ */
+bool ThreadPool::init(int threads) {
+    _jobs = JobSystem::alloc(threads);
+    return _jobs != nullptr;
+}
+
 /**
  * Adds a task to the thread pool.
  *
@@ -155,9 +434,9 @@ int ThreadPool::sdlThreadFunc(void* ptr) {
  * @param  task     the task function to add to the thread pool
  */
 void ThreadPool::addTask(const std::function<void()> &task){
-    std::unique_lock<std::mutex> lk(_queueMutex);
-    _taskQueue.emplace(task);
-    _taskCondition.notify_one();
+    if (_jobs) {
+        _jobs->submit(task);
+    }
 }
 
 /**
@@ -168,18 +447,7 @@ void ThreadPool::addTask(const std::function<void()> &task){
  * threads have finished with their tasks.
  */
 void ThreadPool::stop() {
-    {
-        std::unique_lock<std::mutex> lk(_queueMutex);
-        _stop = true;
-        _taskCondition.notify_all();
-    }
-    
-    for (auto&& worker : _workers) {
-#ifdef CU_SDL_THREADS
-        int status;
-        SDL_WaitThread(worker,&status);
-#else
-        worker.join();
-#endif
+    if (_jobs) {
+        _jobs->stop();
     }
 }
@@ -3,6 +3,7 @@
 //
 
 #include "RootedApp.h"
+#include "RootedConstants.h"
 
 using namespace cugl;
 
@@ -26,6 +27,8 @@ using namespace cugl;
 void RootedApp::onStartup() {
     _assets = AssetManager::alloc();
     _batch  = SpriteBatch::alloc();
+    // The game camera is zoomed in, so skip nodes outside of its view
+    _batch->setCulling(true);
     
     // Start-up basic input
 #ifdef CU_TOUCH_SCREEN
@@ -49,6 +52,8 @@ void RootedApp::onStartup() {
     _loaded = false;
     _loading.init(_assets);
     _status = LOAD;
+    _budgetFrames = 0;
+    _arenaBlocks = FrameArena::get()->getHeapBlocks();
     
     // Que up the other assets
     AudioEngine::start();
@@ -88,6 +93,9 @@ void RootedApp::onShutdown() {
 #endif
     
     AudioEngine::stop();
+    if (AllocTracker::isEnabled()) {
+        dumpAllocations();
+    }
     Application::onShutdown();  // YOU MUST END with call to parent
 }
 
@@ -170,6 +178,9 @@ void RootedApp::update(float dt) {
  * @param dt    The amount of time (in seconds) since the last frame
  */
 void RootedApp::preUpdate(float dt) {
+    AllocTracker::beginFrame();
+    ProfilerController::get()->beginFrame();
+    PROFILE_SCOPE("RootedApp::preUpdate");
 //    std::cout<<_status<<"\n";
     if (!_loaded && _loading.isActive()) {
         _loading.update(0.01f);
@@ -209,6 +220,7 @@ void RootedApp::preUpdate(float dt) {
 //        }
     }
     if(_network){
+        PROFILE_SCOPE("NetEventController::updateNet");
         _network->updateNet();
     }
 }
@@ -235,6 +247,8 @@ void RootedApp::preUpdate(float dt) {
  * {@link #preUpdate} and {@link #postUpdate}) or to animate models.
  */
 void RootedApp::fixedUpdate() {
+    FrameArena::get()->reset();
+    PROFILE_SCOPE("RootedApp::fixedUpdate");
     // Compute time to report to game scene version of fixedUpdate
     float time = getFixedStep()/1000000.0f;
 //    _gameplay.fixedUpdate(time);
@@ -267,12 +281,14 @@ void RootedApp::fixedUpdate() {
  * @param dt    The amount of time (in seconds) since the last frame
  */
 void RootedApp::postUpdate(float dt) {
+    PROFILE_SCOPE("RootedApp::postUpdate");
     // Compute time to report to game scene version of postUpdate
     float time = getFixedRemainder()/1000000.0f;
 //    _gameplay.postUpdate(time);
     if (_status == GAME) {
         _gameplay.postUpdate(time);
     }
+    checkAllocations();
 }
 
 /**
@@ -399,22 +415,109 @@ void RootedApp::updateClientScene(float timestep) {
  * at all. The default implmentation does nothing.
  */
 void RootedApp::draw() {
-    switch (_status) {
-        case LOAD:
-            _loading.render(_batch);
-            break;
-        case MENU:
-            _mainmenu.render(_batch);
-            break;
-        case HOST:
-            _hostgame.render(_batch);
-            break;
-        case CLIENT:
-            _joingame.render(_batch);
-            break;
-        case GAME:
-            _gameplay.render(_batch);
-        default:
-            break;
+    FrameArena::get()->reset();
+    _batch->resetStats();
+    {
+        PROFILE_SCOPE("RootedApp::draw");
+        switch (_status) {
+            case LOAD:
+                _loading.render(_batch);
+                break;
+            case MENU:
+                _mainmenu.render(_batch);
+                break;
+            case HOST:
+                _hostgame.render(_batch);
+                break;
+            case CLIENT:
+                _joingame.render(_batch);
+                break;
+            case GAME:
+                _gameplay.render(_batch);
+            default:
+                break;
+        }
+    }
+    checkBatchBudget();
+    checkFrameArena();
+    ProfilerController::get()->endFrame();
+}
+
+/**
+ * Logs the sprite batch statistics of this frame if they exceed the budget.
+ *
+ * The warning lists the context changes that broke batching, so that it is
+ * possible to tell which scene nodes are responsible. Warnings are limited
+ * to one every {@link BATCH_BUDGET_INTERVAL} frames.
+ */
+void RootedApp::checkBatchBudget() {
+    if (_budgetFrames < BATCH_BUDGET_INTERVAL) {
+        _budgetFrames++;
+        return;
+    }
+    
+    const SpriteBatch::Stats& stats = _batch->getStats();
+    if (stats.draws <= BATCH_BUDGET_DRAWS &&
+        stats.textureBinds <= BATCH_BUDGET_TEXTURES &&
+        stats.uniformUploads <= BATCH_BUDGET_UNIFORMS) {
+        return;
+    }
+    
+    std::stringstream ss;
+    for (int ii = 0; ii < SpriteBatch::Stats::REASONS; ii++) {
+        if (stats.reasons[ii] > 0) {
+            ss << " " << SpriteBatch::Stats::getReasonName(ii) << "=" << stats.reasons[ii];
+        }
+    }
+    CUWarn("Sprite batch over budget: %u draws, %u vertices, %u flushes, %u passes, %u texture binds, %u uniforms, %u shader swaps; breaks:%s",
+           stats.draws, stats.vertices, stats.flushes, stats.passes,
+           stats.textureBinds, stats.uniformUploads, stats.shaderSwaps, ss.str().c_str());
+    _budgetFrames = 0;
+}
+
+/**
+ * Logs a warning if the frame arena had to allocate from the heap this frame.
+ *
+ * The arena keeps the memory it grows to, so after the first few frames of a
+ * scene this should never happen. The per-frame arena allocations are shown
+ * in the profiler overlay.
+ */
+void RootedApp::checkFrameArena() {
+    const FrameArena* arena = FrameArena::get();
+    if (arena->getHeapBlocks() == _arenaBlocks) {
+        return;
+    }
+    CUWarn("Frame arena grew to %zu KB (peak usage %zu KB, %zu heap blocks)",
+           arena->getCapacity() / 1024, arena->getPeakUsage() / 1024, arena->getHeapBlocks());
+    _arenaBlocks = arena->getHeapBlocks();
+}
+
+/**
+ * Writes the allocation report if one was requested this frame.
+ *
+ * Reports are requested by closing the debug overlay, or by sending the
+ * process SIGUSR1 in a headless run. This does nothing unless CUGL was
+ * built with CUGL_TRACK_ALLOCATIONS.
+ */
+void RootedApp::checkAllocations() {
+    if (AllocTracker::takeDumpRequest()) {
+        dumpAllocations();
+    }
+}
+
+/**
+ * Writes the allocation report of {@link AllocTracker}.
+ *
+ * The report goes to the path in the environment variable
+ * {@link ALLOC_REPORT_ENV}, or to {@link ALLOC_REPORT_FILE} in the save
+ * directory if it is not set.
+ */
+void RootedApp::dumpAllocations() {
+    const char* env = std::getenv(ALLOC_REPORT_ENV);
+    std::string path = (env != nullptr ? env : getSaveDirectory() + ALLOC_REPORT_FILE);
+    if (AllocTracker::dump(path, ALLOC_REPORT_SITES)) {
+        CULog("Wrote allocation report to %s", path.c_str());
+    } else {
+        CUWarn("Could not write allocation report to %s", path.c_str());
     }
 }
@@ -12,6 +12,7 @@
 #include "scenes/HostScene.h"
 #include "scenes/ClientScene.h"
 #include "controllers/NetworkController.h"
+#include "controllers/ProfilerController.h"
 
 using namespace cugl::physics2::net;
 
@@ -46,6 +47,11 @@ protected:
     
     Status _status;
     
+    /** The number of frames since the last sprite batch budget warning */
+    int _budgetFrames;
+    /** The number of heap blocks of the frame arena at the last check */
+    size_t _arenaBlocks;
+    
 public:
 #pragma mark Constructors
     /**
@@ -236,6 +242,42 @@ public:
      */
     void updateClientScene(float timestep);
     
+    /**
+     * Logs the sprite batch statistics of this frame if they exceed the budget.
+     *
+     * The warning lists the context changes that broke batching, so that it is
+     * possible to tell which scene nodes are responsible. Warnings are limited
+     * to one every {@link BATCH_BUDGET_INTERVAL} frames.
+     */
+    void checkBatchBudget();
+    
+    /**
+     * Logs a warning if the frame arena had to allocate from the heap this frame.
+     *
+     * The arena keeps the memory it grows to, so after the first few frames of a
+     * scene this should never happen. The per-frame arena allocations are shown
+     * in the profiler overlay.
+     */
+    void checkFrameArena();
+    
+    /**
+     * Writes the allocation report if one was requested this frame.
+     *
+     * Reports are requested by closing the debug overlay, or by sending the
+     * process SIGUSR1 in a headless run. This does nothing unless CUGL was
+     * built with CUGL_TRACK_ALLOCATIONS.
+     */
+    void checkAllocations();
+    
+    /**
+     * Writes the allocation report of {@link AllocTracker}.
+     *
+     * The report goes to the path in the environment variable
+     * {@link ALLOC_REPORT_ENV}, or to {@link ALLOC_REPORT_FILE} in the save
+     * directory if it is not set.
+     */
+    void dumpAllocations();
+    
     /**
      * The method called to draw the application to the screen.
      *
@@ -36,7 +36,48 @@
 #define DEFAULT_GRAVITY 0.0f
 /** The number of frame to wait before reinitializing the game */
 #define EXIT_COUNT      240
+/** The worker threads for solving physics islands in parallel (0 to step on the main thread) */
+#define PHYSICS_THREADS 0
 
+#pragma mark -
+#pragma mark Network Constants
+/** Whether to run the game in deterministic lockstep, sending only inputs */
+#define LOCKSTEP_ENABLED false
+/** The number of ticks local input is delayed by in lockstep */
+#define LOCKSTEP_DELAY  4
+/** The hash precision (in Box2d units) for desync detection with synced physics */
+#define SYNC_HASH_PRECISION 0.5f
+/** Whether to record all network traffic of a session to a log */
+#define NET_RECORD_ENABLED  false
+/** The file (in the save directory) that network traffic is recorded to */
+#define NET_RECORD_FILE     "session.netlog"
+
+#pragma mark -
+#pragma mark Profiler Constants
+/** Whether to record frame timings (shown in the debug overlay) */
+#define PROFILER_ENABLED    true
+/** The number of frames kept by the profiler */
+#define PROFILER_HISTORY    120
+/** The number of GPU timer queries that can be in flight */
+#define PROFILER_QUERIES    32
+/** The number of frames between updates of the profiler overlay */
+#define PROFILER_OVERLAY_INTERVAL 15
+/** The file (in the save directory) the profiler trace is written to when the overlay is closed */
+#define PROFILER_TRACE_FILE "profile.json"
+/** The file (in the save directory) the allocation report is written to in tracking builds */
+#define ALLOC_REPORT_FILE   "allocations.txt"
+/** The environment variable that overrides the path of the allocation report */
+#define ALLOC_REPORT_ENV    "ROOTED_ALLOC_REPORT"
+/** The number of call sites in the allocation report */
+#define ALLOC_REPORT_SITES  32
+/** The sprite batch draw calls per frame before a budget warning is logged */
+#define BATCH_BUDGET_DRAWS      64
+/** The sprite batch texture binds per frame before a budget warning is logged */
+#define BATCH_BUDGET_TEXTURES   24
+/** The sprite batch uniform uploads per frame before a budget warning is logged */
+#define BATCH_BUDGET_UNIFORMS   192
+/** The minimum number of frames between two budget warnings */
+#define BATCH_BUDGET_INTERVAL   120
 
 #pragma mark -
 #pragma mark Asset Constants
@@ -131,6 +172,18 @@ const float WIND_DIRECTION[2] = {1.0, 1.0};
 #define DEFAULT_WHEAT_TEX_WIDTH 480
 #define DEFAULT_WHEAT_TEX_HEIGHT 270
 #define MAX_WHEAT_HEIGHT 25.0
+/** The maximum number of wheat trample stamps per draw call (must agree with stamp_vertex.vert) */
+#define WHEAT_MAX_STAMPS 64
+/** The number of segments in the unit ellipse used for wheat trample stamps */
+#define WHEAT_STAMP_SEGMENTS 32
+/** The factor the trample trail texture is downsampled by relative to the wheat texture */
+#define WHEAT_TRAIL_DOWNSAMPLE 2
+/** The trail depth deposited per second per unit of stamp height */
+#define WHEAT_TRAIL_GAIN 0.5f
+/** The trail depth recovered per second (a full depth trail lasts 1/WHEAT_TRAIL_DECAY seconds) */
+#define WHEAT_TRAIL_DECAY 0.1f
+/** The wheat height removed by a full depth trail */
+#define WHEAT_TRAIL_DEPTH 15.0f
 #define STEP_SIZE 1.0
 
 
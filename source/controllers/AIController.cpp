@@ -4,7 +4,6 @@
 
 #include "AIController.h"
 #include "../objects/BabyCarrot.h"
-#include "time.h"
 
 #define RADIUS 0.2f
 #define MOVEMENT_SPEED 0.75f
@@ -12,39 +11,49 @@
 
 using namespace cugl;
 
-bool AIController::init(std::shared_ptr<Map> &map) {
+bool AIController::init(std::shared_ptr<Map> &map, unsigned int seed) {
     _map = map;
-    srand(static_cast<unsigned int>( time(NULL) )^2);
+    _rand32.seed(seed);
     return true;
 }
 
 void AIController::updateBabyCarrotState(const std::shared_ptr<BabyCarrot> &babyCarrot) {
     if (babyCarrot->getState() == State::EVADE) {
         babyCarrot->setState(State::ROAM);
-        Vec2 newTarget = Vec2(((float) std::rand()/ RAND_MAX)*27+2.5, ((float) std::rand()/ RAND_MAX)*13+2.5);
+        float rx = randFloat();
+        float ry = randFloat();
+        Vec2 newTarget = Vec2(rx*27+2.5, ry*13+2.5);
         babyCarrot->setTarget(newTarget);
     }
     float mapWidth = _map->getBounds().size.width;
     float mapHeight = _map->getBounds().size.height;
     if (babyCarrot->getState() == State::HOLD) {
-        if (((float) std::rand()/ RAND_MAX) < 0.5) {
-            Vec2 newTarget = Vec2(babyCarrot->getX()+(((float) std::rand()/ RAND_MAX)*2-1), babyCarrot->getY()+(((float) std::rand()/ RAND_MAX)*2-1));
+        if (randFloat() < 0.5) {
+            float rx = randFloat();
+            float ry = randFloat();
+            Vec2 newTarget = Vec2(babyCarrot->getX()+(rx*2-1), babyCarrot->getY()+(ry*2-1));
             babyCarrot->setTarget(newTarget);
         } else {
             babyCarrot->setState(State::ROAM);
-            Vec2 newTarget = Vec2(((float) std::rand()/ RAND_MAX)*(mapWidth - EDGE_DIST * 2)+EDGE_DIST,
-                                  ((float) std::rand()/ RAND_MAX)*(mapHeight - EDGE_DIST * 2)+EDGE_DIST);
+            float rx = randFloat();
+            float ry = randFloat();
+            Vec2 newTarget = Vec2(rx*(mapWidth - EDGE_DIST * 2)+EDGE_DIST,
+                                  ry*(mapHeight - EDGE_DIST * 2)+EDGE_DIST);
             babyCarrot->setTarget(newTarget);
         }
     } else {
-        if (((float) std::rand()/ RAND_MAX) < 0.3 && babyCarrot->isInWheat()) {
+        if (randFloat() < 0.3 && babyCarrot->isInWheat()) {
             babyCarrot->setState(State::HOLD);
-            Vec2 newTarget = Vec2(babyCarrot->getX()+(((float) std::rand()/ RAND_MAX)*2-1), babyCarrot->getY()+(((float) std::rand()/ RAND_MAX)*2-1));
+            float rx = randFloat();
+            float ry = randFloat();
+            Vec2 newTarget = Vec2(babyCarrot->getX()+(rx*2-1), babyCarrot->getY()+(ry*2-1));
             babyCarrot->setTarget(newTarget);
         } else {
             babyCarrot->setState(State::ROAM);
-            Vec2 newTarget = Vec2(((float) std::rand()/ RAND_MAX)*(mapWidth - EDGE_DIST * 2)+EDGE_DIST,
-                                  ((float) std::rand()/ RAND_MAX)*(mapHeight - EDGE_DIST * 2)+EDGE_DIST);
+            float rx = randFloat();
+            float ry = randFloat();
+            Vec2 newTarget = Vec2(rx*(mapWidth - EDGE_DIST * 2)+EDGE_DIST,
+                                  ry*(mapHeight - EDGE_DIST * 2)+EDGE_DIST);
             babyCarrot->setTarget(newTarget);
         }
     }
@@ -13,13 +13,18 @@ class AIController {
     
 protected:
     std::shared_ptr<Map> _map;
+    /** Seeded generator so every peer makes the same AI decisions in lockstep */
+    std::mt19937 _rand32;
+    
+    /** Returns a uniformly random float in [0,1] */
+    float randFloat() { return float(_rand32()) / _rand32.max(); }
     
 public:
     AIController() {};
 
     ~AIController() {};
     
-    bool init(std::shared_ptr<Map> &map);
+    bool init(std::shared_ptr<Map> &map, unsigned int seed);
     
     void updateBabyCarrot(const std::shared_ptr<BabyCarrot> &baby);
     
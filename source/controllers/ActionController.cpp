@@ -28,14 +28,15 @@ using namespace cugl;
  * Initializes an ActionController
  */
 bool ActionController::init(std::shared_ptr<Map> &map, std::shared_ptr<InputController> &input,
-    std::shared_ptr<NetworkController> &network, const std::shared_ptr<cugl::AssetManager> &assets) {
+    std::shared_ptr<NetworkController> &network, const std::shared_ptr<cugl::AssetManager> &assets,
+    unsigned int seed) {
     _map = map;
     _input = input;
     _world = _map->getWorld();
     _network = network;
     _assets = assets;
-    if (_network->isHost()) {
-        _ai.init(map);
+    if (_network->isHost() || _network->isLockstep()) {
+        _ai.init(map, seed);
     }
     _network->attachEventType<CaptureEvent>();
     _network->attachEventType<RootEvent>();
@@ -54,13 +55,19 @@ bool ActionController::init(std::shared_ptr<Map> &map, std::shared_ptr<InputCont
  */
 void ActionController::preUpdate(float dt) {
     auto playerEntity = _map->getCharacter();
-    playerEntity->setMovement(_input->getMovement());
     bool didDash = _input->didDash();
-    playerEntity->setDashInput(didDash);
     if(didDash){
         std::shared_ptr<Sound> source = _assets->get<Sound>(DASH_EFFECT);
         AudioEngine::get()->play("dash", source);
     }
+    if (_network->isLockstep()) {
+        // Input is applied by applyInputs once every peer has it
+        _map->updateAnimations(dt);
+        updateRustlingNoise();
+        return;
+    }
+    playerEntity->setMovement(_input->getMovement());
+    playerEntity->setDashInput(didDash);
     playerEntity->setRootInput(_input->didRoot());
     playerEntity->setUnrootInput(_input->didUnroot());
     EntityModel::EntityState oldState = playerEntity->getEntityState();
@@ -69,7 +76,7 @@ void ActionController::preUpdate(float dt) {
         _network->pushOutEvent(MoveEvent::allocMoveEvent(playerEntity->getUUID(), playerEntity->getEntityState()));
     }
     playerEntity->applyForce();
-    playerEntity->stepAnimation(dt);
+    _map->updateAnimations(dt);
     updateRustlingNoise();
     
     // Find current character's planting spot
@@ -82,22 +89,13 @@ void ActionController::preUpdate(float dt) {
         }
     }
     
-    if (_network->isHost()) { // Farmer (host) specific actions
-        auto farmerEntity = std::dynamic_pointer_cast<Farmer>(playerEntity);
-        
-        // Step baby carrot AI
-        for (auto babyCarrot : _map->getBabyCarrots()) {
-            // I'm slightly worried that this could get expensive but when I think about it
-            // it's really no different than just checking for collisions so idk
-            for (auto farmer : _map->getFarmers()) {
-                if (farmer->getPosition().distance(babyCarrot->getPosition()) <= EVADE_DIST) {
-                    babyCarrot->setState(State::EVADE);
-                    babyCarrot->setTarget(babyCarrot->getPosition().add(farmer->getPosition().subtract(babyCarrot->getPosition()).normalize().scale(-3)).clamp(Vec2(1, 1), Vec2(13, 13)));
-                }
-            }
-            _ai.updateBabyCarrot(babyCarrot);
-        }
-        
+    if (_network->isHost()) { // The host runs the baby carrot AI
+        stepBabyCarrots();
+    }
+    
+    // The host is the farmer, unless a carrot took over by host migration
+    auto farmerEntity = std::dynamic_pointer_cast<Farmer>(playerEntity);
+    if (farmerEntity) { // Farmer specific actions
         if(_input->didRoot() && _map->getFarmers().at(0)->canPlant() && plantingSpot != nullptr && !plantingSpot->getCarrotPlanted() && _map->getFarmers().at(0)->isHoldingCarrot()){
             //        std::cout<<"farmer did the rooting\n";
             Haptics::get()->playContinuous(1.0, 0.3, 0.2);
@@ -129,15 +127,126 @@ void ActionController::preUpdate(float dt) {
         }
     }
     
-    if(!_network->isHost()){
-        auto carrotEntity = std::dynamic_pointer_cast<Carrot>(_map->getCharacter());
-        if(_input->didShakeDevice() && rand() % 20 < 1 && carrotEntity->isCaptured()){
-            _network->pushOutEvent(FreeEvent::allocFreeEvent(carrotEntity->getUUID()));
+    if(didEscape()){
+        _network->pushOutEvent(FreeEvent::allocFreeEvent(_map->getCharacter()->getUUID()));
 //            Haptics::get()->playContinuous(1.0, 0.3, 0.1);
+    }
+}
+
+/**
+ * Returns true if the local carrot shook itself free this frame.
+ *
+ * The outcome is random, so in lockstep it is decided locally and sent as input.
+ */
+bool ActionController::didEscape() {
+    auto carrotEntity = std::dynamic_pointer_cast<Carrot>(_map->getCharacter());
+    if(carrotEntity == nullptr){
+        return false;
+    }
+    return _input->didShakeDevice() && rand() % 20 < 1 && carrotEntity->isCaptured();
+}
+
+/**
+ * Starts the host-only logic (the baby carrot AI) after a host migration.
+ */
+void ActionController::takeAuthority(unsigned int seed) {
+    _ai.init(_map, seed);
+}
+
+/**
+ * Steps the baby carrot AI, making babies evade nearby farmers
+ */
+void ActionController::stepBabyCarrots() {
+    for (auto babyCarrot : _map->getBabyCarrots()) {
+        // I'm slightly worried that this could get expensive but when I think about it
+        // it's really no different than just checking for collisions so idk
+        for (auto farmer : _map->getFarmers()) {
+            if (farmer->getPosition().distance(babyCarrot->getPosition()) <= EVADE_DIST) {
+                babyCarrot->setState(State::EVADE);
+                babyCarrot->setTarget(babyCarrot->getPosition().add(farmer->getPosition().subtract(babyCarrot->getPosition()).normalize().scale(-3)).clamp(Vec2(1, 1), Vec2(13, 13)));
+            }
         }
+        _ai.updateBabyCarrot(babyCarrot);
     }
 }
 
+/**
+ * Returns the farmer or carrot controlled by the given player, or nullptr
+ */
+std::shared_ptr<EntityModel> ActionController::getPlayerEntity(const std::string& uuid) {
+    for (auto farmer : _map->getFarmers()) {
+        if (farmer->getUUID() == uuid) {
+            return farmer;
+        }
+    }
+    for (auto carrot : _map->getCarrots()) {
+        if (carrot->getUUID() == uuid) {
+            return carrot;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Applies the inputs of all players for one lockstep tick.
+ *
+ * Every peer calls this with the same inputs in the same order, and so
+ * derives the same movement, AI and game events. Game events are queued
+ * locally with {@link NetworkController#pushGameEvent}.
+ *
+ * @param inputs    The inputs of every player, sorted by uuid
+ */
+void ActionController::applyInputs(const std::vector<std::shared_ptr<InputEvent>>& inputs) {
+    for (auto input : inputs) {
+        auto entity = getPlayerEntity(input->getUUID());
+        if (entity == nullptr) {
+            continue;
+        }
+        Uint32 flags = input->getFlags();
+        entity->setMovement(input->getMovement());
+        entity->setDashInput(flags & InputEvent::DASH);
+        entity->setRootInput(flags & InputEvent::ROOT);
+        entity->setUnrootInput(flags & InputEvent::UNROOT);
+        entity->updateState();
+        entity->applyForce();
+        
+        // Contacts only track the local character, so find the spot geometrically
+        std::shared_ptr<PlantingSpot> plantingSpot = _map->getPlantingSpotAt(entity->getPosition());
+        if (auto farmer = std::dynamic_pointer_cast<Farmer>(entity)) {
+            if ((flags & InputEvent::ROOT) && plantingSpot != nullptr && !plantingSpot->getCarrotPlanted() && farmer->isHoldingCarrot()) {
+                if (farmer == _map->getCharacter()) {
+                    Haptics::get()->playContinuous(1.0, 0.3, 0.2);
+                    std::shared_ptr<Sound> source = _assets->get<Sound>(ROOTING_BUNNY_EFFECT);
+                    AudioEngine::get()->play("root-bunny", source);
+                }
+                for (auto carrot : _map->getCarrots()) {
+                    if (carrot->isCaptured()) {
+                        _network->pushGameEvent(RootEvent::allocRootEvent(carrot->getUUID(), plantingSpot->getPlantingID()));
+                    }
+                }
+            }
+        } else if (auto carrotEntity = std::dynamic_pointer_cast<Carrot>(entity)) {
+            if ((flags & InputEvent::UNROOT) && plantingSpot != nullptr && plantingSpot->getCarrotPlanted()) {
+                auto currPos = carrotEntity->getPosition();
+                std::shared_ptr<Carrot> closestCarrot = nullptr;
+                for (auto carrot : _map->getCarrots()){
+                    if(carrot->getUUID() != carrotEntity->getUUID() && (closestCarrot == nullptr || currPos.distance(carrot->getPosition()) < currPos.distance(closestCarrot->getPosition()))){
+                        closestCarrot = carrot;
+                    }
+                }
+                if(closestCarrot != nullptr && currPos.distance(closestCarrot->getPosition()) < 1.0){
+                    _network->pushGameEvent(UnrootEvent::allocUnrootEvent(closestCarrot->getUUID(), plantingSpot->getPlantingID()));
+                }
+            }
+            if ((flags & InputEvent::ESCAPE) && carrotEntity->isCaptured()) {
+                _network->pushGameEvent(FreeEvent::allocFreeEvent(carrotEntity->getUUID()));
+            }
+        }
+    }
+    stepBabyCarrots();
+    updateCarriedCarrots();
+}
+
 /**
  * The method called to indicate the end of a deterministic loop.
  *
@@ -156,11 +265,21 @@ void ActionController::postUpdate(float dt) {
         if ((*it)->isRemoved()) {
             (*it)->getSceneNode()->dispose();
             (*it)->getDebugNode()->dispose();
-            (*it)->getWheatHeightNode()->dispose();
+            (*it)->setWheatStamp(nullptr);
             _map->getBabyCarrots().erase(it);
         }
         else ++it;
     }
+    if (!_network->isLockstep()) {
+        // In lockstep this is part of the simulated tick
+        updateCarriedCarrots();
+    }
+}
+
+/**
+ * Moves captured carrots along with the farmer carrying them.
+ */
+void ActionController::updateCarriedCarrots() {
     for(std::shared_ptr<Carrot> c : _map->getCarrots()){
         if(c->isCaptured()){
             c->setSensor(true);
@@ -371,7 +490,7 @@ void ActionController::processMoveEvent(const std::shared_ptr<MoveEvent>& event)
 
 void ActionController::processFreeEvent(const std::shared_ptr<FreeEvent>& event){
     _map->getFarmers().at(0)->carrotEscaped();
-    if(_network->isHost()){
+    if(_map->getCharacter() == _map->getFarmers().at(0)){
         Haptics::get()->playContinuous(1.0, 0.8, 0.3);
     }
     else if(_map->getCharacter()->getUUID() == event->getUUID()){
@@ -17,6 +17,7 @@
 #include "../events/MoveEvent.h"
 #include "../events/CaptureBarrotEvent.h"
 #include "../events/FreeEvent.h"
+#include "../events/InputEvent.h"
 
 class ActionController {
 private:
@@ -42,6 +43,16 @@ private:
      * Updates rustling sound effect based on the movement of the entities around one's own character
      */
     void updateRustlingNoise();
+    
+    /**
+     * Steps the baby carrot AI, making babies evade nearby farmers
+     */
+    void stepBabyCarrots();
+    
+    /**
+     * Returns the farmer or carrot controlled by the given player, or nullptr
+     */
+    std::shared_ptr<EntityModel> getPlayerEntity(const std::string& uuid);
 
 
 public:
@@ -59,7 +70,8 @@ public:
      * Initializes an ActionController
      */
     bool init(std::shared_ptr<Map> &map, std::shared_ptr<InputController> &input,
-              std::shared_ptr<NetworkController> &network, const std::shared_ptr<cugl::AssetManager> &assets);
+              std::shared_ptr<NetworkController> &network, const std::shared_ptr<cugl::AssetManager> &assets,
+              unsigned int seed);
 
     /**
      * The method called to indicate the start of a deterministic loop.
@@ -71,6 +83,34 @@ public:
     void preUpdate(float dt);
     
     void fixedUpdate();
+    
+    /**
+     * Applies the inputs of all players for one lockstep tick.
+     *
+     * Every peer calls this with the same inputs in the same order, and so
+     * derives the same movement, AI and game events. Game events are queued
+     * locally with {@link NetworkController#pushGameEvent}.
+     *
+     * @param inputs    The inputs of every player, sorted by uuid
+     */
+    void applyInputs(const std::vector<std::shared_ptr<InputEvent>>& inputs);
+    
+    /**
+     * Returns true if the local carrot shook itself free this frame.
+     *
+     * The outcome is random, so in lockstep it is decided locally and sent as input.
+     */
+    bool didEscape();
+    
+    /**
+     * Moves captured carrots along with the farmer carrying them.
+     */
+    void updateCarriedCarrots();
+    
+    /**
+     * Starts the host-only logic (the baby carrot AI) after a host migration.
+     */
+    void takeAuthority(unsigned int seed);
 
     /**
      * The method called to indicate the end of a deterministic loop.
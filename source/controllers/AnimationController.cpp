@@ -0,0 +1,61 @@
+//
+//  AnimationController.cpp
+//  Rooted
+//
+//  Steps the sprite animation of every entity in one pass. Each entity has a compact track
+//  holding its animation clock, and every step the controller resolves the entity's sheet,
+//  flip and frame and hands them to the entity's single EntitySpriteNode.
+//
+
+#include "AnimationController.h"
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Animation Handling
+
+/**
+ * Adds an entity to be animated. The entity must already have its scene node.
+ *
+ * @param entity    The entity to animate
+ */
+void AnimationController::add(const std::shared_ptr<EntityModel> &entity) {
+    CUAssertLog(entity->getSceneNode() != nullptr, "Animated entities need a scene node");
+    _tracks.push_back({entity, entity->getSceneNode().get(), 0});
+}
+
+/**
+ * Steps the animation of every entity by the given time. Entities that have been
+ * removed from the world are dropped.
+ *
+ * @param dt    The time since the last step
+ */
+void AnimationController::update(float dt) {
+    size_t i = 0;
+    while (i < _tracks.size()) {
+        Track &track = _tracks[i];
+        EntityModel* entity = track.entity.get();
+        if (entity->isRemoved()) {
+            // Order does not matter, so swap with the back
+            track = std::move(_tracks.back());
+            _tracks.pop_back();
+            continue;
+        }
+
+        EntitySpriteNode* node = track.node;
+        node->setSheet(entity->getSpriteSheet(), entity->isSpriteFlipped());
+        if (entity->animationShouldStep()) {
+            float duration = entity->getAnimDuration();
+            track.time += dt;
+            if (track.time > duration) {
+                track.time = 0;
+            }
+            // LOOPING style animation
+            node->setFrame(std::min((int)(node->getSpan() * track.time / duration), node->getSpan() - 1));
+        } else {
+            track.time = 0;
+            node->setFrame(0);
+        }
+        i++;
+    }
+}
@@ -0,0 +1,74 @@
+//
+//  AnimationController.h
+//  Rooted
+//
+//  Steps the sprite animation of every entity in one pass. Each entity has a compact track
+//  holding its animation clock, and every step the controller resolves the entity's sheet,
+//  flip and frame and hands them to the entity's single EntitySpriteNode.
+//
+
+#ifndef AnimationController_h
+#define AnimationController_h
+
+#include <cugl/cugl.h>
+#include "../objects/EntityModel.h"
+
+using namespace cugl;
+
+/**
+ * A controller for the sprite animation of all entities.
+ */
+class AnimationController {
+protected:
+    /** The animation state of one entity */
+    struct Track {
+        /** The entity being animated */
+        std::shared_ptr<EntityModel> entity;
+        /** The sprite node of the entity (owned by the entity) */
+        EntitySpriteNode* node;
+        /** The time elapsed in the current animation cycle */
+        float time;
+    };
+
+    /** The tracks of all animated entities */
+    std::vector<Track> _tracks;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+
+    /**
+     * Creates a new animation controller with no entities.
+     */
+    AnimationController() {};
+
+    /**
+     * Destroys the AnimationController, releasing all resources.
+     */
+    virtual ~AnimationController(void) { clear(); };
+
+#pragma mark -
+#pragma mark Animation Handling
+
+    /**
+     * Adds an entity to be animated. The entity must already have its scene node.
+     *
+     * @param entity    The entity to animate
+     */
+    void add(const std::shared_ptr<EntityModel> &entity);
+
+    /**
+     * Removes all entities from this controller.
+     */
+    void clear() { _tracks.clear(); }
+
+    /**
+     * Steps the animation of every entity by the given time. Entities that have been
+     * removed from the world are dropped.
+     *
+     * @param dt    The time since the last step
+     */
+    void update(float dt);
+};
+
+#endif /* AnimationController_h */
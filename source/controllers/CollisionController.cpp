@@ -52,8 +52,10 @@ void CollisionController::beginContact(b2Contact* contact) {
             }
             if (name2 == "baby") {
                 BabyCarrot* b2babycarrot = dynamic_cast<BabyCarrot*>(bd2);
-                if(_map->getCharacter()->getUUID() == carrot->getUUID() && !(carrot->isCaptured() || carrot->isRooted())){
-                    _network->pushOutEvent(CaptureBarrotEvent::allocCaptureBarrotEvent(carrot->getUUID(), b2babycarrot->getID()));
+                // In lockstep every peer sees the same contact, so no one needs to be told
+                bool isOwner = _network->isLockstep() || _map->getCharacter()->getUUID() == carrot->getUUID();
+                if(isOwner && !(carrot->isCaptured() || carrot->isRooted())){
+                    _network->pushGameEvent(CaptureBarrotEvent::allocCaptureBarrotEvent(carrot->getUUID(), b2babycarrot->getID()));
                 }
             }
             if(name2 == "planting spot" && _map->getCharacter()->getUUID() == carrot->getUUID()) {
@@ -79,7 +81,7 @@ void CollisionController::beginContact(b2Contact* contact) {
             if(name2 == "carrot") {
                 Carrot* carrot = dynamic_cast<Carrot*>(bd2);
                 if(farmer->isDashing() && !carrot->isCaptured() && !carrot->isRooted()){
-                    _network->pushOutEvent(CaptureEvent::allocCaptureEvent(carrot->getUUID()));
+                    _network->pushGameEvent(CaptureEvent::allocCaptureEvent(carrot->getUUID()));
                 }
             }
             if(name2 == "planting spot" && _map->getCharacter()->getUUID() == farmer->getUUID()) {
@@ -0,0 +1,132 @@
+//
+//  LockstepController.cpp
+//  Rooted
+//
+
+#include "LockstepController.h"
+
+using namespace cugl;
+
+/**
+ * Disposes of all resources in this instance of LockstepController
+ */
+void LockstepController::dispose() {
+    _network = nullptr;
+    _players.clear();
+    _inputs.clear();
+    _future.clear();
+}
+
+/**
+ * Initializes the controller for the given round.
+ *
+ * @param network   The network controller
+ * @param round     The round (map seed) to simulate
+ * @param delay     The number of ticks local input is delayed by
+ */
+bool LockstepController::init(const std::shared_ptr<NetworkController>& network, Sint32 round, Uint64 delay) {
+    _network = network;
+    _delay = delay;
+    _future.clear();
+    reset(round);
+    return true;
+}
+
+/**
+ * Restarts the tick count for a new round.
+ *
+ * Inputs that already arrived for the new round are kept.
+ */
+void LockstepController::reset(Sint32 round) {
+    _round = round;
+    _tick = 0;
+    _sentTick = _delay;
+    _uuid = _network->getNetcode()->getUUID();
+    _players = _network->getOrderedPlayers();
+    _inputs.clear();
+    _pendingMove = Vec2::ZERO;
+    _pendingFlags = 0;
+    
+    // Nobody can have input for the first ticks, so seed them as empty
+    for (Uint64 tick = 0; tick < _delay; tick++) {
+        for (auto& uuid : _players) {
+            _inputs[tick][uuid] = std::dynamic_pointer_cast<InputEvent>(
+                InputEvent::allocInputEvent(uuid, _round, tick, Vec2::ZERO, 0));
+        }
+    }
+    
+    std::vector<std::shared_ptr<InputEvent>> future;
+    future.swap(_future);
+    for (auto& input : future) {
+        processInputEvent(input);
+    }
+}
+
+/**
+ * Accumulates local input until it is sent.
+ *
+ * Buttons are or-ed together so that a press between two ticks is not lost.
+ */
+void LockstepController::addLocalInput(Vec2 movement, Uint32 flags) {
+    _pendingMove = movement;
+    _pendingFlags |= flags;
+}
+
+/** Handles an input received from the network */
+void LockstepController::processInputEvent(const std::shared_ptr<InputEvent>& event) {
+    if (event->getRound() > _round) {
+        _future.push_back(event);
+        return;
+    } else if (event->getRound() < _round || event->getUUID() == _uuid) {
+        // Our own broadcasts come back to us, but were added when sent
+        return;
+    }
+    addInput(event);
+}
+
+/** Adds an input for the current round */
+void LockstepController::addInput(const std::shared_ptr<InputEvent>& input) {
+    if (input->getTick() >= _tick) {
+        _inputs[input->getTick()][input->getUUID()] = input;
+    }
+}
+
+/**
+ * Advances the lockstep by one tick if possible.
+ *
+ * This sends the pending local input for a future tick, and then checks if
+ * the inputs of all players for the current tick are known. If so, these
+ * inputs are stored in sorted player order and the method returns true.
+ * Otherwise the simulation must stall this tick.
+ *
+ * @param inputs    The inputs to apply this tick
+ *
+ * @return true if the tick can be simulated
+ */
+bool LockstepController::step(std::vector<std::shared_ptr<InputEvent>>& inputs) {
+    // Only run ahead of the simulation by the input delay
+    if (_sentTick <= _tick + _delay) {
+        auto e = InputEvent::allocInputEvent(_uuid, _round, _sentTick, InputEvent::quantize(_pendingMove),
+                                             _pendingFlags);
+        addInput(std::dynamic_pointer_cast<InputEvent>(e));
+        _network->pushOutEvent(e);
+        _pendingFlags = 0;
+        _sentTick++;
+    }
+    
+    auto it = _inputs.find(_tick);
+    if (it == _inputs.end() || it->second.size() < _players.size()) {
+        return false;
+    }
+    inputs.clear();
+    for (auto& uuid : _players) {
+        auto jt = it->second.find(uuid);
+        if (jt == it->second.end()) {
+            return false;
+        }
+        inputs.push_back(jt->second);
+    }
+    _inputs.erase(it);
+    _tick++;
+    return true;
+}
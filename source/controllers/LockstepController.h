@@ -0,0 +1,103 @@
+//
+//  LockstepController.h
+//  Rooted
+//
+//  Deterministic lockstep for the game world. Instead of syncing obstacle
+//  state, peers exchange only their inputs. A tick is simulated once the
+//  inputs of every player for that tick have arrived, so all peers step
+//  the same world with the same inputs in the same order.
+//
+
+#ifndef ROOTED_LOCKSTEPCONTROLLER_H
+#define ROOTED_LOCKSTEPCONTROLLER_H
+
+#include <cugl/cugl.h>
+#include <map>
+#include "NetworkController.h"
+#include "../events/InputEvent.h"
+
+class LockstepController {
+protected:
+    /** The network controller */
+    std::shared_ptr<NetworkController> _network;
+    /** The uuid of this player */
+    std::string _uuid;
+    /** All players, sorted so that every peer applies inputs in the same order */
+    std::vector<std::string> _players;
+    /** The round (map seed) currently simulated */
+    Sint32 _round;
+    /** The next tick to simulate */
+    Uint64 _tick;
+    /** The number of ticks local input is delayed by to hide latency */
+    Uint64 _delay;
+    /** The latest tick local input has been sent for */
+    Uint64 _sentTick;
+    
+    /** Received inputs by tick and then by player uuid */
+    std::map<Uint64, std::map<std::string, std::shared_ptr<InputEvent>>> _inputs;
+    /** Inputs received early for a later round */
+    std::vector<std::shared_ptr<InputEvent>> _future;
+    
+    /** Local movement accumulated since the last input was sent */
+    Vec2 _pendingMove;
+    /** Local buttons accumulated since the last input was sent */
+    Uint32 _pendingFlags;
+    
+    /** Adds an input for the current round */
+    void addInput(const std::shared_ptr<InputEvent>& input);
+    
+public:
+    LockstepController() : _round(0), _tick(0), _delay(0), _sentTick(0), _pendingFlags(0) {}
+    
+    ~LockstepController() { dispose(); }
+    
+    /**
+     * Disposes of all resources in this instance of LockstepController
+     */
+    void dispose();
+    
+    /**
+     * Initializes the controller for the given round.
+     *
+     * @param network   The network controller
+     * @param round     The round (map seed) to simulate
+     * @param delay     The number of ticks local input is delayed by
+     */
+    bool init(const std::shared_ptr<NetworkController>& network, Sint32 round, Uint64 delay);
+    
+    /**
+     * Restarts the tick count for a new round.
+     *
+     * Inputs that already arrived for the new round are kept.
+     */
+    void reset(Sint32 round);
+    
+    /**
+     * Accumulates local input until it is sent.
+     *
+     * Buttons are or-ed together so that a press between two ticks is not lost.
+     */
+    void addLocalInput(Vec2 movement, Uint32 flags);
+    
+    /** Handles an input received from the network */
+    void processInputEvent(const std::shared_ptr<InputEvent>& event);
+    
+    /**
+     * Advances the lockstep by one tick if possible.
+     *
+     * This sends the pending local input for a future tick, and then checks if
+     * the inputs of all players for the current tick are known. If so, these
+     * inputs are stored in sorted player order and the method returns true.
+     * Otherwise the simulation must stall this tick.
+     *
+     * @param inputs    The inputs to apply this tick
+     *
+     * @return true if the tick can be simulated
+     */
+    bool step(std::vector<std::shared_ptr<InputEvent>>& inputs);
+    
+    /** Returns the next tick to simulate */
+    Uint64 getTick() const { return _tick; }
+};
+
+#endif //ROOTED_LOCKSTEPCONTROLLER_H
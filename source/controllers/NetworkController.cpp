@@ -12,6 +12,7 @@ using namespace cugl;
 
 
 void NetworkController::dispose()  {
+    _localEvents = std::queue<std::shared_ptr<NetEvent>>();
     NetEventController::dispose();
 }
 
@@ -29,3 +30,17 @@ std::vector<std::string> NetworkController::getOrderedPlayers() {
     std::sort(playerVec.begin(), playerVec.end());
     return playerVec;
 }
+
+void NetworkController::pushGameEvent(const std::shared_ptr<NetEvent>& e) {
+    if (_lockstep) {
+        _localEvents.push(e);
+    } else {
+        pushOutEvent(e);
+    }
+}
+
+std::shared_ptr<NetEvent> NetworkController::popLocalEvent() {
+    auto e = _localEvents.front();
+    _localEvents.pop();
+    return e;
+}
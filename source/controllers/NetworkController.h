@@ -14,8 +14,14 @@ using namespace cugl::physics2::net;
 using namespace cugl;
 
 class NetworkController : public NetEventController {
+protected:
+    /** Whether the game runs in deterministic lockstep (inputs only) */
+    bool _lockstep;
+    /** Game events produced locally while in lockstep */
+    std::queue<std::shared_ptr<NetEvent>> _localEvents;
+    
 public:
-    NetworkController() {} ;
+    NetworkController() : _lockstep(false) {} ;
     ~NetworkController() { dispose(); }
     void dispose();
 
@@ -29,6 +35,26 @@ public:
     std::shared_ptr<cugl::net::NetcodeConnection> getNetcode();
     
     std::vector<std::string> getOrderedPlayers();
+    
+    /** Returns whether the game runs in deterministic lockstep */
+    bool isLockstep() const { return _lockstep; }
+    
+    /** Sets whether the game runs in deterministic lockstep */
+    void setLockstep(bool value) { _lockstep = value; }
+    
+    /**
+     * Queues a game event (capture, root, ...) for processing.
+     *
+     * Normally the event is broadcast to all peers. In lockstep every peer derives
+     * the same events from the same inputs, so the event stays local instead.
+     */
+    void pushGameEvent(const std::shared_ptr<NetEvent>& e);
+    
+    /** Returns true if there are locally produced game events left */
+    bool isLocalAvailable() const { return !_localEvents.empty(); }
+    
+    /** Pops the next locally produced game event */
+    std::shared_ptr<NetEvent> popLocalEvent();
 };
 
 #endif /* NetworkController_h */
@@ -0,0 +1,307 @@
+//
+//  ProfilerController.cpp
+//  Rooted
+//
+//  A lightweight frame profiler. Scoped CPU timers (PROFILE_SCOPE) and GPU timer queries
+//  (PROFILE_GPU_SCOPE) record samples into the current frame, and the last PROFILER_HISTORY
+//  frames are kept in a ring buffer. The history can be summarized for the debug overlay or
+//  exported as Chrome trace JSON (open it in chrome://tracing or Perfetto).
+//
+//  GPU timing uses GL_TIME_ELAPSED, which is only available on desktop OpenGL. Only one GPU
+//  scope can be active at a time, so GPU scopes must not nest. Results are read back a few
+//  frames later and attached to the frame that issued them.
+//
+
+#include "ProfilerController.h"
+#include "../RootedConstants.h"
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+using namespace cugl;
+
+#if CU_GL_PLATFORM == CU_GL_OPENGL
+    #define PROFILER_GPU 1
+#else
+    #define PROFILER_GPU 0
+#endif
+
+#pragma mark -
+#pragma mark Constructors
+
+ProfilerController::ProfilerController() :
+        _enabled(PROFILER_ENABLED),
+        _frameCount(0),
+        _inFrame(false),
+        _depth(0),
+        _activeQuery(-1),
+        _arenaStart(0),
+        _heapStart() {
+    _frames.resize(PROFILER_HISTORY);
+}
+
+ProfilerController::~ProfilerController() {
+#if PROFILER_GPU
+    for (auto &query : _queries) {
+        glDeleteQueries(1, &query.query);
+    }
+#endif
+}
+
+/**
+ * Returns the profiler singleton
+ */
+ProfilerController* ProfilerController::get() {
+    static ProfilerController profiler;
+    return &profiler;
+}
+
+/** Returns the time in microseconds since the profiler started */
+Uint64 ProfilerController::now() const {
+    return Timestamp::ellapsedMicros(_epoch, Timestamp());
+}
+
+/** Returns the frame with the given id, or nullptr if it left the ring buffer */
+ProfilerController::Frame* ProfilerController::getFrame(Uint64 id) {
+    Frame &frame = _frames[id % _frames.size()];
+    return (_frameCount > 0 && frame.id == id && id < _frameCount) ? &frame : nullptr;
+}
+
+#pragma mark -
+#pragma mark Frames
+
+/**
+ * Starts a new frame, recycling the oldest frame in the ring buffer
+ */
+void ProfilerController::beginFrame() {
+    if (!_enabled) {
+        return;
+    }
+    resolveQueries();
+    _frameCount++;
+    Frame &frame = current();
+    frame.id = _frameCount - 1;
+    frame.start = now();
+    frame.cpu = 0;
+    frame.gpu = 0;
+    frame.arena = 0;
+    frame.heapAllocs = 0;
+    frame.heapBytes = 0;
+    frame.samples.clear(); // keeps capacity, so steady state does not allocate
+    _arenaStart = FrameArena::get()->getTotalAllocations();
+    _heapStart = AllocTracker::getTotals();
+    _inFrame = true;
+    _depth = 0;
+}
+
+/**
+ * Ends the current frame
+ */
+void ProfilerController::endFrame() {
+    if (!_inFrame) {
+        return;
+    }
+    Frame &frame = current();
+    frame.cpu = (Uint32)(now() - frame.start);
+    frame.arena = (Uint32)(FrameArena::get()->getTotalAllocations() - _arenaStart);
+    AllocTracker::Stats heap = AllocTracker::getTotals();
+    frame.heapAllocs = (Uint32)(heap.allocations - _heapStart.allocations);
+    frame.heapBytes = (Uint32)(heap.bytes - _heapStart.bytes);
+    _inFrame = false;
+}
+
+#pragma mark -
+#pragma mark Sections
+
+/**
+ * Starts a CPU section, returning its index in the current frame (or -1)
+ */
+int ProfilerController::beginSection(const char* name) {
+    if (!_inFrame) {
+        return -1;
+    }
+    Frame &frame = current();
+    frame.samples.push_back({name, now(), 0, _depth++, false});
+    return (int)frame.samples.size() - 1;
+}
+
+/**
+ * Ends the CPU section with the given index
+ */
+void ProfilerController::endSection(int index) {
+    if (!_inFrame) {
+        return;
+    }
+    Sample &sample = current().samples[index];
+    sample.duration = (Uint32)(now() - sample.start);
+    _depth--;
+}
+
+/**
+ * Starts a GPU timer query, returning its index (or -1 if one is already active
+ * or GPU timing is unavailable)
+ */
+int ProfilerController::beginQuery(const char* name) {
+#if PROFILER_GPU
+    if (!_inFrame || _activeQuery >= 0) {
+        return -1;
+    }
+    int index = -1;
+    for (size_t i = 0; i < _queries.size() && index < 0; i++) {
+        if (!_queries[i].pending) {
+            index = (int)i;
+        }
+    }
+    if (index < 0) {
+        if (_queries.size() >= PROFILER_QUERIES) {
+            return -1;
+        }
+        Query query = {0, nullptr, 0, 0, false};
+        glGenQueries(1, &query.query);
+        _queries.push_back(query);
+        index = (int)_queries.size() - 1;
+    }
+
+    Query &query = _queries[index];
+    query.name = name;
+    query.start = now();
+    query.frame = _frameCount - 1;
+    query.pending = true;
+    glBeginQuery(GL_TIME_ELAPSED, query.query);
+    _activeQuery = index;
+    return index;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Ends the GPU timer query with the given index
+ */
+void ProfilerController::endQuery(int index) {
+#if PROFILER_GPU
+    if (index == _activeQuery) {
+        glEndQuery(GL_TIME_ELAPSED);
+        _activeQuery = -1;
+    }
+#endif
+}
+
+/** Reads back the GPU queries that have completed */
+void ProfilerController::resolveQueries() {
+#if PROFILER_GPU
+    for (auto &query : _queries) {
+        if (!query.pending) {
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(query.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query.query, GL_QUERY_RESULT, &elapsed);
+        query.pending = false;
+
+        Frame* frame = getFrame(query.frame);
+        if (frame != nullptr) {
+            Uint32 micros = (Uint32)(elapsed / 1000);
+            frame->samples.push_back({query.name, query.start, micros, 0, true});
+            frame->gpu += micros;
+        }
+    }
+#endif
+}
+
+#pragma mark -
+#pragma mark Reporting
+
+/**
+ * Returns a text summary of the recorded frames, with the average and maximum
+ * time of each section, for the debug overlay
+ */
+std::string ProfilerController::getSummary() const {
+    struct Stat {
+        Uint64 total = 0;
+        Uint32 max = 0;
+    };
+    // Only complete frames; the ring holds at most _frames.size() of them
+    Uint64 count = std::min<Uint64>(_frameCount > 0 ? _frameCount - 1 : 0, _frames.size());
+    if (count == 0) {
+        return "";
+    }
+
+    Stat cpu, gpu, arena, heapAllocs, heapBytes;
+    std::map<std::string, Stat> sections;
+    for (Uint64 id = _frameCount - 1 - count; id < _frameCount - 1; id++) {
+        const Frame &frame = _frames[id % _frames.size()];
+        cpu.total += frame.cpu;
+        cpu.max = std::max(cpu.max, frame.cpu);
+        gpu.total += frame.gpu;
+        gpu.max = std::max(gpu.max, frame.gpu);
+        arena.total += frame.arena;
+        arena.max = std::max(arena.max, frame.arena);
+        heapAllocs.total += frame.heapAllocs;
+        heapAllocs.max = std::max(heapAllocs.max, frame.heapAllocs);
+        heapBytes.total += frame.heapBytes;
+        heapBytes.max = std::max(heapBytes.max, frame.heapBytes);
+        for (const Sample &sample : frame.samples) {
+            Stat &stat = sections[std::string(sample.gpu ? "[gpu] " : "") + sample.name];
+            stat.total += sample.duration;
+            stat.max = std::max(stat.max, sample.duration);
+        }
+    }
+
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    ss << "frame " << cpu.total / 1000.0 / count << " ms (max " << cpu.max / 1000.0 << ")";
+    ss << "  gpu " << gpu.total / 1000.0 / count << " ms (max " << gpu.max / 1000.0 << ")\n";
+    const FrameArena* frameArena = FrameArena::get();
+    ss << "arena " << (double)arena.total / count << " allocs (max " << arena.max << ")  peak "
+       << frameArena->getPeakUsage() / 1024.0 << " of " << frameArena->getCapacity() / 1024.0
+       << " KB  " << frameArena->getHeapBlocks() << " heap blocks\n";
+    if (AllocTracker::isEnabled()) {
+        ss << "heap " << (double)heapAllocs.total / count << " allocs (max " << heapAllocs.max << ")  "
+           << heapBytes.total / 1024.0 / count << " KB (max " << heapBytes.max / 1024.0 << ")\n";
+    }
+    for (const auto &it : sections) {
+        ss << it.first << "  " << it.second.total / 1000.0 / count
+           << " ms (max " << it.second.max / 1000.0 << ")\n";
+    }
+    return ss.str();
+}
+
+/**
+ * Writes the recorded frames to the given file as Chrome trace JSON
+ *
+ * @param path  The file to write
+ *
+ * @return true if the file was written
+ */
+bool ProfilerController::exportTrace(const std::string& path) const {
+    auto writer = TextWriter::alloc(path);
+    if (writer == nullptr) {
+        return false;
+    }
+
+    // Complete ("X") events; CPU sections on thread 1 and GPU queries on thread 2
+    writer->write("{\"traceEvents\":[\n");
+    bool first = true;
+    Uint64 count = std::min<Uint64>(_frameCount, _frames.size());
+    for (Uint64 id = _frameCount - count; id < _frameCount; id++) {
+        const Frame &frame = _frames[id % _frames.size()];
+        for (const Sample &sample : frame.samples) {
+            std::stringstream ss;
+            ss << (first ? "" : ",\n");
+            ss << "{\"name\":\"" << sample.name << "\",\"cat\":\"" << (sample.gpu ? "gpu" : "cpu")
+               << "\",\"ph\":\"X\",\"ts\":" << sample.start << ",\"dur\":" << sample.duration
+               << ",\"pid\":1,\"tid\":" << (sample.gpu ? 2 : 1)
+               << ",\"args\":{\"frame\":" << frame.id << "}}";
+            writer->write(ss.str());
+            first = false;
+        }
+    }
+    writer->write("\n],\"displayTimeUnit\":\"ms\"}\n");
+    writer->close();
+    return true;
+}
@@ -0,0 +1,223 @@
+//
+//  ProfilerController.h
+//  Rooted
+//
+//  A lightweight frame profiler. Scoped CPU timers (PROFILE_SCOPE) and GPU timer queries
+//  (PROFILE_GPU_SCOPE) record samples into the current frame, and the last PROFILER_HISTORY
+//  frames are kept in a ring buffer. The history can be summarized for the debug overlay or
+//  exported as Chrome trace JSON (open it in chrome://tracing or Perfetto).
+//
+//  GPU timing uses GL_TIME_ELAPSED, which is only available on desktop OpenGL. Only one GPU
+//  scope can be active at a time, so GPU scopes must not nest. Results are read back a few
+//  frames later and attached to the frame that issued them.
+//
+
+#ifndef ProfilerController_h
+#define ProfilerController_h
+
+#include <cugl/cugl.h>
+
+/**
+ * A singleton profiler for the game loop.
+ */
+class ProfilerController {
+public:
+    /** A single timed section */
+    struct Sample {
+        /** The section name (must be a string literal) */
+        const char* name;
+        /** The start of the section in microseconds since the profiler started */
+        Uint64 start;
+        /** The duration of the section in microseconds */
+        Uint32 duration;
+        /** The nesting depth of the section */
+        Uint8 depth;
+        /** Whether this is GPU time */
+        bool gpu;
+    };
+
+    /** All the samples of one frame */
+    struct Frame {
+        /** The frame number */
+        Uint64 id;
+        /** The start of the frame in microseconds since the profiler started */
+        Uint64 start;
+        /** The CPU duration of the frame in microseconds */
+        Uint32 cpu;
+        /** The GPU time measured in this frame in microseconds */
+        Uint32 gpu;
+        /** The allocations from the frame arena of the main thread in this frame */
+        Uint32 arena;
+        /** The heap allocations of every thread in this frame (tracking builds only) */
+        Uint32 heapAllocs;
+        /** The heap bytes allocated by every thread in this frame (tracking builds only) */
+        Uint32 heapBytes;
+        /** The samples of this frame, in start order for each thread */
+        std::vector<Sample> samples;
+    };
+
+protected:
+    /** An in-flight GPU timer query */
+    struct Query {
+        /** The OpenGL query object */
+        GLuint query;
+        /** The section name */
+        const char* name;
+        /** The CPU time the query was issued */
+        Uint64 start;
+        /** The frame that issued the query */
+        Uint64 frame;
+        /** Whether the query has been issued and not yet read */
+        bool pending;
+    };
+
+    /** Whether the profiler is recording */
+    bool _enabled;
+    /** The time the profiler started */
+    cugl::Timestamp _epoch;
+    /** The ring buffer of frames */
+    std::vector<Frame> _frames;
+    /** The number of frames started */
+    Uint64 _frameCount;
+    /** Whether a frame is in progress */
+    bool _inFrame;
+    /** The current nesting depth */
+    Uint8 _depth;
+    /** The pool of GPU timer queries */
+    std::vector<Query> _queries;
+    /** The active GPU query, or -1 */
+    int _activeQuery;
+    /** The total frame arena allocations when the current frame started */
+    size_t _arenaStart;
+    /** The tracked heap statistics when the current frame started */
+    cugl::AllocTracker::Stats _heapStart;
+
+    /** Returns the frame in progress */
+    Frame& current() { return _frames[(_frameCount - 1) % _frames.size()]; }
+
+    /** Returns the frame with the given id, or nullptr if it left the ring buffer */
+    Frame* getFrame(Uint64 id);
+
+    /** Reads back the GPU queries that have completed */
+    void resolveQueries();
+
+    ProfilerController();
+
+public:
+    ~ProfilerController();
+
+    /**
+     * Returns the profiler singleton
+     */
+    static ProfilerController* get();
+
+    /**
+     * Sets whether the profiler is recording. Scopes are nearly free when it is not.
+     */
+    void setEnabled(bool enabled) { _enabled = enabled; }
+
+    bool isEnabled() const { return _enabled; }
+
+    /** Returns the time in microseconds since the profiler started */
+    Uint64 now() const;
+
+#pragma mark Frames
+    /**
+     * Starts a new frame, recycling the oldest frame in the ring buffer
+     */
+    void beginFrame();
+
+    /**
+     * Ends the current frame
+     */
+    void endFrame();
+
+#pragma mark Sections
+    /**
+     * Starts a CPU section, returning its index in the current frame (or -1)
+     */
+    int beginSection(const char* name);
+
+    /**
+     * Ends the CPU section with the given index
+     */
+    void endSection(int index);
+
+    /**
+     * Starts a GPU timer query, returning its index (or -1 if one is already active
+     * or GPU timing is unavailable)
+     */
+    int beginQuery(const char* name);
+
+    /**
+     * Ends the GPU timer query with the given index
+     */
+    void endQuery(int index);
+
+#pragma mark Reporting
+    /**
+     * Returns a text summary of the recorded frames, with the average and maximum
+     * time of each section, for the debug overlay
+     */
+    std::string getSummary() const;
+
+    /**
+     * Writes the recorded frames to the given file as Chrome trace JSON
+     *
+     * @param path  The file to write
+     *
+     * @return true if the file was written
+     */
+    bool exportTrace(const std::string& path) const;
+};
+
+/**
+ * Times the enclosing scope on the CPU.
+ */
+class ProfileScope {
+private:
+    /** The section index in the current frame */
+    int _index;
+public:
+    ProfileScope(const char* name) {
+        ProfilerController* profiler = ProfilerController::get();
+        _index = profiler->isEnabled() ? profiler->beginSection(name) : -1;
+    }
+
+    ~ProfileScope() {
+        if (_index >= 0) {
+            ProfilerController::get()->endSection(_index);
+        }
+    }
+};
+
+/**
+ * Times the enclosing scope on both the CPU and the GPU.
+ */
+class GpuProfileScope {
+private:
+    /** The CPU section */
+    ProfileScope _cpu;
+    /** The GPU query */
+    int _query;
+public:
+    GpuProfileScope(const char* name) : _cpu(name) {
+        ProfilerController* profiler = ProfilerController::get();
+        _query = profiler->isEnabled() ? profiler->beginQuery(name) : -1;
+    }
+
+    ~GpuProfileScope() {
+        if (_query >= 0) {
+            ProfilerController::get()->endQuery(_query);
+        }
+    }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+/** Times the rest of the enclosing scope on the CPU */
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(_profile, __LINE__)(name)
+/** Times the rest of the enclosing scope on the CPU and GPU (GPU scopes must not nest) */
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(_profile, __LINE__)(name)
+
+#endif /* ProfilerController_h */
@@ -7,11 +7,13 @@
 
 #include "UIController.h"
 #include "../RootedConstants.h"
+#include "ProfilerController.h"
 
 using namespace cugl;
 
 void UIController::dispose() {
     _uinode->removeAllChildren();
+    _profilerText = nullptr;
     _assets = nullptr;
     _input = nullptr;
     _uinode = nullptr;
@@ -76,6 +78,15 @@ void UIController::initGameUINodes() {
     _barrotsRemainingText->setContentSize(_barrotsRemainingBoard->getContentSize());
     _barrotsRemainingText->doLayout();
     _barrotsRemainingBoard->addChild(_barrotsRemainingText);
+    
+    _profilerText = scene2::Label::allocWithText("", _assets->get<Font>("gaeguBold16"));
+    _profilerText->setHorizontalAlignment(HorizontalAlign::LEFT);
+    _profilerText->setVerticalAlignment(VerticalAlign::TOP);
+    _profilerText->setAnchor(Vec2::ANCHOR_TOP_LEFT);
+    _profilerText->setPosition((Vec2(_carrotsRemainingBoard->getContentWidth()/2, SCENE_HEIGHT - 2*_carrotsRemainingBoard->getContentHeight()) - _offset) / _cameraZoom);
+    _profilerText->setForeground(Color4::WHITE);
+    _profilerText->setVisible(false);
+    _uinode->addChild(_profilerText);
 }
 
 bool UIController::init(const std::shared_ptr<cugl::AssetManager>& assets,
@@ -202,6 +213,12 @@ void UIController::update(float step, std::shared_ptr<OrthographicCamera> camera
     }
     _carrotsRemainingBoard->setVisible(debugActive);
     _barrotsRemainingBoard->setVisible(debugActive);
+    _profilerText->setVisible(debugActive);
+    if (debugActive && ++_profilerFrames >= PROFILER_OVERLAY_INTERVAL) {
+        // Rebuilding the label layout every frame would show up in the profile
+        _profilerText->setText(ProfilerController::get()->getSummary(), true);
+        _profilerFrames = 0;
+    }
     updateSwipeSpline();
     updateInfoNodes(numCarrots, numBarrots);
 }
@@ -56,6 +56,11 @@ private:
     std::shared_ptr<cugl::scene2::TexturedNode> _barrotsRemainingBoard;
     std::shared_ptr<cugl::scene2::Label> _barrotsRemainingText;
     
+    /** Pointer to the Label of the profiler summary, shown in debug mode */
+    std::shared_ptr<cugl::scene2::Label> _profilerText;
+    /** The number of frames since the profiler summary was refreshed */
+    int _profilerFrames = 0;
+    
     float swipeThickness = 8;
     Uint32 swipeDurationMillis = 500;
     cugl::Vec2 tmp;
@@ -0,0 +1,73 @@
+//
+//  InputEvent.cpp
+//  Rooted
+//
+
+#include "InputEvent.h"
+
+/**
+ * This method is used by the NetEventController to create a new event of using a
+ * reference of the same type.
+ *
+ * Not that this method is not static, it differs from the static alloc() method
+ * and all methods must implement this method.
+ */
+std::shared_ptr<NetEvent> InputEvent::newEvent(){
+    return std::make_shared<InputEvent>();
+}
+
+std::shared_ptr<NetEvent> InputEvent::allocInputEvent(std::string uuid, Sint32 round, Uint64 tick,
+                                                      Vec2 movement, Uint32 flags){
+    auto event = std::make_shared<InputEvent>();
+    event->_uuid = uuid;
+    event->_round = round;
+    event->_tick = tick;
+    event->_moveX = (Sint32)roundf(movement.x * INPUT_FIXED_SCALE);
+    event->_moveY = (Sint32)roundf(movement.y * INPUT_FIXED_SCALE);
+    event->_flags = flags;
+    return event;
+}
+
+/**
+ * Rounds a movement vector to the precision sent over the network.
+ *
+ * The local player must apply the same rounded value as its peers.
+ */
+Vec2 InputEvent::quantize(Vec2 movement) {
+    return Vec2(roundf(movement.x * INPUT_FIXED_SCALE) / INPUT_FIXED_SCALE,
+                roundf(movement.y * INPUT_FIXED_SCALE) / INPUT_FIXED_SCALE);
+}
+
+/**
+ * Serialize any paramater that the event contains to a vector of bytes.
+ */
+std::vector<std::byte> InputEvent::serialize(){
+    _serializer.reset();
+    _serializer.writeString(_uuid);
+    _serializer.writeSint32(_round);
+    _serializer.writeUint64(_tick);
+    _serializer.writeSint32(_moveX);
+    _serializer.writeSint32(_moveY);
+    _serializer.writeUint32(_flags);
+    return _serializer.serialize();
+}
+
+/**
+ * Deserialize a vector of bytes and set the corresponding parameters.
+ *
+ * @param data  a byte vector packed by serialize()
+ *
+ * This function should be the "reverse" of the serialize() function: it
+ * should be able to recreate a serialized event entirely, setting all the
+ * useful parameters of this class.
+ */
+void InputEvent::deserialize(const std::vector<std::byte>& data){
+    _deserializer.reset();
+    _deserializer.receive(data);
+    _uuid = _deserializer.readString();
+    _round = _deserializer.readSint32();
+    _tick = _deserializer.readUint64();
+    _moveX = _deserializer.readSint32();
+    _moveY = _deserializer.readSint32();
+    _flags = _deserializer.readUint32();
+}
@@ -0,0 +1,89 @@
+//
+//  InputEvent.h
+//  Rooted
+//
+//  An event carrying one player's input for a single lockstep tick. In
+//  lockstep mode this is the only per-tick traffic between peers.
+//
+
+#ifndef InputEvent_h
+#define InputEvent_h
+
+#include <cugl/cugl.h>
+
+using namespace cugl::physics2::net;
+using namespace cugl;
+using namespace cugl::net;
+
+/** The fixed-point scale used to quantize movement input */
+#define INPUT_FIXED_SCALE 1024.0f
+
+class InputEvent : public NetEvent {
+public:
+    /** Bit flags for the button inputs of a tick */
+    enum Flags : Uint32 {
+        DASH = 1,
+        ROOT = 2,
+        UNROOT = 4,
+        ESCAPE = 8
+    };
+    
+protected:
+    NetcodeSerializer _serializer;
+    NetcodeDeserializer _deserializer;
+    
+    /** The uuid of the player this input belongs to */
+    std::string _uuid;
+    /** The round (map seed) this input belongs to */
+    Sint32 _round;
+    /** The lockstep tick this input is applied on */
+    Uint64 _tick;
+    /** The movement vector in fixed-point */
+    Sint32 _moveX;
+    Sint32 _moveY;
+    /** The button flags */
+    Uint32 _flags;
+    
+public:
+    /**
+    * This method is used by the NetEventController to create a new event of using a
+    * reference of the same type.
+    *
+    * Not that this method is not static, it differs from the static alloc() method
+    * and all methods must implement this method.
+    */
+    std::shared_ptr<NetEvent> newEvent() override;
+    
+    static std::shared_ptr<NetEvent> allocInputEvent(std::string uuid, Sint32 round, Uint64 tick,
+                                                     Vec2 movement, Uint32 flags);
+    
+    /**
+     * Serialize any parameter that the event contains to a vector of bytes.
+     */
+    std::vector<std::byte> serialize() override;
+    /**
+     * Deserialize a vector of bytes and set the corresponding parameters.
+     *
+     * @param data  a byte vector packed by serialize()
+     *
+     * This function should be the "reverse" of the serialize() function: it
+     * should be able to recreate a serialized event entirely, setting all the
+     * useful parameters of this class.
+     */
+    void deserialize(const std::vector<std::byte>& data) override;
+    
+    /** Rounds a movement vector to the precision sent over the network */
+    static Vec2 quantize(Vec2 movement);
+    
+    std::string getUUID() { return _uuid; }
+    
+    Sint32 getRound() { return _round; }
+    
+    Uint64 getTick() { return _tick; }
+    
+    Vec2 getMovement() { return Vec2(_moveX / INPUT_FIXED_SCALE, _moveY / INPUT_FIXED_SCALE); }
+    
+    Uint32 getFlags() { return _flags; }
+};
+
+#endif /* InputEvent_h */
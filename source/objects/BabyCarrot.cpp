@@ -26,6 +26,15 @@ bool BabyCarrot::init(const cugl::Vec2& pos, const cugl::Size& size, float scale
     return EntityModel::init(pos, size, scale);
 }
 
+/**
+ * Restores this baby carrot to the state of a new one, so that it can be recycled.
+ */
+void BabyCarrot::reset() {
+    EntityModel::reset();
+    _isCaptured = false;
+    _id = 0;
+}
+
 void BabyCarrot::gotCaptured() {
     _isCaptured = true;
 //    this->~BabyCarrot();
@@ -31,6 +31,11 @@ public:
     
     ~BabyCarrot() { dispose(); };
 
+    /**
+     * Restores this baby carrot to the state of a new one, so that it can be recycled.
+     */
+    void reset() override;
+
     bool init(const cugl::Vec2& pos, const cugl::Size& size, float scale);
 
     static std::shared_ptr<BabyCarrot> alloc(const cugl::Vec2& pos, const cugl::Size& size, float scale) {
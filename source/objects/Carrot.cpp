@@ -72,6 +72,14 @@ void Carrot::updateCurAnimDurationForState() {
     }
 }
 
+/**
+ * Restores this carrot to the state of a new carrot, so that it can be recycled.
+ */
+void Carrot::reset() {
+    EntityModel::reset();
+    resetCarrot();
+}
+
 void Carrot::resetCarrot(){
     _isCaptured = false;
     _isRooted = false;
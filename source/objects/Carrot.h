@@ -87,6 +87,11 @@ public:
     int getNumBabyCarrots() { return  _numBabyCarrots; };
     
     void resetCarrot();
+
+    /**
+     * Restores this carrot to the state of a new carrot, so that it can be recycled.
+     */
+    void reset() override;
     
 #pragma mark -
 #pragma mark Interactions
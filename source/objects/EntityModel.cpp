@@ -90,6 +90,8 @@ bool EntityModel::init(const cugl::Vec2& pos, const cugl::Size& size, float scal
         setDensity(DUDE_DENSITY);
         setFriction(0.0f);
         setFixedRotation(true);
+        // The update only moves this entity's own node and wheat stamp
+        setUpdateThreadSafe(true);
         
         // Gameplay attributes
         _facing = SOUTH;
@@ -114,57 +116,43 @@ bool EntityModel::animationShouldStep() {
     return isMoving() || _state == DASHING || _state == PLANTING;
 }
 
-void EntityModel::stepAnimation(float dt) {
-    if (_node != nullptr) {
-        if (animationShouldStep()) {
-                curAnimTime += dt;
-                if (curAnimTime > (curAnimDuration)) { curAnimTime = 0;}
-                // PING-PING style animation
-                // https://www.desmos.com/calculator/kszulthvhz
-//                _node->setFrame(std::floor(_node->getSpan() * (-abs(curAnimTime - curAnimDuration) + curAnimDuration) / curAnimDuration));
-                // LOOPING style animation
-                 _node->setFrame(std::floor(_node->getSpan() * curAnimTime / curAnimDuration));
-        }
-        else if (_node->getFrame() != 0) {
-            _node->setFrame(0);
-            curAnimTime = 0;
-        }
-    }
-   
-    
+/** The walk sheet for each facing */
+static const EntityModel::EntitySheet FACING_SHEETS[8] = {
+    EntityModel::EAST_SHEET, EntityModel::NORTHEAST_SHEET, EntityModel::NORTH_SHEET,
+    EntityModel::NORTHEAST_SHEET, EntityModel::EAST_SHEET, EntityModel::SOUTHEAST_SHEET,
+    EntityModel::SOUTH_SHEET, EntityModel::SOUTHEAST_SHEET
+};
+
+/** Whether the walk sheet is flipped for each facing (the sheets face east) */
+static const bool FACING_FLIPS[8] = { false, false, true, true, true, true, true, false };
+
+EntityModel::EntitySheet EntityModel::getSpriteSheet() const {
+    return FACING_SHEETS[_facing];
+}
+
+bool EntityModel::isSpriteFlipped() const {
+    return FACING_FLIPS[_facing];
 }
 
 #pragma mark -
 #pragma mark Attribute Properties
 
-EntityModel::EntityFacing EntityModel::calculateFacing(cugl::Vec2 movement) {
-    EntityFacing dir = _facing;
-    float ang = atan(movement.y/movement.x);
+/** tan(pi/8), the slope between a cardinal and a diagonal octant */
+#define TAN_PI_8 0.41421356f
 
-    ang = abs(ang);
-    if (movement.x < 0 && movement.y > 0) { // Top-left quadrant, excluding axes
-        ang = M_PI_2 + (M_PI_2 - ang);
-    }
-    else if (movement.x <= 0 && movement.y <= 0) { // Bottom-left quadrant, including both axes
-        ang += M_PI;
-    }
-    else if (movement.x > 0 && movement.y < 0) { // Bottom-right quadrant, excluding axes
-        ang = 3 * M_PI_2 + (M_PI_2 - ang);
-    }
-    
-    // Adjustment for the overflow for the EAST direction
-    // TODO: See if this can be simplified?
-    if (ang < M_PI / 8) {
-        ang += 2 * M_PI;
-    }
-    for (auto i = _facingMap.begin(); i != _facingMap.end(); i++) {
-        if (ang >= i->first.x && ang < i->first.y) {
-            dir = i->second;
-            break;
-        }
-    }
-//    std::cout << "Ang: " << ang << " | Dir: " << dir << "\n";
-    return dir;
+EntityModel::EntityFacing EntityModel::calculateFacing(cugl::Vec2 movement) {
+    // Octants indexed by quadrant (bit 0 is west, bit 1 is south) and by steepness
+    static const EntityFacing OCTANTS[4][3] = {
+        { EAST, NORTHEAST, NORTH },
+        { WEST, NORTHWEST, NORTH },
+        { EAST, SOUTHEAST, SOUTH },
+        { WEST, SOUTHWEST, SOUTH }
+    };
+    float ax = fabsf(movement.x);
+    float ay = fabsf(movement.y);
+    int steep = (ay > ax * TAN_PI_8) + (ay * TAN_PI_8 > ax);
+    int quadrant = (movement.x < 0) | ((movement.y < 0) << 1);
+    return OCTANTS[quadrant][steep];
 }
 
 /**
@@ -176,34 +164,10 @@ EntityModel::EntityFacing EntityModel::calculateFacing(cugl::Vec2 movement) {
  */
 void EntityModel::setMovement(Vec2 movement) {
     _movement = movement;
-    EntityFacing face = calculateFacing(movement);
-    if (_facing == face) {
-        return;
-    }
-    // Grab the correct sprite
-    auto sprite = _southWalkSprite;
-    if (face == SOUTH) {
-        sprite = _southWalkSprite;
-    }
-    else if (face == NORTH) {
-        sprite = _northWalkSprite;
+    // Keep the last facing when there is no input
+    if (!movement.isZero()) {
+        _facing = calculateFacing(movement);
     }
-    else if (face == EAST || face == WEST) {
-        sprite = _eastWalkSprite;
-    }
-    else if (face == NORTHEAST || face == NORTHWEST) {
-        sprite = _northEastWalkSprite;
-    }
-    else if (face == SOUTHEAST || face == SOUTHWEST) {
-        sprite = _southEastWalkSprite;
-    }
-    // Change facing for the sprite
-//    scene2::TexturedNode* image = dynamic_cast<scene2::TexturedNode*>(sprite.get());
-    if (sprite->isFlipHorizontal() == (face == EAST || face == NORTHEAST || face == SOUTHEAST)) {
-        sprite->flipHorizontal(!sprite->isFlipHorizontal());
-    }
-    setSceneNode(sprite);
-    _facing = face;
 }
 
 void EntityModel::setDashInput(bool dashInput) {
@@ -258,14 +222,33 @@ void EntityModel::releaseFixtures() {
  */
 void EntityModel::dispose() {
     _node = nullptr;
-    _wheatHeightNode = nullptr;
+    _wheatStamp = nullptr;
     _geometry = nullptr;
-    
-    _northWalkSprite = nullptr;
-    _northEastWalkSprite = nullptr;
-    _eastWalkSprite = nullptr;
-    _southEastWalkSprite = nullptr;
-    _southWalkSprite = nullptr;
+}
+
+/**
+ * Restores this entity to the state of a new entity, so that it can be recycled.
+ *
+ * The scene node is detached from its parent but kept, so that the next round
+ * can reuse it with its sprite sheets. The wheat stamp belongs to the wheat
+ * scene of the round, and is released. Physics must be deactivated first.
+ */
+void EntityModel::reset() {
+    BoxObstacle::reset();
+    if (_node != nullptr) {
+        _node->removeFromParent();
+        _node->setVisible(true);
+    }
+    _wheatStamp = nullptr;
+    _uuid.clear();
+    _wheatContacts = 0;
+    _movement = Vec2::ZERO;
+    _dashCache = Vec2::ZERO;
+    _dashInput = false;
+    _plantInput = false;
+    _rootInput = false;
+    _unrootInput = false;
+    _inWheat = false;
 }
 
 /**
@@ -395,8 +378,8 @@ void EntityModel::update(float dt) {
 //        }
     }
     
-    if (_wheatHeightNode != nullptr) {
-        updateWheatHeightNode();
+    if (_wheatStamp != nullptr) {
+        updateWheatStamp();
     }
 }
 
@@ -414,40 +397,24 @@ void EntityModel::resetDebug() {
     BoxObstacle::resetDebug();
 }
 
-std::shared_ptr<cugl::scene2::SceneNode> EntityModel::allocWheatHeightNode() {
-    pf = PolyFactory(0.01);
-    _wheatHeightTarget = 0.0;
-    _wheatSizeTarget = 0.75;
-    _currWheatHeight = _wheatHeightTarget;
-    _currWheatSize = _wheatSizeTarget;
-    _wheatHeightNode = scene2::PolygonNode::allocWithPoly(pf.makeEllipse(Vec2(0,0), _wheatSizeTarget * Size(0.8, 0.8)));
-    _wheatHeightNode->setColor(Color4(0, 0, 0, 255));
-    _wheatHeightNode->setBlendFunc(GL_DST_ALPHA, GL_ZERO, GL_ONE, GL_ONE);
-    _wheatHeightNode->setAnchor(Vec2::ANCHOR_CENTER);
-    _wheatHeightNode->setPosition(getX(), getY()-getHeight());
-    return _wheatHeightNode;
-}
-
-std::shared_ptr<cugl::scene2::SceneNode> EntityModel::allocWheatHeightNode(std::shared_ptr<cugl::Texture> &rustle) {
-    pf = PolyFactory(0.01);
+void EntityModel::setWheatStamp(const std::shared_ptr<WheatStamp> &stamp) {
+    _wheatStamp = stamp;
+    if (_wheatStamp == nullptr) {
+        return;
+    }
     _wheatHeightTarget = 0.0;
     _wheatSizeTarget = 0.75;
     _currWheatHeight = _wheatHeightTarget;
     _currWheatSize = _wheatSizeTarget;
-    _wheatHeightNode = scene2::PolygonNode::allocWithTexture(rustle);
-//    _wheatHeightNode->setColor(Color4(0, 0, 0, 255));
-    _wheatHeightNode->setBlendFunc(GL_DST_ALPHA, GL_ZERO, GL_ONE, GL_ONE);
-    _wheatHeightNode->setAnchor(Vec2::ANCHOR_CENTER);
-    _wheatHeightNode->setPosition(getX(), getY()-getHeight());
-    return _wheatHeightNode;
+    _wheatStamp->position.set(getX(), getY()-getHeight());
+    _wheatStamp->size = _wheatSizeTarget * Size(0.8, 0.8);
+    _wheatStamp->color = Color4(0, 0, 0, 255);
 }
 
-
-void EntityModel::updateWheatHeightNode() {
-    _wheatHeightNode->setPosition(getX(), getY()-getHeight());
+void EntityModel::updateWheatStamp() {
+    _wheatStamp->position.set(getX(), getY()-getHeight());
     
     Vec2 velocity = getLinearVelocity();
-    float angle = atan2(velocity.y, velocity.x);
     
     if (_state == DASHING) {
         _wheatSizeTarget = 1.5;
@@ -459,9 +426,9 @@ void EntityModel::updateWheatHeightNode() {
     _currWheatHeight += (_wheatHeightTarget - _currWheatHeight) * 0.1;
     _currWheatSize += (_wheatSizeTarget - _currWheatSize) * 0.1;
     
-    _wheatHeightNode->setPolygon(pf.makeEllipse(Vec2(0,0), _currWheatSize * Size(1.6, 0.9)));
-    _wheatHeightNode->setColor(Color4(0,_currWheatHeight > 0 ? int(_currWheatHeight) : 0,
-                                      _currWheatHeight < 0 ? -int(_currWheatHeight) : 0,255));
+    _wheatStamp->size = _currWheatSize * Size(1.6, 0.9);
+    _wheatStamp->color = Color4(0,_currWheatHeight > 0 ? int(_currWheatHeight) : 0,
+                                _currWheatHeight < 0 ? -int(_currWheatHeight) : 0,255);
 }
 
 
@@ -47,6 +47,8 @@
 #include <cugl/physics2/CUBoxObstacle.h>
 #include <cugl/physics2/CUCapsuleObstacle.h>
 #include <cugl/scene2/graph/CUWireNode.h>
+#include "../shaders/WheatStamp.h"
+#include "../shaders/EntitySpriteNode.h"
 
 #pragma mark -
 #pragma mark Drawing Constants
@@ -118,6 +120,18 @@ private:
 	/** This macro disables the copy constructor (not allowed on physics objects) */
 	CU_DISALLOW_COPY_AND_ASSIGN(EntityModel);
 
+public:
+    /** The sprite sheets of an entity, in the order they are added to its EntitySpriteNode.
+        Entities with fewer sheets (like baby carrots) fall back to the first one. */
+    enum EntitySheet {
+        SOUTH_SHEET,
+        NORTH_SHEET,
+        EAST_SHEET,
+        NORTHEAST_SHEET,
+        SOUTHEAST_SHEET,
+        CAPTURE_SHEET   // farmer only
+    };
+
 protected:
     enum EntityFacing {
         EAST,
@@ -130,28 +144,11 @@ protected:
         SOUTHEAST
     };
     
-    const std::map<cugl::Vec2, EntityFacing> _facingMap = {
-        { cugl::Vec2(15 * M_PI / 8, 17 * M_PI / 8), EAST }, // Adjustment for the overflow for the EAST direction TODO: See if this can be simplified?
-        { cugl::Vec2(M_PI / 8, 3 * M_PI / 8), NORTHEAST },
-        { cugl::Vec2(3 * M_PI / 8, 5 * M_PI / 8), NORTH },
-        { cugl::Vec2(5 * M_PI / 8, 7 * M_PI / 8), NORTHWEST },
-        { cugl::Vec2(7 * M_PI / 8, 9 * M_PI / 8), WEST },
-        { cugl::Vec2(9 * M_PI / 8, 11 * M_PI / 8), SOUTHWEST },
-        { cugl::Vec2(11 * M_PI / 8, 13 * M_PI / 8), SOUTH },
-        { cugl::Vec2(13 * M_PI / 8, 15 * M_PI / 8), SOUTHEAST },
-    };
-    
 	/** Which direction is the character facing */
     EntityFacing _facing;
 
 	/** The scene graph node for the Dude. */
-	std::shared_ptr<cugl::scene2::SpriteNode> _node;
-    
-    std::shared_ptr<cugl::scene2::SpriteNode> _eastWalkSprite;
-    std::shared_ptr<cugl::scene2::SpriteNode> _southWalkSprite;
-    std::shared_ptr<cugl::scene2::SpriteNode> _northWalkSprite;
-    std::shared_ptr<cugl::scene2::SpriteNode> _northEastWalkSprite;
-    std::shared_ptr<cugl::scene2::SpriteNode> _southEastWalkSprite;
+	std::shared_ptr<EntitySpriteNode> _node;
     
 	/** The scale between the physics world and the screen */
 	float _drawScale;
@@ -162,10 +159,6 @@ protected:
     
     /** The time it takes for the currently active animation to complete 1 cycle (in seconds) */
     float curAnimDuration = 1.5f;
-    
-    /** The amount of time that has elapsed in the current animation cycle
-        For example, if the player is in a walking animation cycle that is 1.5 seconds long, and this field is 0.7 seconds, then the animation is roughly at its middle frame */
-    float curAnimTime;
    
 	/**
 	* Redraws the outline of the physics fixtures to the debug node
@@ -191,10 +184,8 @@ protected:
     bool _unrootInput;
     
     cugl::Vec2 _dashCache;
-    /** Polygon factory for the wheat node. */
-    cugl::PolyFactory pf;
-    /** The wheat height adjustment node in the wheat scene from this entity's velocity */
-    std::shared_ptr<cugl::scene2::PolygonNode> _wheatHeightNode;
+    /** The wheat height adjustment stamp in the wheat scene from this entity's velocity */
+    std::shared_ptr<WheatStamp> _wheatStamp;
     /** Target height for wheat node. This is very temporary */
     float _wheatHeightTarget;
     /** Current rendered height for wheat node. This is very temporary */
@@ -232,6 +223,15 @@ public:
      * disposed, a DudeModel may not be used until it is initialized again.
      */
     void dispose();
+
+    /**
+     * Restores this entity to the state of a new entity, so that it can be recycled.
+     *
+     * The scene node is detached from its parent but kept, so that the next round
+     * can reuse it with its sprite sheets. The wheat stamp belongs to the wheat
+     * scene of the round, and is released. Physics must be deactivated first.
+     */
+    void reset() override;
     
     /**
      * Initializes a new dude at the origin.
@@ -392,19 +392,13 @@ public:
      *
      * @return the scene graph node representing this DudeModel.
      */
-	const std::shared_ptr<cugl::scene2::SpriteNode>& getSceneNode() const { return _node; }
+	const std::shared_ptr<EntitySpriteNode>& getSceneNode() const { return _node; }
 
     /**
      * Sets the scene graph node representing this DudeModel.
      *
-     * Note that this method also handles creating the nodes for the body parts
-     * of this DudeModel. Since the obstacles are decoupled from the scene graph,
-     * initialization (which creates the obstacles) occurs prior to the call to
-     * this method. Therefore, to be drawn to the screen, the nodes of the attached
-     * bodies must be added here.
-     *
-     * The bubbler also uses the world node when adding bubbles to the scene, so
-     * the input node must be added to the world BEFORE this method is called.
+     * The node holds every sprite sheet of this entity. Which sheet and frame it
+     * shows is decided by the AnimationController from {@link #getSpriteSheet}.
      *
      * By storing a reference to the scene graph node, the model can update
      * the node to be in sync with the physics info. It does this via the
@@ -412,12 +406,8 @@ public:
      *
      * @param node  The scene graph node representing this DudeModel, which has been added to the world node already.
      */
-	void setSceneNode(const std::shared_ptr<cugl::scene2::SpriteNode>& node) {
-        if (_node != nullptr) {
-            _node->setVisible(false);
-        }
+	void setSceneNode(const std::shared_ptr<EntitySpriteNode>& node) {
         _node = node;
-        _node->setVisible(true);
         _node->setPosition(getPosition() * _drawScale);
     }
 
@@ -450,31 +440,30 @@ public:
     bool animationShouldStep();
     
     /**
-     * Sets all of the sprite nodes associated with this EntityModel
-     *
-     * This currently only includes the 5-directional movement sprites, but
-     * TODO: It should later include all action sprites.
+     * Returns the time it takes for the current animation to complete one cycle (in seconds)
      */
-    void setSpriteNodes(const std::shared_ptr<cugl::scene2::SpriteNode>& northNode,
-                        const std::shared_ptr<cugl::scene2::SpriteNode>& northEastNode,
-                        const std::shared_ptr<cugl::scene2::SpriteNode>& eastNode,
-                        const std::shared_ptr<cugl::scene2::SpriteNode>& southEastNode,
-                        const std::shared_ptr<cugl::scene2::SpriteNode>& southNode) {
-        _northWalkSprite = northNode;
-        _northEastWalkSprite = northEastNode;
-        _eastWalkSprite = eastNode;
-        _southEastWalkSprite = southEastNode;
-        _southWalkSprite = southNode;
-    }
+    float getAnimDuration() const { return curAnimDuration; }
     
     /**
-     * Steps the current sprite's animation by dt.
+     * Returns the sprite sheet this entity should currently show
      *
-     * This steps the current sprite node associated with this EntityModel by incrementing curAnimTime by dt and comparing it with curAnimDuration
+     * By default this is the walk sheet for the current facing. Derived classes can
+     * override this for action sprites.
      */
-    void stepAnimation(float dt);
+    virtual EntitySheet getSpriteSheet() const;
     
-    EntityFacing calculateFacing(cugl::Vec2 movement);
+    /**
+     * Returns whether the sprite sheet should be flipped horizontally (i.e. facing west)
+     */
+    virtual bool isSpriteFlipped() const;
+    
+    /**
+     * Returns the facing octant of the given (nonzero) movement
+     *
+     * This compares the slope against tan(pi/8) instead of computing the angle, and
+     * resolves the octant with a table lookup on the signs of the movement.
+     */
+    static EntityFacing calculateFacing(cugl::Vec2 movement);
 
     
 #pragma mark -
@@ -624,13 +613,19 @@ public:
         _state = state;
     }
     
-    virtual std::shared_ptr<cugl::scene2::SceneNode> allocWheatHeightNode();
-    
-    virtual std::shared_ptr<cugl::scene2::SceneNode> allocWheatHeightNode(std::shared_ptr<cugl::Texture> &rustle);
+    /**
+     * Sets the wheat height adjustment stamp for this entity, resetting its targets.
+     *
+     * The stamp is drawn by the WheatScene that allocated it for as long as this entity
+     * holds it. Setting it to nullptr removes this entity's mark from the wheat.
+     *
+     * @param stamp the stamp from {@link WheatScene#allocStamp}
+     */
+    void setWheatStamp(const std::shared_ptr<WheatStamp> &stamp);
 
-    virtual void updateWheatHeightNode();
+    virtual void updateWheatStamp();
 
-    std::shared_ptr<cugl::scene2::SceneNode> getWheatHeightNode() { return _wheatHeightNode; };
+    std::shared_ptr<WheatStamp> getWheatStamp() { return _wheatStamp; };
 
     unsigned int getWheatQueryId() { return _wheatQueryId; };
 
@@ -0,0 +1,134 @@
+//
+//  EntityPool.cpp
+//  Rooted
+//
+//  Recycles the entities of a round. Carrots, farmers, baby carrots and planting spots are
+//  taken from free lists instead of the heap, and go back to them when the last reference
+//  is released.
+//
+
+#include "EntityPool.h"
+
+using namespace cugl;
+
+/** The preallocated carrots (two rounds are alive while the next one is built) */
+#define CARROT_CAPACITY     8
+/** The preallocated farmers */
+#define FARMER_CAPACITY     2
+/** The preallocated baby carrots */
+#define BABY_CAPACITY       40
+/** The preallocated planting spots */
+#define PLANTING_CAPACITY   16
+
+#pragma mark -
+#pragma mark Constructors
+
+/**
+ * Releases every recycled entity of this pool.
+ */
+void EntityPool::dispose() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _carrots.dispose();
+    _farmers.dispose();
+    _babies.dispose();
+    _plantingSpots.dispose();
+}
+
+/**
+ * Initializes this pool, preallocating the entities of two rounds.
+ *
+ * @return true if the pool is initialized properly
+ */
+bool EntityPool::init() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _carrots.init(CARROT_CAPACITY, true) &&
+           _farmers.init(FARMER_CAPACITY, true) &&
+           _babies.init(BABY_CAPACITY, true) &&
+           _plantingSpots.init(PLANTING_CAPACITY, true);
+}
+
+#pragma mark -
+#pragma mark Entities
+
+/**
+ * Returns an uninitialized object from the given free list.
+ *
+ * The object returns to the list when its last reference is released.
+ *
+ * @param list  The free list to take the object from
+ *
+ * @return an uninitialized object from the given free list
+ */
+template <class T>
+std::shared_ptr<T> EntityPool::acquire(FreeList<T> &list) {
+    T *obj = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        obj = list.malloc();
+    }
+    if (obj == nullptr) {
+        return nullptr;
+    }
+    // The deleter keeps the pool (and so the list) alive
+    std::shared_ptr<EntityPool> self = shared_from_this();
+    return std::shared_ptr<T>(obj, [self, &list](T *obj) {
+        std::lock_guard<std::mutex> lock(self->_mutex);
+        list.free(obj);
+    });
+}
+
+/**
+ * Returns a carrot at the given position, recycled if possible.
+ *
+ * @param pos   Initial position in world coordinates
+ * @param size  The size of the carrot in world units
+ * @param scale The drawing scale (world to screen)
+ *
+ * @return a carrot at the given position
+ */
+std::shared_ptr<Carrot> EntityPool::allocCarrot(const Vec2 &pos, const Size &size, float scale) {
+    std::shared_ptr<Carrot> result = acquire(_carrots);
+    return (result != nullptr && result->init(pos, size, scale) ? result : nullptr);
+}
+
+/**
+ * Returns a farmer at the given position, recycled if possible.
+ *
+ * @param pos   Initial position in world coordinates
+ * @param size  The size of the farmer in world units
+ * @param scale The drawing scale (world to screen)
+ *
+ * @return a farmer at the given position
+ */
+std::shared_ptr<Farmer> EntityPool::allocFarmer(const Vec2 &pos, const Size &size, float scale) {
+    std::shared_ptr<Farmer> result = acquire(_farmers);
+    return (result != nullptr && result->init(pos, size, scale) ? result : nullptr);
+}
+
+/**
+ * Returns a baby carrot at the given position, recycled if possible.
+ *
+ * @param pos   Initial position in world coordinates
+ * @param size  The size of the baby carrot in world units
+ * @param scale The drawing scale (world to screen)
+ *
+ * @return a baby carrot at the given position
+ */
+std::shared_ptr<BabyCarrot> EntityPool::allocBabyCarrot(const Vec2 &pos, const Size &size, float scale) {
+    std::shared_ptr<BabyCarrot> result = acquire(_babies);
+    return (result != nullptr && result->init(pos, size, scale) ? result : nullptr);
+}
+
+/**
+ * Returns a planting spot at the given position, recycled if possible.
+ *
+ * @param pos   Initial position in world coordinates
+ * @param size  The size of the planting spot in world units
+ * @param scale The drawing scale (world to screen)
+ *
+ * @return a planting spot at the given position
+ */
+std::shared_ptr<PlantingSpot> EntityPool::allocPlantingSpot(const Vec2 &pos, const Size &size, float scale) {
+    std::shared_ptr<PlantingSpot> result = acquire(_plantingSpots);
+    return (result != nullptr && result->init(pos, size, scale) ? result : nullptr);
+}
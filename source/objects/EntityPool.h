@@ -0,0 +1,146 @@
+//
+//  EntityPool.h
+//  Rooted
+//
+//  Recycles the entities of a round. Carrots, farmers, baby carrots and planting spots are
+//  taken from free lists instead of the heap, and go back to them when the last reference
+//  is released. A recycled entity keeps its scene nodes (sprite sheets, planting tiles and
+//  debug wireframe), so a new round only reinitializes it and adds it to the new world.
+//
+//  The pool is shared by every round of a game. Rounds are built on a worker thread while
+//  the previous round is still alive, so the free lists are guarded by a mutex.
+//
+
+#ifndef EntityPool_h
+#define EntityPool_h
+
+#include <cugl/cugl.h>
+#include <mutex>
+#include "BabyCarrot.h"
+#include "Carrot.h"
+#include "Farmer.h"
+#include "PlantingSpot.h"
+
+using namespace cugl;
+
+/**
+ * A set of free lists for the entity archetypes of a round.
+ *
+ * Entities are handed out as shared pointers whose deleter returns them to
+ * this pool, calling their reset() method. Every entity keeps the pool alive,
+ * so the pool may be released before the entities are.
+ */
+class EntityPool : public std::enable_shared_from_this<EntityPool> {
+private:
+    /** The lock guarding the free lists */
+    std::mutex _mutex;
+    /** The recycled carrots */
+    FreeList<Carrot> _carrots;
+    /** The recycled farmers */
+    FreeList<Farmer> _farmers;
+    /** The recycled baby carrots */
+    FreeList<BabyCarrot> _babies;
+    /** The recycled planting spots */
+    FreeList<PlantingSpot> _plantingSpots;
+
+    /**
+     * Returns an uninitialized object from the given free list.
+     *
+     * The object returns to the list when its last reference is released.
+     *
+     * @param list  The free list to take the object from
+     *
+     * @return an uninitialized object from the given free list
+     */
+    template <class T>
+    std::shared_ptr<T> acquire(FreeList<T> &list);
+
+public:
+#pragma mark -
+#pragma mark Constructors
+
+    /**
+     * Creates an empty pool.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    EntityPool() {}
+
+    /**
+     * Deletes this pool, releasing every recycled entity.
+     */
+    ~EntityPool() { dispose(); }
+
+    /**
+     * Releases every recycled entity of this pool.
+     */
+    void dispose();
+
+    /**
+     * Initializes this pool, preallocating the entities of two rounds.
+     *
+     * @return true if the pool is initialized properly
+     */
+    bool init();
+
+    /**
+     * Returns a newly allocated entity pool.
+     *
+     * @return a newly allocated entity pool
+     */
+    static std::shared_ptr<EntityPool> alloc() {
+        std::shared_ptr<EntityPool> result = std::make_shared<EntityPool>();
+        return (result->init() ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Entities
+
+    /**
+     * Returns a carrot at the given position, recycled if possible.
+     *
+     * @param pos   Initial position in world coordinates
+     * @param size  The size of the carrot in world units
+     * @param scale The drawing scale (world to screen)
+     *
+     * @return a carrot at the given position
+     */
+    std::shared_ptr<Carrot> allocCarrot(const Vec2 &pos, const Size &size, float scale);
+
+    /**
+     * Returns a farmer at the given position, recycled if possible.
+     *
+     * @param pos   Initial position in world coordinates
+     * @param size  The size of the farmer in world units
+     * @param scale The drawing scale (world to screen)
+     *
+     * @return a farmer at the given position
+     */
+    std::shared_ptr<Farmer> allocFarmer(const Vec2 &pos, const Size &size, float scale);
+
+    /**
+     * Returns a baby carrot at the given position, recycled if possible.
+     *
+     * @param pos   Initial position in world coordinates
+     * @param size  The size of the baby carrot in world units
+     * @param scale The drawing scale (world to screen)
+     *
+     * @return a baby carrot at the given position
+     */
+    std::shared_ptr<BabyCarrot> allocBabyCarrot(const Vec2 &pos, const Size &size, float scale);
+
+    /**
+     * Returns a planting spot at the given position, recycled if possible.
+     *
+     * @param pos   Initial position in world coordinates
+     * @param size  The size of the planting spot in world units
+     * @param scale The drawing scale (world to screen)
+     *
+     * @return a planting spot at the given position
+     */
+    std::shared_ptr<PlantingSpot> allocPlantingSpot(const Vec2 &pos, const Size &size, float scale);
+
+};
+
+#endif /* EntityPool_h */
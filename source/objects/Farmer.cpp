@@ -10,27 +10,26 @@ bool Farmer::init(const cugl::Vec2& pos, const cugl::Size& size, float scale) {
 
 void Farmer::dispose() {
     EntityModel::dispose();
-    _normalNode = nullptr;
-    _captureNode = nullptr;
 }
 
 void Farmer::grabCarrot(){
     _isHoldingCarrot = true;
-//    _normalNode->setVisible(false);
-//    _captureNode->setVisible(true);
-    setSceneNode(_captureNode);
 }
 
 void Farmer::rootCarrot(){
     _isHoldingCarrot = false;
-//    _captureNode->setVisible(false);
-//    _normalNode->setVisible(true);
-    setSceneNode(_normalNode);
 }
 
 void Farmer::carrotEscaped(){
     _isHoldingCarrot = false;
-    setSceneNode(_normalNode);
+}
+
+EntityModel::EntitySheet Farmer::getSpriteSheet() const {
+    return _isHoldingCarrot ? CAPTURE_SHEET : EntityModel::getSpriteSheet();
+}
+
+bool Farmer::isSpriteFlipped() const {
+    return _isHoldingCarrot ? false : EntityModel::isSpriteFlipped();
 }
 
 void Farmer::setMovement(Vec2 movement) {
@@ -64,3 +63,12 @@ void Farmer::resetFarmer(){
     _canPlant = false;
 
 }
+
+/**
+ * Restores this farmer to the state of a new farmer, so that it can be recycled.
+ */
+void Farmer::reset() {
+    EntityModel::reset();
+    resetFarmer();
+    _dashWindow = false;
+}
@@ -16,8 +16,6 @@ private:
     bool _isHoldingCarrot;
     bool _canPlant;
     bool _dashWindow;
-    std::shared_ptr<cugl::scene2::SpriteNode> _normalNode;
-    std::shared_ptr<cugl::scene2::SpriteNode> _captureNode;
     
     // Animation timers
     float sneakAnimDuration = 5.0f;
@@ -51,14 +49,20 @@ public:
     
     void setCanPlant(bool plant) { _canPlant = plant; };
     
-    void setNormalNode(std::shared_ptr<cugl::scene2::SpriteNode> n) { _normalNode = n; }
-    void setCaptureNode(std::shared_ptr<cugl::scene2::SpriteNode> n) { _captureNode = n; }
+    EntitySheet getSpriteSheet() const override;
+    
+    bool isSpriteFlipped() const override;
     
     void setMovement(cugl::Vec2 movement) override;
     
     void updateCurAnimDurationForState() override;
 
     void resetFarmer();
+
+    /**
+     * Restores this farmer to the state of a new farmer, so that it can be recycled.
+     */
+    void reset() override;
 };
 
 
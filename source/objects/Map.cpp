@@ -121,7 +121,7 @@ void Map::setRootNode(const std::shared_ptr<scene2::SceneNode> &node) {
     _worldnode->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
     _worldnode->setPosition(Vec2::ZERO);
 
-    _debugnode = scene2::SceneNode::alloc();
+    _debugnode = DebugOverlayNode::alloc();
     _debugnode->setScale(_scale); // Debug node draws in PHYSICS coordinates
     _debugnode->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
     _debugnode->setPosition(Vec2::ZERO);
@@ -136,27 +136,10 @@ void Map::setRootNode(const std::shared_ptr<scene2::SceneNode> &node) {
     
     bool showGrid = true; //change this to show the grid in debug
     if (showGrid) {
-        for (int x = 0; x < _bounds.size.width; x++) {
-            std::shared_ptr<scene2::WireNode> rect = scene2::WireNode::allocWithPath(Rect(Vec2::ZERO, Vec2(1, _bounds.size.height)));
-            rect->setColor(Color4::WHITE);
-            rect->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
-            rect->setPosition(Vec2(x, 0));
-            _debugnode->addChild(rect);
-        }
-        
-        for (int y = 0; y < _bounds.size.height; y++) {
-            std::shared_ptr<scene2::WireNode> rect = scene2::WireNode::allocWithPath(Rect(Vec2::ZERO, Vec2(_bounds.size.width, 1)));
-            rect->setColor(Color4::WHITE);
-            rect->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
-            rect->setPosition(Vec2(0, y));
-            _debugnode->addChild(rect);
-        }
+        _debugnode->setGrid(_bounds.size, Color4::WHITE);
     }
 
-    _root->addChild(_worldnode);
 //    _worldnode->addChild(_entitiesNode);
-    _root->addChild(_debugnode);
-
 }
 
 /**
@@ -184,13 +167,41 @@ void Map::showDebug(bool flag) {
  *
  * @return true if successfully loaded the asset from a file
  */
-bool Map::init(const std::shared_ptr<AssetManager> &assets) {
+bool Map::init(const std::shared_ptr<AssetManager> &assets, const std::shared_ptr<EntityPool> &pool) {
     setAssets(assets);
+    _pool = pool;
+    if (_pool == nullptr) {
+        CUAssertLog(false, "Map needs an entity pool");
+        return false;
+    }
+    // Textures are shared with the renderer, so only name them here (build() may run on a worker)
+    if (auto baby = _assets->get<Texture>(BABY_TEXTURE)) {
+        baby->setName("baby");
+    }
+    
     auto json = _assets->get<JsonValue>("mapNames");
     if (json == nullptr) {
         CUAssertLog(false, "Failed to load map names");
     }
     _mapNames = json->get("names")->asStringArray();
+    
+    // Prefer the cooked units, and only read the Tiled exports of units missing from the pack
+    _pack.dispose();
+    if (json->has("pack") && !_pack.initWithAsset(json->getString("pack"))) {
+        CUWarn("TILED JSON: Could not open the map unit pack, reading the Tiled exports instead");
+    }
+    auto files = json->get("files");
+    _units.resize(_mapNames.size());
+    _parsed.resize(_mapNames.size());
+    for (size_t ii = 0; ii < _mapNames.size(); ii++) {
+        if (_pack.has(_mapNames[ii])) {
+            _units[ii] = _pack.get(_mapNames[ii]);
+        } else if (loadUnit(_mapNames[ii], files, _parsed[ii])) {
+            _units[ii] = _parsed[ii].view();
+        } else {
+            CUAssertLog(false, "Failed to load map unit %s", _mapNames[ii].c_str());
+        }
+    }
 
     return true;
 }
@@ -207,9 +218,8 @@ void Map::generate(int randSeed, int numFarmers, int numCarrots, int numBabyCarr
     //randomly select a map for each location and object info lists
     for (int i = 0; i < _bounds.size.width / MAP_UNIT_WIDTH; i++ ) {
         for (int j = 0; j < _bounds.size.height / MAP_UNIT_HEIGHT; j++) {
-            std::string mapName = _mapNames[floor(float(_rand32()) / _rand32.max() * _mapNames.size())];
-            std::shared_ptr<JsonValue> json = _assets->get<JsonValue>(mapName);
-            loadTiledJson(json, i, j);
+            int unit = floor(float(_rand32()) / _rand32.max() * _mapNames.size());
+            placeUnit(_units[unit], i, j);
         }
     }
     
@@ -226,60 +236,80 @@ void Map::generate(int randSeed, int numFarmers, int numCarrots, int numBabyCarr
     _plantingSpawns = std::vector(_plantingSpawns.begin(), _plantingSpawns.begin() + std::min(numPlantingSpots, int(_plantingSpawns.size())));
 }
 
-void Map::loadTiledJson(std::shared_ptr<JsonValue>& json, int i, int j) {
-    
-    CUAssertLog(json != nullptr, "Failed to load tiled json");
-    
-    std::shared_ptr<JsonValue> layers = json->get("layers");
-    int height = json->getFloat("height");
-    int tileSize = json->getInt("tilewidth");
-    for (auto layer : layers->children()) {
-        std::string name = layer->getString("name");
-        auto objects = layer->get("objects");
-        for (auto object : objects->children()) {
-            readProperties(object, tileSize, height);
-            
-            std::string type = std::any_cast<std::string>(_propertiesMap.at("type"));
-            float x = std::any_cast<float>(_propertiesMap.at("x"));
-            float y = std::any_cast<float>(_propertiesMap.at("y"));
-            float width = std::any_cast<float>(_propertiesMap.at("width"));
-            float height = std::any_cast<float>(_propertiesMap.at("height"));
-            
-            if (name == "wheat") {
-                std::string name = std::any_cast<std::string>(_propertiesMap.at("name"));
-                float bladeColorScale = std::any_cast<float>(_propertiesMap.at("blade_color_scale"));
-                _mapInfo[i][j] = std::pair(name, bladeColorScale);
-                break;
-            } else if (name == "environment") {
-                if (type == "PlantingSpot") {
-                    _plantingSpawns.push_back(Rect(x + i * MAP_UNIT_WIDTH+ 0.5 * width, y + j * MAP_UNIT_HEIGHT + 0.5 * height, width, height));
-                } else {
-                    CUWarn("TILED JSON: Unrecognized environmental object: %s. Are you sure you have placed the object in the correct layer?", type.c_str());
-                }
-            } else if (name == "entities"){
-                if (type == "Farmer") {
-                    _farmerSpawns.push_back(Rect(x + i * MAP_UNIT_WIDTH+ 0.5 * width, y + j * MAP_UNIT_HEIGHT + 0.5 * height, width, height));
-                } else if (type == "Baby") {
-                    _babyCarrotSpawns.push_back(Rect(x + i * MAP_UNIT_WIDTH+ 0.5 * width, y + j * MAP_UNIT_HEIGHT + 0.5 * height, width, height));
-                } else if (type == "Carrot") {
-                    _carrotSpawns.push_back(Rect(x + i * MAP_UNIT_WIDTH+ 0.5 * width, y + j * MAP_UNIT_HEIGHT + 0.5 * height, width, height));
-                } else {
-                    CUWarn("TILED JSON: Unrecognized entity: %s. Are you sure you have placed the object in the correct layer?", type.c_str());
-                }
-            } else {
-                CUWarn("TILED JSON: Unrecognized layer name: %s", name.c_str());
-                break;
+bool Map::loadUnit(const std::string &name, const std::shared_ptr<JsonValue> &files, MapUnit &unit) {
+    if (files != nullptr && files->has(name)) {
+        std::string file = files->getString(name);
+        auto reader = TextReader::allocWithAsset(file);
+        if (reader != nullptr) {
+            std::string text = reader->readAll();
+            reader->close();
+            if (unit.initWithTiled(text)) {
+                return true;
             }
         }
+        CUWarn("TILED JSON: Could not read %s, falling back to the asset", file.c_str());
     }
-        
+    return unit.initWithJson(_assets->get<JsonValue>(name));
+}
+
+void Map::placeUnit(const MapUnit::View &unit, int i, int j) {
+    Vec2 offset(i * MAP_UNIT_WIDTH, j * MAP_UNIT_HEIGHT);
+    auto place = [&](const MapUnit::Spawns &spawns, std::vector<Rect> &out) {
+        for (const Rect &rect : spawns) {
+            out.push_back(Rect(rect.origin + offset, rect.size));
+        }
+    };
+    
+    _mapInfo[i][j] = std::pair(std::string(unit.wheatName), unit.bladeColorScale);
+    place(unit.plantingSpawns, _plantingSpawns);
+    place(unit.farmerSpawns, _farmerSpawns);
+    place(unit.babyCarrotSpawns, _babyCarrotSpawns);
+    place(unit.carrotSpawns, _carrotSpawns);
 }
 
 void Map::populate() {
+    build();
+    finalize();
+}
+
+void Map::build() {
 
     /** Create the physics world */
     _world = physics2::net::NetWorld::alloc(getBounds(), Vec2(0, 0));
     
+    // The grass and planting spots do not change during a round, so they are baked into one layer
+    _groundLayer = StaticBatchNode::alloc();
+    _groundLayer->setPriority(float(DrawOrder::GRASS));
+    _worldnode->addChild(_groundLayer);
+    
+    //add grass background node
+    float grassScale = 16.0 * DEFAULT_DRAWSCALE / _scale.x;
+    std::shared_ptr<Texture> grassTex = _assets->get<Texture>(GRASS_TEXTURE);
+    Size nodesize; //ensure node properly fills scene
+    if (float(grassTex->getWidth())/grassTex->getHeight() > float(_root->getContentWidth())/_root->getContentHeight()) {
+        nodesize = grassScale * Size(float(_root->getContentHeight()) * grassTex->getWidth() / grassTex->getHeight(), _root->getContentHeight());
+    } else {
+        nodesize = grassScale * Size(_root->getContentWidth(), float(_root->getContentWidth()) * grassTex->getHeight() / grassTex->getWidth());
+    }
+    auto grassnode = scene2::PolygonNode::allocWithPoly(Rect(Vec2::ZERO, nodesize));
+    grassnode->setTexture(grassTex);
+    grassnode->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
+    grassnode->setScale(1/grassScale);
+    _groundLayer->addChild(grassnode);
+    
+    spawnPlantingSpots();
+    spawnFarmers();
+    spawnCarrots();
+    spawnBabyCarrots();
+    
+    //place boundary walls
+    loadBoundary(Vec2(-0.5, _bounds.size.height/2), Size(1, _bounds.size.height));
+    loadBoundary(Vec2(_bounds.size.width+0.5, _bounds.size.height/2), Size(1, _bounds.size.height));
+    loadBoundary(Vec2(_bounds.size.width/2, -0.5), Size(_bounds.size.width, 1));
+    loadBoundary(Vec2(_bounds.size.width/2, _bounds.size.height+0.5), Size(_bounds.size.width, 1));
+}
+
+void Map::finalize() {
     _wheatscene = WheatScene::alloc(_assets, _mapInfo, _scale, _bounds.size);
 
     _shaderrenderer = ShaderRenderer::alloc(_wheatscene->getTexture(), _assets, _bounds.size, FULL_WHEAT_HEIGHT);
@@ -300,32 +330,19 @@ void Map::populate() {
     _worldnode->addChild(_groundnode);
     _worldnode->addChild(_cloudsnode);
     
-    spawnPlantingSpots();
-    spawnFarmers();
-    spawnCarrots();
-    spawnBabyCarrots();
-    
-    //place boundary walls
-    loadBoundary(Vec2(-0.5, _bounds.size.height/2), Size(1, _bounds.size.height));
-    loadBoundary(Vec2(_bounds.size.width+0.5, _bounds.size.height/2), Size(1, _bounds.size.height));
-    loadBoundary(Vec2(_bounds.size.width/2, -0.5), Size(_bounds.size.width, 1));
-    loadBoundary(Vec2(_bounds.size.width/2, _bounds.size.height+0.5), Size(_bounds.size.width, 1));
-    
-    //add grass background node
-    float grassScale = 16.0 * DEFAULT_DRAWSCALE / _scale.x;
-    std::shared_ptr<Texture> grassTex = _assets->get<Texture>(GRASS_TEXTURE);
-    Size nodesize; //ensure node properly fills scene
-    if (float(grassTex->getWidth())/grassTex->getHeight() > float(_root->getContentWidth())/_root->getContentHeight()) {
-        nodesize = grassScale * Size(float(_root->getContentHeight()) * grassTex->getWidth() / grassTex->getHeight(), _root->getContentHeight());
-    } else {
-        nodesize = grassScale * Size(_root->getContentWidth(), float(_root->getContentWidth()) * grassTex->getHeight() / grassTex->getWidth());
+    // The wheat stamps live in the wheat scene, so the entities only get them now
+    for (auto &farmer : _farmers) {
+        farmer->setWheatStamp(_wheatscene->allocStamp());
     }
-    auto grassnode = scene2::PolygonNode::allocWithPoly(Rect(Vec2::ZERO, nodesize));
-    grassnode->setTexture(grassTex);
-    grassnode->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
-    grassnode->setPriority(float(DrawOrder::GRASS));
-    grassnode->setScale(1/grassScale);
-    _worldnode->addChild(grassnode);
+    for (auto &carrot : _carrots) {
+        carrot->setWheatStamp(_wheatscene->allocStamp());
+    }
+    for (auto &baby : _babies) {
+        baby->setWheatStamp(_wheatscene->allocStamp());
+    }
+    
+    _root->addChild(_worldnode);
+    _root->addChild(_debugnode);
 }
 
 /**
@@ -371,13 +388,20 @@ void Map::dispose() {
         (*it) = nullptr;
     }
     _farmers.clear();
+    _animations.clear();
     if (_world != nullptr) {
         _world->clear();
         _world = nullptr;
     }
-    _shaderedEntitiesNode->dispose();
-    _shaderrenderer->dispose();
-    _wheatscene->dispose();
+    // Planting spots go back to the pool once the world has deactivated them
+    _plantingSpot.clear();
+    // A round that was built but never finalized has no shaders
+    if (_shaderedEntitiesNode != nullptr) {
+        _shaderedEntitiesNode->dispose();
+        _shaderrenderer->dispose();
+        _wheatscene->dispose();
+    }
+    _groundLayer = nullptr;
     
     _mapInfo.clear();
     _carrotSpawns.clear();
@@ -415,6 +439,23 @@ std::shared_ptr<EntityModel> Map::loadPlayerEntities(std::vector<std::string> pl
     return ret;
 }
 
+/**
+ * Returns the planting spot containing the given position, or nullptr if there is none.
+ *
+ * Unlike {@link PlantingSpot#getBelowAvatar}, this does not depend on contacts
+ * tracked for the local character, so every peer gets the same answer.
+ */
+std::shared_ptr<PlantingSpot> Map::getPlantingSpotAt(Vec2 pos) {
+    for (auto ps : _plantingSpot) {
+        Size half = ps->getDimension() / 2;
+        Vec2 diff = pos - ps->getPosition();
+        if (std::abs(diff.x) <= half.width && std::abs(diff.y) <= half.height) {
+            return ps;
+        }
+    }
+    return nullptr;
+}
+
 std::vector<std::shared_ptr<EntityModel>> Map::loadBabyEntities() {
     std::vector<std::shared_ptr<EntityModel>> ret;
     for ( auto baby : _babies) {
@@ -471,89 +512,55 @@ void Map::loadBoundary(Vec2 pos, Size size){
 
 void Map::spawnPlantingSpots() {
     for (Rect rect : _plantingSpawns) {
-        std::shared_ptr<PlantingSpot> plantingSpot = PlantingSpot::alloc(rect.origin, rect.size, _scale.x);
+        std::shared_ptr<PlantingSpot> plantingSpot = _pool->allocPlantingSpot(rect.origin, rect.size, _scale.x);
         plantingSpot->setDebugColor(DEBUG_COLOR);
         plantingSpot->setName("planting spot");
         plantingSpot->setPlantingID((unsigned)_plantingSpot.size());
         _plantingSpot.push_back(plantingSpot);
 
         plantingSpot->setSceneNode(_assets, float(Map::DrawOrder::PLANTINGSPOT));
-        addObstacle(plantingSpot, plantingSpot->getSceneNode());
+        addObstacle(plantingSpot, plantingSpot->getSceneNode(), _groundLayer);
     }
 }
 
 void Map::spawnFarmers() {
     for (Rect rect : _farmerSpawns) {
-        std::shared_ptr<Farmer> farmer = Farmer::alloc(rect.origin, rect.size, _scale.x);
+        std::shared_ptr<Farmer> farmer = _pool->allocFarmer(rect.origin, rect.size, _scale.x);
         farmer->setDebugColor(DEBUG_COLOR);
         farmer->setName("farmer");
         
-        auto farmerSouthWalkSprite = _assets->get<Texture>(FARMER_SOUTH_WALK_SPRITE);
-        auto farmerNorthWalkSprite = _assets->get<Texture>(FARMER_NORTH_WALK_SPRITE);
-        auto farmerEastWalkSprite  = _assets->get<Texture>(FARMER_EAST_WALK_SPRITE);
-        auto farmerNorthEastWalkSprite  = _assets->get<Texture>(FARMER_NORTHEAST_WALK_SPRITE);
-        auto farmerSouthEastWalkSprite  = _assets->get<Texture>(FARMER_SOUTHEAST_WALK_SPRITE);
-
-        auto farmerSouthWalkNode = scene2::SpriteNode::allocWithSheet(farmerSouthWalkSprite, 3, 4);
-        farmerSouthWalkNode->setScale(0.18f * _scale/DEFAULT_DRAWSCALE);
-        farmerSouthWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        farmerSouthWalkNode->setHeight(farmerSouthWalkSprite->getHeight()/3.0 *0.18); //do not know why these values are not multiplied by drawscale ratio
-        
-        auto farmerNorthWalkNode = scene2::SpriteNode::allocWithSheet(farmerNorthWalkSprite, 3, 4);
-        farmerNorthWalkNode->setScale(0.18f * _scale/DEFAULT_DRAWSCALE);
-        farmerNorthWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        farmerNorthWalkNode->setVisible(false);
-        farmerNorthWalkNode->setHeight(farmerNorthWalkSprite->getHeight()/3.0*0.18);
-        
-        auto farmerEastWalkNode = scene2::SpriteNode::allocWithSheet(farmerEastWalkSprite, 3, 4);
-        farmerEastWalkNode->setScale(0.11f * _scale/DEFAULT_DRAWSCALE);
-        farmerEastWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        farmerEastWalkNode->setVisible(false);
-        farmerEastWalkNode->setHeight(farmerEastWalkSprite->getHeight()/3.0*0.11);
-        
-        auto farmerNorthEastWalkNode = scene2::SpriteNode::allocWithSheet(farmerNorthEastWalkSprite, 3, 4);
-        farmerNorthEastWalkNode->setScale(0.12f * _scale/DEFAULT_DRAWSCALE);
-        farmerNorthEastWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        farmerNorthEastWalkNode->setVisible(false);
-        farmerNorthEastWalkNode->setHeight(farmerNorthEastWalkSprite->getHeight()/3.0*0.12);
-        
-        auto farmerSouthEastWalkNode = scene2::SpriteNode::allocWithSheet(farmerSouthEastWalkSprite, 3, 4, 9);
-        farmerSouthEastWalkNode->setScale(0.14f * _scale/DEFAULT_DRAWSCALE);
-        farmerSouthEastWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        farmerSouthEastWalkNode->setVisible(false);
-        farmerSouthEastWalkNode->setHeight(farmerSouthEastWalkSprite->getHeight()/3.0*0.14);
-        
-        auto carrotfarmerNode = scene2::SpriteNode::allocWithSheet(_assets->get<Texture>(CARROTFARMER_TEXTURE), 1, 1);
-        carrotfarmerNode->setVisible(false);
-        carrotfarmerNode->setScale(0.23f * _scale/DEFAULT_DRAWSCALE);
-        carrotfarmerNode->setHeight(_assets->get<Texture>(CARROTFARMER_TEXTURE)->getHeight()*0.23);
-        
-        _entitiesNode->addChild(farmerSouthWalkNode);
-        _entitiesNode->addChild(farmerNorthWalkNode);
-        _entitiesNode->addChild(farmerEastWalkNode);
-        _entitiesNode->addChild(farmerNorthEastWalkNode);
-        _entitiesNode->addChild(farmerSouthEastWalkNode);
-        _entitiesNode->addChild(carrotfarmerNode);
-        
-        farmer->setSpriteNodes(farmerNorthWalkNode,
-                               farmerNorthEastWalkNode,
-                               farmerEastWalkNode,
-                               farmerSouthEastWalkNode,
-                               farmerSouthWalkNode);
-        
-        farmer->setNormalNode(farmerSouthWalkNode);
-        farmer->setCaptureNode(carrotfarmerNode);
+        // A recycled farmer still has its sprite sheets
+        std::shared_ptr<EntitySpriteNode> farmerNode = farmer->getSceneNode();
+        if (farmerNode == nullptr) {
+            // One node holds every sheet, in EntityModel::EntitySheet order
+            float ratio = _scale.x/DEFAULT_DRAWSCALE;
+            auto farmerSouthWalkSprite = _assets->get<Texture>(FARMER_SOUTH_WALK_SPRITE);
+            auto farmerNorthWalkSprite = _assets->get<Texture>(FARMER_NORTH_WALK_SPRITE);
+            auto farmerEastWalkSprite  = _assets->get<Texture>(FARMER_EAST_WALK_SPRITE);
+            auto farmerNorthEastWalkSprite  = _assets->get<Texture>(FARMER_NORTHEAST_WALK_SPRITE);
+            auto farmerSouthEastWalkSprite  = _assets->get<Texture>(FARMER_SOUTHEAST_WALK_SPRITE);
+            auto carrotfarmerSprite = _assets->get<Texture>(CARROTFARMER_TEXTURE);
+
+            farmerNode = EntitySpriteNode::alloc();
+            //do not know why the heights are not multiplied by drawscale ratio
+            farmerNode->addSheet(farmerSouthWalkSprite, 3, 4, 12, 0.18f * ratio, farmerSouthWalkSprite->getHeight()/3.0*0.18);
+            farmerNode->addSheet(farmerNorthWalkSprite, 3, 4, 12, 0.18f * ratio, farmerNorthWalkSprite->getHeight()/3.0*0.18);
+            farmerNode->addSheet(farmerEastWalkSprite, 3, 4, 12, 0.11f * ratio, farmerEastWalkSprite->getHeight()/3.0*0.11);
+            farmerNode->addSheet(farmerNorthEastWalkSprite, 3, 4, 12, 0.12f * ratio, farmerNorthEastWalkSprite->getHeight()/3.0*0.12);
+            farmerNode->addSheet(farmerSouthEastWalkSprite, 3, 4, 9, 0.14f * ratio, farmerSouthEastWalkSprite->getHeight()/3.0*0.14);
+            farmerNode->addSheet(carrotfarmerSprite, 1, 1, 1, 0.23f * ratio, carrotfarmerSprite->getHeight()*0.23);
+        }
+        farmerNode->setPriority(float(Map::DrawOrder::ENTITIES));
+        _entitiesNode->addChild(farmerNode);
         
-        farmer->setSceneNode(farmerSouthWalkNode);
+        farmer->setSceneNode(farmerNode);
         farmer->setDrawScale(
                 _scale.x);  //scale.x is used as opposed to scale since physics scaling MUST BE UNIFORM
 
         farmer->setDebugScene(_debugnode);
 
-        auto wheatnode = farmer->allocWheatHeightNode();
-        _wheatscene->getRoot()->addChild(wheatnode);
-        
         _farmers.push_back(farmer);
+        _animations.add(farmer);
 
         _world->initObstacle(farmer);
     }
@@ -561,30 +568,28 @@ void Map::spawnFarmers() {
 
 void Map::spawnBabyCarrots() {
     for (Rect rect : _babyCarrotSpawns) {
-        std::shared_ptr<BabyCarrot> baby = BabyCarrot::alloc(rect.origin, rect.size, _scale.x);
+        std::shared_ptr<BabyCarrot> baby = _pool->allocBabyCarrot(rect.origin, rect.size, _scale.x);
         baby->setDebugColor(DEBUG_COLOR);
         baby->setName("baby");
         baby->setID((unsigned)_babies.size());
         _babies.push_back(baby);
         
-        _assets->get<Texture>(BABY_TEXTURE)->setName("baby");
-        auto babyNode = scene2::SpriteNode::allocWithSheet(
-                _assets->get<Texture>(BABY_TEXTURE), 1, 1);
-    //        babyNode->setColor(Color4::BLUE);
+        // A recycled baby carrot still has its sprite sheet
+        std::shared_ptr<EntitySpriteNode> babyNode = baby->getSceneNode();
+        if (babyNode == nullptr) {
+            babyNode = EntitySpriteNode::alloc();
+            babyNode->addSheet(_assets->get<Texture>(BABY_TEXTURE), 1, 1, 1,
+                               _scale.x/DEFAULT_DRAWSCALE, 32*_scale.y/DEFAULT_DRAWSCALE);
+        }
         baby->setSceneNode(babyNode);
         babyNode->setName("baby");
         babyNode->setPriority(float(DrawOrder::ENTITIES));
-        //    babyNode->setColor(Color4::BLACK);
         baby->setDrawScale(
                            _scale.x);  //scale.x is used as opposed to scale since physics scaling MUST BE UNIFORM
-        babyNode->setScale(_scale/DEFAULT_DRAWSCALE);
-        // Create the polygon node (empty, as the model will initialize)
-        babyNode->setHeight(32*_scale.y/DEFAULT_DRAWSCALE);
         _entitiesNode->addChild(babyNode);
         baby->setDebugScene(_debugnode);
         
-        auto wheatnode = baby->allocWheatHeightNode();
-        _wheatscene->getRoot()->addChild(wheatnode);
+        _animations.add(baby);
         
         _world->initObstacle(baby);
     }
@@ -602,13 +607,14 @@ void Map::spawnBabyCarrots() {
  * @param node            The scene graph node to attach it to
  */
 void Map::addObstacle(const std::shared_ptr<cugl::physics2::Obstacle> &obj,
-                      const std::shared_ptr<cugl::scene2::SceneNode> &node) {
+                      const std::shared_ptr<cugl::scene2::SceneNode> &node,
+                      const std::shared_ptr<cugl::scene2::SceneNode> &parent) {
     _world->initObstacle(obj);
     obj->setDebugScene(_debugnode);
 
     // Position the scene graph node (enough for static objects)
     node->setPosition(obj->getPosition() * _scale);
-    _worldnode->addChild(node);
+    (parent == nullptr ? _worldnode : parent)->addChild(node);
 
     // Dynamic objects need constant updating
     if (obj->getBodyType() == b2_dynamicBody) {
@@ -621,108 +627,43 @@ void Map::addObstacle(const std::shared_ptr<cugl::physics2::Obstacle> &obj,
 }
 
 
-bool Map::readProperties(const std::shared_ptr<cugl::JsonValue> &json, int tileSize, int levelHeight) {
-    // this is copied from nine lives but might be a bit unnecessary
-
-    _propertiesMap.clear();
-
-    _propertiesMap.emplace("x", json->getFloat("x")/tileSize);
-    _propertiesMap.emplace("y", levelHeight - json->getFloat("y")/tileSize);
-    _propertiesMap.emplace("width", json->getFloat("width")/tileSize);
-    _propertiesMap.emplace("height", json->getFloat("height")/tileSize);
-    _propertiesMap.emplace("type", json->getString("type"));
-
-    auto properties = json->get("properties");
-    if (properties == nullptr) { return true; }
-
-    for (auto property : properties->children()){
-        std::string name = property->getString("name");
-        std::string type = property->getString("type");
-
-        if (type == "string") {
-            _propertiesMap.emplace(name, property->getString("value"));
-        } else if (type == "int") {
-            _propertiesMap.emplace(name, property->getInt("value"));
-        } else if (type == "bool") {
-            _propertiesMap.emplace(name, property->getBool("value"));
-        } else if (type == "float") {
-            _propertiesMap.emplace(name, property->getFloat("value"));
-        }
-
-    }
-    return true;
-}
-
 void Map::spawnCarrots() {
     for (Rect rect : _carrotSpawns) {
-        std::shared_ptr<Carrot> carrot = Carrot::alloc(rect.origin, rect.size, _scale.x);
+        std::shared_ptr<Carrot> carrot = _pool->allocCarrot(rect.origin, rect.size, _scale.x);
         carrot->setDebugColor(DEBUG_COLOR);
         carrot->setName("carrot");
         _carrots.push_back(carrot);
         
-        auto carrotSouthWalkSprite = _assets->get<Texture>(CARROT_SOUTH_WALK_SPRITE);
-        auto carrotNorthWalkSprite = _assets->get<Texture>(CARROT_NORTH_WALK_SPRITE);
-        auto carrotEastWalkSprite = _assets->get<Texture>(CARROT_EAST_WALK_SPRITE);
-        auto carrotNorthEastWalkSprite = _assets->get<Texture>(CARROT_NORTHEAST_WALK_SPRITE);
-        auto carrotSouthEastWalkSprite = _assets->get<Texture>(CARROT_SOUTHEAST_WALK_SPRITE);
-        
-        auto carrotSouthWalkNode = scene2::SpriteNode::allocWithSheet(
-                                                                      carrotSouthWalkSprite, 3, 5);
-        carrotSouthWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        carrotSouthWalkNode->setScale(0.1f * _scale/DEFAULT_DRAWSCALE);
-        carrotSouthWalkNode->setAnchor(Vec2(0.5, 0.25));
-        carrotSouthWalkNode->setHeight(carrotSouthWalkSprite->getHeight()/3.0 *0.1); //do not know why these values are not multiplied by drawscale ratio
-        
-        auto carrotNorthWalkNode = scene2::SpriteNode::allocWithSheet(
-                                                                      carrotNorthWalkSprite, 3, 5);
-        carrotNorthWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        carrotNorthWalkNode->setScale(0.1f * _scale/DEFAULT_DRAWSCALE);
-        carrotNorthWalkNode->setAnchor(Vec2(0.5, 0.25));
-        carrotNorthWalkNode->setVisible(false);
-        carrotNorthWalkNode->setHeight(carrotNorthWalkSprite->getHeight()/3.0 *0.1);
-        
-        auto carrotEastWalkNode = scene2::SpriteNode::allocWithSheet(
-                                                                     carrotEastWalkSprite, 3, 5);
-        carrotEastWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        carrotEastWalkNode->setScale(0.1f * _scale/DEFAULT_DRAWSCALE);
-        carrotEastWalkNode->setAnchor(Vec2(0.5, 0.25));
-        carrotEastWalkNode->setVisible(false);
-        carrotEastWalkNode->setHeight(carrotEastWalkSprite->getHeight()/3.0 *0.1);
-        
-        auto carrotNorthEastWalkNode = scene2::SpriteNode::allocWithSheet(carrotNorthEastWalkSprite, 3, 5);
-        carrotNorthEastWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        carrotNorthEastWalkNode->setScale(0.1f * _scale/DEFAULT_DRAWSCALE);
-        carrotNorthEastWalkNode->setAnchor(Vec2(0.5, 0.25));
-        carrotNorthEastWalkNode->setVisible(false);
-        carrotNorthEastWalkNode->setHeight(carrotNorthEastWalkSprite->getHeight()/3.0 *0.1);
-        
-        auto carrotSouthEastWalkNode = scene2::SpriteNode::allocWithSheet(carrotSouthEastWalkSprite, 3, 5);
-        carrotSouthEastWalkNode->setPriority(float(Map::DrawOrder::ENTITIES));
-        carrotSouthEastWalkNode->setScale(0.1f * _scale/DEFAULT_DRAWSCALE);
-        carrotSouthEastWalkNode->setAnchor(Vec2(0.5, 0.25));
-        carrotSouthEastWalkNode->setVisible(false);
-        carrotSouthEastWalkNode->setHeight(carrotSouthEastWalkSprite->getHeight()/3.0 *0.1);
-        
-        _entitiesNode->addChild(carrotNorthWalkNode);
-        _entitiesNode->addChild(carrotEastWalkNode);
-        _entitiesNode->addChild(carrotSouthWalkNode);
-        _entitiesNode->addChild(carrotNorthEastWalkNode);
-        _entitiesNode->addChild(carrotSouthEastWalkNode);
+        // A recycled carrot still has its sprite sheets
+        std::shared_ptr<EntitySpriteNode> carrotNode = carrot->getSceneNode();
+        if (carrotNode == nullptr) {
+            // One node holds every sheet, in EntityModel::EntitySheet order
+            float ratio = _scale.x/DEFAULT_DRAWSCALE;
+            Vec2 anchor(0.5, 0.25);
+            auto carrotSouthWalkSprite = _assets->get<Texture>(CARROT_SOUTH_WALK_SPRITE);
+            auto carrotNorthWalkSprite = _assets->get<Texture>(CARROT_NORTH_WALK_SPRITE);
+            auto carrotEastWalkSprite = _assets->get<Texture>(CARROT_EAST_WALK_SPRITE);
+            auto carrotNorthEastWalkSprite = _assets->get<Texture>(CARROT_NORTHEAST_WALK_SPRITE);
+            auto carrotSouthEastWalkSprite = _assets->get<Texture>(CARROT_SOUTHEAST_WALK_SPRITE);
+            
+            carrotNode = EntitySpriteNode::alloc();
+            //do not know why the heights are not multiplied by drawscale ratio
+            carrotNode->addSheet(carrotSouthWalkSprite, 3, 5, 15, 0.1f * ratio, carrotSouthWalkSprite->getHeight()/3.0 *0.1, anchor);
+            carrotNode->addSheet(carrotNorthWalkSprite, 3, 5, 15, 0.1f * ratio, carrotNorthWalkSprite->getHeight()/3.0 *0.1, anchor);
+            carrotNode->addSheet(carrotEastWalkSprite, 3, 5, 15, 0.1f * ratio, carrotEastWalkSprite->getHeight()/3.0 *0.1, anchor);
+            carrotNode->addSheet(carrotNorthEastWalkSprite, 3, 5, 15, 0.1f * ratio, carrotNorthEastWalkSprite->getHeight()/3.0 *0.1, anchor);
+            carrotNode->addSheet(carrotSouthEastWalkSprite, 3, 5, 15, 0.1f * ratio, carrotSouthEastWalkSprite->getHeight()/3.0 *0.1, anchor);
+        }
+        carrotNode->setPriority(float(Map::DrawOrder::ENTITIES));
+        _entitiesNode->addChild(carrotNode);
         
-        carrot->setSceneNode(carrotSouthWalkNode);
+        carrot->setSceneNode(carrotNode);
         carrot->setDrawScale(
                              _scale.x);  //scale.x is used as opposed to scale since physics scaling MUST BE UNIFORM
-        // Create the polygon node (empty, as the model will initialize)
-        carrot->setSpriteNodes(carrotNorthWalkNode,
-                               carrotNorthEastWalkNode,
-                               carrotEastWalkNode,
-                               carrotSouthEastWalkNode,
-                               carrotSouthWalkNode);
         
         carrot->setDebugScene(_debugnode);
         
-        auto wheatnode = carrot->allocWheatHeightNode();
-        _wheatscene->getRoot()->addChild(wheatnode);
+        _animations.add(carrot);
         
         _world->initObstacle(carrot);
     }
@@ -730,8 +671,9 @@ void Map::spawnCarrots() {
 
 void Map::updateShaders(float step, Mat4 perspective) {
     int size = (unsigned)(_carrots.size() + _farmers.size() + _babies.size());
-    float positions[2*size]; // must be 1d array
-    float velocities[size];
+    // The uniforms are uploaded before returning, so the arrays only live for this frame
+    float *positions = FrameArena::get()->allocArray<float>(2*size); // must be 1d array
+    float *velocities = FrameArena::get()->allocArray<float>(size);
     float ratio = _shaderrenderer->getAspectRatio();
     float scale = _root->getContentSize().width/_scale.x;
     for (int i = 0; i < _carrots.size(); i++) {
@@ -751,6 +693,7 @@ void Map::updateShaders(float step, Mat4 perspective) {
     }
     _shaderrenderer->update(step, perspective, size, positions, velocities, _character->getPosition() / scale * Vec2(1.0, ratio));
     _shaderedEntitiesNode->update(step);
+    _wheatscene->update(step);
 }
 
 void Map::resetPlantingSpots() {
@@ -6,17 +6,22 @@
 #define ROOTED_MAP_H
 
 #include <cugl/cugl.h>
-#include <any>
 
 #include "BabyCarrot.h"
 #include "Carrot.h"
 #include "Farmer.h"
 #include "Wheat.h"
 #include "PlantingSpot.h"
+#include "EntityPool.h"
+#include "MapUnit.h"
+#include "MapUnitPack.h"
 #include "../shaders/EntitiesNode.h"
 #include "../shaders/ShaderNode.h"
 #include "../shaders/ShaderRenderer.h"
 #include "../shaders/WheatScene.h"
+#include "../shaders/StaticBatchNode.h"
+#include "../shaders/DebugOverlayNode.h"
+#include "../controllers/AnimationController.h"
 
 class Map {
 private:
@@ -48,10 +53,12 @@ private:
     std::shared_ptr<JsonValue> _json;
     /** The AssetManager for the game mode */
     std::shared_ptr<cugl::AssetManager> _assets;
+    /** The pool recycling the entities of every round */
+    std::shared_ptr<EntityPool> _pool;
     /** Reference to the physics root of the scene graph */
     std::shared_ptr<scene2::SceneNode> _worldnode;
     /** Reference to the debug root of the scene graph */
-    std::shared_ptr<scene2::SceneNode> _debugnode;
+    std::shared_ptr<DebugOverlayNode> _debugnode;
     /** Reference to the wheat node of the scene graph */
     std::shared_ptr<ShaderNode> _wheatnode;
     /** Reference to the ground node of the scene graph */
@@ -62,8 +69,9 @@ private:
     std::shared_ptr<EntitiesNode> _shaderedEntitiesNode;
     
     std::shared_ptr<scene2::SceneNode> _entitiesNode;
-
-    std::unordered_map<std::string, std::any> _propertiesMap;
+    
+    /** The static layer holding the grass and planting spots */
+    std::shared_ptr<StaticBatchNode> _groundLayer;
 
     std::shared_ptr<ShaderRenderer> _shaderrenderer;
 
@@ -83,9 +91,21 @@ private:
     /** Vector of key names for all map units in assets json */
     std::vector<std::string> _mapNames;
     
+    /** The map units named by _mapNames, read once at initialization */
+    std::vector<MapUnit::View> _units;
+    
+    /** The cooked map units, viewed in place by _units */
+    MapUnitPack _pack;
+    
+    /** The map units missing from the pack, read from their Tiled exports */
+    std::vector<MapUnit> _parsed;
+    
     /** Mersenne Twister random number generator to ensure randomness is consistent without broadcasting across network (hopefully) */
     std::mt19937 _rand32;
     
+    /** Steps the sprite animation of every entity */
+    AnimationController _animations;
+    
     /** 2D vector representing tiling of randomly generated map */
     std::vector<std::vector<std::pair<std::string, float>>> _mapInfo;
 
@@ -118,19 +138,46 @@ public:
      * This method does NOT load the level. You must call the load() method to do that.
      * This method returns false if file does not exist.
      *
+     * @param assets    The asset manager for the game mode
+     * @param pool      The pool recycling the entities of every round
+     *
      * @return  an autoreleased level file
      */
-    static std::shared_ptr<Map> alloc(const std::shared_ptr<AssetManager> &assets) {
+    static std::shared_ptr<Map> alloc(const std::shared_ptr<AssetManager> &assets,
+                                      const std::shared_ptr<EntityPool> &pool) {
         std::shared_ptr<Map> result = std::make_shared<Map>();
-        return (result->init(assets) ? result : nullptr);
+        return (result->init(assets, pool) ? result : nullptr);
     }
 
-    bool init(const std::shared_ptr<AssetManager> &assets);
+    bool init(const std::shared_ptr<AssetManager> &assets, const std::shared_ptr<EntityPool> &pool);
     
     void generate(int randSeed, int numFarmers, int numCarrots, int numBabyCarrots, int numPlantingSpots);
     
+    /**
+     * Builds and finalizes the round on this thread.
+     *
+     * This is the same as {@link build} followed by {@link finalize}.
+     */
     void populate();
     
+    /**
+     * Builds the part of the round that does not use OpenGL.
+     *
+     * This creates the physics world, every obstacle and their scene nodes, but
+     * does not attach them to the root node. It touches no state outside of this
+     * map, so it may run on a worker thread after {@link generate} and
+     * {@link setRootNode}, as long as nothing else uses this map meanwhile.
+     */
+    void build();
+    
+    /**
+     * Finishes a round created with {@link build}.
+     *
+     * This creates the wheat scene and the shaders, and attaches the map to its
+     * root node. It must be called on the main thread.
+     */
+    void finalize();
+    
     /**
      * populate the map with Carrots
      */
@@ -203,6 +250,8 @@ public:
      * does not have to be the same size as the physics body. We only guarantee
      * that the node is positioned correctly according to the drawing scale.
      *
+     * The nodes of this map are not added to the root until {@link finalize}.
+     *
      * @param value  the scene graph node for drawing purposes.
      *
      * @retain  a reference to this scene graph node
@@ -270,6 +319,14 @@ public:
 
     std::shared_ptr<cugl::physics2::net::NetWorld> getWorld() { return _world; }
     
+    /**
+     * Returns the planting spot containing the given position, or nullptr if there is none.
+     *
+     * Unlike {@link PlantingSpot#getBelowAvatar}, this does not depend on contacts
+     * tracked for the local character, so every peer gets the same answer.
+     */
+    std::shared_ptr<PlantingSpot> getPlantingSpotAt(Vec2 pos);
+    
     void resetPlantingSpots();
     
     void resetPlayers();
@@ -279,12 +336,41 @@ public:
     void updateShaders(float step, Mat4 perspective);
 
     std::shared_ptr<WheatScene> getWheatScene() { return _wheatscene; }
+
+    /**
+     * Steps the sprite animation of every entity on this map.
+     *
+     * @param dt    The time since the last animation step
+     */
+    void updateAnimations(float dt) { _animations.update(dt); }
     
 private:
 #pragma mark -
 #pragma mark Internal Helper Methods
     
-    void loadTiledJson(std::shared_ptr<JsonValue> &json, int i, int j);
+    /**
+     * Reads the map unit with the given name.
+     *
+     * If the unit has a file in the map names json, it is streamed from that file.
+     * Otherwise it is read from the JSON asset of the same name.
+     *
+     * @param name  The key name of the map unit
+     * @param files The map unit files, by key name (may be nullptr)
+     * @param unit  The unit to fill
+     *
+     * @return true if the unit was read successfully
+     */
+    bool loadUnit(const std::string &name, const std::shared_ptr<JsonValue> &files, MapUnit &unit);
+    
+    /**
+     * Adds the wheat tile and spawns of a map unit to the given grid cell.
+     *
+     * @param unit  The map unit to place
+     * @param i     The column of the grid cell
+     * @param j     The row of the grid cell
+     */
+    void placeUnit(const MapUnit::View &unit, int i, int j);
+    
     /**
      * Adds the physics object to the physics world and loosely couples it to the scene graph
      *
@@ -293,19 +379,12 @@ private:
      * with dude.  The other is to use callback functions to loosely couple
      * the two.  This function is an example of the latter.
      *
-     * @param obj   The physics object to add
-     * @param node  The scene graph node to attach it to
-     */
-    void addObstacle(const std::shared_ptr<cugl::physics2::Obstacle> &obj, const std::shared_ptr<cugl::scene2::SceneNode> &node);
-    
-    /**
-     * Reads the JSON of an object in a Tiled JSON, and puts it into _propertiesMap.
-     *
-     * @param json  JSON of the object
-     * @param tileSize   (Pixel) size of the Tiled tiles in the JSON
-     * @param levelHeight   Height of the map in physics coordinates
+     * @param obj    The physics object to add
+     * @param node   The scene graph node to attach it to
+     * @param parent The parent of the scene graph node (the world node if nullptr)
      */
-    bool readProperties(const std::shared_ptr<cugl::JsonValue> &json, int tileSize, int levelHeight);
+    void addObstacle(const std::shared_ptr<cugl::physics2::Obstacle> &obj, const std::shared_ptr<cugl::scene2::SceneNode> &node,
+                     const std::shared_ptr<cugl::scene2::SceneNode> &parent = nullptr);
     
     /**
      * Adds a boundary box obstacle to the world.
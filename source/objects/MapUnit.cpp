@@ -0,0 +1,468 @@
+//
+//  MapUnit.cpp
+//  Rooted
+//
+//  The parts of a Tiled map unit that round generation needs: the wheat tile, its blade color
+//  scale and the spawn rectangles of each object type. Units are read once when the map is
+//  initialized, either by streaming the Tiled export (without building a JsonValue tree) or
+//  from a JsonValue that is already loaded, and are then placed on the grid every round.
+//
+
+#include "MapUnit.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Tiled Layers
+
+namespace {
+
+/** A Tiled object, in the pixel coordinates of the export */
+struct TiledObject {
+    float x = 0;
+    float y = 0;
+    float width = 0;
+    float height = 0;
+    /** The class of the object */
+    std::string type;
+    /** The "name" property (only used by wheat tiles) */
+    std::string name;
+    /** The "blade_color_scale" property (only used by wheat tiles) */
+    float bladeColorScale = 0;
+};
+
+/** A Tiled object layer */
+struct TiledLayer {
+    std::string name;
+    std::vector<TiledObject> objects;
+};
+
+/**
+ * Fills the unit from the layers of a Tiled export.
+ *
+ * Both readers produce the same layers, so this is the only place that knows
+ * how layer names and object classes map onto spawns.
+ *
+ * @param unit      The unit to fill
+ * @param layers    The object layers of the export
+ * @param tileSize  The (pixel) width of a Tiled tile
+ * @param height    The height of the unit, in tiles
+ */
+void buildUnit(MapUnit &unit, const std::vector<TiledLayer> &layers, int tileSize, int height) {
+    unit.clear();
+    for (const TiledLayer &layer : layers) {
+        for (const TiledObject &object : layer.objects) {
+            float x = object.x / tileSize;
+            float y = height - object.y / tileSize;
+            float width = object.width / tileSize;
+            float h = object.height / tileSize;
+            Rect spawn(x + 0.5f * width, y + 0.5f * h, width, h);
+
+            if (layer.name == "wheat") {
+                unit.wheatName = object.name;
+                unit.bladeColorScale = object.bladeColorScale;
+                break;
+            } else if (layer.name == "environment") {
+                if (object.type == "PlantingSpot") {
+                    unit.plantingSpawns.push_back(spawn);
+                } else {
+                    CUWarn("TILED JSON: Unrecognized environmental object: %s. Are you sure you have placed the object in the correct layer?", object.type.c_str());
+                }
+            } else if (layer.name == "entities") {
+                if (object.type == "Farmer") {
+                    unit.farmerSpawns.push_back(spawn);
+                } else if (object.type == "Baby") {
+                    unit.babyCarrotSpawns.push_back(spawn);
+                } else if (object.type == "Carrot") {
+                    unit.carrotSpawns.push_back(spawn);
+                } else {
+                    CUWarn("TILED JSON: Unrecognized entity: %s. Are you sure you have placed the object in the correct layer?", object.type.c_str());
+                }
+            } else {
+                CUWarn("TILED JSON: Unrecognized layer name: %s", layer.name.c_str());
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * A single pass reader for Tiled JSON exports.
+ *
+ * The reader walks the text once, keeping only the map size, the layer names and the
+ * fields of each object, and skips everything else (tile sets, layer data, editor
+ * settings). Tiled writes keys in alphabetical order, so "tilewidth" comes after
+ * "layers"; this is why the layers are collected first and converted at the end.
+ */
+class TiledReader {
+private:
+    /** The current position in the text */
+    const char *_pos;
+    /** The end of the text */
+    const char *_end;
+    /** A scratch buffer for skipped strings */
+    std::string _scratch;
+
+    /** Skips any whitespace at the current position */
+    void skipSpace() {
+        while (_pos < _end && (*_pos == ' ' || *_pos == '\n' || *_pos == '\r' || *_pos == '\t')) {
+            _pos++;
+        }
+    }
+
+    /** Consumes the given character (after any whitespace), returning false if it is not next */
+    bool expect(char c) {
+        skipSpace();
+        if (_pos < _end && *_pos == c) {
+            _pos++;
+            return true;
+        }
+        return false;
+    }
+
+    /** Returns the next non-whitespace character, without consuming it */
+    char peek() {
+        skipSpace();
+        return _pos < _end ? *_pos : '\0';
+    }
+
+    /** Appends the code point to the string as UTF-8 */
+    static void appendUTF8(std::string &out, unsigned int code) {
+        if (code < 0x80) {
+            out += (char)code;
+        } else if (code < 0x800) {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        } else {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    /** Reads a string value into out */
+    bool readString(std::string &out) {
+        out.clear();
+        if (!expect('"')) {
+            return false;
+        }
+        while (_pos < _end && *_pos != '"') {
+            if (*_pos != '\\') {
+                out += *_pos++;
+                continue;
+            }
+            if (++_pos >= _end) {
+                return false;
+            }
+            switch (*_pos++) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u':
+                    if (_end - _pos < 4) {
+                        return false;
+                    } else {
+                        std::string hex(_pos, 4);
+                        appendUTF8(out, (unsigned int)strtoul(hex.c_str(), nullptr, 16));
+                        _pos += 4;
+                    }
+                    break;
+                default:
+                    out += _pos[-1];
+                    break;
+            }
+        }
+        return expect('"');
+    }
+
+    /** Reads a number value into out */
+    bool readNumber(float &out) {
+        skipSpace();
+        char *stop = nullptr;
+        double value = strtod(_pos, &stop);
+        if (stop == _pos || stop > _end) {
+            return false;
+        }
+        _pos = stop;
+        out = (float)value;
+        return true;
+    }
+
+    /** Consumes the given literal (true, false or null) */
+    bool readLiteral(const char *literal) {
+        size_t len = strlen(literal);
+        if ((size_t)(_end - _pos) < len || strncmp(_pos, literal, len) != 0) {
+            return false;
+        }
+        _pos += len;
+        return true;
+    }
+
+    /**
+     * Reads an object, calling the handler on each key.
+     *
+     * The handler must consume the value of the key (or skip it).
+     */
+    template <typename F>
+    bool readObject(F handler) {
+        if (!expect('{')) {
+            return false;
+        }
+        if (expect('}')) {
+            return true;
+        }
+        std::string key;
+        do {
+            if (!readString(key) || !expect(':') || !handler(key)) {
+                return false;
+            }
+        } while (expect(','));
+        return expect('}');
+    }
+
+    /**
+     * Reads an array, calling the handler on each element.
+     *
+     * The handler must consume the element (or skip it).
+     */
+    template <typename F>
+    bool readArray(F handler) {
+        if (!expect('[')) {
+            return false;
+        }
+        if (expect(']')) {
+            return true;
+        }
+        do {
+            if (!handler()) {
+                return false;
+            }
+        } while (expect(','));
+        return expect(']');
+    }
+
+    /** Skips the next value, whatever its type */
+    bool skipValue() {
+        switch (peek()) {
+            case '{':
+                return readObject([this](const std::string &) { return skipValue(); });
+            case '[':
+                return readArray([this]() { return skipValue(); });
+            case '"':
+                return readString(_scratch);
+            case 't':
+                return readLiteral("true");
+            case 'f':
+                return readLiteral("false");
+            case 'n':
+                return readLiteral("null");
+            default: {
+                float value;
+                return readNumber(value);
+            }
+        }
+    }
+
+    /** Reads a custom property of an object, keeping the ones wheat tiles use */
+    bool readProperty(TiledObject &object) {
+        std::string name;
+        std::string text;
+        float number = 0;
+        bool ok = readObject([&](const std::string &key) {
+            if (key == "name") {
+                return readString(name);
+            } else if (key == "value") {
+                if (peek() == '"') {
+                    return readString(text);
+                } else if (peek() == '-' || (peek() >= '0' && peek() <= '9')) {
+                    return readNumber(number);
+                }
+            }
+            return skipValue();
+        });
+        if (name == "name") {
+            object.name = text;
+        } else if (name == "blade_color_scale") {
+            object.bladeColorScale = number;
+        }
+        return ok;
+    }
+
+    /** Reads a Tiled object */
+    bool readTiledObject(TiledObject &object) {
+        return readObject([&](const std::string &key) {
+            if (key == "x") {
+                return readNumber(object.x);
+            } else if (key == "y") {
+                return readNumber(object.y);
+            } else if (key == "width") {
+                return readNumber(object.width);
+            } else if (key == "height") {
+                return readNumber(object.height);
+            } else if (key == "type") {
+                return readString(object.type);
+            } else if (key == "properties") {
+                return readArray([&]() { return readProperty(object); });
+            }
+            return skipValue();
+        });
+    }
+
+    /** Reads a Tiled layer */
+    bool readLayer(TiledLayer &layer) {
+        return readObject([&](const std::string &key) {
+            if (key == "name") {
+                return readString(layer.name);
+            } else if (key == "objects") {
+                return readArray([&]() {
+                    layer.objects.emplace_back();
+                    return readTiledObject(layer.objects.back());
+                });
+            }
+            return skipValue();
+        });
+    }
+
+public:
+    /**
+     * Reads the layers and map size of a Tiled export.
+     *
+     * @param text      The contents of the Tiled JSON file
+     * @param layers    The vector to store the layers
+     * @param tileSize  The variable to store the tile width
+     * @param height    The variable to store the map height (in tiles)
+     *
+     * @return true if the text was well-formed
+     */
+    bool read(const std::string &text, std::vector<TiledLayer> &layers, float &tileSize, float &height) {
+        _pos = text.c_str();
+        _end = _pos + text.size();
+        bool ok = readObject([&](const std::string &key) {
+            if (key == "height") {
+                return readNumber(height);
+            } else if (key == "tilewidth") {
+                return readNumber(tileSize);
+            } else if (key == "layers") {
+                return readArray([&]() {
+                    layers.emplace_back();
+                    return readLayer(layers.back());
+                });
+            }
+            return skipValue();
+        });
+        return ok && peek() == '\0';
+    }
+};
+
+}
+
+#pragma mark -
+#pragma mark Constructors
+
+/**
+ * Removes the wheat tile and every spawn of this unit.
+ */
+void MapUnit::clear() {
+    wheatName.clear();
+    bladeColorScale = 0;
+    plantingSpawns.clear();
+    farmerSpawns.clear();
+    babyCarrotSpawns.clear();
+    carrotSpawns.clear();
+}
+
+/**
+ * Initializes this unit from the text of a Tiled JSON export.
+ *
+ * The text is read in a single pass, and only the values used by round
+ * generation are kept. No JsonValue tree is built.
+ *
+ * @param text  The contents of the Tiled JSON file
+ *
+ * @return true if the text was a well-formed Tiled map
+ */
+bool MapUnit::initWithTiled(const std::string &text) {
+    std::vector<TiledLayer> layers;
+    float tileSize = 0;
+    float height = 0;
+    TiledReader reader;
+    if (!reader.read(text, layers, tileSize, height) || tileSize <= 0) {
+        return false;
+    }
+    buildUnit(*this, layers, (int)tileSize, (int)height);
+    return true;
+}
+
+/**
+ * Initializes this unit from a Tiled JSON export that is already loaded.
+ *
+ * @param json  The root of the Tiled JSON
+ *
+ * @return true if the json was a well-formed Tiled map
+ */
+bool MapUnit::initWithJson(const std::shared_ptr<JsonValue> &json) {
+    std::shared_ptr<JsonValue> jlayers = json == nullptr ? nullptr : json->get("layers");
+    int tileSize = json == nullptr ? 0 : json->getInt("tilewidth");
+    if (jlayers == nullptr || tileSize <= 0) {
+        return false;
+    }
+
+    std::vector<TiledLayer> layers;
+    for (auto &jlayer : jlayers->children()) {
+        layers.emplace_back();
+        TiledLayer &layer = layers.back();
+        layer.name = jlayer->getString("name");
+        auto objects = jlayer->get("objects");
+        if (objects == nullptr) {
+            continue;
+        }
+        for (auto &jobject : objects->children()) {
+            layer.objects.emplace_back();
+            TiledObject &object = layer.objects.back();
+            object.x = jobject->getFloat("x");
+            object.y = jobject->getFloat("y");
+            object.width = jobject->getFloat("width");
+            object.height = jobject->getFloat("height");
+            object.type = jobject->getString("type");
+            auto properties = jobject->get("properties");
+            if (properties == nullptr) {
+                continue;
+            }
+            for (auto &property : properties->children()) {
+                std::string name = property->getString("name");
+                if (name == "name") {
+                    object.name = property->getString("value");
+                } else if (name == "blade_color_scale") {
+                    object.bladeColorScale = property->getFloat("value");
+                }
+            }
+        }
+    }
+    buildUnit(*this, layers, tileSize, json->getFloat("height"));
+    return true;
+}
+
+#pragma mark -
+#pragma mark Attributes
+
+/**
+ * Returns a read-only view of this unit.
+ *
+ * The view is invalidated by any change to this unit.
+ *
+ * @return a read-only view of this unit
+ */
+MapUnit::View MapUnit::view() const {
+    View result;
+    result.wheatName = wheatName;
+    result.bladeColorScale = bladeColorScale;
+    result.plantingSpawns = {plantingSpawns.data(), plantingSpawns.size()};
+    result.farmerSpawns = {farmerSpawns.data(), farmerSpawns.size()};
+    result.babyCarrotSpawns = {babyCarrotSpawns.data(), babyCarrotSpawns.size()};
+    result.carrotSpawns = {carrotSpawns.data(), carrotSpawns.size()};
+    return result;
+}
@@ -0,0 +1,119 @@
+//
+//  MapUnit.h
+//  Rooted
+//
+//  The parts of a Tiled map unit that round generation needs: the wheat tile, its blade color
+//  scale and the spawn rectangles of each object type. Units are read once when the map is
+//  initialized, either by streaming the Tiled export (without building a JsonValue tree) or
+//  from a JsonValue that is already loaded, and are then placed on the grid every round.
+//
+
+#ifndef MapUnit_h
+#define MapUnit_h
+
+#include <cugl/cugl.h>
+#include <string_view>
+
+using namespace cugl;
+
+/**
+ * A single Tiled map unit, in physics coordinates relative to the bottom left of the unit.
+ *
+ * Every spawn rectangle has its origin at the center of the Tiled object.
+ */
+class MapUnit {
+public:
+    /** A read-only range of spawn rectangles */
+    struct Spawns {
+        /** The first rectangle of the range */
+        const Rect *data = nullptr;
+        /** The number of rectangles in the range */
+        size_t size = 0;
+
+        const Rect *begin() const { return data; }
+        const Rect *end() const { return data + size; }
+    };
+
+    /**
+     * A read-only view of a map unit.
+     *
+     * A view does not own its data, which may belong to a MapUnit or live inside
+     * a cooked {@link MapUnitPack}. It is only valid as long as its owner is.
+     */
+    struct View {
+        /** The name of the wheat tile of the unit */
+        std::string_view wheatName;
+        /** The blade color scale of the wheat tile */
+        float bladeColorScale = 0;
+        /** The planting spots of the unit */
+        Spawns plantingSpawns;
+        /** The farmer spawns of the unit */
+        Spawns farmerSpawns;
+        /** The baby carrot spawns of the unit */
+        Spawns babyCarrotSpawns;
+        /** The carrot spawns of the unit */
+        Spawns carrotSpawns;
+    };
+
+    /** The name of the wheat tile of this unit */
+    std::string wheatName;
+    /** The blade color scale of the wheat tile */
+    float bladeColorScale;
+    /** The planting spots of this unit */
+    std::vector<Rect> plantingSpawns;
+    /** The farmer spawns of this unit */
+    std::vector<Rect> farmerSpawns;
+    /** The baby carrot spawns of this unit */
+    std::vector<Rect> babyCarrotSpawns;
+    /** The carrot spawns of this unit */
+    std::vector<Rect> carrotSpawns;
+
+#pragma mark -
+#pragma mark Constructors
+
+    /**
+     * Creates an empty map unit.
+     */
+    MapUnit() : bladeColorScale(0) {}
+
+    /**
+     * Removes the wheat tile and every spawn of this unit.
+     */
+    void clear();
+
+    /**
+     * Initializes this unit from the text of a Tiled JSON export.
+     *
+     * The text is read in a single pass, and only the values used by round
+     * generation are kept. No JsonValue tree is built.
+     *
+     * @param text  The contents of the Tiled JSON file
+     *
+     * @return true if the text was a well-formed Tiled map
+     */
+    bool initWithTiled(const std::string &text);
+
+    /**
+     * Initializes this unit from a Tiled JSON export that is already loaded.
+     *
+     * @param json  The root of the Tiled JSON
+     *
+     * @return true if the json was a well-formed Tiled map
+     */
+    bool initWithJson(const std::shared_ptr<JsonValue> &json);
+
+#pragma mark -
+#pragma mark Attributes
+
+    /**
+     * Returns a read-only view of this unit.
+     *
+     * The view is invalidated by any change to this unit.
+     *
+     * @return a read-only view of this unit
+     */
+    View view() const;
+
+};
+
+#endif /* MapUnit_h */
@@ -0,0 +1,262 @@
+//
+//  MapUnitPack.cpp
+//  Rooted
+//
+//  A cooked, read-only set of map units. The pack is written offline by the map cooker
+//  (tools/mapcooker) from the Tiled exports, and is memory-mapped by the game so that
+//  every unit is a view into the file itself: no parsing and no copies.
+//
+
+#include "MapUnitPack.h"
+#include <SDL_rwops.h>
+#include <cstring>
+#include <type_traits>
+
+#if !defined (__WINDOWS__)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace cugl;
+
+/** The number of spawn types in an entry */
+#define SPAWN_TYPES 4
+
+/** The header of a pack */
+struct PackHeader {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 count;
+};
+
+/** The entry of a single unit in a pack */
+struct PackEntry {
+    Uint32 nameOffset;
+    Uint32 nameLength;
+    Uint32 wheatOffset;
+    Uint32 wheatLength;
+    float  bladeColorScale;
+    /** The (offset, count) of the planting, farmer, baby carrot and carrot spawns */
+    Uint32 spawns[SPAWN_TYPES][2];
+};
+
+// Spawns are viewed in place, so a Rect must be exactly four packed floats
+static_assert(sizeof(Rect) == 4 * sizeof(float) && std::is_standard_layout<Rect>::value,
+              "Rect does not match the cooked spawn layout");
+static_assert(sizeof(PackHeader) == 12 && sizeof(PackEntry) == 52, "Unexpected padding in the pack layout");
+
+const Uint32 MapUnitPack::MAGIC = 0x50414D52; // "RMAP"
+const Uint32 MapUnitPack::VERSION = 1;
+
+#pragma mark -
+#pragma mark Constructors
+
+/**
+ * Creates an empty pack.
+ */
+MapUnitPack::MapUnitPack() :
+        _data(nullptr),
+        _size(0),
+        _mapping(nullptr) {
+}
+
+/**
+ * Unmaps the file of this pack, invalidating every view into it.
+ */
+void MapUnitPack::dispose() {
+#if !defined (__WINDOWS__)
+    if (_mapping) {
+        munmap(_mapping, _size);
+    }
+#endif
+    _mapping = nullptr;
+    _buffer.clear();
+    _index.clear();
+    _data = nullptr;
+    _size = 0;
+}
+
+/**
+ * Initializes this pack from the given file.
+ *
+ * The file is memory-mapped if the platform allows it, and read into memory
+ * otherwise.
+ *
+ * @param file  The path to the pack
+ *
+ * @return true if the file is a valid pack
+ */
+bool MapUnitPack::init(const std::string &file) {
+    if (_data) {
+        CUAssertLog(false, "Pack is already initialized");
+        return false;
+    }
+#if SDL_BYTEORDER != SDL_LIL_ENDIAN
+    // Units are viewed in place, and packs are cooked little-endian
+    return false;
+#endif
+    std::string path = filetool::normalize_path(file);
+
+#if !defined (__WINDOWS__)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void *addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                _mapping = addr;
+                _size = info.st_size;
+                _data = static_cast<const std::byte *>(addr);
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    // Fall back to reading the pack into memory
+    if (_data == nullptr) {
+        SDL_RWops *stream = SDL_RWFromFile(path.c_str(), "rb");
+        if (stream == nullptr) {
+            return false;
+        }
+        Sint64 size = SDL_RWsize(stream);
+        _buffer.resize(size > 0 ? size : 0);
+        size_t total = _buffer.empty() ? 0 : SDL_RWread(stream, _buffer.data(), 1, _buffer.size());
+        SDL_RWclose(stream);
+        _buffer.resize(total);
+        _data = _buffer.data();
+        _size = _buffer.size();
+    }
+
+    if (!validate()) {
+        CULogError("'%s' is not a valid map unit pack", path.c_str());
+        dispose();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Initializes this pack from the given file, relative to the asset directory.
+ *
+ * @param file  The path to the pack, relative to the asset directory
+ *
+ * @return true if the file is a valid pack
+ */
+bool MapUnitPack::initWithAsset(const std::string &file) {
+    return init(Application::get()->getAssetDirectory() + file);
+}
+
+/**
+ * Returns true if the header and every entry of the pack are within bounds.
+ */
+bool MapUnitPack::validate() {
+    PackHeader header;
+    if (_size < sizeof(PackHeader)) {
+        return false;
+    }
+    std::memcpy(&header, _data, sizeof(PackHeader));
+    if (header.magic != MAGIC || header.version != VERSION ||
+        header.count > (_size - sizeof(PackHeader)) / sizeof(PackEntry)) {
+        return false;
+    }
+
+    auto inside = [this](Uint32 offset, size_t bytes) {
+        return offset <= _size && bytes <= _size - offset;
+    };
+    for (Uint32 ii = 0; ii < header.count; ii++) {
+        PackEntry entry;
+        std::memcpy(&entry, _data + sizeof(PackHeader) + ii * sizeof(PackEntry), sizeof(PackEntry));
+        if (!inside(entry.nameOffset, entry.nameLength) || !inside(entry.wheatOffset, entry.wheatLength)) {
+            return false;
+        }
+        for (int jj = 0; jj < SPAWN_TYPES; jj++) {
+            Uint32 offset = entry.spawns[jj][0];
+            if (offset % alignof(Rect) != 0 || !inside(offset, (size_t)entry.spawns[jj][1] * sizeof(Rect))) {
+                return false;
+            }
+        }
+        std::string name((const char *)_data + entry.nameOffset, entry.nameLength);
+        _index.emplace(name, ii);
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Unit Access
+
+/**
+ * Returns a view of the unit with the given name.
+ *
+ * The view points into this pack, and is only valid until it is disposed.
+ * This method fails if there is no unit with this name.
+ *
+ * @param name  The name of the unit
+ *
+ * @return a view of the unit with the given name
+ */
+MapUnit::View MapUnitPack::get(const std::string &name) const {
+    MapUnit::View result;
+    auto it = _index.find(name);
+    CUAssertLog(it != _index.end(), "There is no map unit %s in the pack", name.c_str());
+    if (it == _index.end()) {
+        return result;
+    }
+
+    PackEntry entry;
+    std::memcpy(&entry, _data + sizeof(PackHeader) + it->second * sizeof(PackEntry), sizeof(PackEntry));
+    result.wheatName = std::string_view((const char *)_data + entry.wheatOffset, entry.wheatLength);
+    result.bladeColorScale = entry.bladeColorScale;
+    MapUnit::Spawns *spawns[SPAWN_TYPES] = {&result.plantingSpawns, &result.farmerSpawns,
+                                            &result.babyCarrotSpawns, &result.carrotSpawns};
+    for (int jj = 0; jj < SPAWN_TYPES; jj++) {
+        spawns[jj]->data = reinterpret_cast<const Rect *>(_data + entry.spawns[jj][0]);
+        spawns[jj]->size = entry.spawns[jj][1];
+    }
+    return result;
+}
+
+#pragma mark -
+#pragma mark Cooking
+
+/**
+ * Returns the pack of the given units.
+ *
+ * @param names The name of each unit
+ * @param units The units, in the same order as the names
+ *
+ * @return the bytes of the pack
+ */
+std::vector<std::byte> MapUnitPack::cook(const std::vector<std::string> &names, const std::vector<MapUnit> &units) {
+    CUAssertLog(names.size() == units.size(), "There must be one name per unit");
+    std::vector<std::byte> result(sizeof(PackHeader) + units.size() * sizeof(PackEntry));
+    auto append = [&](const void *data, size_t bytes) {
+        Uint32 offset = (Uint32)result.size();
+        const std::byte *start = static_cast<const std::byte *>(data);
+        result.insert(result.end(), start, start + bytes);
+        result.resize((result.size() + 3) & ~(size_t)3);
+        return offset;
+    };
+
+    PackHeader header = {MAGIC, VERSION, (Uint32)units.size()};
+    std::memcpy(result.data(), &header, sizeof(PackHeader));
+    for (size_t ii = 0; ii < units.size(); ii++) {
+        const MapUnit &unit = units[ii];
+        const std::vector<Rect> *spawns[SPAWN_TYPES] = {&unit.plantingSpawns, &unit.farmerSpawns,
+                                                        &unit.babyCarrotSpawns, &unit.carrotSpawns};
+        PackEntry entry;
+        for (int jj = 0; jj < SPAWN_TYPES; jj++) {
+            entry.spawns[jj][0] = append(spawns[jj]->data(), spawns[jj]->size() * sizeof(Rect));
+            entry.spawns[jj][1] = (Uint32)spawns[jj]->size();
+        }
+        entry.nameOffset = append(names[ii].data(), names[ii].size());
+        entry.nameLength = (Uint32)names[ii].size();
+        entry.wheatOffset = append(unit.wheatName.data(), unit.wheatName.size());
+        entry.wheatLength = (Uint32)unit.wheatName.size();
+        entry.bladeColorScale = unit.bladeColorScale;
+        std::memcpy(result.data() + sizeof(PackHeader) + ii * sizeof(PackEntry), &entry, sizeof(PackEntry));
+    }
+    return result;
+}
@@ -0,0 +1,138 @@
+//
+//  MapUnitPack.h
+//  Rooted
+//
+//  A cooked, read-only set of map units. The pack is written offline by the map cooker
+//  (tools/mapcooker) from the Tiled exports, and is memory-mapped by the game so that
+//  every unit is a view into the file itself: no parsing and no copies.
+//
+//  All values are stored in little-endian order and aligned to four bytes:
+//
+//      header:  magic "RMAP" | version | unit count
+//      entry:   name offset, length | wheat name offset, length | blade color scale |
+//               (offset, count) of the planting, farmer, baby carrot and carrot spawns
+//      data:    per unit, its spawn rectangles as four floats (x, y, width, height),
+//               then its name and wheat name
+//
+//  Offsets are in bytes from the start of the pack.
+//
+
+#ifndef MapUnitPack_h
+#define MapUnitPack_h
+
+#include <cugl/cugl.h>
+#include "MapUnit.h"
+
+using namespace cugl;
+
+/**
+ * A memory-mapped set of cooked map units, indexed by name.
+ */
+class MapUnitPack {
+private:
+    /** The start of the pack (mapped or buffered) */
+    const std::byte *_data;
+    /** The size of the pack in bytes */
+    size_t _size;
+    /** The memory mapping of the pack (nullptr if it is buffered) */
+    void *_mapping;
+    /** The contents of the pack, if it could not be mapped */
+    std::vector<std::byte> _buffer;
+    /** The entry of each unit, by name */
+    std::unordered_map<std::string, Uint32> _index;
+
+    /**
+     * Returns true if the header and every entry of the pack are within bounds.
+     */
+    bool validate();
+
+public:
+    /** The first four bytes of every pack */
+    static const Uint32 MAGIC;
+    /** The version of the pack layout */
+    static const Uint32 VERSION;
+
+#pragma mark -
+#pragma mark Constructors
+
+    /**
+     * Creates an empty pack.
+     */
+    MapUnitPack();
+
+    /**
+     * Deletes this pack, unmapping the file.
+     */
+    ~MapUnitPack() { dispose(); }
+
+    /**
+     * Unmaps the file of this pack, invalidating every view into it.
+     */
+    void dispose();
+
+    /**
+     * Initializes this pack from the given file.
+     *
+     * The file is memory-mapped if the platform allows it, and read into memory
+     * otherwise.
+     *
+     * @param file  The path to the pack
+     *
+     * @return true if the file is a valid pack
+     */
+    bool init(const std::string &file);
+
+    /**
+     * Initializes this pack from the given file, relative to the asset directory.
+     *
+     * @param file  The path to the pack, relative to the asset directory
+     *
+     * @return true if the file is a valid pack
+     */
+    bool initWithAsset(const std::string &file);
+
+    /** This class holds a mapping, so it cannot be copied */
+    MapUnitPack(const MapUnitPack &) = delete;
+    MapUnitPack &operator=(const MapUnitPack &) = delete;
+
+#pragma mark -
+#pragma mark Unit Access
+
+    /**
+     * Returns the number of units in this pack.
+     */
+    size_t size() const { return _index.size(); }
+
+    /**
+     * Returns true if this pack has a unit with the given name.
+     */
+    bool has(const std::string &name) const { return _index.find(name) != _index.end(); }
+
+    /**
+     * Returns a view of the unit with the given name.
+     *
+     * The view points into this pack, and is only valid until it is disposed.
+     * This method fails if there is no unit with this name.
+     *
+     * @param name  The name of the unit
+     *
+     * @return a view of the unit with the given name
+     */
+    MapUnit::View get(const std::string &name) const;
+
+#pragma mark -
+#pragma mark Cooking
+
+    /**
+     * Returns the pack of the given units.
+     *
+     * @param names The name of each unit
+     * @param units The units, in the same order as the names
+     *
+     * @return the bytes of the pack
+     */
+    static std::vector<std::byte> cook(const std::vector<std::string> &names, const std::vector<MapUnit> &units);
+
+};
+
+#endif /* MapUnitPack_h */
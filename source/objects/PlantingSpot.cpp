@@ -22,7 +22,27 @@ void PlantingSpot::dispose() {
     _node = nullptr;
 }
 
+/**
+ * Restores this planting spot to the state of a new one, so that it can be recycled.
+ *
+ * The tile nodes are detached from their parent but kept, and are reused by
+ * {@link #setSceneNode} if the next spot has the same size.
+ */
+void PlantingSpot::reset() {
+    BoxObstacle::reset();
+    if (_node != nullptr) {
+        _node->removeFromParent();
+    }
+    _isCarrotPlanted = false;
+    _belowAvatar = false;
+    _plantingID = 0;
+}
+
 void PlantingSpot::setSceneNode(const std::shared_ptr<cugl::AssetManager> &assets, float priority) {
+    if (_node != nullptr && _node->getContentSize() == _drawScale * _dimension) {
+        _node->setPriority(priority);
+        return;
+    }
     _node = scene2::SceneNode::allocWithBounds((Rect(Vec2::ZERO, _drawScale * _dimension)));
     _node->setAnchor(Vec2::ANCHOR_CENTER);
     _node->setPriority(priority);
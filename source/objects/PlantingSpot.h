@@ -48,6 +48,14 @@ public:
      * disposed, a planting spot may not be used until it is initialized again.
      */
     void dispose();
+
+    /**
+     * Restores this planting spot to the state of a new one, so that it can be recycled.
+     *
+     * The tile nodes are detached from their parent but kept, and are reused by
+     * {@link #setSceneNode} if the next spot has the same size.
+     */
+    void reset() override;
     
     /**
      * Standard constructor
@@ -76,6 +84,9 @@ public:
     /**
      * Sets the scene graph node representing this planting spot.
      *
+     * The tile nodes of a recycled planting spot are reused if they have the
+     * right size.
+     *
      * @param node  The scene graph node representing this planting spot, which has
      *              been added to the world node already.
      */
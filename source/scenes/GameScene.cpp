@@ -8,6 +8,7 @@
 #include <box2d/b2_collision.h>
 #include "../objects/EntityModel.h"
 #include "../RootedConstants.h"
+#include "../controllers/ProfilerController.h"
 
 #include <ctime>
 #include <string>
@@ -82,7 +83,10 @@ bool GameScene::init(const std::shared_ptr<AssetManager> &assets) {
     _rootnode->setContentSize(Size(SCENE_WIDTH, SCENE_HEIGHT));
         
     _seed = hex2dec(_network->getRoomID());
-    _map = Map::alloc(_assets); // Obtains ownership of root.
+    _roundBuilder = JobSystem::alloc(1);
+    _physicsJobs = PHYSICS_THREADS > 0 ? JobSystem::alloc(PHYSICS_THREADS) : nullptr;
+    _entities = EntityPool::alloc();
+    _map = Map::alloc(_assets, _entities); // Obtains ownership of root.
 //    if (!_map->populate()) {
 //        CULog("Failed to populate map");
 //        return false;
@@ -98,7 +102,9 @@ bool GameScene::init(const std::shared_ptr<AssetManager> &assets) {
 
     // Create the world and attach the listeners.
     std::shared_ptr<physics2::ObstacleWorld> world = _map->getWorld();
+    world->setJobSystem(_physicsJobs);
     activateWorldCollisions(world);
+    activateStateHashing(_map->getWorld());
     
     // IMPORTANT: SCALING MUST BE UNIFORM
     // This means that we cannot change the aspect ratio of the physics world
@@ -113,7 +119,17 @@ bool GameScene::init(const std::shared_ptr<AssetManager> &assets) {
     _input = InputController::alloc(getBounds());
     Haptics::start();
     _collision.init(_map, _network);
-    _action.init(_map, _input, _network, _assets);
+    _network->setLockstep(LOCKSTEP_ENABLED);
+    if (NET_RECORD_ENABLED && _network->getRecorder() == nullptr) {
+        std::string path = Application::get()->getSaveDirectory() + NET_RECORD_FILE;
+        auto recorder = NetEventRecorder::alloc(path);
+        if (recorder) {
+            _network->startRecording(recorder);
+        } else {
+            CUWarn("Could not open %s for recording", path.c_str());
+        }
+    }
+    _action.init(_map, _input, _network, _assets, _seed);
     _active = true;
     _complete = false;
     setDebug(false);
@@ -124,16 +140,24 @@ bool GameScene::init(const std::shared_ptr<AssetManager> &assets) {
         _map->acquireMapOwnership();
         _babies = _map->loadBabyEntities();
     }
-    _character = _map->loadPlayerEntities(_network->getOrderedPlayers(), _network->getNetcode()->getHost(), _network->getNetcode()->getUUID());
+    _farmerUUID = _network->getNetcode()->getHost();
+    _character = _map->loadPlayerEntities(_network->getOrderedPlayers(), _farmerUUID, _network->getNetcode()->getUUID());
     
-    std::shared_ptr<NetWorld> w = _map->getWorld();
-    _network->enablePhysics(w);
-    if (!_network->isHost()) {
-        _network->getPhysController()->acquireObs(_character, 0);
+    if (_network->isLockstep()) {
+        // Peers simulate the same world from inputs alone, so no obstacle sync
+        _network->attachEventType<InputEvent>();
+        _lockstep.init(_network, _seed, LOCKSTEP_DELAY);
     } else {
-        for (auto baby : _babies) {
-            _network->getPhysController()->acquireObs(baby, 0);
+        std::shared_ptr<NetWorld> w = _map->getWorld();
+        _network->enablePhysics(w);
+        if (!_network->isHost()) {
+            _network->getPhysController()->acquireObs(_character, 0);
+        } else {
+            for (auto baby : _babies) {
+                _network->getPhysController()->acquireObs(baby, 0);
+            }
         }
+        activateHostMigration();
     }
     
     _network->attachEventType<ResetEvent>();
@@ -188,9 +212,21 @@ void GameScene::dispose() {
         _collision.dispose();
         _action.dispose();
         _ui.dispose();
+        if (_network) {
+            _network->onSaveState = nullptr;
+            _network->onRestoreState = nullptr;
+            _network->onPromotion = nullptr;
+        }
         _complete = false;
         _debug = false;
+        if (_nextMap != nullptr) {
+            _roundBuilder->wait(_nextBuilt);
+            _nextMap = nullptr;
+        }
+        _roundBuilder = nullptr;
         _map = nullptr;
+        _physicsJobs = nullptr;
+        _entities = nullptr;
         _character = nullptr;
         unload();
         Scene2::dispose();
@@ -216,38 +252,47 @@ void GameScene::unload() {
 void GameScene::reset() {
     // Load a new level
     _seed++;
+    // After a host migration the farmer has left, and every player is a carrot
+    auto players = _network->getOrderedPlayers();
+    int numCarrots = (int)players.size() - (int)std::count(players.begin(), players.end(), _farmerUUID);
+    std::shared_ptr<Map> next = takeNextRound(_seed, numCarrots);
     _map->clearRootNode();
     _map->dispose();
-    _map->generate(_seed, 1, _network->getNumPlayers() - 1, 20, 8);
-    _map->setRootNode(_rootnode);
-    _map->populate();
+    _map = next;
+    _map->finalize();
 
     _ui.dispose();
     _collision.dispose();
     _action.dispose();
 
     std::shared_ptr<physics2::ObstacleWorld> world = _map->getWorld();
+    world->setJobSystem(_physicsJobs);
     activateWorldCollisions(world);
+    activateStateHashing(_map->getWorld());
 
     _map->resetPlantingSpots();
     _map->resetPlayers();
     
     _collision.init(_map, _network);
-    _action.init(_map, _input, _network, _assets);
+    _action.init(_map, _input, _network, _assets, _seed);
 
-    if (_isHost) {
+    if (_network->isHost()) {
         _map->acquireMapOwnership();
         _babies = _map->loadBabyEntities();
     }
-    _character = _map->loadPlayerEntities(_network->getOrderedPlayers(), _network->getNetcode()->getHost(), _network->getNetcode()->getUUID());
+    _character = _map->loadPlayerEntities(players, _farmerUUID, _network->getNetcode()->getUUID());
     
-    std::shared_ptr<NetWorld> w = _map->getWorld();
-    _network->enablePhysics(w);
-    if (!_network->isHost()) {
-        _network->getPhysController()->acquireObs(_character, 0);
+    if (_network->isLockstep()) {
+        _lockstep.reset(_seed);
     } else {
-        for (auto baby : _babies) {
-            _network->getPhysController()->acquireObs(baby, 0);
+        std::shared_ptr<NetWorld> w = _map->getWorld();
+        _network->enablePhysics(w);
+        if (!_network->isHost()) {
+            _network->getPhysController()->acquireObs(_character, 0);
+        } else {
+            for (auto baby : _babies) {
+                _network->getPhysController()->acquireObs(baby, 0);
+            }
         }
     }
     
@@ -269,6 +314,63 @@ void GameScene::reset() {
     setFailure(false);
 }
 
+/**
+ * Starts building the next round on a worker thread, unless one is pending.
+ *
+ * This is called when the end of round countdown starts, so that the reset
+ * only has to swap the maps and create the shaders.
+ */
+void GameScene::prepareNextRound() {
+    if (_nextMap != nullptr || _roundBuilder == nullptr) {
+        return;
+    }
+    auto players = _network->getOrderedPlayers();
+    _nextSeed = _seed + 1;
+    _nextCarrots = (int)players.size() - (int)std::count(players.begin(), players.end(), _farmerUUID);
+    _nextMap = Map::alloc(_assets, _entities);
+
+    // The worker only touches the new map, which nothing else sees until the reset
+    std::shared_ptr<Map> next = _nextMap;
+    std::shared_ptr<scene2::SceneNode> root = _rootnode;
+    int seed = _nextSeed;
+    int numCarrots = _nextCarrots;
+    _roundBuilder->submit([next, root, seed, numCarrots]() {
+        next->generate(seed, 1, numCarrots, 20, 8);
+        next->setRootNode(root);
+        next->build();
+    }, &_nextBuilt);
+}
+
+/**
+ * Returns the next round, built but not finalized.
+ *
+ * If the pending round was built with a different seed or number of carrots
+ * (e.g. a player left during the countdown), or there is no pending round,
+ * the round is built now instead.
+ *
+ * @param seed          The seed of the next round
+ * @param numCarrots    The number of carrots in the next round
+ *
+ * @return the next round, built but not finalized
+ */
+std::shared_ptr<Map> GameScene::takeNextRound(int seed, int numCarrots) {
+    std::shared_ptr<Map> next = nullptr;
+    if (_nextMap != nullptr) {
+        _roundBuilder->wait(_nextBuilt);
+        if (_nextSeed == seed && _nextCarrots == numCarrots) {
+            next = _nextMap;
+        }
+        _nextMap = nullptr;
+    }
+    if (next == nullptr) {
+        next = Map::alloc(_assets, _entities);
+        next->generate(seed, 1, numCarrots, 20, 8);
+        next->setRootNode(_rootnode);
+        next->build();
+    }
+    return next;
+}
+
 #pragma mark -
 #pragma mark Physics Handling
 
@@ -300,7 +402,19 @@ void GameScene::preUpdate(float dt) {
     _input->update(dt);
 
     // Process the toggled key commands
-    if (_input->didDebug()) { setDebug(!isDebug()); }
+    if (_input->didDebug()) {
+        setDebug(!isDebug());
+        if (!isDebug()) {
+            // Dump the recorded frames when the debug overlay is closed
+            std::string path = Application::get()->getSaveDirectory() + PROFILER_TRACE_FILE;
+            if (!ProfilerController::get()->exportTrace(path)) {
+                CUWarn("Could not write profiler trace to %s", path.c_str());
+            }
+            if (AllocTracker::isEnabled()) {
+                AllocTracker::requestDump();
+            }
+        }
+    }
     if (_input->didReset()) {
         _network->pushOutEvent(ResetEvent::allocResetEvent());
         return;
@@ -310,6 +424,23 @@ void GameScene::preUpdate(float dt) {
         Application::get()->quit();
     }
 
+    if (_network->isLockstep()) {
+        Uint32 flags = 0;
+        if (_input->didDash()) {
+            flags |= InputEvent::DASH;
+        }
+        if (_input->didRoot()) {
+            flags |= InputEvent::ROOT;
+        }
+        if (_input->didUnroot()) {
+            flags |= InputEvent::UNROOT;
+        }
+        if (_action.didEscape()) {
+            flags |= InputEvent::ESCAPE;
+        }
+        _lockstep.addLocalInput(_input->getMovement(), flags);
+    }
+
     _action.preUpdate(dt);
 }
 
@@ -342,39 +473,51 @@ void GameScene::preUpdate(float dt) {
 void GameScene::fixedUpdate(float step) {
     // Turn the physics engine crank.
     while(_network->isInAvailable()){
-        auto e = _network->popInEvent();
-        if(auto captureEvent = std::dynamic_pointer_cast<CaptureEvent>(e)){
-            //            CULog("Received dash event");
-            _action.processCaptureEvent(captureEvent);
-        }
-        if(auto rootEvent = std::dynamic_pointer_cast<RootEvent>(e)){
-            //            std::cout<<"got a root event\n";
-            _action.processRootEvent(rootEvent);
-        }
-        if(auto unrootEvent = std::dynamic_pointer_cast<UnrootEvent>(e)){
-            _action.processUnrootEvent(unrootEvent);
-        }
-        if(auto captureBarrotEvent = std::dynamic_pointer_cast<CaptureBarrotEvent>(e)){
-            _action.processBarrotEvent(captureBarrotEvent);
-        }
-        if(auto resetEvent = std::dynamic_pointer_cast<ResetEvent>(e)){
-            processResetEvent(resetEvent);
-        }
-        if(auto moveEvent = std::dynamic_pointer_cast<MoveEvent>(e)){
-            _action.processMoveEvent(moveEvent);
-        }
-        if(auto freeEvent = std::dynamic_pointer_cast<FreeEvent>(e)){
-            _action.processFreeEvent(freeEvent);
-        }
+        processGameEvent(_network->popInEvent());
     }
     if (_countdown >= 0 && _network->getNumPlayers() > 1){
         return;
     }
     
-    _map->getWorld()->update(step);
+    if (_network->isLockstep()) {
+        // Stall until the inputs of every player for this tick have arrived
+        std::vector<std::shared_ptr<InputEvent>> inputs;
+        if (_lockstep.step(inputs)) {
+            _action.applyInputs(inputs);
+            {
+                PROFILE_SCOPE("NetWorld::update");
+                _map->getWorld()->update(step);
+            }
+            while (_network->isLocalAvailable()) {
+                processGameEvent(_network->popLocalEvent());
+            }
+            _network->hashState(_lockstep.getTick());
+        }
+    } else {
+        {
+            PROFILE_SCOPE("NetWorld::update");
+            _map->getWorld()->update(step);
+        }
+        // Synced worlds only agree up to the network delay, so they are hashed
+        // at the game tick with the coarse SYNC_HASH_PRECISION
+        _network->hashState(_network->getGameTick());
+    }
     _cam.update(step);
     
-    _map->updateShaders(step, _cam.getCamera()->getCombined());
+    // prioritize syncing obstacles near each player's avatar
+    if (auto phys = _network->getPhysController()) {
+        for (auto carrot : _map->getCarrots()) {
+            phys->setPeerFocus(carrot->getUUID(), carrot->getPosition());
+        }
+        for (auto farmer : _map->getFarmers()) {
+            phys->setPeerFocus(farmer->getUUID(), farmer->getPosition());
+        }
+    }
+    
+    {
+        PROFILE_SCOPE("Map::updateShaders");
+        _map->updateShaders(step, _cam.getCamera()->getCombined());
+    }
 
     
     //check if entities are in wheat
@@ -394,7 +537,10 @@ void GameScene::fixedUpdate(float step) {
     }
 
     //resolve queries
-    _map->getWheatScene()->doQueries();
+    {
+        PROFILE_SCOPE("WheatScene::doQueries");
+        _map->getWheatScene()->doQueries();
+    }
     
     //fetch results
     for (auto farmer : _map->getFarmers()) {
@@ -495,7 +641,7 @@ void GameScene::postUpdate(float remain) {
 //        }
     }
     
-    _map->getCharacter()->getSceneNode()->TexturedNode::setIsPlayer(true);
+    _map->getCharacter()->getSceneNode()->setIsPlayer(true);
     
 }
 
@@ -518,6 +664,146 @@ void GameScene::activateWorldCollisions(const std::shared_ptr<physics2::Obstacle
     };
 }
 
+/**
+ * Enables desync detection on the given world, hashing entity states and planting spots
+ * along with the physics state
+ *
+ * @param world the physics world to hash
+ */
+void GameScene::activateStateHashing(const std::shared_ptr<NetWorld> &world) {
+    if (!_network->isLockstep()) {
+        // Clients trail the host by the network delay, so only compare coarsely
+        world->setHashPrecision(SYNC_HASH_PRECISION);
+    }
+    world->onHashObstacle = [](const std::shared_ptr<physics2::Obstacle> &obj) {
+        if (auto entity = std::dynamic_pointer_cast<EntityModel>(obj)) {
+            return (Uint32)entity->getEntityState() + 1;
+        } else if (auto ps = std::dynamic_pointer_cast<PlantingSpot>(obj)) {
+            return ps->getCarrotPlanted() ? 2u : 1u;
+        }
+        return 0u;
+    };
+    _network->enableStateHashing(world);
+}
+
+/**
+ * Registers the snapshot and promotion callbacks for host migration
+ */
+void GameScene::activateHostMigration() {
+    _network->onSaveState = [this](LWSerializer &out) {
+        saveGameState(out);
+    };
+    _network->onRestoreState = [this](LWDeserializer &in) {
+        restoreGameState(in);
+    };
+    _network->onPromotion = [this]() {
+        takeAuthority();
+    };
+}
+
+/**
+ * Writes the game state the physics snapshot does not cover: planting spots,
+ * captured/rooted flags and baby carrot AI targets
+ *
+ * @param out   the serializer to write to
+ */
+void GameScene::saveGameState(LWSerializer &out) {
+    out.writeUint32((Uint32)_map->getPlantingSpots().size());
+    for (auto ps : _map->getPlantingSpots()) {
+        out.writeBool(ps->getCarrotPlanted());
+    }
+    out.writeUint32((Uint32)_map->getCarrots().size());
+    for (auto carrot : _map->getCarrots()) {
+        out.writeBool(carrot->isCaptured());
+        out.writeBool(carrot->isRooted());
+    }
+    out.writeBool(_map->getFarmers().at(0)->isHoldingCarrot());
+    // Captured babies are removed from the map, so babies are matched by id
+    out.writeUint32((Uint32)_map->getBabyCarrots().size());
+    for (auto baby : _map->getBabyCarrots()) {
+        out.writeUint32(baby->getID());
+        out.writeBool(baby->isCaptured());
+        out.writeUint32((Uint32)baby->getState());
+        out.writeFloat(baby->getTarget().x);
+        out.writeFloat(baby->getTarget().y);
+    }
+}
+
+/**
+ * Restores the game state written by {@link #saveGameState}
+ *
+ * @param in    the deserializer to read from
+ */
+void GameScene::restoreGameState(LWDeserializer &in) {
+    auto &spots = _map->getPlantingSpots();
+    Uint32 size = in.readUint32();
+    for (Uint32 ii = 0; ii < size; ii++) {
+        bool planted = in.readBool();
+        if (ii < spots.size()) {
+            spots[ii]->setCarrotPlanted(planted);
+        }
+    }
+    
+    auto &carrots = _map->getCarrots();
+    size = in.readUint32();
+    for (Uint32 ii = 0; ii < size; ii++) {
+        bool captured = in.readBool();
+        bool rooted = in.readBool();
+        if (ii >= carrots.size()) {
+            continue;
+        }
+        auto carrot = carrots[ii];
+        if (rooted != carrot->isRooted()) {
+            rooted ? carrot->gotRooted() : carrot->gotUnrooted();
+        }
+        if (captured != carrot->isCaptured()) {
+            captured ? carrot->gotCaptured() : carrot->escaped();
+        }
+    }
+    
+    auto farmer = _map->getFarmers().at(0);
+    bool holding = in.readBool();
+    if (holding != farmer->isHoldingCarrot()) {
+        holding ? farmer->grabCarrot() : farmer->carrotEscaped();
+    }
+    
+    std::unordered_map<int, std::shared_ptr<BabyCarrot>> babies;
+    for (auto baby : _map->getBabyCarrots()) {
+        babies[baby->getID()] = baby;
+    }
+    size = in.readUint32();
+    for (Uint32 ii = 0; ii < size; ii++) {
+        int id = (int)in.readUint32();
+        bool captured = in.readBool();
+        State state = (State)in.readUint32();
+        Vec2 target;
+        target.x = in.readFloat();
+        target.y = in.readFloat();
+        auto it = babies.find(id);
+        if (it == babies.end()) {
+            continue;
+        }
+        if (captured && !it->second->isCaptured()) {
+            it->second->gotCaptured();
+        }
+        it->second->setState(state);
+        it->second->setTarget(target);
+    }
+}
+
+/**
+ * Takes over the obstacles and AI of the old host after a host migration
+ */
+void GameScene::takeAuthority() {
+    // The farmer left with the old host, so this peer now simulates the map
+    _babies = _map->loadBabyEntities();
+    auto &owned = _map->getWorld()->getOwnedObstacles();
+    for (auto farmer : _map->getFarmers()) {
+        owned.insert({farmer, 0});
+    }
+    _action.takeAuthority(_seed);
+}
+
 void GameScene::pauseNonEssentialAudio(){
     AudioEngine::get()->clear("root-carrot");
     AudioEngine::get()->clear("root-bunny");
@@ -543,6 +829,7 @@ void GameScene::setComplete(bool value) {
         AudioEngine::get()->getMusicQueue()->play(source, false, MUSIC_VOLUME);
         _ui.setWinVisible(true);
         _countdown = EXIT_COUNT;
+        prepareNextRound();
     } else if (!value) {
         _ui.setWinVisible(false);
         _countdown = -1;
@@ -564,6 +851,7 @@ void GameScene::setFailure(bool value) {
         AudioEngine::get()->getMusicQueue()->play(source, false, MUSIC_VOLUME);
         _ui.setLoseVisible(true);
         _countdown = EXIT_COUNT;
+        prepareNextRound();
     } else {
         _ui.setLoseVisible(false);
         _countdown = -1;
@@ -597,8 +885,48 @@ void GameScene::render(const std::shared_ptr<SpriteBatch> &batch) {
 void GameScene::processResetEvent(const std::shared_ptr<ResetEvent>& event){
     _network->disablePhysics();
     while(_network->isInAvailable()){
-        _network->popInEvent();
+        auto e = _network->popInEvent();
+        // Faster peers may already be sending input for the next round
+        if (auto inputEvent = std::dynamic_pointer_cast<InputEvent>(e)) {
+            _lockstep.processInputEvent(inputEvent);
+        }
+    }
+    while(_network->isLocalAvailable()){
+        _network->popLocalEvent();
     }
     reset();
 }
 
+/**
+ * Dispatches a game event (from the network or, in lockstep, produced locally)
+ * to the controller that handles it.
+ */
+void GameScene::processGameEvent(const std::shared_ptr<NetEvent>& e){
+    if(auto captureEvent = std::dynamic_pointer_cast<CaptureEvent>(e)){
+        //            CULog("Received dash event");
+        _action.processCaptureEvent(captureEvent);
+    }
+    if(auto rootEvent = std::dynamic_pointer_cast<RootEvent>(e)){
+        //            std::cout<<"got a root event\n";
+        _action.processRootEvent(rootEvent);
+    }
+    if(auto unrootEvent = std::dynamic_pointer_cast<UnrootEvent>(e)){
+        _action.processUnrootEvent(unrootEvent);
+    }
+    if(auto captureBarrotEvent = std::dynamic_pointer_cast<CaptureBarrotEvent>(e)){
+        _action.processBarrotEvent(captureBarrotEvent);
+    }
+    if(auto resetEvent = std::dynamic_pointer_cast<ResetEvent>(e)){
+        processResetEvent(resetEvent);
+    }
+    if(auto moveEvent = std::dynamic_pointer_cast<MoveEvent>(e)){
+        _action.processMoveEvent(moveEvent);
+    }
+    if(auto freeEvent = std::dynamic_pointer_cast<FreeEvent>(e)){
+        _action.processFreeEvent(freeEvent);
+    }
+    if(auto inputEvent = std::dynamic_pointer_cast<InputEvent>(e)){
+        _lockstep.processInputEvent(inputEvent);
+    }
+}
+
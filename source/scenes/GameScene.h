@@ -18,6 +18,7 @@
 #include "../controllers/UIController.h"
 #include "../controllers/CameraController.h"
 #include "../controllers/NetworkController.h"
+#include "../controllers/LockstepController.h"
 #include "../objects/Map.h"
 #include "../events/ResetEvent.h"
 
@@ -45,6 +46,8 @@ protected:
     UIController _ui;
     /** Controller for camera */
     CameraController _cam;
+    /** Controller for deterministic lockstep (only used if enabled) */
+    LockstepController _lockstep;
     
     // VIEW
     /** Reference to the physics root of the scene graph */
@@ -86,12 +89,29 @@ protected:
     int _countdown;
     /** Host is by default a farmer (will need to change this later) */
     bool _isHost;
+    /** The uuid of the farmer, which stays the original host after a host migration */
+    std::string _farmerUUID;
 
     /** Initial camera position */
     Vec3 _initCamera;
     
     int _seed;
     
+    /** The pool recycling the entities of every round */
+    std::shared_ptr<EntityPool> _entities;
+    /** The worker that builds the next round during the countdown */
+    std::shared_ptr<cugl::JobSystem> _roundBuilder;
+    /** The workers that step the physics world (nullptr to step on the main thread) */
+    std::shared_ptr<cugl::JobSystem> _physicsJobs;
+    /** The next round, built by the worker (nullptr if none is pending) */
+    std::shared_ptr<Map> _nextMap;
+    /** Completes when the worker has built the next round */
+    cugl::JobSystem::Counter _nextBuilt;
+    /** The seed the next round was built with */
+    int _nextSeed;
+    /** The number of carrots the next round was built with */
+    int _nextCarrots;
+    
     
 
 
@@ -320,18 +340,79 @@ public:
      * @param world the physics world to activate world collision callbacks on
      */
     void activateWorldCollisions(const std::shared_ptr<physics2::ObstacleWorld> &world);
+    
+    /**
+     * Enables desync detection on the given world, hashing entity states and planting spots
+     * along with the physics state
+     *
+     * @param world the physics world to hash
+     */
+    void activateStateHashing(const std::shared_ptr<NetWorld> &world);
+    
+    /**
+     * Registers the snapshot and promotion callbacks for host migration
+     */
+    void activateHostMigration();
+    
+    /**
+     * Writes the game state the physics snapshot does not cover: planting spots,
+     * captured/rooted flags and baby carrot AI targets
+     *
+     * @param out   the serializer to write to
+     */
+    void saveGameState(LWSerializer &out);
+    
+    /**
+     * Restores the game state written by {@link #saveGameState}
+     *
+     * @param in    the deserializer to read from
+     */
+    void restoreGameState(LWDeserializer &in);
+    
+    /**
+     * Takes over the obstacles and AI of the old host after a host migration
+     */
+    void takeAuthority();
 
     /**
      * Resets the status of the game so that we can play again.
      */
     void reset();
     
+    /**
+     * Starts building the next round on a worker thread, unless one is pending.
+     *
+     * This is called when the end of round countdown starts, so that the reset
+     * only has to swap the maps and create the shaders.
+     */
+    void prepareNextRound();
+    
+    /**
+     * Returns the next round, built but not finalized.
+     *
+     * If the pending round was built with a different seed or number of carrots
+     * (e.g. a player left during the countdown), or there is no pending round,
+     * the round is built now instead.
+     *
+     * @param seed          The seed of the next round
+     * @param numCarrots    The number of carrots in the next round
+     *
+     * @return the next round, built but not finalized
+     */
+    std::shared_ptr<Map> takeNextRound(int seed, int numCarrots);
+    
     
     void unload();
 
     void render(const std::shared_ptr<SpriteBatch> &batch);
     
     void processResetEvent(const std::shared_ptr<ResetEvent>& event);
+    
+    /**
+     * Dispatches a game event (from the network or, in lockstep, produced locally)
+     * to the controller that handles it.
+     */
+    void processGameEvent(const std::shared_ptr<NetEvent>& e);
 };
 
 #endif /* RootedGameScene_h */
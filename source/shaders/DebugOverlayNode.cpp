@@ -0,0 +1,104 @@
+//
+// The root of the debug layer. It draws the world grid and the wireframes of every physics obstacle
+// as a single line mesh, instead of traversing and drawing one WireNode per grid line and obstacle.
+// The grid is built once from the world bounds. The obstacle wireframes are still the WireNodes that
+// the obstacles create and position (as children of this node), but this node collects their meshes
+// each frame rather than letting each one draw itself, and skips those outside of the view.
+//
+
+#include "DebugOverlayNode.h"
+
+DebugOverlayNode::DebugOverlayNode() :
+        SceneNode() {
+    _classname = "DebugOverlayNode";
+    _grid.command = GL_LINES;
+    _wires.command = GL_LINES;
+}
+
+void DebugOverlayNode::dispose() {
+    clearGrid();
+    _wires.clear();
+    SceneNode::dispose();
+}
+
+void DebugOverlayNode::setGrid(Size bounds, Color4 color) {
+    clearGrid();
+    Uint32 packed = color.getPacked();
+    auto addLine = [&](Vec2 a, Vec2 b) {
+        SpriteVertex2 vert;
+        vert.color = packed;
+        vert.position = a;
+        _grid.indices.push_back((Uint32)_grid.vertices.size());
+        _grid.vertices.push_back(vert);
+        vert.position = b;
+        _grid.indices.push_back((Uint32)_grid.vertices.size());
+        _grid.vertices.push_back(vert);
+    };
+    for (int x = 0; x <= bounds.width; x++) {
+        addLine(Vec2(x, 0), Vec2(x, bounds.height));
+    }
+    for (int y = 0; y <= bounds.height; y++) {
+        addLine(Vec2(0, y), Vec2(bounds.width, y));
+    }
+}
+
+void DebugOverlayNode::clearGrid() {
+    _grid.vertices.clear();
+    _grid.indices.clear();
+}
+
+void DebugOverlayNode::render(const shared_ptr<SpriteBatch> &batch, const Affine2 &transform, Color4 tint) {
+    if (!_isVisible) { return; }
+
+    Affine2 matrix;
+    Affine2::multiply(_combined, transform, &matrix);
+    Color4 color = _tintColor;
+    if (_hasParentColor) {
+        color *= tint;
+    }
+
+    // Collect the wireframes in the coordinate space of this node
+    _wires.vertices.clear();
+    _wires.indices.clear();
+    bool culling = batch->isCulling();
+    for (auto &child : _children) {
+        auto wire = dynamic_pointer_cast<scene2::WireNode>(child);
+        if (wire == nullptr || !wire->isVisible()) {
+            continue;
+        }
+        const Affine2 &local = wire->getNodeToParentTransform();
+        if (culling) {
+            Affine2 global;
+            Affine2::multiply(local, matrix, &global);
+            if (wire->isOutside(global, batch->getCullBounds())) {
+                continue;
+            }
+        }
+
+        const Mesh<SpriteVertex2> &mesh = wire->getMesh();
+        Uint32 packed = wire->getColor().getPacked();
+        Uint32 base = (Uint32)_wires.vertices.size();
+        for (const SpriteVertex2 &vert : mesh.vertices) {
+            SpriteVertex2 out = vert;
+            out.position = local.transform(vert.position);
+            out.color = packed;
+            _wires.vertices.push_back(out);
+        }
+        for (Uint32 index : mesh.indices) {
+            _wires.indices.push_back(base + index);
+        }
+    }
+
+    // Both meshes share the same state, so the sprite batch draws them together
+    batch->setColor(color);
+    batch->setTexture(nullptr);
+    batch->setBlendEquation(GL_FUNC_ADD);
+    batch->setSrcBlendFunc(GL_SRC_ALPHA, GL_SRC_ALPHA);
+    batch->setDstBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (!_grid.vertices.empty()) {
+        batch->drawMesh(_grid, matrix);
+    }
+    if (!_wires.vertices.empty()) {
+        batch->drawMesh(_wires, matrix);
+    }
+}
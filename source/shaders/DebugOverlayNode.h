@@ -0,0 +1,61 @@
+//
+// The root of the debug layer. It draws the world grid and the wireframes of every physics obstacle
+// as a single line mesh, instead of traversing and drawing one WireNode per grid line and obstacle.
+// The grid is built once from the world bounds. The obstacle wireframes are still the WireNodes that
+// the obstacles create and position (as children of this node), but this node collects their meshes
+// each frame rather than letting each one draw itself, and skips those outside of the view.
+//
+
+#ifndef ROOTED_DEBUGOVERLAYNODE_H
+#define ROOTED_DEBUGOVERLAYNODE_H
+
+#include <cugl/cugl.h>
+
+using namespace std;
+
+using namespace cugl;
+
+class DebugOverlayNode : public scene2::SceneNode {
+private:
+    /** the grid lines, in the coordinate space of this node */
+    Mesh<SpriteVertex2> _grid;
+    /** the wireframes of the children, rebuilt every frame */
+    Mesh<SpriteVertex2> _wires;
+
+public:
+
+    DebugOverlayNode();
+
+    ~DebugOverlayNode() { dispose(); }
+
+    static shared_ptr<DebugOverlayNode> alloc() {
+        shared_ptr<DebugOverlayNode> result = make_shared<DebugOverlayNode>();
+        return (result->init() ? result : nullptr);
+    }
+
+    void dispose() override;
+
+    /**
+     * Builds a grid with a line at every unit of the given bounds
+     *
+     * @param bounds    the size of the grid, in the coordinate space of this node
+     * @param color     the color of the grid lines
+     */
+    void setGrid(Size bounds, Color4 color);
+
+    /**
+     * Removes the grid
+     */
+    void clearGrid();
+
+    /**
+     * Draws the grid and the wireframes of the children as one line mesh.
+     *
+     * Unlike SceneNode, this does not render the children. Only the meshes of
+     * visible WireNode children are drawn.
+     */
+    void render(const shared_ptr<SpriteBatch> &batch, const Affine2 &transform, Color4 tint) override;
+
+};
+
+#endif //ROOTED_DEBUGOVERLAYNODE_H
@@ -0,0 +1,154 @@
+//
+// A single scene graph node for an animated entity. Rather than keeping one SpriteNode per facing
+// and swapping between them, this node holds every sprite sheet of the entity and draws the active
+// frame as one textured quad, writing the frame's texture coordinates straight into the sprite
+// batch. The sheet, frame and flip are chosen by the AnimationController each step, and the quad
+// is only rebuilt when one of those changes.
+//
+// The node supports the wheat cover shader in EntitiesNode, so it sets the texture height and
+// origin on the sprite batch the same way TexturedNode does.
+//
+
+#include "EntitySpriteNode.h"
+
+EntitySpriteNode::EntitySpriteNode() :
+        SceneNode(),
+        _sheet(0),
+        _frame(0),
+        _flip(false),
+        _isPlayer(false),
+        _dirty(true),
+        _origin(0) {
+    _classname = "EntitySpriteNode";
+}
+
+bool EntitySpriteNode::init() {
+    if (SceneNode::init()) {
+        Uint32 white = Color4::WHITE.getPacked();
+        for (int i = 0; i < 4; i++) {
+            _quad[i].color = white;
+        }
+        return true;
+    }
+    return false;
+}
+
+void EntitySpriteNode::dispose() {
+    _sheets.clear();
+    SceneNode::dispose();
+}
+
+/**
+ * Adds a sprite sheet to this node, returning its index. The first sheet added is active.
+ *
+ * @param texture   the sprite sheet texture
+ * @param rows      the number of rows in the sheet
+ * @param cols      the number of columns in the sheet
+ * @param size      the number of frames in the sheet
+ * @param scale     the scale of a frame in the scene graph
+ * @param height    the height of a frame for the wheat cover shader
+ * @param anchor    the anchor of a frame
+ */
+int EntitySpriteNode::addSheet(const shared_ptr<Texture> &texture, int rows, int cols, int size,
+                               float scale, float height, Vec2 anchor) {
+    CUAssertLog(size <= rows * cols, "Invalid strip size for %dx%d", rows, cols);
+    _sheets.push_back({texture, rows, cols, size, scale, height, anchor});
+    if (_sheets.size() == 1) {
+        _sheet = 1; // force the first sheet to be applied
+        setSheet(0, false);
+    }
+    return (int)_sheets.size() - 1;
+}
+
+/**
+ * Sets the active sheet and whether it is flipped horizontally. A sheet that this node does
+ * not have falls back to the first sheet.
+ */
+void EntitySpriteNode::setSheet(int sheet, bool flip) {
+    if (sheet < 0 || (size_t)sheet >= _sheets.size()) {
+        sheet = 0;
+    }
+    if (sheet == _sheet && flip == _flip) {
+        return;
+    }
+    if (sheet != _sheet) {
+        const Sheet &next = _sheets[sheet];
+        Size frame = next.texture->getSize();
+        frame.width /= next.cols;
+        frame.height /= next.rows;
+        _sheet = sheet;
+        setAnchor(next.anchor);
+        setContentSize(frame * next.scale);
+        _frame = std::min(_frame, next.size - 1);
+    }
+    _flip = flip;
+    _dirty = true;
+}
+
+/**
+ * Sets the active frame of the active sheet.
+ */
+void EntitySpriteNode::setFrame(int frame) {
+    CUAssertLog(frame >= 0 && frame < getSpan(), "Invalid animation frame %d", frame);
+    if (frame != _frame) {
+        _frame = frame;
+        _dirty = true;
+    }
+}
+
+/**
+ * Rebuilds the quad positions and texture coordinates for the active frame
+ */
+void EntitySpriteNode::updateQuad() {
+    const Sheet &sheet = _sheets[_sheet];
+    const shared_ptr<Texture> &texture = sheet.texture;
+
+    // Frames are read left to right, top to bottom, as in SpriteNode
+    int col = _frame % sheet.cols;
+    int row = _frame / sheet.cols;
+    float s0 = (float)col / sheet.cols;
+    float s1 = (float)(col + 1) / sheet.cols;
+    float t0 = (float)(row + 1) / sheet.rows;
+    float t1 = (float)row / sheet.rows;
+    if (_flip) {
+        std::swap(s0, s1);
+    }
+    _origin = 1 - t0;
+
+    float minS = texture->getMinS(), maxS = texture->getMaxS();
+    float minT = texture->getMinT(), maxT = texture->getMaxT();
+    s0 = s0 * maxS + (1 - s0) * minS;
+    s1 = s1 * maxS + (1 - s1) * minS;
+    t0 = t0 * maxT + (1 - t0) * minT;
+    t1 = t1 * maxT + (1 - t1) * minT;
+
+    const Size &size = getContentSize();
+    _quad[0].position.set(0, 0);
+    _quad[0].texcoord.set(s0, t0);
+    _quad[1].position.set(size.width, 0);
+    _quad[1].texcoord.set(s1, t0);
+    _quad[2].position.set(size.width, size.height);
+    _quad[2].texcoord.set(s1, t1);
+    _quad[3].position.set(0, size.height);
+    _quad[3].texcoord.set(s0, t1);
+    _dirty = false;
+}
+
+void EntitySpriteNode::draw(const shared_ptr<SpriteBatch> &batch, const Affine2 &transform, Color4 tint) {
+    if (_sheets.empty()) {
+        return;
+    }
+    if (_dirty) {
+        updateQuad();
+    }
+
+    batch->setColor(tint);
+    batch->setTexture(_sheets[_sheet].texture);
+    batch->setBlendEquation(GL_FUNC_ADD);
+    batch->setSrcBlendFunc(GL_SRC_ALPHA);
+    batch->setDstBlendFunc(GL_ONE_MINUS_SRC_ALPHA);
+    batch->setHeight(_sheets[_sheet].height);
+    batch->setOrigin(_origin);
+    batch->setIsPlayer(_isPlayer);
+    batch->drawMesh(_quad, 4, transform);
+}
@@ -0,0 +1,120 @@
+//
+// A single scene graph node for an animated entity. Rather than keeping one SpriteNode per facing
+// and swapping between them, this node holds every sprite sheet of the entity and draws the active
+// frame as one textured quad, writing the frame's texture coordinates straight into the sprite
+// batch. The sheet, frame and flip are chosen by the AnimationController each step, and the quad
+// is only rebuilt when one of those changes.
+//
+// The node supports the wheat cover shader in EntitiesNode, so it sets the texture height and
+// origin on the sprite batch the same way TexturedNode does.
+//
+
+#ifndef ROOTED_ENTITYSPRITENODE_H
+#define ROOTED_ENTITYSPRITENODE_H
+
+#include <cugl/cugl.h>
+
+using namespace std;
+
+using namespace cugl;
+
+class EntitySpriteNode : public scene2::SceneNode {
+public:
+    /** A sprite sheet (film strip) that this node can draw */
+    class Sheet {
+    public:
+        /** the sprite sheet texture */
+        shared_ptr<Texture> texture;
+        /** the number of rows in the sheet */
+        int rows;
+        /** the number of columns in the sheet */
+        int cols;
+        /** the number of frames in the sheet */
+        int size;
+        /** the scale of a frame in the scene graph */
+        float scale;
+        /** the height of a frame for the wheat cover shader */
+        float height;
+        /** the anchor of a frame */
+        Vec2 anchor;
+    };
+
+private:
+    /** the sheets of this node */
+    vector<Sheet> _sheets;
+    /** the active sheet */
+    int _sheet;
+    /** the active frame in the active sheet */
+    int _frame;
+    /** whether the active frame is flipped horizontally */
+    bool _flip;
+    /** whether this node is the player for the wheat cover shader */
+    bool _isPlayer;
+    /** whether the quad must be rebuilt before drawing */
+    bool _dirty;
+    /** the y origin of the active frame for the wheat cover shader */
+    float _origin;
+    /** the quad for the active frame, as a triangle fan */
+    SpriteVertex2 _quad[4];
+
+    /**
+     * Rebuilds the quad positions and texture coordinates for the active frame
+     */
+    void updateQuad();
+
+public:
+
+    EntitySpriteNode();
+
+    ~EntitySpriteNode() { dispose(); }
+
+    static shared_ptr<EntitySpriteNode> alloc() {
+        shared_ptr<EntitySpriteNode> result = make_shared<EntitySpriteNode>();
+        return (result->init() ? result : nullptr);
+    }
+
+    bool init() override;
+
+    void dispose() override;
+
+    /**
+     * Adds a sprite sheet to this node, returning its index. The first sheet added is active.
+     *
+     * @param texture   the sprite sheet texture
+     * @param rows      the number of rows in the sheet
+     * @param cols      the number of columns in the sheet
+     * @param size      the number of frames in the sheet
+     * @param scale     the scale of a frame in the scene graph
+     * @param height    the height of a frame for the wheat cover shader
+     * @param anchor    the anchor of a frame
+     */
+    int addSheet(const shared_ptr<Texture> &texture, int rows, int cols, int size,
+                 float scale, float height, Vec2 anchor = Vec2::ANCHOR_CENTER);
+
+    /**
+     * Sets the active sheet and whether it is flipped horizontally. A sheet that this node does
+     * not have falls back to the first sheet.
+     */
+    void setSheet(int sheet, bool flip);
+
+    int getSheet() const { return _sheet; }
+
+    /**
+     * Sets the active frame of the active sheet.
+     */
+    void setFrame(int frame);
+
+    int getFrame() const { return _frame; }
+
+    /** Returns the number of frames in the active sheet */
+    int getSpan() const { return _sheets.empty() ? 1 : _sheets[_sheet].size; }
+
+    void setIsPlayer(bool player) { _isPlayer = player; }
+
+    bool getIsPlayer() const { return _isPlayer; }
+
+    void draw(const shared_ptr<SpriteBatch> &batch, const Affine2 &transform, Color4 tint) override;
+
+};
+
+#endif //ROOTED_ENTITYSPRITENODE_H
@@ -7,6 +7,7 @@
 
 #include "ShaderRenderer.h"
 #include "../RootedConstants.h"
+#include "../controllers/ProfilerController.h"
 
 using namespace cugl;
 
@@ -105,6 +106,11 @@ bool ShaderRenderer::init(const shared_ptr<Texture> &wheattex, const std::shared
         _textures[i]->setBindPoint(i);
     }
     
+    _wheatTextures = { _wheattex, _noisetex, _gradienttex, _wheatsidetex, _wheattoptex };
+    _groundTextures = { _noisetex, _wheattex, _grassgradienttex };
+    _cloudsTextures = { _cloudtex, _noisetex };
+    _visible = true;
+    
     return true;
     
 }
@@ -115,6 +121,9 @@ void ShaderRenderer::dispose() {
     _vertbuff = nullptr;
     _assets = nullptr;
     _textures.clear();
+    _wheatTextures.clear();
+    _groundTextures.clear();
+    _cloudsTextures.clear();
 }
 
 void ShaderRenderer::update(float timestep, const Mat4& perspective, int size, float *positions, float *velocities, Vec2 playerPos) {
@@ -157,80 +166,77 @@ void ShaderRenderer::update(float timestep, const Mat4& perspective, int size, f
         _cloudsShader->unbind();
     }
 
+    updateMesh(perspective);
 }
 
-void ShaderRenderer::renderWheat() {
-    // OpenGL commands to enable alpha blending (if needed)
-//    _shader->bind();
+void ShaderRenderer::updateMesh(const Mat4& perspective) {
+    if (!_vertbuff) {
+        return;
+    }
     
-    if (_wheatShader) {
-        _vertbuff->attach(_wheatShader);
-        
-        // Draw with the given textures (if it exists)
-        for (auto texture : _textures) {
-            if (texture) {
-                texture->bind();
-            }
-        }
-
-        _vertbuff->draw(_mesh.command, (int)_mesh.indices.size(), 1);
-
-        _vertbuff->detach();
-
-        for (auto texture : _textures) {
-            if (texture) {
-                texture->unbind();
-            }
-        }
+    // The visible rect is clip space pulled back through the camera
+    Mat4 inverse;
+    Mat4::invert(perspective, &inverse);
+    Rect view = Rect(Vec2(-1, -1) * inverse, Size::ZERO);
+    view.merge(Rect(Vec2(1, -1) * inverse, Size::ZERO));
+    view.merge(Rect(Vec2(-1, 1) * inverse, Size::ZERO));
+    view.merge(Rect(Vec2(1, 1) * inverse, Size::ZERO));
+    
+    Rect world = Rect(Vec2::ZERO, _size);
+    _visible = world.doesIntersect(view);
+    if (!_visible) {
+        return;
+    }
+    view.intersect(world);
+    
+    // Texture coordinates match the full world quad (with the y-coordinate flipped)
+    const Vec2 corners[4] = {
+        Vec2(view.getMinX(), view.getMinY()), Vec2(view.getMaxX(), view.getMinY()),
+        Vec2(view.getMinX(), view.getMaxY()), Vec2(view.getMaxX(), view.getMaxY())
+    };
+    for (int i = 0; i < 4; i++) {
+        _mesh.vertices[i].position = corners[i];
+        _mesh.vertices[i].texcoord = Vec2(corners[i].x / _size.width, 1 - corners[i].y / _size.height);
     }
+    
+    _vertbuff->bind();
+    _vertbuff->loadVertexData(_mesh.vertices.data(), (int)_mesh.vertices.size());
+    _vertbuff->unbind();
 }
 
-void ShaderRenderer::renderGround() {
-    // OpenGL commands to enable alpha blending (if needed)
-//    _shader->bind();
-
-    if (_wheatShader) {
-        _vertbuff->attach(_groundShader);
-
-        for (auto texture : _textures) {
-            if (texture) {
-                texture->bind();
-            }
+void ShaderRenderer::renderPass(const std::shared_ptr<cugl::Shader>& shader, const std::vector<std::shared_ptr<cugl::Texture>>& textures) {
+    if (!shader || !_visible) {
+        return;
+    }
+    
+    _vertbuff->attach(shader);
+    for (auto texture : textures) {
+        if (texture) {
+            texture->bind();
         }
+    }
 
-        _vertbuff->draw(_mesh.command, (int)_mesh.indices.size(), 1);
+    _vertbuff->draw(_mesh.command, (int)_mesh.indices.size(), 0);
 
-        for (auto texture : _textures) {
-            if (texture) {
-                texture->unbind();
-            }
+    for (auto texture : textures) {
+        if (texture) {
+            texture->unbind();
         }
-        _vertbuff->detach();
     }
+    _vertbuff->detach();
 }
 
-void ShaderRenderer::renderClouds() {
-    // OpenGL commands to enable alpha blending (if needed)
-//    _shader->bind();
-
-    if (_cloudsShader) {
-        _vertbuff->attach(_cloudsShader);
-
-        for (auto texture : _textures) {
-            if (texture) {
-                texture->bind();
-            }
-        }
+void ShaderRenderer::renderWheat() {
+    PROFILE_GPU_SCOPE("ShaderRenderer::renderWheat");
+    renderPass(_wheatShader, _wheatTextures);
+}
 
-        _vertbuff->draw(_mesh.command, (int)_mesh.indices.size(), 1);
+void ShaderRenderer::renderGround() {
+    renderPass(_groundShader, _groundTextures);
+}
 
-        for (auto texture : _textures) {
-            if (texture) {
-                texture->unbind();
-            }
-        }
-        _vertbuff->detach();
-    }
+void ShaderRenderer::renderClouds() {
+    renderPass(_cloudsShader, _cloudsTextures);
 }
 
 void ShaderRenderer::buildShaders() {
@@ -308,12 +314,12 @@ void ShaderRenderer::buildShaders() {
     vert.texcoord = Vec2(1, 0);
     _mesh.vertices.push_back(vert);
 
-    _mesh.indices = {0, 1, 2, 0, 1, 2, 3}; // Two? triangles to cover the rectangle
+    _mesh.indices = {0, 1, 2, 2, 1, 3}; // Two triangles to cover the rectangle
 
     _mesh.command = GL_TRIANGLES;
     
     // IMPORTANT LAST STEP: Load the mesh into the vertex buffer
-    // We only need to reload it if the vertex data changes (which is never)
+    // The vertices are reloaded by update to match the camera, but the indices never change
     _vertbuff->loadVertexData(_mesh.vertices.data(), (int)_mesh.vertices.size());
     _vertbuff->loadIndexData(_mesh.indices.data(), (int)_mesh.indices.size());
     _vertbuff->unbind();
@@ -43,11 +43,37 @@ protected:
     std::shared_ptr<cugl::Texture> _wheatsidetex;
     std::shared_ptr<cugl::Texture> _wheattoptex;
     std::vector<std::shared_ptr<cugl::Texture>> _textures;
+    /** The textures sampled by the wheat shader */
+    std::vector<std::shared_ptr<cugl::Texture>> _wheatTextures;
+    /** The textures sampled by the ground shader */
+    std::vector<std::shared_ptr<cugl::Texture>> _groundTextures;
+    /** The textures sampled by the clouds shader */
+    std::vector<std::shared_ptr<cugl::Texture>> _cloudsTextures;
+    /** Whether any part of the world quad is visible to the camera */
+    bool _visible;
     float _aspectRatio;
     bool _fullHeight;
     Size _worldSize;
     
     
+    /**
+     * Restricts the quad to the part of the world visible under the given perspective.
+     *
+     * The vertices and texture coordinates are recomputed so the shaders see the same
+     * texture coordinates as the full world quad, but fragments are only shaded on screen.
+     *
+     * @param perspective   The combined camera matrix
+     */
+    void updateMesh(const Mat4& perspective);
+    
+    /**
+     * Draws the visible quad with the given shader, binding only the given textures.
+     *
+     * @param shader    The shader to draw with
+     * @param textures  The textures sampled by the shader
+     */
+    void renderPass(const std::shared_ptr<cugl::Shader>& shader, const std::vector<std::shared_ptr<cugl::Texture>>& textures);
+    
 public:
     
     ShaderRenderer() {}
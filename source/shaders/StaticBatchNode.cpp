@@ -0,0 +1,127 @@
+//
+// A scene graph node for static layers, like the grass, planting spots and wheat tiles of a round.
+// Instead of traversing and transforming its subtree every frame, this node bakes the meshes of
+// every textured node below it into a few cached meshes (one per texture and blend state) the
+// first time it is rendered. After that, drawing the whole layer costs one drawMesh per cached
+// mesh and no per-node work.
+//
+// The cache is rebuilt if the number of children changes. Any other change to the subtree (moving,
+// recoloring or retexturing a descendant) must be followed by a call to invalidate(). Only textured
+// nodes with triangle meshes (such as PolygonNode and SpriteNode) are baked. Line meshes, like those
+// of WireNode and PathNode, are skipped with a warning, and gradients and scissors on descendants
+// are ignored.
+//
+
+#include "StaticBatchNode.h"
+
+StaticBatchNode::StaticBatchNode() :
+        SceneNode(),
+        _dirty(true),
+        _bakedChildren(0) {
+    _classname = "StaticBatchNode";
+}
+
+void StaticBatchNode::dispose() {
+    _runs.clear();
+    _dirty = true;
+    SceneNode::dispose();
+}
+
+void StaticBatchNode::render(const shared_ptr<SpriteBatch> &batch, const Affine2 &transform, Color4 tint) {
+    if (!_isVisible) { return; }
+
+    if (_dirty || _bakedChildren != _children.size()) {
+        bake();
+    }
+
+    Affine2 matrix;
+    Affine2::multiply(_combined, transform, &matrix);
+    Color4 color = _tintColor;
+    if (_hasParentColor) {
+        color *= tint;
+    }
+
+    batch->setColor(color);
+    for (auto &run : _runs) {
+        batch->setTexture(run.texture);
+        batch->setBlendEquation(run.blendEquation);
+        batch->setSrcBlendFunc(run.srcFactor, run.srcAlphaFactor);
+        batch->setDstBlendFunc(run.dstFactor, run.dstAlphaFactor);
+        batch->setHeight(run.height);
+        batch->setOrigin(run.origin);
+        batch->setIsPlayer(run.player);
+        batch->drawMesh(run.mesh, matrix);
+    }
+}
+
+void StaticBatchNode::bake() {
+    _runs.clear();
+    for (auto &child : _children) {
+        bakeNode(child, Affine2::IDENTITY, Color4::WHITE);
+    }
+    _bakedChildren = _children.size();
+    _dirty = false;
+}
+
+void StaticBatchNode::bakeNode(const shared_ptr<scene2::SceneNode> &node, const Affine2 &transform, Color4 tint) {
+    if (!node->isVisible()) { return; }
+
+    Affine2 matrix;
+    Affine2::multiply(node->getNodeToParentTransform(), transform, &matrix);
+    Color4 color = node->getColor();
+    if (node->hasRelativeColor()) {
+        color *= tint;
+    }
+
+    auto textured = dynamic_pointer_cast<scene2::TexturedNode>(node);
+    if (textured != nullptr && textured->getTexture() != nullptr &&
+        textured->getMesh().command != GL_TRIANGLES) {
+        // The runs are drawn as triangles, so lines would come out as garbage
+        CUWarn("StaticBatchNode: skipping %s, which is not a triangle mesh", node->getName().c_str());
+    } else if (textured != nullptr && textured->getTexture() != nullptr) {
+        // Start a new run whenever the texture or shader state changes
+        if (_runs.empty() || _runs.back().texture != textured->getTexture() ||
+            _runs.back().blendEquation != textured->getBlendEquation() ||
+            _runs.back().srcFactor != textured->getSourceBlendFactor() ||
+            _runs.back().srcAlphaFactor != textured->getSourceAlphaBlendFactor() ||
+            _runs.back().dstFactor != textured->getDestinationBlendFactor() ||
+            _runs.back().dstAlphaFactor != textured->getDestinationAlphaBlendFactor() ||
+            _runs.back().height != textured->getHeight() ||
+            _runs.back().origin != textured->getOrigin() ||
+            _runs.back().player != textured->getIsPlayer()) {
+            Run run;
+            run.texture = textured->getTexture();
+            run.blendEquation = textured->getBlendEquation();
+            run.srcFactor = textured->getSourceBlendFactor();
+            run.srcAlphaFactor = textured->getSourceAlphaBlendFactor();
+            run.dstFactor = textured->getDestinationBlendFactor();
+            run.dstAlphaFactor = textured->getDestinationAlphaBlendFactor();
+            run.height = textured->getHeight();
+            run.origin = textured->getOrigin();
+            run.player = textured->getIsPlayer();
+            run.mesh.command = GL_TRIANGLES;
+            _runs.push_back(run);
+        }
+
+        const Mesh<SpriteVertex2> &mesh = textured->getMesh();
+        Mesh<SpriteVertex2> &baked = _runs.back().mesh;
+        Uint32 base = (Uint32)baked.vertices.size();
+        baked.vertices.reserve(baked.vertices.size() + mesh.vertices.size());
+        for (const SpriteVertex2 &vert : mesh.vertices) {
+            SpriteVertex2 out = vert;
+            out.position = matrix.transform(vert.position);
+            Color4 vcolor;
+            vcolor.rgba = vert.color;
+            out.color = (vcolor * color).getPacked();
+            baked.vertices.push_back(out);
+        }
+        baked.indices.reserve(baked.indices.size() + mesh.indices.size());
+        for (Uint32 index : mesh.indices) {
+            baked.indices.push_back(base + index);
+        }
+    }
+
+    for (auto &child : node->getChildren()) {
+        bakeNode(child, matrix, color);
+    }
+}
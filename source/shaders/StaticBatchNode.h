@@ -0,0 +1,101 @@
+//
+// A scene graph node for static layers, like the grass, planting spots and wheat tiles of a round.
+// Instead of traversing and transforming its subtree every frame, this node bakes the meshes of
+// every textured node below it into a few cached meshes (one per texture and blend state) the
+// first time it is rendered. After that, drawing the whole layer costs one drawMesh per cached
+// mesh and no per-node work.
+//
+// The cache is rebuilt if the number of children changes. Any other change to the subtree (moving,
+// recoloring or retexturing a descendant) must be followed by a call to invalidate(). Only textured
+// nodes with triangle meshes (such as PolygonNode and SpriteNode) are baked. Line meshes, like those
+// of WireNode and PathNode, are skipped with a warning, and gradients and scissors on descendants
+// are ignored.
+//
+
+#ifndef ROOTED_STATICBATCHNODE_H
+#define ROOTED_STATICBATCHNODE_H
+
+#include <cugl/cugl.h>
+
+using namespace std;
+
+using namespace cugl;
+
+class StaticBatchNode : public scene2::SceneNode {
+private:
+    /** A baked mesh sharing a single texture and blend state */
+    class Run {
+    public:
+        /** the texture of this run */
+        shared_ptr<Texture> texture;
+        /** the blend equation of this run */
+        GLenum blendEquation;
+        /** the source blend factors (rgb, alpha) of this run */
+        GLenum srcFactor, srcAlphaFactor;
+        /** the destination blend factors (rgb, alpha) of this run */
+        GLenum dstFactor, dstAlphaFactor;
+        /** the shader height of this run (see TexturedNode::getHeight) */
+        float height;
+        /** the shader origin of this run (see TexturedNode::getOrigin) */
+        float origin;
+        /** whether this run is the player texture (see TexturedNode::getIsPlayer) */
+        bool player;
+        /** the baked vertices, in the coordinate space of this node */
+        Mesh<SpriteVertex2> mesh;
+    };
+
+    /** the cached meshes, in drawing order */
+    vector<Run> _runs;
+    /** whether the cache must be rebuilt before drawing */
+    bool _dirty;
+    /** the number of children when the cache was built */
+    size_t _bakedChildren;
+
+    /**
+     * Rebuilds the cached meshes from the subtree of this node
+     */
+    void bake();
+
+    /**
+     * Appends the meshes of the given node and its descendants to the cache
+     *
+     * @param node      the node to bake
+     * @param transform the transform from the node's parent to this node
+     * @param tint      the color of the node's parent, relative to this node
+     */
+    void bakeNode(const shared_ptr<scene2::SceneNode> &node, const Affine2 &transform, Color4 tint);
+
+public:
+
+    StaticBatchNode();
+
+    ~StaticBatchNode() { dispose(); }
+
+    static shared_ptr<StaticBatchNode> alloc() {
+        shared_ptr<StaticBatchNode> result = make_shared<StaticBatchNode>();
+        return (result->init() ? result : nullptr);
+    }
+
+    void dispose() override;
+
+    /**
+     * Marks the cached meshes as stale, so they are rebuilt at the next render
+     */
+    void invalidate() { _dirty = true; }
+
+    /**
+     * Returns the number of cached meshes (and hence draw calls) of this node
+     */
+    size_t getRunCount() const { return _runs.size(); }
+
+    /**
+     * Draws the cached meshes of this node, baking them first if necessary.
+     *
+     * Unlike SceneNode, this does not render the children. They are only visited
+     * when the cache is rebuilt.
+     */
+    void render(const shared_ptr<SpriteBatch> &batch, const Affine2 &transform, Color4 tint) override;
+
+};
+
+#endif //ROOTED_STATICBATCHNODE_H
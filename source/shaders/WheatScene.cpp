@@ -11,6 +11,10 @@
 // just directly set the wheat height (i.e. not adding or subtracting) then you should draw to the
 // red channel with regular blending.
 //
+// Stamps also press down a persistent trail. The trail depth is kept in a pair of render targets
+// that are ping-ponged each frame: the previous depth is decayed into the other target, the stamps
+// add to it, and the result is subtracted from the wheat height (blue channel) of this scene.
+//
 // Note that the root node of this scene is in physics coordinates, so any textures added to this
 // scene graph need to be scaled down by the draw scale. This is for convenience purposes
 // so that other classes are unaware of the size of the wheat texture. However I am not sure if this
@@ -21,6 +25,7 @@
 
 #include "WheatScene.h"
 #include "../RootedConstants.h"
+#include "../controllers/ProfilerController.h"
 
 const std::string fsqShaderFrag =
 #include "FSQShader.frag"
@@ -30,12 +35,29 @@ const std::string fsqShaderVert =
 #include "FSQShader.vert"
 ;
 
+const std::string stampShaderFrag =
+#include "stamp_fragment.frag"
+;
+
+const std::string stampShaderVert =
+#include "stamp_vertex.vert"
+;
+
+const std::string trailStampShaderFrag =
+#include "trail_stamp.frag"
+;
+
+const std::string trailShaderFrag =
+#include "trail_fragment.frag"
+;
+
 bool WheatScene::init(const shared_ptr<AssetManager> &assets, vector<vector<pair<string, float>>> mapInfo,
                       Vec2 drawScale, Size worldSize) {
 
     _fsqshader = Shader::alloc(SHADER(fsqShaderVert), SHADER(fsqShaderFrag));
-    if (!Scene2Texture::init(0, 0, DEFAULT_WHEAT_TEX_WIDTH * worldSize.width / DEFAULT_WIDTH,
-                             DEFAULT_WHEAT_TEX_HEIGHT * worldSize.height / DEFAULT_HEIGHT, false)) {
+    int width = DEFAULT_WHEAT_TEX_WIDTH * worldSize.width / DEFAULT_WIDTH;
+    int height = DEFAULT_WHEAT_TEX_HEIGHT * worldSize.height / DEFAULT_HEIGHT;
+    if (!Scene2Texture::init(0, 0, width, height, false)) {
         return false;
     }
 
@@ -48,6 +70,10 @@ bool WheatScene::init(const shared_ptr<AssetManager> &assets, vector<vector<pair
     _rootnode->setPosition(Vec2::ZERO);
     addChild(_rootnode);
 
+    // The wheat tiles are fixed for the round, so they are baked into one layer
+    _wheatLayer = StaticBatchNode::alloc();
+    _rootnode->addChild(_wheatLayer);
+
     //add wheat texture nodes based on data in mapInfo
     for (int i = 0; i < mapInfo.size(); i++) {
         for (int j = 0; j < mapInfo[i].size(); j++) {
@@ -61,7 +87,7 @@ bool WheatScene::init(const shared_ptr<AssetManager> &assets, vector<vector<pair
                     Color4(255 / bladeColorScale, 255 / bladeColorScale, 255 / bladeColorScale,
                            255)); //not sure if this will work for all scales
             wheatnode->setPosition(MAP_UNIT_WIDTH * i, MAP_UNIT_HEIGHT * j);
-            _rootnode->addChild(wheatnode);
+            _wheatLayer->addChild(wheatnode);
         }
     }
 
@@ -69,6 +95,24 @@ bool WheatScene::init(const shared_ptr<AssetManager> &assets, vector<vector<pair
 
     _queryId = 0;
 
+    buildStamps();
+
+    _trailStampShader = Shader::alloc(SHADER(stampShaderVert), SHADER(trailStampShaderFrag));
+    _trailShader = Shader::alloc(SHADER(fsqShaderVert), SHADER(trailShaderFrag));
+    for (int i = 0; i < 2; i++) {
+        _trails[i] = RenderTarget::alloc(width / WHEAT_TRAIL_DOWNSAMPLE, height / WHEAT_TRAIL_DOWNSAMPLE);
+        if (_trails[i] == nullptr) {
+            return false;
+        }
+        _trails[i]->setClearColor(Color4::CLEAR);
+        // begin clears the target, so the first decay pass reads zero depth
+        _trails[i]->begin();
+        _trails[i]->end();
+    }
+    _trailIndex = 0;
+    _trailTime = 0;
+    _trailDecay = 0;
+
     return true;
 }
 
@@ -96,10 +140,206 @@ void WheatScene::renderToScreen(float alpha, float scale) {
 
 void WheatScene::dispose() {
     _rootnode = nullptr;
+    _wheatLayer = nullptr;
     _fsqshader = nullptr;
+    _stampShader = nullptr;
+    _stampBuffer = nullptr;
+    _stamps.clear();
+    _trailStampShader = nullptr;
+    _trailShader = nullptr;
+    _trails[0] = nullptr;
+    _trails[1] = nullptr;
     Scene2::dispose();
 }
 
+/**
+ * Builds the stamp shader and the unit ellipse mesh
+ */
+void WheatScene::buildStamps() {
+    _stampShader = Shader::alloc(SHADER(stampShaderVert), SHADER(stampShaderFrag));
+
+    // A triangle fan around the center, as a triangle list
+    vector<Vec2> vertices;
+    vector<GLuint> indices;
+    vertices.push_back(Vec2::ZERO);
+    for (int i = 0; i < WHEAT_STAMP_SEGMENTS; i++) {
+        float angle = 2 * M_PI * i / WHEAT_STAMP_SEGMENTS;
+        vertices.push_back(Vec2(0.5f * cosf(angle), 0.5f * sinf(angle)));
+        indices.push_back(0);
+        indices.push_back(i + 1);
+        indices.push_back((i + 1) % WHEAT_STAMP_SEGMENTS + 1);
+    }
+    _stampIndices = (GLsizei)indices.size();
+
+    _stampBuffer = VertexBuffer::alloc(sizeof(Vec2));
+    _stampBuffer->setupAttribute("aPosition", 2, GL_FLOAT, GL_FALSE, 0);
+    _stampBuffer->bind();
+    _stampBuffer->loadVertexData(vertices.data(), (int)vertices.size(), GL_STATIC_DRAW);
+    _stampBuffer->loadIndexData(indices.data(), (int)indices.size(), GL_STATIC_DRAW);
+    _stampBuffer->unbind();
+
+    _stampData.reserve(2 * WHEAT_MAX_STAMPS);
+}
+
+/**
+ * Returns a new trample stamp drawn with this scene. The stamp is drawn until the
+ * caller releases its reference.
+ */
+shared_ptr<WheatStamp> WheatScene::allocStamp() {
+    auto stamp = make_shared<WheatStamp>();
+    _stamps.push_back(stamp);
+    return stamp;
+}
+
+/**
+ * Advances the trample trail by the given time. The trail is decayed (and new stamps
+ * deposited) the next time this scene is rendered.
+ *
+ * @param timestep  the time since the last update
+ */
+void WheatScene::update(float timestep) {
+    _trailTime += timestep;
+    _trailDecay += timestep * WHEAT_TRAIL_DECAY;
+}
+
+/**
+ * Renders the wheat scene to its texture, followed by all trample stamps and the trail
+ *
+ * @param batch     the sprite batch for the scene graph
+ */
+void WheatScene::render(const shared_ptr<SpriteBatch> &batch) {
+    PROFILE_GPU_SCOPE("WheatScene::render");
+    Affine2 matrix = _camera->getCombined();
+    matrix.scale(1, -1); // Flip the y axis for texture write
+
+    // Stamps are in the physics coordinates of the root node
+    Affine2 transform;
+    Affine2::multiply(_rootnode->getNodeToParentTransform(), matrix, &transform);
+    _stamps.erase(remove_if(_stamps.begin(), _stamps.end(),
+                            [](const shared_ptr<WheatStamp> &stamp) { return stamp.use_count() == 1; }),
+                  _stamps.end());
+    updateTrails(transform);
+
+    _target->begin();
+    batch->begin(matrix);
+    batch->setSrcBlendFunc(_srcFactor);
+    batch->setDstBlendFunc(_dstFactor);
+    batch->setBlendEquation(_blendEquation);
+    for (auto it = _children.begin(); it != _children.end(); ++it) {
+        (*it)->render(batch, Affine2::IDENTITY, _color);
+    }
+    batch->end();
+
+    renderStamps(transform);
+    applyTrails();
+    _target->end();
+}
+
+/**
+ * Draws all active stamps
+ *
+ * @param transform the transform from physics coordinates to clip space
+ */
+void WheatScene::renderStamps(const Affine2 &transform) {
+    if (_stamps.empty()) {
+        return;
+    }
+
+    _stampBuffer->attach(_stampShader);
+    _stampShader->setUniformAffine2("uTransform", transform);
+
+    // Same blending as the height nodes these stamps replace: additive color, alpha kept
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFuncSeparate(GL_DST_ALPHA, GL_ONE, GL_ZERO, GL_ONE);
+    drawStamps();
+    _stampBuffer->detach();
+}
+
+/**
+ * Uploads the active stamps and draws them with the currently attached shader
+ */
+void WheatScene::drawStamps() {
+    GLint location = _stampBuffer->getShader()->getUniformLocation("uStamps");
+    for (size_t start = 0; start < _stamps.size(); start += WHEAT_MAX_STAMPS) {
+        size_t count = std::min(_stamps.size() - start, (size_t)WHEAT_MAX_STAMPS);
+        _stampData.clear();
+        for (size_t i = start; i < start + count; i++) {
+            const auto &stamp = _stamps[i];
+            Color4f color(stamp->color);
+            _stampData.push_back(Vec4(stamp->position.x, stamp->position.y,
+                                      stamp->size.width, stamp->size.height));
+            _stampData.push_back(Vec4(color.r, color.g, color.b, color.a));
+        }
+        glUniform4fv(location, (GLsizei)_stampData.size(), reinterpret_cast<const GLfloat *>(_stampData.data()));
+        _stampBuffer->drawInstanced(GL_TRIANGLES, _stampIndices, (GLsizei)count);
+    }
+}
+
+/**
+ * Decays the trail into the other trail target and deposits the stamps into it
+ *
+ * This must be called outside of the wheat render target, as render targets do not nest.
+ *
+ * @param transform the transform from physics coordinates to clip space
+ */
+void WheatScene::updateTrails(const Affine2 &transform) {
+    // The trail is 8 bits, so hold back decay until it amounts to a whole step
+    float decay = floorf(_trailDecay * 255.0f) / 255.0f;
+    _trailDecay -= decay;
+
+    auto &source = _trails[_trailIndex];
+    _trailIndex = 1 - _trailIndex;
+    auto &dest = _trails[_trailIndex];
+
+    dest->begin();
+    glDisable(GL_BLEND);
+    auto texture = source->getTexture();
+    GLuint bindpoint = texture->getBindPoint();
+    texture->setBindPoint(0);
+    _trailShader->bind();
+    _trailShader->setUniform1f("uDecay", decay);
+    _trailShader->setUniformVec4("uMask", Vec4(1, 0, 0, 1));
+    texture->bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    texture->unbind();
+    _trailShader->unbind();
+    texture->setBindPoint(bindpoint);
+
+    if (!_stamps.empty()) {
+        _stampBuffer->attach(_trailStampShader);
+        _trailStampShader->setUniformAffine2("uTransform", transform);
+        _trailStampShader->setUniform1f("uDeposit", WHEAT_TRAIL_GAIN * _trailTime);
+        glEnable(GL_BLEND);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_ONE, GL_ONE);
+        drawStamps();
+        _stampBuffer->detach();
+    }
+    dest->end();
+    _trailTime = 0;
+}
+
+/**
+ * Subtracts the current trail depth from the wheat height in the bound wheat target
+ */
+void WheatScene::applyTrails() {
+    auto texture = _trails[_trailIndex]->getTexture();
+    GLuint bindpoint = texture->getBindPoint();
+    texture->setBindPoint(0);
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_ONE, GL_ONE);
+    _trailShader->bind();
+    _trailShader->setUniform1f("uDecay", 0);
+    _trailShader->setUniformVec4("uMask", Vec4(0, 0, WHEAT_TRAIL_DEPTH / 255.0f, 0));
+    texture->bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    texture->unbind();
+    _trailShader->unbind();
+    texture->setBindPoint(bindpoint);
+}
+
 int WheatScene::addWheatQuery(Vec2 position) {
     _queries.emplace(_queryId, WheatQuery(position, _queryId));
     _queryId++;
@@ -11,6 +11,13 @@
 // just directly set the wheat height (i.e. not adding or subtracting) then you should draw to the
 // red channel with regular blending.
 //
+// Entity trample marks are not scene nodes. Entities update a WheatStamp from allocStamp(), and
+// all stamps are drawn after the scene graph in one instanced draw call, with the same blending.
+//
+// Stamps also press down a persistent trail. The trail depth is kept in a pair of render targets
+// that are ping-ponged each frame: the previous depth is decayed into the other target, the stamps
+// add to it, and the result is subtracted from the wheat height (blue channel) of this scene.
+//
 // Note that the root node of this scene is in physics coordinates, so any textures added to this
 // scene graph need to be scaled down by the draw scale. This is for convenience purposes
 // so that other classes are unaware of the size of the wheat texture. However I am not sure if this
@@ -22,6 +29,8 @@
 #ifndef ROOTED_WHEATSCENE_H
 #define ROOTED_WHEATSCENE_H
 #include <cugl/cugl.h>
+#include "WheatStamp.h"
+#include "StaticBatchNode.h"
 
 using namespace cugl;
 using namespace std;
@@ -30,6 +39,8 @@ class WheatScene : public Scene2Texture {
 private:
     /** the root node of the wheat scene */
     shared_ptr<scene2::SceneNode> _rootnode;
+    /** the static layer holding the wheat tiles of every map unit */
+    shared_ptr<StaticBatchNode> _wheatLayer;
     /** a full screen quad shader for debug rendering the full wheat texture */
     shared_ptr<Shader> _fsqshader;
 
@@ -56,6 +67,61 @@ private:
 
     unordered_map<unsigned int, WheatQuery> _queries;
 
+    /** the shader for drawing trample stamps */
+    shared_ptr<Shader> _stampShader;
+    /** the vertex buffer holding the unit ellipse for trample stamps */
+    shared_ptr<VertexBuffer> _stampBuffer;
+    /** the number of indices in the unit ellipse */
+    GLsizei _stampIndices;
+    /** the active trample stamps */
+    vector<shared_ptr<WheatStamp>> _stamps;
+    /** the uniform data for one batch of stamps */
+    vector<Vec4> _stampData;
+
+    /** the shader for depositing stamps into the trail */
+    shared_ptr<Shader> _trailStampShader;
+    /** the full screen shader for decaying and applying the trail */
+    shared_ptr<Shader> _trailShader;
+    /** the ping-pong trail targets; the trail depth is in the red channel */
+    shared_ptr<RenderTarget> _trails[2];
+    /** the index of the trail target holding the current depth */
+    int _trailIndex;
+    /** the time since the trail was last updated */
+    float _trailTime;
+    /** the trail decay not yet applied, as it is less than one texel step */
+    float _trailDecay;
+
+    /**
+     * Builds the stamp shader and the unit ellipse mesh
+     */
+    void buildStamps();
+
+    /**
+     * Draws all active stamps, dropping those no longer owned by an entity
+     *
+     * @param transform the transform from physics coordinates to clip space
+     */
+    void renderStamps(const Affine2 &transform);
+
+    /**
+     * Uploads the active stamps and draws them with the currently attached shader
+     */
+    void drawStamps();
+
+    /**
+     * Decays the trail into the other trail target and deposits the stamps into it
+     *
+     * This must be called outside of the wheat render target, as render targets do not nest.
+     *
+     * @param transform the transform from physics coordinates to clip space
+     */
+    void updateTrails(const Affine2 &transform);
+
+    /**
+     * Subtracts the current trail depth from the wheat height in the bound wheat target
+     */
+    void applyTrails();
+
 public:
 
     WheatScene() {};
@@ -81,8 +147,29 @@ public:
      */
     void renderToScreen(float alpha = 1.0, float scale = 8.5);
 
+    /**
+     * Advances the trample trail by the given time. The trail is decayed (and new stamps
+     * deposited) the next time this scene is rendered.
+     *
+     * @param timestep  the time since the last update
+     */
+    void update(float timestep) override;
+
+    /**
+     * Renders the wheat scene to its texture, followed by all trample stamps and the trail
+     *
+     * @param batch     the sprite batch for the scene graph
+     */
+    void render(const shared_ptr<SpriteBatch> &batch) override;
+
     shared_ptr<scene2::SceneNode> getRoot() { return _rootnode; }
 
+    /**
+     * Returns a new trample stamp drawn with this scene. The stamp is drawn until the
+     * caller releases its reference.
+     */
+    shared_ptr<WheatStamp> allocStamp();
+
     int addWheatQuery(Vec2 position);
 
     bool getWheatQueryResult(unsigned int queryId);
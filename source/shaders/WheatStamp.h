@@ -0,0 +1,26 @@
+//
+//  WheatStamp.h
+//  Rooted
+//
+//  A trample stamp in the WheatScene. Entities own a stamp and update it every physics step, and
+//  WheatScene draws all live stamps in a single instanced draw call when it renders the wheat
+//  texture. A stamp is dropped once its entity releases it.
+//
+
+#ifndef ROOTED_WHEATSTAMP_H
+#define ROOTED_WHEATSTAMP_H
+#include <cugl/cugl.h>
+
+class WheatStamp {
+public:
+    /** the center of the stamp in physics coordinates */
+    cugl::Vec2 position;
+    /** the size (full width and height) of the stamp ellipse in physics coordinates */
+    cugl::Size size;
+    /** the height delta color of the stamp (see WheatScene for the channel meaning) */
+    cugl::Color4 color;
+
+    WheatStamp() : color(cugl::Color4::BLACK) {};
+};
+
+#endif //ROOTED_WHEATSTAMP_H
@@ -0,0 +1,18 @@
+R"(////////// SHADER BEGIN /////////
+//  stamp_fragment.frag
+//  Rooted
+//
+//  Fills a wheat trample stamp with its height delta color.
+//
+
+#ifdef CUGLES
+precision mediump float;
+#endif
+
+in vec4 outColor;
+out vec4 frag_color;
+
+void main(void) {
+    frag_color = outColor;
+}
+/////////// SHADER END //////////)"
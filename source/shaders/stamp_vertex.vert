@@ -0,0 +1,27 @@
+R"(////////// SHADER BEGIN /////////
+//  stamp_vertex.vert
+//  Rooted
+//
+//  Draws one wheat trample stamp per instance. The vertex buffer holds a unit
+//  ellipse (diameter 1), and each instance reads its center, size and height
+//  delta color from a uniform array. Stamp positions are in physics coordinates.
+//
+
+// Must agree with WHEAT_MAX_STAMPS
+#define MAX_STAMPS 64
+
+in vec2 aPosition;
+out vec4 outColor;
+
+// Physics coordinates to clip space
+uniform mat3 uTransform;
+// Each stamp is a (center, size) vec4 followed by a color vec4
+uniform vec4 uStamps[2*MAX_STAMPS];
+
+void main(void) {
+    vec4 stamp = uStamps[2*gl_InstanceID];
+    vec2 pos = stamp.xy + aPosition*stamp.zw;
+    gl_Position = vec4((uTransform*vec3(pos, 1.0)).xy, 0.0, 1.0);
+    outColor = uStamps[2*gl_InstanceID+1];
+}
+/////////// SHADER END //////////)"
@@ -0,0 +1,28 @@
+R"(////////// SHADER BEGIN /////////
+//  trail_fragment.frag
+//  Rooted
+//
+//  Full screen pass over the trample trail texture (used with FSQShader.vert). The trail depth
+//  lives in the red channel. The decay pass writes the depth less uDecay back to the red channel
+//  of the other trail target, and the apply pass adds the depth to the blue (height decrease)
+//  channel of the wheat texture.
+//
+
+#ifdef CUGLES
+precision highp float;
+#endif
+
+in vec2 outUV;
+uniform sampler2D uTexture;
+// The amount to subtract from the depth
+uniform float uDecay;
+// The channels (and scale) to write the depth to
+uniform vec4 uMask;
+
+out vec4 frag_color;
+
+void main(void) {
+    float depth = max(texture(uTexture, outUV).r - uDecay, 0.0);
+    frag_color = uMask * depth;
+}
+/////////// SHADER END //////////)"
@@ -0,0 +1,22 @@
+R"(////////// SHADER BEGIN /////////
+//  trail_stamp.frag
+//  Rooted
+//
+//  Deposits trample depth into the trail texture for a wheat stamp (used with stamp_vertex.vert).
+//  Faster entities (green) and dashes (blue) press the wheat down more.
+//
+
+#ifdef CUGLES
+precision mediump float;
+#endif
+
+in vec4 outColor;
+// Depth deposited per unit of stamp height this frame
+uniform float uDeposit;
+
+out vec4 frag_color;
+
+void main(void) {
+    frag_color = vec4(uDeposit * (outColor.g + outColor.b) * 255.0, 0.0, 0.0, 0.0);
+}
+/////////// SHADER END //////////)"
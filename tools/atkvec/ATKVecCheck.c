@@ -0,0 +1,327 @@
+//
+//  ATKVecCheck.c
+//  Rooted
+//
+//  Checks the vectorized ATK kernels against their scalar loops, and times both. Every kernel
+//  (add, multiply, scale, scale-add, and max) is run over every length up to 67 and every
+//  starting offset up to 7, so that each vector body is followed by odd scalar tails and starts
+//  on unaligned data. The unit strided versions are checked too, as they forward to the same
+//  kernels. The results of each vector path must match the scalar path bit for bit:
+//
+//      atkvec [length] [rounds]
+//
+//  The defaults time 4096 elements over 20000 rounds. The tool exits with an error if any
+//  result differs. It includes the ATK source directly so that it can switch the vector
+//  kernels off (and AVX off, on x86) to produce the scalar results.
+//
+//  This tool is not part of the game build. Compile it with the same contraction rules as
+//  the library, for example
+//
+//      cc -std=c99 -O2 -ffp-contract=off -I../../cugl/sdlapp/include ATKVecCheck.c -lSDL2 -lm
+//
+
+#include "../../cugl/sdlapp/src/atk/math/ATK_MathVec.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** The longest buffer to check */
+#define MAX_LENGTH  67
+/** The largest starting offset to check */
+#define MAX_OFFSET  7
+/** The padding (in floats) around each check buffer */
+#define PADDING     8
+/** The size of each check buffer */
+#define CHECK_SIZE  (MAX_LENGTH+MAX_OFFSET+2*PADDING)
+
+/** The kernel paths to compare */
+typedef enum {
+    /** The scalar loops only */
+    PATH_SCALAR,
+    /** The SSE or NEON kernels */
+    PATH_VECTOR,
+    /** The AVX kernels */
+    PATH_AVX,
+    /** The number of paths */
+    PATH_COUNT
+} Path;
+
+/** The display names of each path */
+static const char* PATH_NAMES[PATH_COUNT] = { "scalar", "sse/neon", "avx" };
+
+/** The kernels to check */
+typedef enum {
+    KERNEL_ADD,
+    KERNEL_MULT,
+    KERNEL_SCALE,
+    KERNEL_SCALEADD,
+    KERNEL_MAX,
+    KERNEL_COUNT
+} Kernel;
+
+/** The display names of each kernel */
+static const char* KERNEL_NAMES[KERNEL_COUNT] = { "add", "mult", "scale", "scaleadd", "max" };
+
+/** The scalar argument for scale and scale-add (not a power of two, so products round) */
+static const float SCALAR = 0.7310586f;
+
+/**
+ * Returns true if this build has the given path
+ *
+ * @param path  The path to check
+ *
+ * @return true if this build has the given path
+ */
+static int has_path(Path path) {
+    switch (path) {
+        case PATH_SCALAR:
+            return 1;
+        case PATH_VECTOR:
+#if defined(ATK_SIMD_SSE) || defined(ATK_SIMD_NEON)
+            return 1;
+#else
+            return 0;
+#endif
+        case PATH_AVX:
+#if defined(ATK_SIMD_AVX)
+            atk_has_avx = -1;
+            return atk_vec_avx() ? 1 : 0;
+#else
+            return 0;
+#endif
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Selects the kernels used by the ATK vector functions
+ *
+ * @param path  The path to select
+ */
+static void use_path(Path path) {
+#if defined(ATK_SIMD_SSE) || defined(ATK_SIMD_NEON)
+    atk_vec_simd = path != PATH_SCALAR;
+#endif
+#if defined(ATK_SIMD_AVX)
+    atk_has_avx = path == PATH_AVX ? 1 : 0;
+#endif
+}
+
+/**
+ * Fills the buffer with random values of mixed sign and magnitude
+ *
+ * The values avoid NaN and signed zero, as max does not order those the same way on
+ * every path.
+ *
+ * @param data  The buffer to fill
+ * @param len   The buffer length
+ */
+static void fill(float* data, size_t len) {
+    for(size_t ii = 0; ii < len; ii++) {
+        float value = (float)rand()/(float)RAND_MAX;
+        value = (value+0.001f)*(float)(1 << (rand() % 12));
+        data[ii] = (rand() & 1) ? -value : value;
+    }
+}
+
+/**
+ * Runs the kernel once, using the strided version if requested
+ *
+ * The output buffer receives the result. For max, the result is written to the first
+ * element of output.
+ *
+ * @param kernel    The kernel to run
+ * @param stride    Whether to call the unit strided version
+ * @param input1    The first input buffer
+ * @param input2    The second input buffer
+ * @param output    The output buffer
+ * @param len       The number of elements
+ */
+static void run(Kernel kernel, int stride, const float* input1, const float* input2,
+                float* output, size_t len) {
+    switch (kernel) {
+        case KERNEL_ADD:
+            if (stride) {
+                ATK_VecAdd_stride(input1,1,input2,1,output,1,len);
+            } else {
+                ATK_VecAdd(input1,input2,output,len);
+            }
+            break;
+        case KERNEL_MULT:
+            if (stride) {
+                ATK_VecMult_stride(input1,1,input2,1,output,1,len);
+            } else {
+                ATK_VecMult(input1,input2,output,len);
+            }
+            break;
+        case KERNEL_SCALE:
+            if (stride) {
+                ATK_VecScale_stride(input1,1,SCALAR,output,1,len);
+            } else {
+                ATK_VecScale(input1,SCALAR,output,len);
+            }
+            break;
+        case KERNEL_SCALEADD:
+            if (stride) {
+                ATK_VecScaleAdd_stride(input1,1,input2,1,SCALAR,output,1,len);
+            } else {
+                ATK_VecScaleAdd(input1,input2,SCALAR,output,len);
+            }
+            break;
+        case KERNEL_MAX:
+            if (stride) {
+                output[0] = ATK_VecMax_stride((float*)input1,1,len);
+            } else {
+                output[0] = ATK_VecMax((float*)input1,len);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Returns the number of mismatches between each vector path and the scalar path
+ *
+ * Every kernel is checked at every length and offset, with and without strides. The
+ * output buffers are compared in full (padding included) so that a kernel writing past
+ * the end of its range is caught as well.
+ *
+ * @return the number of mismatches
+ */
+static int check(void) {
+    float input1[CHECK_SIZE];
+    float input2[CHECK_SIZE];
+    float expect[CHECK_SIZE];
+    float actual[CHECK_SIZE];
+    int errors = 0;
+
+    fill(input1,CHECK_SIZE);
+    fill(input2,CHECK_SIZE);
+    for(Path path = PATH_VECTOR; path < PATH_COUNT; path++) {
+        if (!has_path(path)) {
+            printf("%-9s skipped (not supported)\n",PATH_NAMES[path]);
+            continue;
+        }
+
+        int failed = 0;
+        for(int kernel = 0; kernel < KERNEL_COUNT; kernel++) {
+            for(int stride = 0; stride < 2; stride++) {
+                for(size_t offset = 0; offset <= MAX_OFFSET; offset++) {
+                    for(size_t len = 0; len <= MAX_LENGTH; len++) {
+                        const float* src1 = input1+PADDING+offset;
+                        const float* src2 = input2+PADDING+offset;
+                        size_t dst = PADDING+offset;
+
+                        memset(expect,0,sizeof(expect));
+                        memset(actual,0,sizeof(actual));
+                        use_path(PATH_SCALAR);
+                        run((Kernel)kernel,stride,src1,src2,expect+dst,len);
+                        use_path(path);
+                        run((Kernel)kernel,stride,src1,src2,actual+dst,len);
+                        if (memcmp(expect,actual,sizeof(expect))) {
+                            if (failed < 10) {
+                                printf("%-9s %s%s differs at length %zu, offset %zu\n",
+                                       PATH_NAMES[path],KERNEL_NAMES[kernel],
+                                       stride ? "_stride" : "",len,offset);
+                            }
+                            failed++;
+                        }
+                    }
+                }
+            }
+        }
+        printf("%-9s %s (%d mismatches)\n",PATH_NAMES[path],failed ? "FAILED" : "ok",failed);
+        errors += failed;
+    }
+    use_path(PATH_VECTOR);
+    return errors;
+}
+
+/**
+ * Returns the current time in seconds
+ *
+ * @return the current time in seconds
+ */
+static double now(void) {
+    return (double)clock()/(double)CLOCKS_PER_SEC;
+}
+
+/**
+ * Times each kernel on each path and prints the results
+ *
+ * @param len       The buffer length
+ * @param rounds    The number of calls to time
+ */
+static void timing(size_t len, int rounds) {
+    float* input1 = (float*)malloc(len*sizeof(float));
+    float* input2 = (float*)malloc(len*sizeof(float));
+    float* output = (float*)malloc(len*sizeof(float));
+    double base[KERNEL_COUNT];
+    volatile float sink = 0;
+
+    fill(input1,len);
+    fill(input2,len);
+    printf("\n%-9s","");
+    for(int kernel = 0; kernel < KERNEL_COUNT; kernel++) {
+        printf(" %16s",KERNEL_NAMES[kernel]);
+    }
+    printf("\n");
+
+    for(Path path = PATH_SCALAR; path < PATH_COUNT; path++) {
+        if (!has_path(path)) {
+            continue;
+        }
+        use_path(path);
+        printf("%-9s",PATH_NAMES[path]);
+        for(int kernel = 0; kernel < KERNEL_COUNT; kernel++) {
+            double start = now();
+            for(int ii = 0; ii < rounds; ii++) {
+                run((Kernel)kernel,0,input1,input2,output,len);
+                sink += output[ii % len];
+            }
+            double time = (now()-start)*1e6/rounds;
+            if (path == PATH_SCALAR) {
+                base[kernel] = time;
+                printf(" %9.2f us     ",time);
+            } else {
+                printf(" %9.2f us %4.1fx",time,time > 0 ? base[kernel]/time : 0.0);
+            }
+        }
+        printf("\n");
+    }
+    use_path(PATH_VECTOR);
+
+    free(input1);
+    free(input2);
+    free(output);
+    (void)sink;
+}
+
+/**
+ * Checks and times the ATK vector kernels
+ *
+ * @param argc  The number of arguments
+ * @param argv  The optional length and number of rounds
+ *
+ * @return 0 if every kernel matches the scalar path, 1 otherwise
+ */
+int main(int argc, char** argv) {
+    size_t len = argc > 1 ? (size_t)strtoul(argv[1],NULL,10) : 4096;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20000;
+    if (len == 0 || rounds <= 0) {
+        fprintf(stderr,"usage: %s [length] [rounds]\n",argv[0]);
+        return 1;
+    }
+
+    srand(1);
+    int errors = check();
+    timing(len,rounds);
+    if (errors) {
+        printf("\n%d mismatches against the scalar path\n",errors);
+        return 1;
+    }
+    return 0;
+}
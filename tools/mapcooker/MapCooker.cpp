@@ -0,0 +1,115 @@
+//
+//  MapCooker.cpp
+//  Rooted
+//
+//  Cooks the Tiled map units listed in json/mapNames.json into the map unit pack that the
+//  game memory-maps at startup. Run it after changing or adding a unit in the level editor:
+//
+//      mapcooker <asset directory>
+//
+//  The units are read with the same MapUnit code the game uses for Tiled exports, and the
+//  pack is written to the "pack" path of mapNames.json. The cooker then reopens the pack and
+//  checks that every unit matches both the streamed and the JsonValue readings of its export,
+//  exiting with an error on any difference.
+//
+//  This tool is not part of the game build. Compile it against the CUGL library with the
+//  map unit sources, for example
+//
+//      c++ -std=c++17 -I../../cugl/include -I../../source MapCooker.cpp
+//          ../../source/objects/MapUnit.cpp ../../source/objects/MapUnitPack.cpp -lcugl -lSDL2
+//
+
+#include <cugl/cugl.h>
+#include "objects/MapUnit.h"
+#include "objects/MapUnitPack.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace cugl;
+
+/**
+ * Returns the contents of the given file, or the empty string if it cannot be read.
+ */
+static std::string readFile(const std::string &path) {
+    std::ifstream stream(path, std::ios::binary);
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    return buffer.str();
+}
+
+/**
+ * Returns true if the spawns are identical, down to the bit.
+ */
+static bool matches(const MapUnit::Spawns &spawns, const std::vector<Rect> &expected) {
+    if (spawns.size != expected.size()) {
+        return false;
+    }
+    return std::memcmp(spawns.data, expected.data(), expected.size() * sizeof(Rect)) == 0;
+}
+
+/**
+ * Returns true if the cooked unit is identical to the unit read from its export.
+ */
+static bool matches(const MapUnit::View &cooked, const MapUnit &expected) {
+    return cooked.wheatName == expected.wheatName &&
+           std::memcmp(&cooked.bladeColorScale, &expected.bladeColorScale, sizeof(float)) == 0 &&
+           matches(cooked.plantingSpawns, expected.plantingSpawns) &&
+           matches(cooked.farmerSpawns, expected.farmerSpawns) &&
+           matches(cooked.babyCarrotSpawns, expected.babyCarrotSpawns) &&
+           matches(cooked.carrotSpawns, expected.carrotSpawns);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <asset directory>\n", argv[0]);
+        return 1;
+    }
+    std::string assets = std::string(argv[1]) + "/";
+
+    auto json = JsonValue::allocWithJson(readFile(assets + "json/mapNames.json"));
+    if (json == nullptr || !json->has("names") || !json->has("files") || !json->has("pack")) {
+        fprintf(stderr, "json/mapNames.json needs names, files and pack\n");
+        return 1;
+    }
+    std::vector<std::string> names = json->get("names")->asStringArray();
+    auto files = json->get("files");
+    std::string pack = assets + json->getString("pack");
+
+    // Read every unit from its Tiled export
+    std::vector<MapUnit> units(names.size());
+    std::vector<MapUnit> trees(names.size());
+    for (size_t ii = 0; ii < names.size(); ii++) {
+        std::string text = readFile(assets + files->getString(names[ii]));
+        if (!units[ii].initWithTiled(text) || !trees[ii].initWithJson(JsonValue::allocWithJson(text))) {
+            fprintf(stderr, "could not read map unit %s\n", names[ii].c_str());
+            return 1;
+        }
+    }
+
+    std::vector<std::byte> bytes = MapUnitPack::cook(names, units);
+    std::ofstream stream(pack, std::ios::binary | std::ios::trunc);
+    stream.write((const char *)bytes.data(), bytes.size());
+    stream.close();
+    if (!stream) {
+        fprintf(stderr, "could not write %s\n", pack.c_str());
+        return 1;
+    }
+
+    // Compare the pack against both readings of the exports
+    MapUnitPack cooked;
+    if (!cooked.init(pack) || cooked.size() != names.size()) {
+        fprintf(stderr, "could not reopen %s\n", pack.c_str());
+        return 1;
+    }
+    int failures = 0;
+    for (size_t ii = 0; ii < names.size(); ii++) {
+        MapUnit::View view = cooked.get(names[ii]);
+        if (!matches(view, units[ii]) || !matches(view, trees[ii])) {
+            fprintf(stderr, "map unit %s does not match its export\n", names[ii].c_str());
+            failures++;
+        }
+    }
+    printf("cooked %zu map units into %s (%zu bytes)\n", names.size(), pack.c_str(), bytes.size());
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+//
+//  PhysicsBench.cpp
+//  Rooted
+//
+//  Times the physics step with and without a job system. The scene is a grid of walled pens,
+//  each filled with dynamic boxes and wheels that start with random velocities (there is no
+//  gravity, as in the game). Every body has a scene graph listener like the ones Map attaches,
+//  so the benchmark covers both the island solver and the obstacle updates:
+//
+//      physicsbench [bodies] [threads] [steps]
+//
+//  The defaults are 600 bodies, one thread per core, and 600 steps. Islands that touch the
+//  same wall are solved together, so a pen is the unit of parallel work. The two worlds are
+//  built identically, and the benchmark exits with an error if any body or node differs
+//  after the last step, as the parallel step must match the serial step exactly.
+//
+//  This tool is not part of the game build. Compile it against the CUGL library, for example
+//
+//      c++ -std=c++17 -O2 -I../../cugl/include PhysicsBench.cpp -lcugl -lbox2d -lSDL2
+//
+
+#include <cugl/cugl.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+using namespace cugl;
+
+/** The number of pens along each side of the world */
+#define PENS        5
+/** The inside width (and height) of a pen */
+#define PEN_SIZE    20.0f
+/** The thickness of a pen wall */
+#define WALL_SIZE   1.0f
+/** The size of a dynamic body */
+#define BODY_SIZE   0.8f
+/** The largest initial speed of a dynamic body */
+#define MAX_SPEED   8.0f
+/** The fixed physics step */
+#define STEP        (1/60.0f)
+/** The seed of the initial velocities */
+#define SEED        0x5eed
+
+/**
+ * A physics world with the nodes that mirror its dynamic bodies.
+ */
+struct Bench {
+    /** The physics world */
+    std::shared_ptr<physics2::ObstacleWorld> world;
+    /** The dynamic bodies, in creation order */
+    std::vector<std::shared_ptr<physics2::Obstacle>> bodies;
+    /** The scene graph nodes updated by the listeners */
+    std::vector<std::shared_ptr<scene2::SceneNode>> nodes;
+};
+
+/**
+ * Adds a static wall with the given bounds to the world.
+ */
+static void addWall(Bench &bench, const Rect &bounds) {
+    auto wall = physics2::BoxObstacle::alloc(bounds.origin + bounds.size / 2, bounds.size);
+    wall->setBodyType(b2_staticBody);
+    bench.world->addObstacle(wall);
+}
+
+/**
+ * Returns a world of pens with the given number of dynamic bodies.
+ *
+ * The world is the same for every call with the same arguments.
+ */
+static Bench build(int count) {
+    Bench bench;
+    float side = PENS * (PEN_SIZE + WALL_SIZE) + WALL_SIZE;
+    bench.world = physics2::ObstacleWorld::alloc(Rect(0, 0, side, side), Vec2::ZERO);
+    bench.world->setLockStep(true);
+    bench.world->setStepsize(STEP);
+
+    for (int px = 0; px < PENS; px++) {
+        for (int py = 0; py < PENS; py++) {
+            Vec2 corner(px * (PEN_SIZE + WALL_SIZE), py * (PEN_SIZE + WALL_SIZE));
+            float outer = PEN_SIZE + 2 * WALL_SIZE;
+            addWall(bench, Rect(corner.x, corner.y, outer, WALL_SIZE));
+            addWall(bench, Rect(corner.x, corner.y + PEN_SIZE + WALL_SIZE, outer, WALL_SIZE));
+            addWall(bench, Rect(corner.x, corner.y + WALL_SIZE, WALL_SIZE, PEN_SIZE));
+            addWall(bench, Rect(corner.x + PEN_SIZE + WALL_SIZE, corner.y + WALL_SIZE, WALL_SIZE, PEN_SIZE));
+        }
+    }
+
+    // Spread the bodies over the pens, on a grid inside each pen
+    std::mt19937 random(SEED);
+    std::uniform_real_distribution<float> speed(-MAX_SPEED, MAX_SPEED);
+    int perPen = (count + PENS * PENS - 1) / (PENS * PENS);
+    int perRow = (int)std::ceil(std::sqrt((float)perPen));
+    float spacing = PEN_SIZE / perRow;
+    for (int ii = 0; ii < count; ii++) {
+        int pen = ii % (PENS * PENS);
+        int slot = ii / (PENS * PENS);
+        Vec2 pos((pen % PENS) * (PEN_SIZE + WALL_SIZE) + WALL_SIZE + (slot % perRow + 0.5f) * spacing,
+                 (pen / PENS) * (PEN_SIZE + WALL_SIZE) + WALL_SIZE + (slot / perRow + 0.5f) * spacing);
+
+        std::shared_ptr<physics2::Obstacle> body;
+        if (ii % 2 == 0) {
+            body = physics2::BoxObstacle::alloc(pos, Size(BODY_SIZE, BODY_SIZE));
+        } else {
+            body = physics2::WheelObstacle::alloc(pos, BODY_SIZE / 2);
+        }
+        body->setBodyType(b2_dynamicBody);
+        body->setDensity(1.0f);
+        body->setFriction(0.2f);
+        body->setRestitution(0.5f);
+        body->setLinearVelocity(Vec2(speed(random), speed(random)));
+
+        // The same listener Map attaches to dynamic objects
+        auto node = scene2::SceneNode::alloc();
+        scene2::SceneNode *weak = node.get();
+        body->setListener([=](physics2::Obstacle *obs) {
+            weak->setPosition(obs->getPosition());
+            weak->setAngle(obs->getAngle());
+        });
+        body->setUpdateThreadSafe(true);
+
+        bench.world->addObstacle(body);
+        bench.bodies.push_back(body);
+        bench.nodes.push_back(node);
+    }
+    return bench;
+}
+
+/**
+ * Returns the average time of a step of the world in milliseconds.
+ */
+static double run(Bench &bench, int steps) {
+    auto start = std::chrono::steady_clock::now();
+    for (int ii = 0; ii < steps; ii++) {
+        bench.world->update(STEP);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / steps;
+}
+
+/**
+ * Returns the number of bodies whose state differs between the two worlds.
+ */
+static int compare(const Bench &serial, const Bench &parallel) {
+    int failures = 0;
+    for (size_t ii = 0; ii < serial.bodies.size(); ii++) {
+        b2Body *a = serial.bodies[ii]->getBody();
+        b2Body *b = parallel.bodies[ii]->getBody();
+        Vec2 nodeA = serial.nodes[ii]->getPosition();
+        Vec2 nodeB = parallel.nodes[ii]->getPosition();
+        if (std::memcmp(&a->GetTransform(), &b->GetTransform(), sizeof(b2Transform)) != 0 ||
+            std::memcmp(&a->GetLinearVelocity(), &b->GetLinearVelocity(), sizeof(b2Vec2)) != 0 ||
+            std::memcmp(&nodeA, &nodeB, sizeof(Vec2)) != 0) {
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 600;
+    int threads = argc > 2 ? std::atoi(argv[2]) : 0;
+    int steps = argc > 3 ? std::atoi(argv[3]) : 600;
+    if (count <= 0 || threads < 0 || steps <= 0) {
+        fprintf(stderr, "usage: %s [bodies] [threads] [steps]\n", argv[0]);
+        return 1;
+    }
+
+    Bench serial = build(count);
+    Bench parallel = build(count);
+    auto jobs = JobSystem::alloc(threads);
+    parallel.world->setJobSystem(jobs);
+
+    double serialTime = run(serial, steps);
+    double parallelTime = run(parallel, steps);
+    int failures = compare(serial, parallel);
+
+    printf("%d bodies in %d pens, %d steps\n", count, PENS * PENS, steps);
+    printf("serial:   %.3f ms/step\n", serialTime);
+    printf("parallel: %.3f ms/step (%zu workers + caller, %.2fx)\n",
+           parallelTime, jobs->getThreadCount(), serialTime / parallelTime);
+    if (failures > 0) {
+        fprintf(stderr, "%d bodies differ between the serial and parallel steps\n", failures);
+    }
+
+    jobs->stop();
+    return failures == 0 ? 0 : 1;
+}